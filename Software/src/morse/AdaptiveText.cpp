@@ -0,0 +1,126 @@
+/******************************************************************************************************************************
+ *  morse_3 Software for the Morserino-32 multi-functional Morse code machine, based on the Heltec WiFi LORA (ESP32) module ***
+ *  Copyright (C) 2018  Willi Kraml, OE1WKL                                                                                 ***
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this program.
+ *  If not, see <https://www.gnu.org/licenses/>.
+ *****************************************************************************************************************************/
+#include <string.h>
+#include "AdaptiveText.h"
+
+AdaptiveText::AdaptiveText(CharStats &s) :
+        stats(s)
+{
+    chars[0] = 0;
+    for (int p = 0; p < POOLS; ++p)
+    {
+        items[p] = 0;
+        firsts[p] = 0;
+        stale[p] = true;
+    }
+}
+
+/// setChars sets the characters to choose from (in internal form); nothing happens if they are the same as before
+void AdaptiveText::setChars(const char *c)
+{
+    if (!stale[CHARS] && !strncmp(chars, c, MAX_CHARS))
+    {
+        return;
+    }
+    strncpy(chars, c, MAX_CHARS);
+    chars[MAX_CHARS] = 0;
+    rebuild(CHARS);
+}
+
+/// setList sets the words or abbreviations to choose from: item(first) .. item(first + n - 1), at most WeightedSampler::CAPACITY of them
+void AdaptiveText::setList(Pool pool, Item item, uint16_t first, uint16_t n)
+{
+    if (n > WeightedSampler::CAPACITY)
+    {
+        n = WeightedSampler::CAPACITY;
+    }
+    if (!stale[pool] && items[pool] == item && firsts[pool] == first && samplers[pool].getSize() == n)
+    {
+        return;
+    }
+    items[pool] = item;
+    firsts[pool] = first;
+    samplers[pool].clear(n);
+    rebuild(pool);
+}
+
+void AdaptiveText::onEvaluated(const char *word)
+{
+    uint16_t meanMs = stats.getMeanResponse();
+
+    for (const char *w = word; *w; ++w)
+    {
+        const char *found = strchr(chars, *w);
+        if (found)
+        {
+            samplers[CHARS].set(found - chars, stats.getWeakness(*w, meanMs));
+        }
+    }
+    stale[WORDS] = stale[ABBREVS] = true;
+}
+
+void AdaptiveText::invalidate()
+{
+    for (int p = 0; p < POOLS; ++p)
+    {
+        stale[p] = true;
+    }
+}
+
+/// getTotal is the sum of the weights of a pool: the range of the random number for picking from it
+uint32_t AdaptiveText::getTotal(Pool pool)
+{
+    if (stale[pool])
+    {
+        rebuild(pool);
+    }
+    return samplers[pool].getTotal();
+}
+
+/// pickChar, r in [0, getTotal(CHARS))
+char AdaptiveText::pickChar(uint32_t r)
+{
+    return chars[0] ? chars[samplers[CHARS].pick(r)] : 0;
+}
+
+/// pickItem, r in [0, getTotal(pool))
+const char* AdaptiveText::pickItem(Pool pool, uint32_t r)
+{
+    return items[pool] ? items[pool](firsts[pool] + samplers[pool].pick(r)) : "";
+}
+
+void AdaptiveText::rebuild(Pool pool)
+{
+    uint16_t weights[WeightedSampler::CAPACITY];
+    uint16_t meanMs = stats.getMeanResponse();
+    uint16_t n = 0;
+
+    if (pool == CHARS)
+    {
+        for (; chars[n]; ++n)
+        {
+            weights[n] = stats.getWeakness(chars[n], meanMs);
+        }
+    }
+    else if (items[pool])
+    {
+        n = samplers[pool].getSize();
+        for (int i = 0; i < n; ++i)
+        {
+            weights[i] = stats.getWeakness(items[pool](firsts[pool] + i), meanMs);
+        }
+    }
+    samplers[pool].build(weights, n);
+    stale[pool] = false;
+}
@@ -0,0 +1,54 @@
+/*
+ * AdaptiveText.h
+ *
+ *  Chooses characters, words and abbreviations for training more often the weaker the user is at them.
+ */
+
+#ifndef ADAPTIVETEXT_H_
+#define ADAPTIVETEXT_H_
+
+#include "arduino.h"
+#include "CharStats.h"
+#include "WeightedSampler.h"
+
+/// There is a WeightedSampler for each Pool, with the weakness (see CharStats::getWeakness()) of each character or
+/// word as its weight. The characters come from setChars(), the words and abbreviations through an Item function
+/// that returns entry first + i of a list; a pool is rebuilt in O(n) when it is set to something else.
+///
+/// onEvaluated() is called after each response has gone into the statistics: the weights of the characters of the
+/// word are updated at once, O(length * log n); the words and abbreviations depend on many characters, so these pools
+/// are only marked stale and rebuilt before they are used next. Whoever changes a word list calls invalidate().
+
+class AdaptiveText
+{
+    public:
+        typedef const char* (*Item)(uint16_t i);
+
+        enum Pool
+        {
+            CHARS, WORDS, ABBREVS, POOLS
+        };
+
+        static const uint8_t MAX_CHARS = 64;
+
+        AdaptiveText(CharStats &stats);
+        void setChars(const char *chars);
+        void setList(Pool pool, Item item, uint16_t first, uint16_t n);
+        void onEvaluated(const char *word);
+        void invalidate();
+        uint32_t getTotal(Pool pool);
+        char pickChar(uint32_t r);
+        const char* pickItem(Pool pool, uint32_t r);
+
+    private:
+        CharStats &stats;
+        WeightedSampler samplers[POOLS];
+        char chars[MAX_CHARS + 1];
+        Item items[POOLS];
+        uint16_t firsts[POOLS];
+        boolean stale[POOLS];
+
+        void rebuild(Pool pool);
+};
+
+#endif /* ADAPTIVETEXT_H_ */
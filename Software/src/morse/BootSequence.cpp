@@ -0,0 +1,109 @@
+/******************************************************************************************************************************
+ *  morse_3 Software for the Morserino-32 multi-functional Morse code machine, based on the Heltec WiFi LORA (ESP32) module ***
+ *  Copyright (C) 2018  Willi Kraml, OE1WKL                                                                                 ***
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this program.
+ *  If not, see <https://www.gnu.org/licenses/>.
+ *****************************************************************************************************************************/
+#include "BootSequence.h"
+
+BootSequence::BootSequence(Clock clock, Logger logger) :
+        clock(clock), logger(logger), count(0), lastMark(0)
+{
+}
+
+/// mark logs the end of a boot phase; the phase started where the previous one (or step) ended
+void BootSequence::mark(const char *phase)
+{
+    unsigned long now = clock();
+    logger(phase, now, now - lastMark);
+    lastMark = now;
+}
+
+/// defer registers a step to be run later; if there is no room left, it is run right away
+void BootSequence::defer(const char *name, Step step)
+{
+    if (find(step))
+    {
+        return;
+    }
+    if (count == MAX_STEPS)
+    {
+        Deferred d = { name, step, false };
+        run(d);
+        return;
+    }
+    steps[count].name = name;
+    steps[count].step = step;
+    steps[count].done = false;
+    ++count;
+}
+
+/// ensure runs step now, unless it has already been run; steps that have never been deferred count as done
+void BootSequence::ensure(Step step)
+{
+    Deferred *d = find(step);
+    if (d && !d->done)
+    {
+        run(*d);
+    }
+}
+
+boolean BootSequence::isDone(Step step)
+{
+    Deferred *d = find(step);
+    return !d || d->done;
+}
+
+/// runNext runs the oldest step that is still pending; returns false if there was none
+boolean BootSequence::runNext()
+{
+    for (int i = 0; i < count; ++i)
+    {
+        if (!steps[i].done)
+        {
+            run(steps[i]);
+            return true;
+        }
+    }
+    return false;
+}
+
+boolean BootSequence::isComplete()
+{
+    for (int i = 0; i < count; ++i)
+    {
+        if (!steps[i].done)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+BootSequence::Deferred* BootSequence::find(Step step)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        if (steps[i].step == step)
+        {
+            return &steps[i];
+        }
+    }
+    return 0;
+}
+
+void BootSequence::run(Deferred &d)
+{
+    d.done = true;                  // before running it: the step may itself call functions that ensure it
+    unsigned long start = clock();
+    d.step();
+    lastMark = clock();
+    logger(d.name, lastMark, lastMark - start);
+}
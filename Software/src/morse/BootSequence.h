@@ -0,0 +1,58 @@
+/*
+ * BootSequence.h
+ *
+ *  Staged start-up: boot phase timing and subsystems that are initialized later.
+ */
+
+#ifndef BOOTSEQUENCE_H_
+#define BOOTSEQUENCE_H_
+
+#include "arduino.h"
+
+/// Only what is needed to get the first mode going is set up in setup(); everything else (LoRa
+/// transceiver, SPIFFS, Koch word lists, ...) is registered as a deferred step. A deferred step runs
+/// either when the machine has nothing else to do (runNext(), called while the splash screen is shown
+/// and from the main loop), or as soon as somebody needs it (ensure()) - whichever comes first, and
+/// never twice.
+///
+/// mark() records the end of a synchronous boot phase; every phase and every deferred step is
+/// handed to the logger with the time since power on and the time it took.
+///
+/// The clock is passed in, so the class can be used without hardware.
+
+class BootSequence
+{
+    public:
+        typedef void (*Step)();
+        typedef unsigned long (*Clock)();
+        typedef void (*Logger)(const char *phase, unsigned long at, unsigned long took);
+
+        static const uint8_t MAX_STEPS = 8;
+
+        BootSequence(Clock clock, Logger logger);
+        void mark(const char *phase);
+        void defer(const char *name, Step step);
+        void ensure(Step step);
+        boolean isDone(Step step);
+        boolean runNext();
+        boolean isComplete();
+
+    private:
+        struct Deferred
+        {
+                const char *name;
+                Step step;
+                boolean done;
+        };
+
+        Clock clock;
+        Logger logger;
+        Deferred steps[MAX_STEPS];
+        uint8_t count;
+        unsigned long lastMark;
+
+        Deferred* find(Step step);
+        void run(Deferred &d);
+};
+
+#endif /* BOOTSEQUENCE_H_ */
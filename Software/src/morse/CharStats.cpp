@@ -0,0 +1,278 @@
+/******************************************************************************************************************************
+ *  morse_3 Software for the Morserino-32 multi-functional Morse code machine, based on the Heltec WiFi LORA (ESP32) module ***
+ *  Copyright (C) 2018  Willi Kraml, OE1WKL                                                                                 ***
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this program.
+ *  If not, see <https://www.gnu.org/licenses/>.
+ *****************************************************************************************************************************/
+#include <string.h>
+#include "CharStats.h"
+#include "PrefsStore.h"
+
+const CharStats::Entry CharStats::NONE = { };
+
+CharStats::CharStats()
+{
+    clear();
+}
+
+void CharStats::clear()
+{
+    memset(table, 0, sizeof(table));
+}
+
+/// align finds the cheapest way to turn expected into response; edits receives one Edit per step, from the start of
+/// the words, and the number of steps is returned
+uint8_t CharStats::align(const char *expected, const char *response, Edit *edits)
+{
+    uint8_t d[MAX_WORD + 1][MAX_WORD + 1];
+    uint8_t n = strnlen(expected, MAX_WORD);
+    uint8_t m = strnlen(response, MAX_WORD);
+
+    for (int i = 0; i <= n; ++i)
+    {
+        d[i][0] = i;
+    }
+    for (int j = 0; j <= m; ++j)
+    {
+        d[0][j] = j;
+    }
+    for (int i = 1; i <= n; ++i)
+    {
+        for (int j = 1; j <= m; ++j)
+        {
+            uint8_t diagonal = d[i - 1][j - 1] + (expected[i - 1] != response[j - 1]);
+            uint8_t shorter = (d[i - 1][j] < d[i][j - 1] ? d[i - 1][j] : d[i][j - 1]) + 1;
+            d[i][j] = diagonal < shorter ? diagonal : shorter;
+        }
+    }
+
+    /// walk back from the end; where there is a choice, a substitution is more likely than a character too many or too few
+    uint8_t steps = 0;
+    int i = n;
+    int j = m;
+    while (i > 0 || j > 0)
+    {
+        if (i > 0 && j > 0 && d[i][j] == d[i - 1][j - 1] + (expected[i - 1] != response[j - 1]))
+        {
+            edits[steps++] = expected[i - 1] == response[j - 1] ? MATCH : SUBSTITUTE;
+            --i;
+            --j;
+        }
+        else if (i > 0 && d[i][j] == d[i - 1][j] + 1)
+        {
+            edits[steps++] = DELETE;
+            --i;
+        }
+        else
+        {
+            edits[steps++] = INSERT;
+            --j;
+        }
+    }
+    for (int k = 0; k < steps / 2; ++k)
+    {
+        Edit e = edits[k];
+        edits[k] = edits[steps - 1 - k];
+        edits[steps - 1 - k] = e;
+    }
+    return steps;
+}
+
+/// evaluate aligns the words and updates the table; responseMs has one time per character of the response (or is 0)
+CharStats::Result CharStats::evaluate(const char *expected, const char *response, const uint16_t *responseMs)
+{
+    Edit edits[2 * MAX_WORD];
+    Result r = { };
+    uint8_t i = 0;
+    uint8_t j = 0;
+    uint8_t steps = align(expected, response, edits);
+
+    for (int k = 0; k < steps; ++k)
+    {
+        Entry *e;
+        switch (edits[k])
+        {
+            case MATCH:
+                ++r.matches;
+                if ((e = find(expected[i])))
+                {
+                    ++e->sent;
+                    if (responseMs && responseMs[j])
+                    {
+                        e->responseMs = e->responseMs ? e->responseMs + ((int32_t) responseMs[j] - e->responseMs) / 8 : responseMs[j];
+                    }
+                }
+                ++i;
+                ++j;
+                break;
+            case SUBSTITUTE:
+                ++r.substitutions;
+                if ((e = find(expected[i])))
+                {
+                    ++e->sent;
+                    ++e->substituted;
+                    e->confusedWith = response[j];
+                }
+                ++i;
+                ++j;
+                break;
+            case DELETE:
+                ++r.deletions;
+                if ((e = find(expected[i])))
+                {
+                    ++e->sent;
+                    ++e->dropped;
+                }
+                ++i;
+                break;
+            case INSERT:
+                ++r.insertions;
+                if ((e = find(response[j])))
+                {
+                    ++e->inserted;
+                }
+                ++j;
+                break;
+        }
+        if (e && e->sent >= AGE_LIMIT)
+        {
+            age(*e);
+        }
+    }
+    r.distance = r.substitutions + r.insertions + r.deletions;
+    return r;
+}
+
+const CharStats::Entry& CharStats::get(char c)
+{
+    Entry *e = find(c);
+    return e ? *e : NONE;
+}
+
+/// getErrorPercent: how often the character was substituted or dropped, of the times it was expected
+uint8_t CharStats::getErrorPercent(char c)
+{
+    const Entry &e = get(c);
+    return e.sent ? (uint32_t) (e.substituted + e.dropped) * 100 / e.sent : 0;
+}
+
+/// getWorst fills worst with up to n characters that have been sent at least minSent times, the highest error rate
+/// first; characters without errors are left out. Returns how many it has filled in.
+uint8_t CharStats::getWorst(char *worst, uint8_t n, uint16_t minSent)
+{
+    uint8_t count = 0;
+
+    for (int i = 0; i < SIZE; ++i)
+    {
+        char c = FIRST + i;
+        uint8_t percent = getErrorPercent(c);
+        if (table[i].sent < minSent || percent == 0)
+        {
+            continue;
+        }
+        int k = count < n ? count++ : n;
+        while (k > 0 && getErrorPercent(worst[k - 1]) < percent)
+        {
+            if (k < n)
+            {
+                worst[k] = worst[k - 1];
+            }
+            --k;
+        }
+        if (k < n)
+        {
+            worst[k] = c;
+        }
+    }
+    return count;
+}
+
+/// getMeanResponse is the average response time of all characters that have one, 0 if none has
+uint16_t CharStats::getMeanResponse()
+{
+    uint32_t sum = 0;
+    uint8_t n = 0;
+
+    for (int i = 0; i < SIZE; ++i)
+    {
+        if (table[i].responseMs)
+        {
+            sum += table[i].responseMs;
+            ++n;
+        }
+    }
+    return n ? sum / n : 0;
+}
+
+/// getWeakness of a character, from WEIGHT (always right, not slower than meanMs) to 2 * WEIGHT + 200
+uint16_t CharStats::getWeakness(char c, uint16_t meanMs)
+{
+    const Entry &e = get(c);
+
+    if (e.sent < MIN_SENT)
+    {
+        return WEIGHT + 100;                    // as if half of them were wrong
+    }
+    uint16_t weight = WEIGHT + 2 * getErrorPercent(c);
+    if (meanMs && e.responseMs > meanMs)
+    {
+        uint32_t slower = (uint32_t) WEIGHT * (e.responseMs - meanMs) / meanMs;
+        weight += slower < WEIGHT ? slower : WEIGHT;
+    }
+    return weight;
+}
+
+/// getWeakness of a word: the average of its characters
+uint16_t CharStats::getWeakness(const char *word, uint16_t meanMs)
+{
+    uint32_t sum = 0;
+    uint8_t n = 0;
+
+    for (; *word && n < MAX_WORD; ++word, ++n)
+    {
+        sum += getWeakness(*word, meanMs);
+    }
+    return n ? sum / n : WEIGHT;
+}
+
+void CharStats::toBlob(Blob &blob)
+{
+    blob.version = LAYOUT_VERSION;
+    blob.size = SIZE;
+    memcpy(blob.entries, table, sizeof(table));
+    blob.crc = PrefsStore::crc16((const uint8_t*) blob.entries, sizeof(blob.entries));
+}
+
+/// fromBlob takes the table from a blob read from storage; returns false (and leaves the table alone) if it is damaged
+/// or of another layout
+boolean CharStats::fromBlob(const Blob &blob, size_t length)
+{
+    if (length != sizeof(Blob) || blob.version != LAYOUT_VERSION || blob.size != SIZE
+            || blob.crc != PrefsStore::crc16((const uint8_t*) blob.entries, sizeof(blob.entries)))
+    {
+        return false;
+    }
+    memcpy(table, blob.entries, sizeof(table));
+    return true;
+}
+
+CharStats::Entry* CharStats::find(char c)
+{
+    uint8_t i = (uint8_t) c - FIRST;
+    return i < SIZE ? &table[i] : 0;
+}
+
+void CharStats::age(Entry &e)
+{
+    e.sent /= 2;
+    e.substituted /= 2;
+    e.dropped /= 2;
+    e.inserted /= 2;
+}
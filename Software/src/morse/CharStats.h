@@ -0,0 +1,96 @@
+/*
+ * CharStats.h
+ *
+ *  Per-character error statistics: aligns the response with the word it should have been, and counts what went wrong.
+ */
+
+#ifndef CHARSTATS_H_
+#define CHARSTATS_H_
+
+#include "arduino.h"
+
+/// evaluate() aligns the response with the expected word (edit distance, each substitution, insertion and deletion
+/// costs 1) and attributes every edit to a character: a substitution and a deletion (a character that was not keyed)
+/// to the expected character, an insertion (an extra character) to the one that was keyed. Characters keyed correctly
+/// also feed the average response time of the character, the time in ms from the end of the previous character (or the
+/// prompt) to the end of this one.
+///
+/// The table has one Entry for each of the internal characters (the ASCII range from ' ' to DEL; lower case letters
+/// are the letters, upper case letters stand for the pro signs), so it is fixed size and an update is O(word length)
+/// once the words are aligned. Words are aligned up to MAX_WORD characters; the rest is ignored. Once a character has
+/// been sent AGE_LIMIT times, its counts are halved, so old mistakes are slowly forgotten.
+///
+/// getWeakness() turns the table into a weight for choosing what to train: WEIGHT (the weight of a character that is
+/// always keyed right and in average time) plus two per percent of errors, plus up to WEIGHT if it takes longer than
+/// the average of all characters to key it. A character that has been sent less than MIN_SENT times is weak until we
+/// know better. The weakness of a word is the average of its characters.
+///
+/// The table goes into non-volatile storage as a Blob, with a layout version and a CRC.
+
+class CharStats
+{
+    public:
+        static const uint8_t FIRST = ' ';
+        static const uint8_t SIZE = 96;
+        static const uint8_t MAX_WORD = 24;
+        static const uint16_t AGE_LIMIT = 4000;
+        static const uint8_t LAYOUT_VERSION = 1;
+        static const uint16_t WEIGHT = 16;
+        static const uint16_t MIN_SENT = 3;
+
+        enum Edit
+        {
+            MATCH, SUBSTITUTE, INSERT, DELETE
+        };
+
+        struct Entry
+        {
+                uint16_t sent;                  /// how often it was expected
+                uint16_t substituted;           /// ... and something else was keyed
+                uint16_t dropped;               /// ... and nothing was keyed
+                uint16_t inserted;              /// how often it was keyed although it was not expected
+                uint16_t responseMs;            /// running average, 0 = not known yet
+                uint8_t confusedWith;           /// what was keyed instead, the last time it was substituted
+                uint8_t reserved;
+        };
+
+        struct Result
+        {
+                uint8_t distance;
+                uint8_t matches;
+                uint8_t substitutions;
+                uint8_t insertions;
+                uint8_t deletions;
+        };
+
+        struct Blob
+        {
+                uint8_t version;
+                uint8_t size;
+                uint16_t crc;
+                Entry entries[SIZE];
+        };
+
+        CharStats();
+        void clear();
+        Result evaluate(const char *expected, const char *response, const uint16_t *responseMs);
+        const Entry& get(char c);
+        uint8_t getErrorPercent(char c);
+        uint8_t getWorst(char *worst, uint8_t n, uint16_t minSent);
+        uint16_t getMeanResponse();
+        uint16_t getWeakness(char c, uint16_t meanMs);
+        uint16_t getWeakness(const char *word, uint16_t meanMs);
+        void toBlob(Blob &blob);
+        boolean fromBlob(const Blob &blob, size_t length);
+
+        static uint8_t align(const char *expected, const char *response, Edit *edits);
+
+    private:
+        Entry table[SIZE];
+        static const Entry NONE;
+
+        Entry* find(char c);
+        static void age(Entry &e);
+};
+
+#endif /* CHARSTATS_H_ */
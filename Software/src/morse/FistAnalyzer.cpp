@@ -0,0 +1,166 @@
+/******************************************************************************************************************************
+ *  morse_3 Software for the Morserino-32 multi-functional Morse code machine, based on the Heltec WiFi LORA (ESP32) module ***
+ *  Copyright (C) 2018  Willi Kraml, OE1WKL                                                                                 ***
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this program.
+ *  If not, see <https://www.gnu.org/licenses/>.
+ *****************************************************************************************************************************/
+#include "FistAnalyzer.h"
+
+FistAnalyzer::FistAnalyzer()
+{
+    clear();
+}
+
+void FistAnalyzer::clear()
+{
+    for (int i = 0; i < KINDS; ++i)
+    {
+        stats[i].count = 0;
+        stats[i].mean = 0;
+        stats[i].m2 = 0;
+    }
+}
+
+void FistAnalyzer::mark(boolean dah, unsigned long ms)
+{
+    add(stats[dah ? DAH : DIT], ms);
+}
+
+/// space sorts the space before a mark by the dits keyed so far
+void FistAnalyzer::space(unsigned long ms)
+{
+    float dit = stats[DIT].mean;
+
+    if (!stats[DIT].count)
+    {
+        return;
+    }
+    if (ms < ELEMENT_SPACE * dit)
+    {
+        add(stats[ELEMENT], ms);
+    }
+    else if (ms < CHAR_SPACE * dit)
+    {
+        add(stats[CHARACTER], ms);
+    }
+    else if (ms < WORD_SPACE * dit)
+    {
+        add(stats[WORD], ms);
+    }
+}
+
+const FistAnalyzer::Stat& FistAnalyzer::get(Kind kind)
+{
+    return stats[kind];
+}
+
+uint16_t FistAnalyzer::getMean(Kind kind)
+{
+    return stats[kind].mean + 0.5f;
+}
+
+/// getDeviation is the standard deviation in ms
+uint16_t FistAnalyzer::getDeviation(Kind kind)
+{
+    const Stat &s = stats[kind];
+
+    return s.count ? squareRoot(s.m2 / s.count + 0.5f) : 0;
+}
+
+FistAnalyzer::Report FistAnalyzer::getReport(uint8_t wpm)
+{
+    Report r = { };
+    const Stat &dit = stats[DIT];
+    const Stat &dah = stats[DAH];
+    const Stat &element = stats[ELEMENT];
+    float selectedDit = wpm ? 1200.0f / wpm : 0;
+
+    r.marks = dit.count + dah.count;
+    if (dit.count)
+    {
+        r.wpm = 1200.0f / dit.mean + 0.5f;
+        r.ditSpread = spread(dit);
+    }
+    if (dit.count && dah.count)
+    {
+        r.ratio = dah.mean * 100 / dit.mean + 0.5f;
+    }
+    if (dah.count)
+    {
+        r.dahSpread = spread(dah);
+    }
+    if (dit.count && element.count)
+    {
+        r.weight = dit.mean * 100 / (dit.mean + element.mean) + 0.5f;
+        r.spaceSpread = spread(element);
+    }
+    if (selectedDit && stats[CHARACTER].count)
+    {
+        r.charSpace = stats[CHARACTER].mean * 100 / (3 * selectedDit) + 0.5f;
+    }
+    if (selectedDit && stats[WORD].count)
+    {
+        r.wordSpace = stats[WORD].mean * 100 / (7 * selectedDit) + 0.5f;
+    }
+    return r;
+}
+
+/// add is one step of Welford's algorithm; with a full window, the oldest sample is assumed to have been the mean
+void FistAnalyzer::add(Stat &stat, float x)
+{
+    if (stat.count < WINDOW)
+    {
+        ++stat.count;
+    }
+    else
+    {
+        stat.m2 = stat.m2 * (WINDOW - 1) / WINDOW;
+    }
+    float delta = x - stat.mean;
+    stat.mean += delta / stat.count;
+    stat.m2 += delta * (x - stat.mean);
+}
+
+/// squareRoot rounds down, bit by bit - we have no need for floating point square roots otherwise
+uint32_t FistAnalyzer::squareRoot(uint32_t x)
+{
+    uint32_t root = 0;
+    uint32_t bit = 1UL << 30;
+
+    while (bit > x)
+    {
+        bit >>= 2;
+    }
+    while (bit)
+    {
+        if (x >= root + bit)
+        {
+            x -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+/// spread is the standard deviation in percent of the mean
+uint8_t FistAnalyzer::spread(const Stat &stat)
+{
+    if (!stat.count || stat.mean <= 0)
+    {
+        return 0;
+    }
+    uint32_t deviation = squareRoot(stat.m2 * 10000 / stat.count / (stat.mean * stat.mean) + 0.5f);
+    return deviation < 255 ? deviation : 255;
+}
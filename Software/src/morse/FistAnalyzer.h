@@ -0,0 +1,81 @@
+/*
+ * FistAnalyzer.h
+ *
+ *  Timing statistics of hand keyed code: dah/dit ratio, weighting, and how even the elements and the spaces are.
+ */
+
+#ifndef FISTANALYZER_H_
+#define FISTANALYZER_H_
+
+#include "arduino.h"
+
+/// The decoder feeds in every mark it has accepted (and whether it took it for a dit or a dah), and every space before
+/// a mark, in ms. A space is an element space if it is shorter than ELEMENT_SPACE dits (of the dits keyed so far), a
+/// character space if shorter than CHAR_SPACE dits, a word space if shorter than WORD_SPACE dits; anything longer is a
+/// pause, and says nothing about the fist. Spaces before the first dit are not counted.
+///
+/// Each kind of element has a Stat: count, mean and variance, updated with Welford's online algorithm - so memory
+/// is fixed however long one keys. Once a Stat has WINDOW samples, it keeps WINDOW: it becomes a moving average that
+/// follows the fist as it changes.
+///
+/// getReport() sums it up, for the speed selected in the preferences:
+/// - wpm: the speed of the dits keyed (1200 / dit ms)
+/// - ratio: dah / dit in percent - 300 is the book value
+/// - weight: dit / (dit + element space) in percent - 50 is even, more is heavy, less is light
+/// - ditSpread, dahSpread, spaceSpread: standard deviation in percent of the mean (of dits, dahs, element spaces)
+/// - charSpace, wordSpace: the spaces between characters and words in percent of 3 and 7 dits of the selected speed
+///   (so less than 100 means rushed, more means Farnsworth)
+/// A value is 0 as long as there is nothing to base it on.
+
+class FistAnalyzer
+{
+    public:
+        static const uint16_t WINDOW = 500;
+        static const uint8_t ELEMENT_SPACE = 2;         /// dits
+        static const uint8_t CHAR_SPACE = 5;
+        static const uint8_t WORD_SPACE = 14;
+
+        enum Kind
+        {
+            DIT, DAH, ELEMENT, CHARACTER, WORD, KINDS
+        };
+
+        struct Stat
+        {
+                uint16_t count;
+                float mean;
+                float m2;                   /// sum of the squared deviations from the mean
+        };
+
+        struct Report
+        {
+                uint16_t marks;
+                uint8_t wpm;
+                uint16_t ratio;
+                uint8_t weight;
+                uint8_t ditSpread;
+                uint8_t dahSpread;
+                uint8_t spaceSpread;
+                uint16_t charSpace;
+                uint16_t wordSpace;
+        };
+
+        FistAnalyzer();
+        void clear();
+        void mark(boolean dah, unsigned long ms);
+        void space(unsigned long ms);
+        const Stat& get(Kind kind);
+        uint16_t getMean(Kind kind);
+        uint16_t getDeviation(Kind kind);
+        Report getReport(uint8_t wpm);
+
+        static void add(Stat &stat, float x);
+        static uint32_t squareRoot(uint32_t x);
+
+    private:
+        Stat stats[KINDS];
+
+        static uint8_t spread(const Stat &stat);
+};
+
+#endif /* FISTANALYZER_H_ */
@@ -0,0 +1,187 @@
+/******************************************************************************************************************************
+ *  morse_3 Software for the Morserino-32 multi-functional Morse code machine, based on the Heltec WiFi LORA (ESP32) module ***
+ *  Copyright (C) 2018  Willi Kraml, OE1WKL                                                                                 ***
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this program.
+ *  If not, see <https://www.gnu.org/licenses/>.
+ *****************************************************************************************************************************/
+#include <string.h>
+#include "HeadCopyScorer.h"
+
+HeadCopyScorer::HeadCopyScorer()
+{
+    word[0] = response[0] = 0;
+    responseLength = 0;
+    waiting = false;
+    ended = first = last = 0;
+    begin(MAX_LENGTH, 20);
+}
+
+/// begin starts on level 0, with words of up to length characters (0 or more than MAX_LENGTH: MAX_LENGTH) at wpm
+void HeadCopyScorer::begin(uint8_t l, uint8_t w)
+{
+    startLength = l && l < MAX_LENGTH ? (l > MIN_LENGTH ? l : MIN_LENGTH) : MAX_LENGTH;
+    startWpm = w < MIN_WPM ? MIN_WPM : w > MAX_WPM ? MAX_WPM : w;
+    backoff = 0;
+    setLevel(0);
+}
+
+/// wordEnd starts waiting for the answer to word
+void HeadCopyScorer::wordEnd(const char *w, unsigned long now)
+{
+    strncpy(word, w, CharStats::MAX_WORD);
+    word[CharStats::MAX_WORD] = 0;
+    response[0] = 0;
+    responseLength = 0;
+    waiting = true;
+    ended = now;
+    first = last = 0;
+}
+
+/// character adds a keyed character (a pro sign is one character, in internal form) to the answer
+void HeadCopyScorer::character(const char *symbol, unsigned long now)
+{
+    if (!waiting)
+    {
+        return;
+    }
+    if (!responseLength)
+    {
+        first = now;
+    }
+    last = now;
+    for (; *symbol && responseLength < CharStats::MAX_WORD; ++symbol)
+    {
+        response[responseLength++] = *symbol;
+    }
+    response[responseLength] = 0;
+}
+
+boolean HeadCopyScorer::isWaiting()
+{
+    return waiting;
+}
+
+/// isTimedOut: nothing has been keyed since the word ended, for TIMEOUT ms
+boolean HeadCopyScorer::isTimedOut(unsigned long now)
+{
+    return waiting && !responseLength && now - ended >= TIMEOUT;
+}
+
+/// evaluate scores the answer, and moves the level on
+HeadCopyScorer::Result HeadCopyScorer::evaluate(unsigned long now)
+{
+    Result r;
+
+    r.distance = getDistance(word, response);
+    r.score = score(word, response);
+    r.right = r.distance == 0;
+    r.latencyMs = responseLength ? (first - ended < 0xffff ? first - ended : 0xffff) : 0;
+    r.responseMs = responseLength ? last - ended : now - ended;
+    waiting = false;
+
+    scoreSum += r.score;
+    ++words;
+    r.levelChanged = false;
+    if (words >= WINDOW)
+    {
+        uint8_t average = scoreSum / words;
+        if (average < DOWN)
+        {
+            setLevel(level - 1);
+            backoff = backoff < MAX_BACKOFF ? backoff + 1 : backoff;
+            r.levelChanged = true;
+        }
+        else if (words >= WINDOW << backoff && average >= UP)
+        {
+            setLevel(level + 1);
+            r.levelChanged = true;
+        }
+        else if (words >= WINDOW << backoff)
+        {
+            scoreSum = words = 0;       // a new window on the same level
+        }
+    }
+    return r;
+}
+
+const char* HeadCopyScorer::getWord()
+{
+    return word;
+}
+
+const char* HeadCopyScorer::getResponse()
+{
+    return response;
+}
+
+int8_t HeadCopyScorer::getLevel()
+{
+    return level;
+}
+
+/// getLength is the longest word that should be sent on this level
+uint8_t HeadCopyScorer::getLength()
+{
+    return length;
+}
+
+uint8_t HeadCopyScorer::getWpm()
+{
+    return wpm;
+}
+
+/// getAverage is the average score of the words on this level so far
+uint8_t HeadCopyScorer::getAverage()
+{
+    return words ? scoreSum / words : 0;
+}
+
+/// score: the share of the characters of expected that response has got right, in percent
+uint8_t HeadCopyScorer::score(const char *expected, const char *response)
+{
+    uint8_t n = strnlen(expected, CharStats::MAX_WORD);
+    uint8_t distance = getDistance(expected, response);
+
+    return distance < n ? (n - distance) * 100 / n : 0;
+}
+
+/// getDistance is the number of edits that turn expected into response
+uint8_t HeadCopyScorer::getDistance(const char *expected, const char *response)
+{
+    CharStats::Edit edits[2 * CharStats::MAX_WORD];
+    uint8_t steps = CharStats::align(expected, response, edits);
+    uint8_t distance = 0;
+
+    for (int i = 0; i < steps; ++i)
+    {
+        distance += edits[i] != CharStats::MATCH;
+    }
+    return distance;
+}
+
+/// setLevel works out length and speed of a level: on the way up, odd steps make the words longer, even ones faster;
+/// on the way down, odd steps make them slower, even ones shorter - and where the length cannot change, the speed does
+void HeadCopyScorer::setLevel(int8_t l)
+{
+    int lengthSteps = l > 0 ? (l + 1) / 2 : l / 2;
+    int newLength = startLength + lengthSteps;
+
+    newLength = newLength < MIN_LENGTH ? MIN_LENGTH : newLength > MAX_LENGTH ? MAX_LENGTH : newLength;
+    int newWpm = startWpm + l - (newLength - startLength);
+
+    scoreSum = words = 0;
+    if (newWpm < MIN_WPM || newWpm > MAX_WPM)
+    {
+        return;                         // as easy (or as hard) as it gets: stay
+    }
+    level = l;
+    length = newLength;
+    wpm = newWpm;
+}
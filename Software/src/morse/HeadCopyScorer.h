@@ -0,0 +1,91 @@
+/*
+ * HeadCopyScorer.h
+ *
+ *  Head copying with a keyed answer: takes the answer, scores it against the word that was sent, and makes the
+ *  next words longer or faster as long as the user copies well (and shorter or slower when not).
+ */
+
+#ifndef HEADCOPYSCORER_H_
+#define HEADCOPYSCORER_H_
+
+#include "arduino.h"
+#include "CharStats.h"
+
+/// wordEnd() is called when the generator has sent a word; the answer is keyed after that, one character() at a time,
+/// and evaluate() is called at the end of the keyed word - or when isTimedOut(): nothing has been keyed for TIMEOUT ms
+/// after the word.
+///
+/// The answer is aligned with the word the way the echo trainer does it (CharStats::align), and the score is the share
+/// of the characters of the word that did not need an edit: 100 for a perfect copy, 0 if nothing fits. The latency is
+/// the time from the end of the word to the first character keyed (so it includes keying that character); the response
+/// time is the time to the last one.
+///
+/// The difficulty is a level: each level up makes the words one character longer or the speed one WpM faster, in
+/// turns, starting with the length - until the words are MAX_LENGTH long; from then on it is the speed only. Each
+/// level down takes the last step back. After WINDOW words on a level, if their average score is less than DOWN, the
+/// level goes down; if it is UP or more, it goes up - but after each step down it takes twice as many words (up to
+/// 2^MAX_BACKOFF times WINDOW) to go up again. Otherwise a user at the edge of what they can copy would spend every
+/// other window on a level that is too hard.
+
+class HeadCopyScorer
+{
+    public:
+        static const uint8_t WINDOW = 8;
+        static const uint8_t UP = 90;               /// percent
+        static const uint8_t DOWN = 60;
+        static const uint8_t MAX_BACKOFF = 3;
+        static const uint8_t MIN_LENGTH = 2;
+        static const uint8_t MAX_LENGTH = 6;
+        static const uint8_t MIN_WPM = 5;
+        static const uint8_t MAX_WPM = 60;
+        static const unsigned long TIMEOUT = 8000;  /// ms
+
+        struct Result
+        {
+                boolean right;
+                uint8_t score;
+                uint8_t distance;
+                uint16_t latencyMs;
+                uint32_t responseMs;
+                boolean levelChanged;
+        };
+
+        HeadCopyScorer();
+        void begin(uint8_t length, uint8_t wpm);
+        void wordEnd(const char *word, unsigned long now);
+        void character(const char *symbol, unsigned long now);
+        boolean isWaiting();
+        boolean isTimedOut(unsigned long now);
+        Result evaluate(unsigned long now);
+        const char* getWord();
+        const char* getResponse();
+        int8_t getLevel();
+        uint8_t getLength();
+        uint8_t getWpm();
+        uint8_t getAverage();
+
+        static uint8_t score(const char *expected, const char *response);
+        static uint8_t getDistance(const char *expected, const char *response);
+
+    private:
+        char word[CharStats::MAX_WORD + 1];
+        char response[CharStats::MAX_WORD + 1];
+        uint8_t responseLength;
+        boolean waiting;
+        unsigned long ended;            // when the word was sent
+        unsigned long first;            // when the first character was keyed
+        unsigned long last;             // ... and the last one
+
+        uint8_t startLength;
+        uint8_t startWpm;
+        int8_t level;
+        uint8_t length;
+        uint8_t wpm;
+        uint16_t scoreSum;              // of the words on this level
+        uint8_t words;
+        uint8_t backoff;                // steps down so far: it takes WINDOW << backoff words to go up
+
+        void setLevel(int8_t l);
+};
+
+#endif /* HEADCOPYSCORER_H_ */
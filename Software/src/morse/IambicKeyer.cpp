@@ -0,0 +1,316 @@
+/******************************************************************************************************************************
+ *  morse_3 Software for the Morserino-32 multi-functional Morse code machine, based on the Heltec WiFi LORA (ESP32) module ***
+ *  Copyright (C) 2018  Willi Kraml, OE1WKL                                                                                 ***
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this program.
+ *  If not, see <https://www.gnu.org/licenses/>.
+ *****************************************************************************************************************************/
+#include "IambicKeyer.h"
+
+const uint32_t MAX_AGE = 0x40000000;               // older releases are moved up, so that comparisons never wrap
+
+/// what comes after an element space, by the paddle latches (keyerControl & 3)
+const uint8_t IambicKeyer::latchTable[4] =
+{
+    IDLE_STATE,                 // none latched: end of character
+    DIT,                        // dit only is latched, regardless what was last element
+    DAH,                        // dah only latched, regardless what was last element
+    SQUEEZE                     // both paddles are latched - up to the keyer mode
+};
+
+/// the keyer modes; squeeze is the next element when both paddles are latched, by [first element was a dit][last was a dit]
+const IambicKeyer::ModeRule IambicKeyer::modeRules[MODES] =
+{
+    { EARLY_NONE,   { { DIT, DAH }, { DIT, DAH } } },   // (invalid mode - as IAMBICA)
+    { EARLY_NONE,   { { DIT, DAH }, { DIT, DAH } } },   // IAMBICA: the opposite of the last element
+    { EARLY_CURTIS, { { DIT, DAH }, { DIT, DAH } } },   // IAMBICB: the same, but the opposite paddle is latched during the element already
+    { EARLY_NONE,   { { DIT, DIT }, { DAH, DAH } } },   // ULTIMATIC: the opposite of the first element
+    { EARLY_FIXED,  { { DAH, DAH }, { DIT, DIT } } }    // NONSQUEEZE: the first element again
+};
+
+IambicKeyer::IambicKeyer()
+{
+    client = 0;
+    config.mode = IAMBICB;
+    config.didah = true;
+    config.ditLength = 60;
+    config.curtisBTiming = 35;
+    config.curtisBDotTiming = 75;
+    config.latency = 4;
+    config.acsLength = 0;
+    for (int i = 0; i < 2; ++i)
+    {
+        raw[i] = false;
+        down[i] = false;
+        pressedAt[i] = 0;
+        released[i] = 0;
+    }
+    reset(1);
+}
+
+void IambicKeyer::setConfig(const Config &c)
+{
+    config = c;
+}
+
+/// reset puts the state machine back into IDLE_STATE and forgets everything the paddles did before now
+void IambicKeyer::reset(uint32_t now)
+{
+    state = IDLE_STATE;
+    keyerControl = 0;
+    ditFirst = false;
+    acsTimer = now;
+    idleSince = now;
+    lastUpdate = now;
+}
+
+/// paddleEdge records an edge of the left or right paddle; in non-squeeze mode the second paddle
+/// of a squeeze is ignored - the keyer keeps seeing the first one only, as long as both are pressed
+void IambicKeyer::paddleEdge(uint8_t paddle, boolean pressed, uint32_t time)
+{
+    raw[paddle] = pressed;
+    if (config.mode == NONSQUEEZE && raw[0] && raw[1])
+    {
+        return;
+    }
+    for (int i = 0; i < 2; ++i)
+    {
+        if (!down[i] && raw[i])
+        {
+            pressedAt[i] = time;
+        }
+        else if (down[i] && !raw[i] && time != pressedAt[i])
+        {   // (when both paddles of a squeeze are released at once, the first one was not pressed at all)
+            released[i] = time;
+        }
+        down[i] = raw[i];
+    }
+}
+
+/// update runs the state machine as far as it can get at this time; returns true while a paddle latch is set
+boolean IambicKeyer::update(uint32_t now)
+{
+    for (int i = 0; i < 2; ++i)
+    {
+        if (now - released[i] > MAX_AGE)
+        {
+            released[i] = now - MAX_AGE;
+        }
+    }
+
+    while (step(now))
+        ;
+
+    return (keyerControl & (DIT_L | DAH_L)) != 0;   // true as long as we are processing a paddle press
+}
+
+/// getWakeTime tells when update() has to be called next if no paddle edge arrives in between; false if
+/// only a paddle edge (or the client, in IDLE_STATE) can change anything. The latches do not need a call at
+/// the Curtis or latency time, they are decided from the edge times later.
+boolean IambicKeyer::getWakeTime(uint32_t &at)
+{
+    switch (state)
+    {
+        case IDLE_STATE:
+            return false;
+        case DIT:
+        case DAH:
+            at = acsTimer + 1;
+            return true;
+        case KEYED:
+            at = ktimer + 1;
+            return true;
+        case INTER_ELEMENT:
+            at = ((int32_t) (latencytimer - ktimer) > 0 ? latencytimer : ktimer) + 1;
+            return true;
+        default:
+            at = lastUpdate;
+            return true;
+    }
+}
+
+/// step does one transition of the state machine; returns true if the new state has to be looked at right away
+boolean IambicKeyer::step(uint32_t now)
+{
+    const ModeRule &rule = modeRules[config.mode < MODES ? config.mode : 0];
+    uint32_t dit = config.ditLength * 1000;
+
+    lastUpdate = now;
+    switch (state)
+    {                                         // this is the keyer state machine
+        case IDLE_STATE:
+        {
+            if ((int32_t) (now - acsTimer) > 0)
+            {
+                acsTimer = now;
+            }
+            // Was there a paddle press?
+            boolean ditPressed = activeSince(false, idleSince);
+            boolean dahPressed = activeSince(true, idleSince);
+            if (client->onIdle(ditPressed || dahPressed))
+            {
+                return false;
+            }
+            if (!(ditPressed || dahPressed))
+            {
+                idleSince = now;
+                return false;           // no paddle press in IDLE STATE - Arduino can do other tasks for a bit
+            }
+
+            updatePaddleLatch(ditPressed, dahPressed);  // trigger the paddle latches
+            client->onCharacterStart();
+            ditFirst = ditPressed;                      // first paddle pressed after IDLE was a DIT?
+            setElement(ditPressed ? DIT : DAH);
+            return true;
+        }
+
+        case DIT:
+        case DAH:
+        {
+            /// first we check that we have waited as defined by ACS settings
+            if (config.acsLength > 0 && (int32_t) (now - acsTimer) <= 0)
+            { // if we do automatic character spacing, and haven't waited for (3 or whatever) dits...
+                return false;
+            }
+            uint32_t length = state == DIT ? dit : 3 * dit;
+            uint8_t curtisTiming = state == DIT ? config.curtisBDotTiming : config.curtisBTiming;
+
+            clearLatches(now);                              // always clear the paddle latches at beginning of new element
+            keyerControl = state == DIT ? keyerControl | DIT_LAST : keyerControl & ~DIT_LAST;   // remember what we process
+            ktimer = now + length;                          // element end time
+            switch (rule.earlyLatch)
+            {
+                case EARLY_CURTIS:
+                    curtistimer = now + 2000 + length * curtisTiming / 100;  // enhanced Curtis mode B starts checking after some time
+                    break;
+                case EARLY_FIXED:
+                    curtistimer = now + 3000;
+                    break;
+                default:
+                    curtistimer = ktimer;                   // no early paddle checking
+                    break;
+            }
+            state = KEY_START;
+            return true;
+        }
+
+        case KEY_START:
+            // Assert key down, state shared for dit or dah
+            client->keyDown();
+            state = KEYED;                          // next state
+            return true;
+
+        case KEYED:
+            if ((int32_t) (now - ktimer) <= 0)
+            {
+                return false;
+            }
+            // end of key down
+            client->keyUp();
+            ktimer = now + dit;                     // inter-element time
+            latencytimer = now + ((int) config.latency - 1) * (int32_t) dit / 8;
+            state = INTER_ELEMENT;                  // next state
+            return true;
+
+        case INTER_ELEMENT:
+        {
+            if ((int32_t) (now - latencytimer) < 0 || (int32_t) (now - ktimer) <= 0)
+            {
+                return false;
+            }
+            // the opposite paddle counts from the Curtis time on (during the element, if the mode checks early);
+            // the paddle of the last element is muted until the latency time is off
+            if (keyerControl & DIT_LAST)
+            {
+                updatePaddleLatch(activeSince(false, latencytimer), activeSince(true, curtistimer));
+            }
+            else
+            {
+                updatePaddleLatch(activeSince(false, curtistimer), activeSince(true, latencytimer));
+            }
+
+            uint8_t next = latchTable[keyerControl & (DIT_L | DAH_L)];
+            if (next == SQUEEZE)
+            {
+                next = rule.squeeze[ditFirst][(keyerControl & DIT_LAST) != 0];
+            }
+            if (next != IDLE_STATE)
+            {
+                setElement((State) next);
+                return true;
+            }
+
+            state = IDLE_STATE;                         // we are at the end of the character and go back into IDLE STATE
+            client->onCharacterEnd();
+            if (config.acsLength > 0)
+            {
+                acsTimer = now + config.acsLength * dit;   // prime the ACS timer
+            }
+            keyerControl = 0;                           // clear all latches completely before we go to IDLE
+            idleSince = now;
+            return false;
+        }
+
+        default:
+            return false;
+    } // end switch state - end of state machine
+}
+
+/// activeSince is true if the dit (or dah) paddle has been pressed at any time since the given time
+boolean IambicKeyer::activeSince(boolean dah, uint32_t since)
+{
+    uint8_t p = (dah == config.didah) ? 1 : 0;          // swap left and right if necessary!
+    return down[p] || (int32_t) (released[p] - since) >= 0;
+}
+
+// update the paddle latches in keyerControl
+void IambicKeyer::updatePaddleLatch(boolean dit, boolean dah)
+{
+    if (dit)
+    {
+        keyerControl |= DIT_L;
+    }
+
+    if (dah)
+    {
+        keyerControl |= DAH_L;
+    }
+}
+
+/// clearLatches clears both paddle latches; presses before now are forgotten, too
+void IambicKeyer::clearLatches(uint32_t now)
+{
+    keyerControl &= ~(DIT_L + DAH_L);   // clear both paddle latch bits
+    if (state == IDLE_STATE)
+    {
+        idleSince = now;
+    }
+}
+
+/// setElement sets the DIT or DAH state and tells the client what comes
+void IambicKeyer::setElement(State element)
+{
+    state = element;
+    client->onElement(element == DAH);
+}
+
+boolean IambicKeyer::isPressed(uint8_t paddle)
+{
+    return down[paddle];
+}
+
+boolean IambicKeyer::isIdle()
+{
+    return state == IDLE_STATE;
+}
+
+IambicKeyer::State IambicKeyer::getState()
+{
+    return state;
+}
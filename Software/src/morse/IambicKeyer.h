@@ -0,0 +1,129 @@
+/*
+ * IambicKeyer.h
+ *
+ *  The iambic keyer state machine, fed with timestamped paddle edges.
+ */
+
+#ifndef IAMBICKEYER_H_
+#define IAMBICKEYER_H_
+
+#include "arduino.h"
+
+// defines for keyer modi
+//
+
+#define    IAMBICA      1
+// Curtis Mode A
+#define    IAMBICB      2
+// Curtis Mode B (with enhanced Curtis timing, set as parameter
+#define    ULTIMATIC    3
+// Ultimatic mode
+#define    NONSQUEEZE   4
+// Non-squeeze mode of dual-lever paddles - simulate a single-lever paddle
+
+/// The keyer does not sample the paddles: it gets every edge with the time it happened (paddleEdge()),
+/// and remembers for each paddle if it is down and when it was released last. When the state machine
+/// decides about a latch, it asks whether the paddle was pressed at any time since the start of the
+/// window that matters (activeSince()) - the Curtis B time within an element, the end of the latency time
+/// between elements, or the start of the idle state. Like that a short tap that begins and ends between
+/// two calls of update() is still latched, and a press that ended before the window opened is not, no
+/// matter how late update() is called.
+///
+/// The state machine does not know the keyer modes; what a mode does differently is in the table modeRules:
+/// when the opposite paddle is latched during an element, and which element follows a squeeze. update()
+/// runs all transitions that are due at once, so a paddle press is keyed in the same call, and
+/// getWakeTime() tells when the next call is needed.
+///
+/// Everything the keyer does to the outside world (sidetone and transmitter, decoder, display, LoRa)
+/// goes through the Client. All times are in µs (wrapping like micros()) and passed in by the caller.
+
+class IambicKeyer
+{
+    public:
+        enum State
+        {
+            IDLE_STATE, DIT, DAH, KEY_START, KEYED, INTER_ELEMENT
+        };
+
+        //  keyerControl bit definitions
+        static const uint8_t DIT_L = 0x01;         // Dit latch
+        static const uint8_t DAH_L = 0x02;         // Dah latch
+        static const uint8_t DIT_LAST = 0x04;      // Dit was last processed element
+
+        struct Config
+        {
+                uint8_t mode;                       /// IAMBICA, IAMBICB, ULTIMATIC or NONSQUEEZE
+                boolean didah;                      /// left paddle is dit
+                unsigned int ditLength;             /// in ms
+                uint8_t curtisBTiming;              /// % of a dah after which the opposite paddle is latched in mode B
+                uint8_t curtisBDotTiming;           /// the same for dits
+                uint8_t latency;                    /// paddles are muted for (latency - 1) / 8 dits after an element
+                uint8_t acsLength;                  /// automatic character spacing in dits, 0 = off
+        };
+
+        struct Client
+        {
+                virtual boolean onIdle(boolean pressed) = 0;    /// true: skip the paddles this time
+                virtual void onCharacterStart() = 0;
+                virtual void onElement(boolean dah) = 0;        /// next element has been chosen
+                virtual void keyDown() = 0;
+                virtual void keyUp() = 0;
+                virtual void onCharacterEnd() = 0;
+        };
+
+        IambicKeyer();
+        void setClient(Client *c) {client = c;};
+        void setConfig(const Config &c);
+        void reset(uint32_t now);
+        void paddleEdge(uint8_t paddle, boolean pressed, uint32_t time);
+        boolean update(uint32_t now);
+        boolean getWakeTime(uint32_t &at);
+        void clearLatches(uint32_t now);
+        boolean isPressed(uint8_t paddle);
+        boolean isIdle();
+        State getState();
+
+    private:
+        static const uint8_t MODES = 5;
+        static const uint8_t SQUEEZE = 0xff;        // both paddles latched, see ModeRule
+
+        enum EarlyLatch
+        {
+            EARLY_NONE,                             // the opposite paddle is latched after the element only
+            EARLY_CURTIS,                           // from a percentage of the element on (Curtis B timing)
+            EARLY_FIXED                             // 3 ms after the start of the element
+        };
+
+        struct ModeRule
+        {
+                uint8_t earlyLatch;
+                uint8_t squeeze[2][2];              /// next element by [first was dit][last was dit]
+        };
+
+        static const uint8_t latchTable[4];
+        static const ModeRule modeRules[MODES];
+
+        Client *client;
+        Config config;
+        State state;
+        uint8_t keyerControl;                       // this holds the latches for the paddles and the DIT_LAST latch, see above
+        boolean ditFirst;                           // first latched was dit?
+        uint32_t ktimer;                            // timer for current element (dit or dah)
+        uint32_t curtistimer;                       // timer for early paddle latch in Curtis mode B+
+        uint32_t latencytimer;                      // timer for "muting" paddles for some time in state INTER_ELEMENT
+        uint32_t acsTimer;                          // timer to use for automatic character spacing (ACS)
+        uint32_t lastUpdate;
+        uint32_t idleSince;                         // paddle presses before this time do not start a character
+
+        boolean raw[2];                             // what the paddles really do
+        boolean down[2];                            // what the keyer sees (differs in non-squeeze mode)
+        uint32_t pressedAt[2];                      // when the paddles (as the keyer sees them) were pressed last
+        uint32_t released[2];                       // when the paddles were released last
+
+        boolean activeSince(boolean dah, uint32_t since);
+        boolean step(uint32_t now);
+        void updatePaddleLatch(boolean dit, boolean dah);
+        void setElement(State element);
+};
+
+#endif /* IAMBICKEYER_H_ */
@@ -0,0 +1,94 @@
+/******************************************************************************************************************************
+ *  morse_3 Software for the Morserino-32 multi-functional Morse code machine, based on the Heltec WiFi LORA (ESP32) module ***
+ *  Copyright (C) 2018  Willi Kraml, OE1WKL                                                                                 ***
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this program.
+ *  If not, see <https://www.gnu.org/licenses/>.
+ *****************************************************************************************************************************/
+#include "JitterBuffer.h"
+
+JitterBuffer::JitterBuffer()
+{
+    reset();
+}
+
+void JitterBuffer::reset()
+{
+    lastArrival = 0;
+    lastDuration = 0;
+    target = 0;
+    jitter = 0;
+    lateness = 0;
+    maxLateness = 0;
+    inOver = false;
+    learned = false;
+}
+
+/// onArrival is called for every received word; duration is the time it takes to play it (including
+/// the following inter-word space), newOver tells if this word starts a new over
+void JitterBuffer::onArrival(unsigned long now, unsigned long duration, boolean newOver)
+{
+    if (newOver || !inOver)
+    {
+        finishOver();
+        inOver = true;
+    }
+    else
+    {
+        /// how much later than needed for back to back playout did this word arrive?
+        long d = (long) (now - lastArrival) - (long) lastDuration;
+        unsigned long absD = d < 0 ? -d : d;
+        jitter += absD - ((jitter + 8) >> 4);
+
+        lateness += d;
+        if (lateness > maxLateness)
+        {
+            maxLateness = lateness;
+        }
+    }
+    lastArrival = now;
+    lastDuration = duration;
+}
+
+void JitterBuffer::finishOver()
+{
+    if (!inOver)
+    {
+        return;
+    }
+
+    unsigned long needed = maxLateness;
+    if (!learned)
+    {
+        target = needed;
+        learned = true;
+    }
+    else if (needed > target)
+    {
+        target = (target + needed) / 2;            // grow fast
+    }
+    else
+    {
+        target = (7 * target + needed) / 8;        // and shrink slowly
+    }
+    lateness = 0;
+    maxLateness = 0;
+}
+
+/// getTargetDelay returns by how much the first word of an over should be held back
+unsigned long JitterBuffer::getTargetDelay()
+{
+    unsigned long t = learned ? target : 2 * getJitter();
+    return t < MAX_DELAY ? t : MAX_DELAY;
+}
+
+unsigned long JitterBuffer::getJitter()
+{
+    return jitter >> 4;
+}
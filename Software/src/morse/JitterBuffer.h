@@ -0,0 +1,45 @@
+/*
+ * JitterBuffer.h
+ *
+ *  Adaptive playout delay for words received via LoRa.
+ */
+
+#ifndef JITTERBUFFER_H_
+#define JITTERBUFFER_H_
+
+#include "arduino.h"
+
+/// Words of an over are played back to back, so a word that arrives later than the end of the previous
+/// word causes a gap. For every word we measure how much later it arrived than back to back playout of
+/// the over would have needed it (its lateness); the largest lateness within an over is the delay that
+/// would have made the over gap-free. The target delay follows this value - quickly when it grows,
+/// slowly when it shrinks - and the first word of the next over is held back by the target delay.
+///
+/// In addition the inter-arrival jitter is estimated like in RFC 3550; it is used as long as no complete
+/// over has been seen.
+
+class JitterBuffer
+{
+    public:
+        static const unsigned long MAX_DELAY = 3000;
+
+        JitterBuffer();
+        void reset();
+        void onArrival(unsigned long now, unsigned long duration, boolean newOver);
+        unsigned long getTargetDelay();
+        unsigned long getJitter();
+
+    private:
+        unsigned long lastArrival;
+        unsigned long lastDuration;
+        unsigned long target;
+        unsigned long jitter;           /// scaled by 16, as in RFC 3550
+        long lateness;
+        long maxLateness;
+        boolean inOver;
+        boolean learned;
+
+        void finishOver();
+};
+
+#endif /* JITTERBUFFER_H_ */
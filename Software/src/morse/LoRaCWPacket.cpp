@@ -0,0 +1,188 @@
+/******************************************************************************************************************************
+ *  morse_3 Software for the Morserino-32 multi-functional Morse code machine, based on the Heltec WiFi LORA (ESP32) module ***
+ *  Copyright (C) 2018  Willi Kraml, OE1WKL                                                                                 ***
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this program.
+ *  If not, see <https://www.gnu.org/licenses/>.
+ *****************************************************************************************************************************/
+#include "LoRaCWPacket.h"
+
+/// start a brand new word - clear buffer and set header, station and speed first
+void LoRaCWPacket::Encoder::start(uint8_t version, uint8_t serial, uint8_t station, uint8_t wpm)
+{
+    for (int i = 0; i < TX_BUFFER_SIZE; ++i)
+    {
+        buffer[i] = (char) 0;
+    }
+
+    buffer[0] = (char) ((version << 6) | (serial & 0x3f));
+    if (version == VERSION_2)
+    {
+        buffer[1] = (char) (station ? station : 1);
+        buffer[2] = (char) (wpm << 2);
+        pairCounter = 11;         /// 4 pairs header, 4 pairs station, 3 pairs wpm
+    }
+    else
+    {
+        buffer[1] = (char) (wpm << 2);
+        pairCounter = 7;          /// 4 pairs header, 3 pairs wpm
+    }
+    firstPair = pairCounter;
+    started = true;
+}
+
+/// addElement packs one element into the buffer; returns true when the word is complete (element 3)
+/// and the buffer is ready for sending
+boolean LoRaCWPacket::Encoder::addElement(uint8_t element)
+{
+    uint8_t temp = element & 0x03;
+
+    if (temp == 3)
+    {
+        /// we got end of character (0) before, so step back and overwrite it with end of word
+        /// - unless it is in the topmost bits of a byte: then the byte is 0 and terminates the packet anyway
+        if (pairCounter > firstPair)
+        {
+            --pairCounter;
+            if (pairCounter % 4 != 0)
+            {
+                buffer[pairCounter / 4] |= (char) (temp << (2 * (3 - (pairCounter % 4))));
+            }
+        }
+        started = false;
+        return true;
+    }
+
+    if (pairCounter / 4 >= TX_BUFFER_SIZE - 1)
+    {
+        /// word too long - keep the terminating 0 byte and drop the rest
+        return false;
+    }
+
+    if (temp)
+    {
+        buffer[pairCounter / 4] |= (char) (temp << (2 * (3 - (pairCounter % 4))));
+    }
+    ++pairCounter;
+    return false;
+}
+
+boolean LoRaCWPacket::Encoder::isStarted()
+{
+    return started;
+}
+
+char* LoRaCWPacket::Encoder::getBuffer()
+{
+    return buffer;
+}
+
+/// decodeHeader checks protocol version and speed; returns false if the packet is not a valid CW packet
+boolean LoRaCWPacket::decodeHeader(const uint8_t *data, uint8_t length, Header &header)
+{
+    if (length < 2)
+    {
+        return false;
+    }
+
+    header.version = data[0] >> 6;
+    header.serial = data[0] & 0x3f;
+
+    switch (header.version)
+    {
+        case VERSION_1:
+        {
+            header.station = STATION_UNKNOWN;
+            header.wpm = data[1] >> 2;
+            break;
+        }
+        case VERSION_2:
+        {
+            if (length < 3)
+            {
+                return false;
+            }
+            header.station = data[1];
+            header.wpm = data[2] >> 2;
+            break;
+        }
+        default:
+        {
+            return false;
+        }
+    }
+
+    /// wpm must be between 5 and 60; values 00 - 04 and 61 to 63 are invalid
+    return (header.wpm >= 5) && (header.wpm <= 60);
+}
+
+/// decodeElements stores the elements of the packet as ASCII characters '0', '1' and '2' in elements,
+/// terminated with a 0 byte; returns the number of elements
+uint16_t LoRaCWPacket::decodeElements(const uint8_t *data, uint8_t length, char *elements, uint16_t size)
+{
+    uint16_t n = 0;
+    uint8_t wpmByte = ((data[0] >> 6) == VERSION_2) ? 2 : 1;
+
+    if (size == 0)
+    {
+        return 0;
+    }
+
+    for (uint8_t i = wpmByte; i < length; ++i)
+    {
+        uint8_t c = data[i];
+        /// the wpm byte carries just one element in its last two bits
+        for (int j = (i == wpmByte ? 3 : 0); j < 4; ++j)
+        {
+            char cc = (c >> (2 * (3 - j))) & 0x03;
+            if (cc == 3 || n + 1 >= size)
+            {
+                elements[n] = 0;
+                return n;
+            }
+            elements[n++] = (char) (cc + '0');
+        }
+    }
+    elements[n] = 0;
+    return n;
+}
+
+/// durationDits returns the length of a word in dit units, including the following inter-word space
+uint16_t LoRaCWPacket::durationDits(const char *elements)
+{
+    uint16_t dits = 0;
+    for (const char *p = elements; *p; ++p)
+    {
+        switch (*p)
+        {
+            case '1':
+                dits += 2;              /// dit + inter-element space
+                break;
+            case '2':
+                dits += 4;              /// dah + inter-element space
+                break;
+            case '0':
+                dits += 2;              /// inter-element space becomes inter-character space
+                break;
+        }
+    }
+    return dits + 6;                    /// inter-element space becomes inter-word space
+}
+
+/// stationFromId folds an arbitrary id (e.g. the MAC address) into a station id between 1 and 255
+uint8_t LoRaCWPacket::stationFromId(const uint8_t *id, uint8_t length)
+{
+    uint32_t hash = 2166136261u;        /// FNV-1a
+    for (uint8_t i = 0; i < length; ++i)
+    {
+        hash ^= id[i];
+        hash *= 16777619u;
+    }
+    return (uint8_t) (1 + (hash ^ (hash >> 8) ^ (hash >> 16) ^ (hash >> 24)) % 255);
+}
@@ -0,0 +1,65 @@
+/*
+ * LoRaCWPacket.h
+ *
+ *  Encoder and decoder for the CW over LoRa packet format.
+ */
+
+#ifndef LORACWPACKET_H_
+#define LORACWPACKET_H_
+
+#include "arduino.h"
+
+/// A CW over LoRa packet carries exactly one word. Elements are packed as bit pairs:
+///   1 = dit, 2 = dah, 0 = end of character, 3 = end of word (or simply the end of the packet)
+///
+/// Version 1 (the original protocol):
+///   byte 0: protocol version (2 bits) + 6 bit serial number
+///   byte 1: wpm (6 bits) + first element
+///   byte 2..: elements
+///
+/// Version 2 (net protocol, adds a station id so that receivers can separate several senders):
+///   byte 0: protocol version (2 bits) + 6 bit serial number
+///   byte 1: station id (1..255; 0 is never sent as the packet is handled like a C string)
+///   byte 2: wpm (6 bits) + first element
+///   byte 3..: elements
+
+class LoRaCWPacket
+{
+    public:
+        static const uint8_t VERSION_1 = 1;
+        static const uint8_t VERSION_2 = 2;
+        static const uint8_t STATION_UNKNOWN = 0;      /// used for packets from version 1 senders
+        static const uint8_t MAX_LENGTH = 48;          /// longer packets are discarded by the receiver
+        static const uint8_t TX_BUFFER_SIZE = 32;
+        static const uint16_t MAX_ELEMENTS = 4 * MAX_LENGTH;
+
+        struct Header
+        {
+                uint8_t version;
+                uint8_t serial;
+                uint8_t station;
+                uint8_t wpm;
+        };
+
+        class Encoder
+        {
+            public:
+                void start(uint8_t version, uint8_t serial, uint8_t station, uint8_t wpm);
+                boolean addElement(uint8_t element);
+                boolean isStarted();
+                char* getBuffer();
+
+            private:
+                char buffer[TX_BUFFER_SIZE];
+                uint8_t pairCounter = 0;
+                uint8_t firstPair = 0;
+                boolean started = false;
+        };
+
+        static boolean decodeHeader(const uint8_t *data, uint8_t length, Header &header);
+        static uint16_t decodeElements(const uint8_t *data, uint8_t length, char *elements, uint16_t size);
+        static uint16_t durationDits(const char *elements);
+        static uint8_t stationFromId(const uint8_t *id, uint8_t length);
+};
+
+#endif /* LORACWPACKET_H_ */
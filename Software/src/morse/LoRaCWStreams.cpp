@@ -0,0 +1,287 @@
+/******************************************************************************************************************************
+ *  morse_3 Software for the Morserino-32 multi-functional Morse code machine, based on the Heltec WiFi LORA (ESP32) module ***
+ *  Copyright (C) 2018  Willi Kraml, OE1WKL                                                                                 ***
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this program.
+ *  If not, see <https://www.gnu.org/licenses/>.
+ *****************************************************************************************************************************/
+#include "LoRaCWStreams.h"
+
+LoRaCWStreams::LoRaCWStreams()
+{
+    clear();
+}
+
+void LoRaCWStreams::clear()
+{
+    for (int i = 0; i < MAX_STREAMS; ++i)
+    {
+        streams[i].used = false;
+        streams[i].count = 0;
+        streams[i].head = 0;
+    }
+    current = NO_STREAM;
+    stats = Stats();
+    version2Heard = false;
+}
+
+/// push stores a received packet in the stream of its sender; returns false if the packet
+/// is invalid or there is no room for it
+boolean LoRaCWStreams::push(const uint8_t *data, uint8_t length, int rssi, unsigned long now)
+{
+    LoRaCWPacket::Header header;
+
+    if (length > LoRaCWPacket::MAX_LENGTH || !LoRaCWPacket::decodeHeader(data, length, header))
+    {
+        return false;
+    }
+    ++stats.received;
+    version2Heard = version2Heard || header.version == LoRaCWPacket::VERSION_2;
+
+    uint8_t s = findStream(header.station, now);
+    if (s == NO_STREAM)
+    {
+        ++stats.dropped;
+        return false;
+    }
+
+    Stream &stream = streams[s];
+    boolean newOver = true;
+    if (!stream.used)
+    {
+        stream.used = true;
+        stream.station = header.station;
+        stream.head = 0;
+        stream.count = 0;
+        stream.avgGap = 0;
+        stream.gapDev = 0;
+        stream.jitter.reset();
+        stream.lastSerial = header.serial;
+    }
+    else
+    {
+        uint8_t ahead = (header.serial - stream.lastSerial) & 0x3f;
+        if (!ahead)
+        {   // the same packet again
+            return false;
+        }
+        if (ahead < 32)
+        {   // a gap forward: packets have been lost; a packet that comes late is not counted
+            stats.lost += ahead - 1;
+            stream.lastSerial = header.serial;
+        }
+
+        unsigned long gap = now - stream.lastArrival;
+        newOver = gap >= holdTime(s);
+        if (gap < MAX_HOLD)
+        {   // a pause within an over - pauses between overs would spoil the average
+            if (stream.avgGap)
+            {
+                unsigned long dev = gap > stream.avgGap ? gap - stream.avgGap : stream.avgGap - gap;
+                stream.gapDev = (3 * stream.gapDev + dev) / 4;
+                stream.avgGap = (7 * stream.avgGap + gap) / 8;
+            }
+            else
+            {
+                stream.avgGap = gap;
+                stream.gapDev = gap / 2;
+            }
+        }
+    }
+    stream.lastArrival = now;
+    stream.wpm = header.wpm;
+
+    char elements[LoRaCWPacket::MAX_ELEMENTS + 1];
+    LoRaCWPacket::decodeElements(data, length, elements, sizeof(elements));
+    stream.jitter.onArrival(now, LoRaCWPacket::durationDits(elements) * (1200 / header.wpm), newOver);
+
+    if (stream.count == SLOTS)
+    {
+        ++stats.dropped;
+        return false;
+    }
+
+    Word &w = stream.slots[(stream.head + stream.count) % SLOTS];
+    w.header = header;
+    w.rssi = rssi;
+    w.arrival = now;
+    w.firstOfOver = newOver;
+    w.length = length;
+    for (int i = 0; i < length; ++i)
+    {
+        w.data[i] = data[i];
+    }
+    ++stream.count;
+    return true;
+}
+
+/// next returns the word that should be played now, or 0 if there is nothing to play (yet);
+/// the returned word stays valid until the next call
+const LoRaCWStreams::Word* LoRaCWStreams::next(unsigned long now)
+{
+    uint8_t s = NO_STREAM;
+
+    if (current != NO_STREAM && streams[current].used)
+    {
+        Stream &stream = streams[current];
+        if (stream.count)
+        {
+            if (!isDue(current, now))
+            {
+                return 0;
+            }
+            s = current;
+        }
+        else if (now - stream.lastArrival < holdTime(current))
+        {   // the current station has not finished its over yet - keep the others waiting
+            return 0;
+        }
+    }
+
+    if (s == NO_STREAM)
+    {
+        s = oldestWaiting(now);
+        if (s == NO_STREAM)
+        {
+            return 0;
+        }
+        if (current != NO_STREAM && s != current)
+        {
+            ++stats.switches;
+        }
+        current = s;
+    }
+
+    Stream &stream = streams[s];
+    playing = stream.slots[stream.head];
+    stream.head = (stream.head + 1) % SLOTS;
+    --stream.count;
+    return &playing;
+}
+
+/// holdTime is how long we wait for the next word of the current over: clearly longer than the usual
+/// pause of this station, or - as long as we do not know it - the time of a long word (100 dits)
+unsigned long LoRaCWStreams::holdTime(uint8_t s)
+{
+    unsigned long hold;
+    if (streams[s].avgGap)
+    {
+        hold = streams[s].avgGap + 4 * streams[s].gapDev;
+        if (hold < 2 * streams[s].avgGap)
+        {   // words differ a lot in length, so do not trust a small deviation too much
+            hold = 2 * streams[s].avgGap;
+        }
+    }
+    else
+    {
+        hold = 100 * (1200 / streams[s].wpm);
+    }
+    return hold < MAX_HOLD ? hold : MAX_HOLD;
+}
+
+/// getTargetDelay returns the playout delay of the station that is playing right now
+unsigned long LoRaCWStreams::getTargetDelay()
+{
+    return current == NO_STREAM ? 0 : streams[current].jitter.getTargetDelay();
+}
+
+uint8_t LoRaCWStreams::getCurrentStation()
+{
+    return current == NO_STREAM ? LoRaCWPacket::STATION_UNKNOWN : streams[current].station;
+}
+
+boolean LoRaCWStreams::isEmpty()
+{
+    for (int i = 0; i < MAX_STREAMS; ++i)
+    {
+        if (streams[i].used && streams[i].count)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// hasHeardVersion2 is true once a packet of version 2 has been received - then the sender is not alone with it
+boolean LoRaCWStreams::hasHeardVersion2()
+{
+    return version2Heard;
+}
+
+LoRaCWStreams::Stats LoRaCWStreams::getStats()
+{
+    return stats;
+}
+
+/// findStream returns the stream of station; if there is none, a free stream or the one that has been
+/// silent for the longest time (and has nothing left to play)
+uint8_t LoRaCWStreams::findStream(uint8_t station, unsigned long now)
+{
+    uint8_t candidate = NO_STREAM;
+
+    for (int i = 0; i < MAX_STREAMS; ++i)
+    {
+        if (streams[i].used && streams[i].station == station)
+        {
+            return i;
+        }
+    }
+    for (int i = 0; i < MAX_STREAMS; ++i)
+    {
+        if (!streams[i].used)
+        {
+            return i;
+        }
+        if (streams[i].count || (i == current && now - streams[i].lastArrival < holdTime(i)))
+        {
+            continue;
+        }
+        if (candidate == NO_STREAM || now - streams[i].lastArrival > now - streams[candidate].lastArrival)
+        {
+            candidate = i;
+        }
+    }
+    if (candidate != NO_STREAM)
+    {
+        streams[candidate].used = false;
+        if (candidate == current)
+        {
+            current = NO_STREAM;
+        }
+    }
+    return candidate;
+}
+
+/// isDue is true if the next word of the stream may be played: the first word of an over
+/// waits for the target delay of the jitter buffer, all others are played as soon as possible
+boolean LoRaCWStreams::isDue(uint8_t s, unsigned long now)
+{
+    Word &w = streams[s].slots[streams[s].head];
+    return !w.firstOfOver || now - w.arrival >= streams[s].jitter.getTargetDelay();
+}
+
+/// oldestWaiting compares the ages of the words, not their arrival times, which wrap around with millis()
+uint8_t LoRaCWStreams::oldestWaiting(unsigned long now)
+{
+    uint8_t oldest = NO_STREAM;
+
+    for (int i = 0; i < MAX_STREAMS; ++i)
+    {
+        if (!streams[i].used || !streams[i].count || !isDue(i, now))
+        {
+            continue;
+        }
+        if (oldest == NO_STREAM
+                || now - streams[i].slots[streams[i].head].arrival > now - streams[oldest].slots[streams[oldest].head].arrival)
+        {
+            oldest = i;
+        }
+    }
+    return oldest;
+}
@@ -0,0 +1,90 @@
+/*
+ * LoRaCWStreams.h
+ *
+ *  Separates received CW over LoRa packets by sending station and decides which word is played next.
+ */
+
+#ifndef LORACWSTREAMS_H_
+#define LORACWSTREAMS_H_
+
+#include "arduino.h"
+#include "LoRaCWPacket.h"
+#include "JitterBuffer.h"
+
+/// Each sending station gets its own small FIFO of words (a stream). Playout is sequential: once a
+/// station has started an "over", its words are played until the station has been silent clearly
+/// longer than it usually pauses between words (average plus four times the mean deviation, like a TCP
+/// retransmission timer, but at least twice the average); only then the station with the oldest waiting word
+/// gets its turn. Like that two stations talking at the same time are played one after the other
+/// instead of word by word interleaved.
+///
+/// Every stream has its own jitter buffer: the first word of an over is held back by the target delay of
+/// its stream, so that the following words are there in time and can be played with even spacing.
+///
+/// All times are in ms and passed in by the caller, so the class can be used without hardware.
+
+class LoRaCWStreams
+{
+    public:
+        static const uint8_t MAX_STREAMS = 4;
+        static const uint8_t SLOTS = 12;                /// words per stream - enough to hold a longer over while another station is played
+        static const unsigned long MAX_HOLD = 8000;     /// never wait longer than this for the next word of an over
+        static const uint8_t NO_STREAM = 0xff;
+
+        struct Word
+        {
+                LoRaCWPacket::Header header;
+                int rssi;
+                unsigned long arrival;
+                boolean firstOfOver;
+                uint8_t length;
+                uint8_t data[LoRaCWPacket::MAX_LENGTH];
+        };
+
+        struct Stats
+        {
+                uint16_t received;
+                uint16_t dropped;           /// no free slot or stream
+                uint16_t lost;              /// gaps in the serial numbers
+                uint16_t switches;          /// how often playout changed to another station
+        };
+
+        LoRaCWStreams();
+        void clear();
+        boolean push(const uint8_t *data, uint8_t length, int rssi, unsigned long now);
+        const Word* next(unsigned long now);
+        unsigned long holdTime(uint8_t stream);
+        uint8_t getCurrentStation();
+        unsigned long getTargetDelay();
+        boolean isEmpty();
+        boolean hasHeardVersion2();
+        Stats getStats();
+
+    private:
+        struct Stream
+        {
+                boolean used;
+                uint8_t station;
+                uint8_t lastSerial;
+                uint8_t wpm;
+                uint8_t head;
+                uint8_t count;
+                unsigned long lastArrival;
+                unsigned long avgGap;       /// average time between two words of an over
+                unsigned long gapDev;       /// and its mean deviation
+                JitterBuffer jitter;
+                Word slots[SLOTS];
+        };
+
+        Stream streams[MAX_STREAMS];
+        uint8_t current;
+        Word playing;
+        Stats stats;
+        boolean version2Heard;
+
+        uint8_t findStream(uint8_t station, unsigned long now);
+        uint8_t oldestWaiting(unsigned long now);
+        boolean isDue(uint8_t stream, unsigned long now);
+};
+
+#endif /* LORACWSTREAMS_H_ */
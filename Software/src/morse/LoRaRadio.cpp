@@ -0,0 +1,93 @@
+/******************************************************************************************************************************
+ *  morse_3 Software for the Morserino-32 multi-functional Morse code machine, based on the Heltec WiFi LORA (ESP32) module ***
+ *  Copyright (C) 2018  Willi Kraml, OE1WKL                                                                                 ***
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this program.
+ *  If not, see <https://www.gnu.org/licenses/>.
+ *****************************************************************************************************************************/
+
+#include <Arduino.h>
+#include <SPI.h>           // library for SPI interface
+#include <LoRa.h>          // library for LoRa transceiver
+
+#include "morsedefs.h"
+#include "LoRaRadio.h"
+
+LoRaRadio *LoRaRadio::instance = 0;
+
+boolean LoRaRadio::begin(long frequency)
+{
+    instance = this;
+    SPI.begin(SCK, MISO, MOSI, SS);
+    LoRa.setPins(SS, RST, DI0);
+    if (!LoRa.begin(frequency, PABOOSTx))
+    {
+        return false;
+    }
+    LoRa.setFrequency(frequency);                       /// default = 434.150 MHz - Region 1 ISM Band, can be changed by system setup
+    LoRa.setSpreadingFactor(7);                         /// default
+    LoRa.setSignalBandwidth(250E3);                     /// 250 kHz
+    LoRa.noCrc();                                       /// we use error correction
+
+    // register the receive callback
+    LoRa.onReceive(onLoRaReceive);
+    return true;
+}
+
+void LoRaRadio::setSyncWord(uint8_t syncWord)
+{
+    LoRa.setSyncWord(syncWord);                         /// the default would be 0x34
+}
+
+void LoRaRadio::send(const uint8_t *data, uint8_t length)
+{
+    LoRa.beginPacket();
+    LoRa.write(data, length);
+    LoRa.endPacket();
+}
+
+void LoRaRadio::receive()
+{
+    LoRa.receive();
+}
+
+void LoRaRadio::idle()
+{
+    LoRa.idle();
+}
+
+void LoRaRadio::sleep()
+{
+    LoRa.sleep();
+}
+
+void LoRaRadio::onLoRaReceive(int packetSize)
+{
+    uint8_t buffer[MAX_PACKET];
+
+    // read packet - all of it, even if it is too long for us
+    for (int i = 0; i < packetSize; i++)
+    {
+        uint8_t c = LoRa.read();
+        if (i < MAX_PACKET)
+        {
+            buffer[i] = c;
+        }
+    }
+
+    if (packetSize > MAX_PACKET)
+    {
+        MORSELOGLN("LoRa Packet longer than 48 bytes! Discarded...");
+        return;
+    }
+    if (instance && instance->callback)
+    {
+        instance->callback(buffer, packetSize, LoRa.packetRssi());
+    }
+}
@@ -0,0 +1,27 @@
+/*
+ * LoRaRadio.h
+ *
+ *  The SX127x LoRa transceiver of the Heltec module.
+ */
+
+#ifndef LORARADIO_H_
+#define LORARADIO_H_
+
+#include "Radio.h"
+
+class LoRaRadio: public Radio
+{
+    public:
+        boolean begin(long frequency) override;
+        void setSyncWord(uint8_t syncWord) override;
+        void send(const uint8_t *data, uint8_t length) override;
+        void receive() override;
+        void idle() override;
+        void sleep() override;
+
+    private:
+        static void onLoRaReceive(int packetSize);
+        static LoRaRadio *instance;
+};
+
+#endif /* LORARADIO_H_ */
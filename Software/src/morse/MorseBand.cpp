@@ -0,0 +1,103 @@
+/******************************************************************************************************************************
+ *  morse_3 Software for the Morserino-32 multi-functional Morse code machine, based on the Heltec WiFi LORA (ESP32) module ***
+ *  Copyright (C) 2018  Willi Kraml, OE1WKL                                                                                 ***
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this program.
+ *  If not, see <https://www.gnu.org/licenses/>.
+ *****************************************************************************************************************************/
+
+#include "MorseBand.h"
+#include "MorseSound.h"
+#include "MorsePreferences.h"
+#include "MorseMachine.h"
+#include "MorseText.h"
+
+using namespace MorseBand;
+
+namespace internal
+{
+    const uint8_t MAX_QRM = 3;
+    const uint8_t qsbDepth[] = { 0, 40, 65, 90 };  // % for off, light, medium, deep
+
+    boolean active = false;
+    unsigned long nextQrm[MAX_QRM];                 // millis when the station sends again, once it is idle
+
+    void sendQrm(uint8_t voice);
+}
+
+/// start sets noise, QSB and QRM from the preferences, in the generator and in head copying; with none of them set,
+/// it stops them
+void MorseBand::start()
+{
+    MorsePreferences::MorsePrefs &p = MorsePreferences::prefs;
+    boolean wanted = (MorseMachine::morseState == MorseMachine::morseGenerator
+            || MorseMachine::morseState == MorseMachine::headCopying) && (p.bandNoise || p.qsb || p.qrm);
+
+    if (!wanted)
+    {
+        stop();
+        return;
+    }
+    MorseSound::startMixer(p.sidetoneVolume, true);
+    MorseSound::setNoise(p.bandNoise ? ((p.bandNoise - 1) % 5 + 1) * 6 : 0, p.bandNoise > 5);
+    MorseSound::setFading(internal::qsbDepth[p.qsb], random(4000, 12000));
+    MorseSound::mixerStopAll();
+    for (uint8_t i = 0; i < p.qrm; ++i)
+    {
+        internal::nextQrm[i] = millis() + random(500, 4000);
+    }
+    internal::active = true;
+}
+
+/// update lets the QRM stations send again when they are done; call it from the loop of the mode
+void MorseBand::update()
+{
+    if (!internal::active)
+    {
+        return;
+    }
+    for (uint8_t i = 0; i < MorsePreferences::prefs.qrm; ++i)
+    {
+        if (MorseSound::isMixerSending(i))
+        {
+            internal::nextQrm[i] = millis() + random(1000, 6000);
+        }
+        else if ((long) (millis() - internal::nextQrm[i]) >= 0)
+        {
+            internal::sendQrm(i);
+        }
+    }
+}
+
+void MorseBand::stop()
+{
+    if (!internal::active)
+    {
+        return;
+    }
+    MorseSound::setNoise(0, false);
+    MorseSound::setFading(0, 0);
+    MorseSound::stopMixer();
+    internal::active = false;
+}
+
+/// sendQrm lets a station call CQ or send its call twice, a bit off the pitch and the speed of the sidetone, and
+/// weaker than the sidetone
+void internal::sendQrm(uint8_t voice)
+{
+    String call = MorseText::getRandomCall(0);
+    String text = random(2) ? "cq cq de " + call + " " + call + " k" : call + " " + call;
+    int pitch = MorseSound::notes[MorsePreferences::prefs.sidetoneFreq];
+    int offset = random(150, 501);
+
+    pitch += random(2) ? offset : -offset;
+    MorseSound::mixerSend(voice, MorseText::toCode(text).c_str(), _max(250, pitch),
+            _max(5, MorsePreferences::prefs.wpm + (int) random(-6, 7)), random(8, 16), 0);
+    nextQrm[voice] = millis() + random(1000, 6000);
+}
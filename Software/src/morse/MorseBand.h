@@ -0,0 +1,15 @@
+#ifndef MORSEBAND_H_
+#define MORSEBAND_H_
+
+#include <Arduino.h>
+
+/// MorseBand makes the generator and head copying sound like a band: noise, fading of the signal (QSB) and other
+/// stations sending nearby (QRM), as set in the preferences; it needs the mixer of MorseSound
+namespace MorseBand
+{
+    void start();
+    void update();
+    void stop();
+}
+
+#endif /* MORSEBAND_H_ */
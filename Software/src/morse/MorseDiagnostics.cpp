@@ -0,0 +1,177 @@
+/******************************************************************************************************************************
+ *  morse_3 Software for the Morserino-32 multi-functional Morse code machine, based on the Heltec WiFi LORA (ESP32) module ***
+ *  Copyright (C) 2018  Willi Kraml, OE1WKL                                                                                 ***
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this program.
+ *  If not, see <https://www.gnu.org/licenses/>.
+ *****************************************************************************************************************************/
+
+#include "MorseDiagnostics.h"
+#include "MorseDisplay.h"
+#include "MorsePower.h"
+#include "MorseRotaryEncoder.h"
+#include "MorseSystem.h"
+#include "MorseUI.h"
+#include "Profiler.h"
+
+using namespace MorseDiagnostics;
+
+namespace internal
+{
+    uint32_t cycles();
+    uint8_t sectionCount();
+    unsigned long perSecond(unsigned long n, unsigned long us);
+    unsigned long percent(unsigned long part, unsigned long us);
+    void showLoad();
+    void showSections(uint8_t top);
+}
+
+uint32_t IRAM_ATTR internal::cycles()
+{
+    return ESP.getCycleCount();
+}
+
+void MorseDiagnostics::setup()
+{
+    Profiler::setCounter(internal::cycles, getCpuFrequencyMhz());
+}
+
+/// the diagnostics screen: p99 and max run time of the profiled sections in µs, three at a time, how often
+/// the main loop runs, how much of the time it sleeps, and the estimated current; encoder scrolls, RED sends everything as CSV over Serial, long RED clears the statistics, BLACK leaves
+boolean MorseDiagnostics::menuExec(String mode)
+{
+    uint8_t top = 0;
+    int t;
+
+    MorseDisplay::clearDisplay();
+    internal::showLoad();
+    internal::showSections(top);
+
+    while (true)
+    {
+        if ((t = MorseRotaryEncoder::checkEncoder()))
+        {
+            MorseUI::click();
+            int last = internal::sectionCount() > 3 ? internal::sectionCount() - 3 : 0;
+            top = constrain(top + t, 0, last);
+            internal::showSections(top);
+        }
+
+        MorseUI::modeButton.Update();
+        if (MorseUI::modeButton.clicks)
+        {
+            break;
+        }
+
+        MorseUI::volButton.Update();
+        switch (MorseUI::volButton.clicks)
+        {
+            case 1:
+                dumpCsv();
+                break;
+            case -1:
+                Profiler::resetAll();
+                MorseSystem::scheduler.resetStats();
+                internal::showLoad();
+                internal::showSections(top);
+                break;
+        }
+        MorseSystem::checkShutDown(false);      // possibly time-out: go to sleep
+    }
+    MorseDisplay::clear();
+    return false;
+}
+
+/// dumpCsv prints two tables: the profiled sections, and the tasks of the scheduler
+void MorseDiagnostics::dumpCsv()
+{
+    char line[80];
+
+    Serial.println(Profiler::CSV_HEADER);
+    for (Profiler::Section *s = Profiler::getFirst(); s; s = s->getNext())
+    {
+        Profiler::formatCsv(*s, line, sizeof(line));
+        Serial.println(line);
+    }
+
+    Serial.println("task,runs,avg_us,max_us,max_latency_us,overruns");
+    for (int i = 0; i < MorseSystem::scheduler.getTaskCount(); ++i)
+    {
+        Scheduler::Stats st = MorseSystem::scheduler.getStats(i);
+        Serial.printf("%s,%lu,%lu,%lu,%lu,%lu\n", MorseSystem::scheduler.getName(i), st.runs, st.runs ? st.totalTime / st.runs : 0,
+                st.maxTime, st.maxLatency, st.overruns);
+    }
+
+    Scheduler::Load load = MorseSystem::scheduler.getLoad();
+    Serial.println("loop,iterations_per_s,busy_pct,idle_pct");
+    Serial.printf("main,%lu,%lu,%lu\n", internal::perSecond(load.iterations, load.elapsed),
+            internal::percent(load.busy, load.elapsed), internal::percent(load.idle, load.elapsed));
+
+    PowerPolicy::Estimate power = MorsePower::policy.getEstimate(micros());
+    Serial.println("power,seconds,charge_uah,average_ua,light_sleep_pct");
+    Serial.printf("estimate,%lu,%lu,%lu,%u\n", power.seconds, power.microAmpHours, power.averageMicroAmps, power.sleepPercent);
+}
+
+uint8_t internal::sectionCount()
+{
+    uint8_t n = 0;
+    for (Profiler::Section *s = Profiler::getFirst(); s; s = s->getNext())
+    {
+        ++n;
+    }
+    return n;
+}
+
+unsigned long internal::perSecond(unsigned long n, unsigned long us)
+{
+    return us ? (unsigned long) ((uint64_t) n * 1000000 / us) : 0;
+}
+
+unsigned long internal::percent(unsigned long part, unsigned long us)
+{
+    return us ? (unsigned long) ((uint64_t) part * 100 / us) : 0;
+}
+
+/// showLoad puts loop iterations per second, the idle time and the estimated current on the status line;
+/// refreshed with the sections
+void internal::showLoad()
+{
+    Scheduler::Load load = MorseSystem::scheduler.getLoad();
+    PowerPolicy::Estimate power = MorsePower::policy.getEstimate(micros());
+    char line[24];
+
+    snprintf(line, sizeof(line), "%4lu/s %2lu%% %2lumA", perSecond(load.iterations, load.elapsed),
+            percent(load.idle, load.elapsed), power.averageMicroAmps / 1000);
+    MorseDisplay::printOnStatusLine(true, 0, line);
+}
+
+void internal::showSections(uint8_t top)
+{
+    uint8_t i = 0;
+    uint8_t line = 0;
+
+    MorseDisplay::clearScroll();
+    if (!Profiler::getFirst())
+    {
+        MorseDisplay::printOnScroll(0, REGULAR, 0, "No sections -");
+        MorseDisplay::printOnScroll(1, REGULAR, 0, "MORSE_PROFILING");
+        MorseDisplay::printOnScroll(2, REGULAR, 0, "is not defined");
+        return;
+    }
+    for (Profiler::Section *s = Profiler::getFirst(); s && line < 3; s = s->getNext(), ++i)
+    {
+        if (i < top)
+        {
+            continue;
+        }
+        Profiler::Summary us = Profiler::inMicros(s->getSummary());
+        MorseDisplay::vprintOnScroll(line++, REGULAR, 0, "%-7.7s%5lu%6lu", s->getName(), (unsigned long) us.p99,
+                (unsigned long) us.max);
+    }
+}
@@ -0,0 +1,15 @@
+#ifndef MORSEDIAGNOSTICS_H_
+#define MORSEDIAGNOSTICS_H_
+
+#include <Arduino.h>
+
+namespace MorseDiagnostics
+{
+
+    void setup();
+    boolean menuExec(String mode);
+    void dumpCsv();
+
+}
+
+#endif /* MORSEDIAGNOSTICS_H_ */
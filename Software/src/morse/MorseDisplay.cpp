@@ -18,10 +18,12 @@
 #include "SSD1306.h"       // alias for `#include "SSD1306Wire.h"
 
 #include "MorseDisplay.h"
+#include "Profiler.h"
 #include "morsedefs.h"
 #include "wklfonts.h"
 #include "MorsePreferences.h"
 #include "MorseSystem.h"
+#include "MorsePower.h"
 #include "MorseMachine.h"
 #include "MorseKeyer.h"
 #include "decoder.h"
@@ -46,6 +48,7 @@ char textBuffer[NoOfLines][2 * NoOfCharsPerLine + 1]; /// we need extra room for
                                                       /// and 0 terminator
 
 uint8_t linePointer = 0;    /// defines the current bottom line
+boolean refreshPending = false;     /// the buffer has changed, but the dimmed display has not been refreshed yet
 
 #define lora_width 6        /// a simple logo that shows when we operate with loRa, stored in XBM format
 #define lora_height 11
@@ -115,7 +118,6 @@ void MorseDisplay::displayStartUp()
         }
         MorseDisplay::displayBatteryStatus(volt);
     }
-    delay(3000);
 }
 
 MorseDisplay::Config* MorseDisplay::getConfig()
@@ -128,11 +130,39 @@ void MorseDisplay::clear()
     display.clear();
 }
 
+/// displayDisplay sends the buffer to the OLED - while it is dimmed only as often as the power profile allows,
+/// the last change is sent later by flushPending()
 void MorseDisplay::displayDisplay()
 {
+    if (!MorsePower::mayRefresh())
+    {
+        refreshPending = true;
+        return;
+    }
+    displayNow();
+}
+
+/// displayNow sends the buffer in any case (before we go to sleep, for example)
+void MorseDisplay::displayNow()
+{
+    MORSE_PROFILE("displayFlush");
+    refreshPending = false;
     display.display();
 }
 
+void MorseDisplay::flushPending()
+{
+    if (refreshPending)
+    {
+        displayDisplay();
+    }
+}
+
+void MorseDisplay::setDimmed(boolean dim)
+{
+    display.setBrightness(dim ? 32 : 255);
+}
+
 void MorseDisplay::clearDisplay()
 {
     MorseDisplay::clear();
@@ -167,7 +197,7 @@ void MorseDisplay::clearStatusLine()
     display.fillRect(0, 0, 128, 15);
     display.setColor(BLACK);
 
-    display.display();
+    MorseDisplay::displayDisplay();
 }
 
 void MorseDisplay::printOnStatusLine(boolean strong, uint8_t xpos, String string)
@@ -183,7 +213,7 @@ void MorseDisplay::printOnStatusLine(boolean strong, uint8_t xpos, String string
     display.setColor(BLACK);
     display.drawString(xpos * 7, 0, string);
     display.setColor(WHITE);
-    display.display();
+    MorseDisplay::displayDisplay();
     MorseSystem::resetTOT();
 }
 
@@ -367,7 +397,7 @@ void MorseDisplay::refreshScrollArea(int pos)
     refreshScrollLine(pos, 0);           /// refresh all three lines
     refreshScrollLine((pos + 1) % NoOfLines, 1);
     refreshScrollLine((pos + 2) % NoOfLines, 2);
-    display.display();
+    MorseDisplay::displayDisplay();
 }
 
 /*
@@ -475,7 +505,7 @@ uint8_t MorseDisplay::printOnScroll(uint8_t line, FONT_ATTRIB how, uint8_t xpos,
     }
 
     display.drawString(x, y, mystring);
-    display.display();
+    MorseDisplay::displayDisplay();
     MorseSystem::resetTOT();
     return w;         // we return the actual width of the output, in case of converted UTF8 characters
 }
@@ -530,7 +560,7 @@ void MorseDisplay::drawVolumeCtrl(boolean inverse, uint16_t x, uint16_t y, uint1
 
     display.fillRect(x + 2, y + 4, (width - 4) * volume / 100, height - 8);
     display.drawHorizontalLine(x + 2, y + height / 2, width - 4);
-    display.display();
+    MorseDisplay::displayDisplay();
     MorseSystem::resetTOT();
 }
 
@@ -550,7 +580,7 @@ void MorseDisplay::displayScrollBar(boolean visible)
         display.setColor(BLACK);
         display.drawVerticalLine(127, 15, 49);
     }
-    display.display();
+    MorseDisplay::displayDisplay();
     MorseSystem::resetTOT();
 }
 
@@ -559,7 +589,7 @@ void MorseDisplay::displayVolume()
 {
     MorseDisplay::drawVolumeCtrl(MorseMachine::isEncoderMode(MorseMachine::speedSettingMode) ? false : true, 93, 0, 28, 15,
             MorsePreferences::prefs.sidetoneVolume);
-    display.display();
+    MorseDisplay::displayDisplay();
 }
 
 ///// display battery status as icon, parameter v: Voltage in mV
@@ -580,7 +610,7 @@ void MorseDisplay::displayBatteryStatus(int v)
     display.drawRect(75, SCROLL_TOP + 2 * LINE_HEIGHT + 3, 35, LINE_HEIGHT - 4);
     display.drawRect(110, SCROLL_TOP + 2 * LINE_HEIGHT + 5, 4, LINE_HEIGHT - 8);
     display.fillRect(77, SCROLL_TOP + 2 * LINE_HEIGHT + 5, w, LINE_HEIGHT - 8);
-    display.display();
+    MorseDisplay::displayDisplay();
 }
 
 void MorseDisplay::displayEmptyBattery()
@@ -597,7 +627,7 @@ void MorseDisplay::dispLoraLogo()
     display.setColor(BLACK);
     display.drawXbm(121, 2, lora_width, lora_height, lora_bits);
     display.setColor(WHITE);
-    display.display();
+    MorseDisplay::displayDisplay();
 }
 
 ////// S Meter for Trx modus
@@ -638,7 +668,7 @@ void MorseDisplay::drawInputStatus(boolean on)
         display.setColor(WHITE);
     }
     display.fillRect(1, 1, 10, 13);
-    display.display();
+    MorseDisplay::displayDisplay();
 }
 
 String MorseDisplay::getKeyerModeSymbolWOStraightKey()
@@ -730,7 +760,7 @@ void MorseDisplay::displayCWspeed()
 
     MorseDisplay::printOnStatusLine(false, 3, numBuffer);                                         // effective wpm
 
-    uint8_t wpm = (MorseMachine::isMode(MorseMachine::morseDecoder) ? wpmDecoded : MorsePreferences::prefs.wpm);
+    uint8_t wpm = (MorseMachine::isMode(MorseMachine::morseDecoder) ? wpmDecoded : MorseKeyer::wpm);
     sprintf(numBuffer, "%2i", wpm);
     MorseDisplay::printOnStatusLine(MorseMachine::isEncoderMode(MorseMachine::speedSettingMode) ? true : false, 7, numBuffer);
     MorseDisplay::printOnStatusLine(false, 10, "WpM");
@@ -747,5 +777,5 @@ void MorseDisplay::showVolumeBar(uint16_t mini, uint16_t maxi)
     display.drawRect(5, SCROLL_TOP + 2 * LINE_HEIGHT + 5, 102, LINE_HEIGHT - 8);
     display.drawRect(30, SCROLL_TOP + 2 * LINE_HEIGHT + 5, 52, LINE_HEIGHT - 8);
     display.fillRect(a, SCROLL_TOP + 2 * LINE_HEIGHT + 7, c, LINE_HEIGHT - 11);
-    display.display();
+    MorseDisplay::displayDisplay();
 }
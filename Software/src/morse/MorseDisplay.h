@@ -23,6 +23,9 @@ namespace MorseDisplay
     Config* getConfig();
     void displayStartUp();
     void displayDisplay();
+    void displayNow();
+    void flushPending();
+    void setDimmed(boolean dim);
     void clearDisplay();
     void sleep();
     void clear();
@@ -0,0 +1,97 @@
+/******************************************************************************************************************************
+ *  morse_3 Software for the Morserino-32 multi-functional Morse code machine, based on the Heltec WiFi LORA (ESP32) module ***
+ *  Copyright (C) 2018  Willi Kraml, OE1WKL                                                                                 ***
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this program.
+ *  If not, see <https://www.gnu.org/licenses/>.
+ *****************************************************************************************************************************/
+#include "MorseFist.h"
+#include "MorseDisplay.h"
+#include "MorsePreferences.h"
+#include "MorseRotaryEncoder.h"
+#include "MorseSystem.h"
+#include "MorseUI.h"
+
+using namespace MorseFist;
+
+FistAnalyzer MorseFist::fist;
+
+namespace internal
+{
+    void show();
+}
+
+/// the fist screen: speed, dah/dit ratio and weighting, how even dits, dahs and spaces are, and the spaces between
+/// characters and words compared with the speed set; RED sends it as CSV over Serial, long RED clears it, BLACK leaves
+boolean MorseFist::menuExec(String mode)
+{
+    MorseDisplay::clearDisplay();
+    internal::show();
+
+    while (true)
+    {
+        MorseUI::modeButton.Update();
+        if (MorseUI::modeButton.clicks)
+        {
+            break;
+        }
+
+        MorseUI::volButton.Update();
+        switch (MorseUI::volButton.clicks)
+        {
+            case 1:
+                dumpCsv();
+                break;
+            case -1:
+                fist.clear();
+                internal::show();
+                break;
+        }
+        MorseSystem::checkShutDown(false);      // possibly time-out: go to sleep
+    }
+    MorseDisplay::clear();
+    return false;
+}
+
+/// dumpCsv prints the statistics of each kind of element, and the summary for the speed set
+void MorseFist::dumpCsv()
+{
+    const char *names[] = { "dit", "dah", "element_space", "char_space", "word_space" };
+    FistAnalyzer::Report r = fist.getReport(MorsePreferences::prefs.wpm);
+
+    Serial.println("kind,count,mean_ms,deviation_ms");
+    for (int i = 0; i < FistAnalyzer::KINDS; ++i)
+    {
+        FistAnalyzer::Kind kind = (FistAnalyzer::Kind) i;
+        Serial.printf("%s,%u,%u,%u\n", names[i], fist.get(kind).count, fist.getMean(kind), fist.getDeviation(kind));
+    }
+    Serial.println("selected_wpm,keyed_wpm,ratio_pct,weight_pct,dit_spread_pct,dah_spread_pct,space_spread_pct,"
+            "char_space_pct,word_space_pct");
+    Serial.printf("%u,%u,%u,%u,%u,%u,%u,%u,%u\n", MorsePreferences::prefs.wpm, r.wpm, r.ratio, r.weight, r.ditSpread,
+            r.dahSpread, r.spaceSpread, r.charSpace, r.wordSpace);
+}
+
+void internal::show()
+{
+    FistAnalyzer::Report r = fist.getReport(MorsePreferences::prefs.wpm);
+
+    MorseDisplay::clearScroll();
+    if (!r.marks)
+    {
+        MorseDisplay::printOnStatusLine(true, 0, "Fist");
+        MorseDisplay::printOnScroll(0, REGULAR, 0, "Nothing keyed yet -");
+        MorseDisplay::printOnScroll(1, REGULAR, 0, "use the Decoder");
+        MorseDisplay::printOnScroll(2, REGULAR, 0, "with a straight key");
+        return;
+    }
+    MorseDisplay::vprintOnStatusLine(true, 0, "Fist %2u WpM %5u", r.wpm, r.marks);
+    MorseDisplay::vprintOnScroll(0, REGULAR, 0, "Ratio %u.%u Wt %u%%", r.ratio / 100, r.ratio / 10 % 10, r.weight);
+    MorseDisplay::vprintOnScroll(1, REGULAR, 0, "+/- %u %u %u%%", r.ditSpread, r.dahSpread, r.spaceSpread);
+    MorseDisplay::vprintOnScroll(2, REGULAR, 0, "Chr %u%% Wrd %u%%", r.charSpace, r.wordSpace);
+}
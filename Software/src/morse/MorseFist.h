@@ -0,0 +1,15 @@
+#ifndef MORSEFIST_H_
+#define MORSEFIST_H_
+
+#include <Arduino.h>
+#include "FistAnalyzer.h"
+
+namespace MorseFist
+{
+    extern FistAnalyzer fist;               /// the timing of what the decoder has read, since power on (or clearing)
+
+    boolean menuExec(String mode);
+    void dumpCsv();
+}
+
+#endif /* MORSEFIST_H_ */
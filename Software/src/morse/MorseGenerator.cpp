@@ -18,8 +18,11 @@
 #include "MorseDisplay.h"
 #include "MorseMachine.h"
 #include "MorseLoRaCW.h"
+#include "LoRaCWPacket.h"
 #include "MorseKeyer.h"
 #include "MorseSound.h"
+#include "MorseSystem.h"
+#include "Profiler.h"
 #include "decoder.h"
 #include "MorseMenu.h"
 #include "MorseModeEchoTrainer.h"
@@ -148,8 +151,22 @@ void MorseGenerator::handleEffectiveTrainerDisplay(uint8_t mode)
     }
 }
 
+/// getWakeTime tells when generateCW() has something to do next (in µs, like micros()); false if it has right now
+boolean MorseGenerator::getWakeTime(unsigned long &at)
+{
+    unsigned long ms = millis();
+
+    if (ms >= genTimer)
+    {
+        return false;
+    }
+    at = micros() + (genTimer - ms) * 1000;
+    return true;
+}
+
 void MorseGenerator::generateCW()
 {          // this is called from loop() (frequently!)  and generates CW
+    MORSE_PROFILE("generateCW");
 
     if (millis() < genTimer)
     {
@@ -413,11 +430,41 @@ unsigned long internal::getInterelementSpace(MorseGenerator::Config *generatorCo
     return delta;
 }
 
-String fetchNewWordFromLoRa()
+/// when another station takes over, we show its id (2 hex digits, inverse) in front of its first word
+void showLoRaStation(uint8_t station)
 {
-    MorseLoRaCW::Packet packet = MorseLoRaCW::decodePacket();
-    if (!packet.valid)
+    static uint8_t lastStation = LoRaCWPacket::STATION_UNKNOWN;
+
+    if (station == lastStation || station == LoRaCWPacket::STATION_UNKNOWN)
     {
+        return;
+    }
+    lastStation = station;
+
+    char id[3];
+    sprintf(id, "%02X", station);
+    if (wordCounter != 0)
+    {
+        MorseDisplay::printToScroll(FONT_INCOMING, " ");
+    }
+    MorseDisplay::printToScroll(INVERSE_REGULAR, id);
+    if (wordCounter == 0)
+    {
+        MorseDisplay::printToScroll(FONT_INCOMING, " ");
+    }
+}
+
+/**
+ * we check the streams of received words and see if one of them is due for playing
+ */
+String fetchNewWord_LoRa()
+{
+    MorseDisplay::updateSMeter(0); // at end of word we set S-meter to 0 until we receive something again
+    ////// from here: retrieve next CWword from the streams!
+    MorseLoRaCW::Packet packet;
+    if (!MorseLoRaCW::nextPacket(packet))
+    {
+        // we did not receive anything, or the station that is sending right now has not finished its next word
         return "";
     }
 
@@ -427,33 +474,14 @@ String fetchNewWordFromLoRa()
     rxInterWordSpace = 7 * rxDitLength;
     MorseDisplay::vprintOnStatusLine(true, 4, "%2ir", packet.rxWpm);
     MorseDisplay::printOnStatusLine(true, 9, "s");
+    MorseDisplay::vprintOnStatusLine(false, 0, "%2i", (int) _min(MorseLoRaCW::getTargetDelay() / 100, 99UL)); // playout delay in 1/10 s
     MorseDisplay::updateSMeter(packet.rssi); // indicate signal strength of new packet
+    showLoRaStation(packet.station);
 
     String word = Decoder::CWwordToClearText(packet.payload);
     return word;
 }
 
-/**
- * we check the rxBuffer and see if we received something
- */
-String fetchNewWord_LoRa()
-{
-    // we check the rxBuffer and see if we received something
-    MorseDisplay::updateSMeter(0); // at end of word we set S-meter to 0 until we receive something again
-    ////// from here: retrieve next CWword from buffer!
-    String word;
-    if (MorseLoRa::loRaBuReady())
-    {
-        word = fetchNewWordFromLoRa();
-    }
-    else
-    {
-        // we did not receive anything
-        word = "";
-    }
-    return word;
-}
-
 String internal::fetchNewWord()
 {
     String result = "";
@@ -487,9 +515,15 @@ void MorseGenerator::keyOut(boolean on, boolean fromHere, int f, int volume)
     static boolean extTone = false;
 
     static int intPitch, extPitch;
+    static boolean firstElement = true;
 
     if (on)
     {
+        if (firstElement)
+        {
+            firstElement = false;
+            MorseSystem::boot.mark("first element");
+        }
         if (fromHere)
         {
             intPitch = f;
@@ -59,6 +59,7 @@ namespace MorseGenerator
     Config* getConfig();
     void startTrainer();
     void generateCW();
+    boolean getWakeTime(unsigned long &at);
     void keyOut(boolean on, boolean fromHere, int f, int volume);
     void setNextWordvvvA(); // to indicate that we want vvvA
     void handleEffectiveTrainerDisplay(uint8_t mode);
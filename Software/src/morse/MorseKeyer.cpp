@@ -19,36 +19,60 @@
 #include "MorseLoRaCW.h"
 #include "MorseDisplay.h"
 #include "MorseSound.h"
+#include "MorseSystem.h"
+#include "TouchFilter.h"
+#include "PaddleQueue.h"
+#include "driver/touch_pad.h"
+#include "esp_timer.h"
+#include "esp_sleep.h"
+#include "Profiler.h"
+#include "MorseSessionLog.h"
 
 using namespace MorseKeyer;
 
 namespace internal
 {
+    struct KeyerClient: public IambicKeyer::Client
+    {
+            boolean onIdle(boolean pressed);
+            void onCharacterStart();
+            void onElement(boolean dah);
+            void keyDown();
+            void keyUp();
+            void onCharacterEnd();
+    };
 
-    void updatePaddleLatch(boolean dit, boolean dah);
-    void setDITstate();
-    void setDAHstate();
-    boolean doPaddleIambic(boolean dit, boolean dah);
-    uint8_t readSensors(int left, int right);
+    void configureKeyer();
+    boolean queueLevels(uint32_t now);
+    void onPaddlePin();
     void initSensors();
+    uint16_t readPad(touch_pad_t pad);
+    void sampleSensors(void *arg);
 }
 
-unsigned char MorseKeyer::keyerControl = 0; // this holds the latches for the paddles and the DIT_LAST latch, see above
-KSTYPE MorseKeyer::keyerState;
+IambicKeyer MorseKeyer::keyer;
+internal::KeyerClient keyerClient;
 
 uint8_t MorseKeyer::sensor;                 // what we read from checking the touch sensors
 boolean MorseKeyer::leftKey, MorseKeyer::rightKey;
 
-boolean MorseKeyer::DIT_FIRST = false; // first latched was dit?
 unsigned int MorseKeyer::ditLength;        // dit length in milliseconds - 100ms = 60bpm = 12 wpm
 unsigned int MorseKeyer::dahLength;        // dahs are 3 dits long
 boolean MorseKeyer::keyTx = false;
 unsigned int MorseKeyer::interCharacterSpace;
 unsigned int MorseKeyer::interWordSpace;   // need to be properly initialised!
 unsigned int MorseKeyer::effWpm;                                // calculated effective speed in WpM
+uint8_t MorseKeyer::wpm;
+
+const touch_pad_t leftPad = TOUCH_PAD_NUM2;         // = LEFT (GPIO 2)
+const touch_pad_t rightPad = TOUCH_PAD_NUM5;        // = RIGHT (GPIO 12)
+const uint32_t samplePeriod = 1000;                 // µs
 
-unsigned int lUntouched = 0;                        // sensor values (in untouched state) will be stored here
-unsigned int rUntouched = 0;
+TouchFilter leftTouch, rightTouch;
+volatile uint8_t touchState = 0;                    // debounced state of the touch paddles, written by the sampler
+PaddleQueue paddleQueue;                            // edges of both paddles, from the pin interrupts and the sampler
+portMUX_TYPE paddleMux = portMUX_INITIALIZER_UNLOCKED;
+esp_timer_handle_t touchTimer;
 
 void (*MorseKeyer::onWordEnd)();
 void (*MorseKeyer::onCharacter)(String keyed);
@@ -60,6 +84,9 @@ void MorseKeyer::setup()
     // to calibrate sensors, we record the values in untouched state
     internal::initSensors();
     MorseKeyer::updateTimings();
+    keyer.setClient(&keyerClient);
+    attachInterrupt(digitalPinToInterrupt(leftPin), internal::onPaddlePin, CHANGE);
+    attachInterrupt(digitalPinToInterrupt(rightPin), internal::onPaddlePin, CHANGE);
     onCharacter = [](String s)
     {
         MorseDisplay::printToScroll(FONT_OUTGOING, s);
@@ -74,6 +101,7 @@ void MorseKeyer::setup()
 
 void MorseKeyer::updateTimings()
 {
+    wpm = MorsePreferences::prefs.wpm;
     ditLength = 1200 / MorsePreferences::prefs.wpm;                    // set new value for length of dits and dahs and other timings
     dahLength = 3 * ditLength;
     interCharacterSpace = MorsePreferences::prefs.interCharSpace * ditLength;
@@ -83,6 +111,18 @@ void MorseKeyer::updateTimings()
     MorseKeyer::effWpm = 60000 / (31 * ditLength + 4 * interCharacterSpace + interWordSpace); ///  effective wpm with lengthened spaces = Farnsworth speed
 }
 
+/// setTimings takes the speed of the speed controller of the echo trainer, without changing the preferences
+void MorseKeyer::setTimings(const SpeedController::Timings &t)
+{
+    wpm = t.wpm;
+    ditLength = t.ditLength;
+    dahLength = 3 * ditLength;
+    interCharacterSpace = t.interCharacterSpace;
+    interWordSpace = t.interWordSpace;
+    effWpm = t.effWpm;
+    MorseSessionLog::speed();
+}
+
 void MorseKeyer::keyTransmitter()
 {
     if (MorseKeyer::keyTx == true)
@@ -103,483 +143,281 @@ void MorseKeyer::unkeyTransmitter()
 
 boolean MorseKeyer::doPaddleIambic()
 {
-    return internal::doPaddleIambic(MorseKeyer::leftKey, MorseKeyer::rightKey);
+    return keyer.update(micros());
 }
 
-boolean internal::doPaddleIambic(boolean dit, boolean dah)
+/// getWakeTime tells when doPaddleIambic() has to be called next (in µs, like micros()), if no paddle edge comes
+/// in between: at the end of the current element or space, at the end of a word for the decoder, or after 100 ms
+boolean MorseKeyer::getWakeTime(unsigned long &at)
 {
-    boolean paddleSwap;                      // temp storage if we need to swap left and right
-    static long ktimer;                      // timer for current element (dit or dah)
-    static long curtistimer;                 // timer for early paddle latch in Curtis mode B+
-    static long latencytimer;                // timer for "muting" paddles for some time in state INTER_ELEMENT
-    unsigned int pitch;
-
-    if (!MorsePreferences::prefs.didah)
-    {              // swap left and right values if necessary!
-        paddleSwap = dit;
-        dit = dah;
-        dah = paddleSwap;
-    }
+    unsigned long now = micros();
+    uint32_t keyerAt;
 
-    switch (keyerState)
-    {                                         // this is the keyer state machine
-        case IDLE_STATE:
-            // display the interword space, if necessary
-            if (millis() > Decoder::interWordTimer)
-            {
-//                MorseDisplay::printToScroll(REGULAR, " ");                       // output a blank
-                Decoder::interWordTimer = 4294967000;  // almost the biggest possible unsigned long number :-) - do not output extra spaces!
-                MorseKeyer::onWordEnd();
-                return false;
-            }
-
-            // Was there a paddle press?
-            if (dit || dah)
-            {
-                internal::updatePaddleLatch(dit, dah);  // trigger the paddle latches
-                MorseKeyer::onWordEndDitDah();
-                Decoder::treeptr = 0;
-                if (dit)
-                {
-                    internal::setDITstate();          // set next state
-                    DIT_FIRST = true;          // first paddle pressed after IDLE was a DIT
-                }
-                else
-                {
-                    internal::setDAHstate();
-                    DIT_FIRST = false;         // first paddle was a DAH
-                }
-            }
-            else
-            {
-                if (millis() > MorseGenerator::genTimer)
-                {
-                    MorseKeyer::onWordEndNDitDah();
-                }
-                return false;           // we return false if there was no paddle press in IDLE STATE - Arduino can do other tasks for a bit
-            }
-            break;
-
-        case DIT:
-            /// first we check that we have waited as defined by ACS settings
-            if (MorsePreferences::prefs.ACSlength > 0 && (millis() <= Decoder::acsTimer))
-            { // if we do automatic character spacing, and haven't waited for (3 or whatever) dits...
-                break;
-            }
-            clearPaddleLatches();                           // always clear the paddle latches at beginning of new element
-            keyerControl |= DIT_LAST;                        // remember that we process a DIT
-
-            ktimer = ditLength;                              // prime timer for dit
-            switch (MorsePreferences::prefs.keyermode)
-            {
-                case IAMBICB:
-                {
-                    curtistimer = 2 + (ditLength * MorsePreferences::prefs.curtisBDotTiming / 100);
-                    break;                         // enhanced Curtis mode B starts checking after some time
-                }
-                case NONSQUEEZE:
-                {
-                    curtistimer = 3;
-                    break;
-                }
-                default:
-                {
-                    curtistimer = ditLength;        // no early paddle checking in Curtis mode A Ultimatic mode oder Non-squeeze
-                    break;
-                }
-            }
-            keyerState = KEY_START;                          // set next state of state machine
-            break;
-
-        case DAH:
-            if (MorsePreferences::prefs.ACSlength > 0 && (millis() <= Decoder::acsTimer))
-            {
-                // if we do automatic character spacing, and haven't waited for 3 dits...
-                break;
-            }
-            clearPaddleLatches();                          // clear the paddle latches
-            keyerControl &= ~(DIT_LAST);                    // clear dit latch  - we are not processing a DIT
-
-            ktimer = dahLength;
-            switch (MorsePreferences::prefs.keyermode)
-            {
-                case IAMBICB:
-                {
-                    curtistimer = 2 + (dahLength * MorsePreferences::prefs.curtisBTiming / 100); // enhanced Curtis mode B starts checking after some time
-                    break;
-                }
-                case NONSQUEEZE:
-                {
-                    curtistimer = 3;
-                    break;
-                }
-                default:
-                {
-                    curtistimer = dahLength;        // no early paddle checking in Curtis mode A or Ultimatic mode
-                    break;
-                }
-            }
-            keyerState = KEY_START;                          // set next state of state machine
-            break;
-
-        case KEY_START:
-            // Assert key down, start timing, state shared for dit or dah
-            pitch = MorseSound::notes[MorsePreferences::prefs.sidetoneFreq];
-            if ((MorseMachine::isMode(MorseMachine::echoTrainer) || MorseMachine::isMode(MorseMachine::loraTrx))
-                    && MorsePreferences::prefs.echoToneShift != 0)
-            {
-                pitch = (MorsePreferences::prefs.echoToneShift == 1 ? pitch * 18 / 17 : pitch * 17 / 18); /// one half tone higher or lower, as set in parameters in echo trainer mode
-            }
-            //pwmTone(pitch, MorsePreferences::prefs.sidetoneVolume, true);
-            //keyTransmitter();
-            MorseGenerator::keyOut(true, true, pitch, MorsePreferences::prefs.sidetoneVolume);
-            ktimer += millis();                     // set ktimer to interval end time
-            curtistimer += millis();                // set curtistimer to curtis end time
-            keyerState = KEYED;                     // next state
-            break;
-
-        case KEYED:
-            // Wait for timers to expire
-            if (millis() > ktimer)
-            {                // are we at end of key down ?
-                //digitalWrite(keyerPin, LOW);        // turn the LED off, unkey transmitter, or whatever
-                //pwmNoTone();                      // stop side tone
-                MorseGenerator::keyOut(false, true, 0, 0);
-                ktimer = millis() + ditLength;    // inter-element time
-                latencytimer = millis() + ((MorsePreferences::prefs.latency - 1) * ditLength / 8);
-                keyerState = INTER_ELEMENT;       // next state
-            }
-            else if (millis() > curtistimer)
-            {
-                // in Curtis mode we check paddle as soon as Curtis time is off
-                if (keyerControl & DIT_LAST)
-                {
-                    // last element was a dit
-                    internal::updatePaddleLatch(false, dah); // not sure here: we only check the opposite paddle - should be ok for Curtis B
-                }
-                else
-                {
-                    internal::updatePaddleLatch(dit, false); // but we remain in the same state until element time is off!
-                }
-            }
-            break;
-
-        case INTER_ELEMENT:
-            //if ((MorsePreferences::prefs.keyermode != NONSQUEEZE) && (millis() < latencytimer)) {     // or should it be MorsePreferences::prefs.keyermode > 2 ? Latency for Ultimatic mode?
-            if (millis() < latencytimer)
-            {
-                if (keyerControl & DIT_LAST)
-                {
-                    // last element was a dit
-                    internal::updatePaddleLatch(false, dah); // not sure here: we only check the opposite paddle - should be ok for Curtis B
-                }
-                else
-                {
-                    internal::updatePaddleLatch(dit, false);
-                }
-            }
-            else
-            {
-                internal::updatePaddleLatch(dit, dah);          // latch paddle state while between elements
-                if (millis() > ktimer)
-                {               // at end of INTER-ELEMENT
-                    switch (keyerControl)
-                    {
-                        case 3:                                         // both paddles are latched
-                        case 7:
-                        {
-                            switch (MorsePreferences::prefs.keyermode)
-                            {
-                                case NONSQUEEZE:
-                                {
-                                    if (DIT_FIRST)
-                                    {                     // when first element was a DIT
-                                        internal::setDITstate();            // next element is a DIT again
-                                    }
-                                    else
-                                    {
-                                        // but when first element was a DAH
-                                        internal::setDAHstate();            // the next element is a DAH again!
-                                    }
-                                    break;
-                                }
-                                case ULTIMATIC:
-                                {
-                                    if (DIT_FIRST)
-                                    {                     // when first element was a DIT
-                                        internal::setDAHstate();            // next element is a DAH
-                                    }
-                                    else
-                                    {
-                                        // but when first element was a DAH
-                                        internal::setDITstate();            // the next element is a DIT!
-                                    }
-                                    break;
-                                }
-                                default:
-                                {
-                                    if (keyerControl & DIT_LAST)
-                                    {     // Iambic: last element was a dit - this is case 7, really
-                                        internal::setDAHstate();               // next element will be a DAH
-                                    }
-                                    else
-                                    {
-                                        // and this is case 3 - last element was a DAH
-                                        internal::setDITstate();               // the next element is a DIT
-                                    }
-                                }
-                            }
-                            break;
-                            // dit only is latched, regardless what was last element
-                        }
-                        case 1:
-                        case 5:
-                        {
-                            internal::setDITstate();
-                            break;
-                            // dah only latched, regardless what was last element
-                        }
-                        case 2:
-                        case 6:
-                        {
-                            internal::setDAHstate();
-                            break;
-                            // none latched, regardless what was last element
-                        }
-                        case 0:
-                        case 4:
-                        {
-                            keyerState = IDLE_STATE;               // we are at the end of the character and go back into IDLE STATE
-                            /*
-                             * display the decoded morse character(s)
-                             */
-                            String symbol = Decoder::getMorsedChar();
-                            if (symbol != "") {
-                                onCharacter(symbol);
-                            }
-
-                            if (MorseMachine::isMode(MorseMachine::loraTrx))
-                            {
-                                MorseLoRaCW::cwForLora(0);
-                            }
-
-                            MorsePreferences::fireCharSeen(false);
-
-                            if (MorsePreferences::prefs.ACSlength > 0)
-                            {
-                                Decoder::acsTimer = millis() + MorsePreferences::prefs.ACSlength * ditLength; // prime the ACS timer
-                            }
-
-                            if (MorseMachine::isMode(MorseMachine::morseKeyer) || MorseMachine::isMode(MorseMachine::loraTrx)
-                                    || MorseMachine::isMode(MorseMachine::morseTrx))
-                            {
-                                Decoder::interWordTimer = millis() + 5 * ditLength;
-                            }
-                            else
-                            {
-                                Decoder::interWordTimer = millis() + interWordSpace; // prime the timer to detect a space between characters
-                            }
-
-                            // nominally 7 dit-lengths, but we are not quite so strict here in keyer or TrX mode,
-                            // use the extended time in echo trainer mode to allow longer space between characters,
-                            // like in listening
-                            keyerControl = 0;                          // clear all latches completely before we go to IDLE
-                            break;
-                        }
-                    } // switch keyerControl : evaluation of flags
-                }
-            } // end of INTER_ELEMENT
-    } // end switch keyerState - end of state machine
-
-    if (keyerControl & 3)
-    {                                               // any paddle latch?
-        return true;                                                      // we return true - we processed a paddle press
-    }
-    else
+    at = now + 100000;
+    if (keyer.getWakeTime(keyerAt))
     {
-        return false;                                                     // when paddle latches are cleared, we return false
+        at = keyerAt;
     }
-} /////////////////// end function doPaddleIambic()
+    else if (Decoder::interWordTimer != 4294967000)
+    {   // the idle keyer still has to tell the end of the word (see KeyerClient::onIdle())
+        long ms = (long) (Decoder::interWordTimer - millis()) + 1;
+        if (ms < 100)
+        {
+            at = now + (ms > 0 ? ms * 1000 : 0);
+        }
+    }
+    return true;
+}
+
+/// paddlesSettled is true when the paddle task has passed on all edges and cannot find any new ones by polling
+boolean MorseKeyer::paddlesSettled()
+{
+    portENTER_CRITICAL(&paddleMux);
+    boolean settled = paddleQueue.isSettled(micros());
+    portEXIT_CRITICAL(&paddleMux);
+    return settled;
+}
 
 //// this function checks the paddles (touch or external), returns true when a paddle has been activated,
 ///// and sets the global variable leftKey and rightKey accordingly
 
 boolean MorseKeyer::checkPaddles()
 {
-    static boolean oldL = false, newL, oldR = false, newR;
-    int left, right;
-    static long lTimer = 0, rTimer = 0;
-    const int debDelay = 750;       // debounce time = 0,75  ms
+    MORSE_PROFILE("checkPaddles");
+    PaddleQueue::Edge edge;
 
-    /* intral and external paddle are now working in parallel - the parameter MorsePreferences::prefs.extPaddle is used to indicate reverse polarity of external paddle
+    /* the edges come from the pin interrupts and the touch sampler, with the time they happened; here we
+     * only look at the levels once more (after contact bounce the queue might be out of step with the pins)
+     * and pass the edges on to the keyer, which does the debouncing for non-squeeze mode, too
      */
-    left = MorsePreferences::prefs.useExtPaddle ? rightPin : leftPin;
-    right = MorsePreferences::prefs.useExtPaddle ? leftPin : rightPin;
-    sensor = internal::readSensors(LEFT, RIGHT);
-    newL = (sensor >> 1) | (!digitalRead(left));
-    newR = (sensor & 0x01) | (!digitalRead(right));
-
-    if ((MorsePreferences::prefs.keyermode == NONSQUEEZE) && newL && newR)
+    internal::configureKeyer();
+    portENTER_CRITICAL(&paddleMux);
+    internal::queueLevels(micros());
+    while (paddleQueue.pop(edge))
     {
-        return (leftKey || rightKey);
+        keyer.paddleEdge(edge.paddle, edge.pressed, edge.time);
     }
+    portEXIT_CRITICAL(&paddleMux);
 
-    if (newL != oldL)
-    {
-        lTimer = micros();
-    }
+    sensor = touchState;
+    leftKey = keyer.isPressed(PaddleQueue::LEFT);
+    rightKey = keyer.isPressed(PaddleQueue::RIGHT);
+    return (leftKey || rightKey);
+}
 
-    if (newR != oldR)
-    {
-        rTimer = micros();
-    }
+// clear the paddle latches in keyer control
+void MorseKeyer::clearPaddleLatches()
+{
+    keyer.clearLatches(micros());
+}
 
-    if (micros() - lTimer > debDelay)
-    {
-        if (newL != leftKey)
-        {
-            leftKey = newL;
-        }
-    }
+void internal::configureKeyer()
+{
+    IambicKeyer::Config config;
+
+    config.mode = MorsePreferences::prefs.keyermode;
+    config.didah = MorsePreferences::prefs.didah;
+    config.ditLength = ditLength;
+    config.curtisBTiming = MorsePreferences::prefs.curtisBTiming;
+    config.curtisBDotTiming = MorsePreferences::prefs.curtisBDotTiming;
+    config.latency = MorsePreferences::prefs.latency;
+    config.acsLength = MorsePreferences::prefs.ACSlength;
+    keyer.setConfig(config);
+}
 
-    if (micros() - rTimer > debDelay)
-    {
-        if (newR != rightKey)
-        {
-            rightKey = newR;
-        }
-    }
+/// queueLevels passes the current level of both paddles (touch or external) to the queue - from the pin
+/// interrupt, the touch sampler and checkPaddles(), always inside paddleMux; true if an edge was queued
+boolean IRAM_ATTR internal::queueLevels(uint32_t now)
+{
+    /* intral and external paddle are now working in parallel - the parameter MorsePreferences::prefs.extPaddle is used to indicate reverse polarity of external paddle
+     */
+    int left = MorsePreferences::prefs.useExtPaddle ? rightPin : leftPin;
+    int right = MorsePreferences::prefs.useExtPaddle ? leftPin : rightPin;
 
-    oldL = newL;
-    oldR = newR;
+    boolean l = paddleQueue.onLevel(PaddleQueue::LEFT, (touchState >> 1) | (!digitalRead(left)), now);
+    boolean r = paddleQueue.onLevel(PaddleQueue::RIGHT, (touchState & 0x01) | (!digitalRead(right)), now);
+    return l || r;
+}
 
-    return (leftKey || rightKey);
+void IRAM_ATTR internal::onPaddlePin()
+{
+    portENTER_CRITICAL_ISR(&paddleMux);
+    boolean queued = queueLevels(micros());
+    portEXIT_CRITICAL_ISR(&paddleMux);
+    if (queued)
+    {
+        MorseSystem::wakeForPaddles();
+    }
 }
 
 ///
-/// Keyer subroutines
+/// what the keyer does to the outside world
 ///
 
-// update the paddle latches in keyerControl
-void internal::updatePaddleLatch(boolean dit, boolean dah)
+boolean internal::KeyerClient::onIdle(boolean pressed)
 {
-    if (dit)
+    // display the interword space, if necessary
+    if (millis() > Decoder::interWordTimer)
     {
-        MorseKeyer::keyerControl |= DIT_L;
+        Decoder::interWordTimer = 4294967000;  // almost the biggest possible unsigned long number :-) - do not output extra spaces!
+        MorseKeyer::onWordEnd();
+        return true;
     }
-
-    if (dah)
+    if (!pressed && millis() > MorseGenerator::genTimer)
     {
-        MorseKeyer::keyerControl |= DAH_L;
+        MorseKeyer::onWordEndNDitDah();
     }
+    return false;
 }
 
-// clear the paddle latches in keyer control
-void MorseKeyer::clearPaddleLatches()
+void internal::KeyerClient::onCharacterStart()
 {
-    keyerControl &= ~(DIT_L + DAH_L);   // clear both paddle latch bits
+    MorseKeyer::onWordEndDitDah();
+    Decoder::treeptr = 0;
 }
 
-// functions to set DIT and DAH keyer states
-void internal::setDITstate()
+void internal::KeyerClient::onElement(boolean dah)
 {
-    keyerState = DIT;
-    Decoder::treeptr = Decoder::CWtree[Decoder::treeptr].dit;
+    Decoder::treeptr = dah ? Decoder::CWtree[Decoder::treeptr].dah : Decoder::CWtree[Decoder::treeptr].dit;
     if (MorseMachine::isMode(MorseMachine::loraTrx))
     {
-        MorseLoRaCW::cwForLora(1);                         // build compressed string for LoRA
+        MorseLoRaCW::cwForLora(dah ? 2 : 1);               // build compressed string for LoRA
     }
 }
 
-void internal::setDAHstate()
+void internal::KeyerClient::keyDown()
 {
-    keyerState = DAH;
-    Decoder::treeptr = Decoder::CWtree[Decoder::treeptr].dah;
-    if (MorseMachine::isMode(MorseMachine::loraTrx))
+    unsigned int pitch = MorseSound::notes[MorsePreferences::prefs.sidetoneFreq];
+    if ((MorseMachine::isMode(MorseMachine::echoTrainer) || MorseMachine::isMode(MorseMachine::loraTrx))
+            && MorsePreferences::prefs.echoToneShift != 0)
     {
-        MorseLoRaCW::cwForLora(2);
+        pitch = (MorsePreferences::prefs.echoToneShift == 1 ? pitch * 18 / 17 : pitch * 17 / 18); /// one half tone higher or lower, as set in parameters in echo trainer mode
     }
+    MorseGenerator::keyOut(true, true, pitch, MorsePreferences::prefs.sidetoneVolume);
 }
 
-/// function to read sensors:
-/// read both left and right twice, repeat reading if it returns 0
-/// return a binary value, depending on a (adaptable?) threshold:
-/// 0 = nothing touched,  1= right touched, 2 = left touched, 3 = both touched
-/// binary:   00          01                10                11
-
-uint8_t internal::readSensors(int left, int right)
+void internal::KeyerClient::keyUp()
 {
-    //static boolean first = true;
-    uint8_t v, lValue, rValue;
+    MorseGenerator::keyOut(false, true, 0, 0);
+}
 
-    while (!(v = touchRead(left)))
-    {
-        ;                                       // ignore readings with value 0
+void internal::KeyerClient::onCharacterEnd()
+{
+    /*
+     * display the decoded morse character(s)
+     */
+    String symbol = Decoder::getMorsedChar();
+    if (symbol != "") {
+        onCharacter(symbol);
     }
 
-    lValue = v;
-    while (!(v = touchRead(right)))
+    if (MorseMachine::isMode(MorseMachine::loraTrx))
     {
-        ;                                       // ignore readings with value 0
+        MorseLoRaCW::cwForLora(0);
     }
 
-    rValue = v;
-    while (!(v = touchRead(left)))
+    MorsePreferences::fireCharSeen(false);
+
+    // nominally 7 dit-lengths, but we are not quite so strict here in keyer or TrX mode,
+    // use the extended time in echo trainer mode to allow longer space between characters,
+    // like in listening
+    if (MorseMachine::isMode(MorseMachine::morseKeyer) || MorseMachine::isMode(MorseMachine::loraTrx)
+            || MorseMachine::isMode(MorseMachine::morseTrx))
     {
-        ;                                       // ignore readings with value 0
+        Decoder::interWordTimer = millis() + 5 * ditLength;
     }
-
-    lValue = (lValue + v) / 2;
-    while (!(v = touchRead(right)))
+    else
     {
-        ;                                       // ignore readings with value 0
+        Decoder::interWordTimer = millis() + interWordSpace; // prime the timer to detect a space between characters
     }
+}
 
-    rValue = (rValue + v) / 2;
+/// the touch paddles are measured by the touch peripheral on its own (timer mode); sampleSensors() takes the
+/// latest readings every millisecond and runs them through the filters; every change of touchState is queued
+/// as a paddle edge:
+/// 0 = nothing touched,  1= right touched, 2 = left touched, 3 = both touched
+/// binary:   00          01                10                11
+
+void internal::initSensors()
+{
+    uint32_t l = 0, r = 0;
 
-    if (lValue < (MorsePreferences::prefs.tLeft + 10))
-    {           //adaptive calibration
-        //if (first) MORSELOGLN("p-tLeft " + String(MorsePreferences::prefs.tLeft));
-        //if (first) MORSELOG("lValue: "); if (first) MORSELOGLN(lValue);
-        //printOnScroll(0, INVERSE_BOLD, 0,  String(lValue) + " " + String(MorsePreferences::prefs.tLeft));
-        MorsePreferences::prefs.tLeft = (7 * MorsePreferences::prefs.tLeft + ((lValue + lUntouched) / SENS_FACTOR)) / 8;
-        //MORSELOG("MorsePreferences::prefs.tLeft: "); MORSELOGLN(MorsePreferences::prefs.tLeft);
+    touch_pad_init();
+    touch_pad_set_fsm_mode(TOUCH_FSM_MODE_TIMER);
+    touch_pad_set_meas_time(30, 0x1000);            // pause 0.2 ms (150 kHz), measure 0.5 ms (8 MHz) - as touchRead() did
+    touch_pad_config(leftPad, 0);
+    touch_pad_config(rightPad, 0);
+    delay(10);
+
+    // to calibrate sensors, we record the values in untouched state
+    for (int i = 0; i < 8; ++i)
+    {
+        l += readPad(leftPad);
+        r += readPad(rightPad);
+        delay(2);
     }
-    if (rValue < (MorsePreferences::prefs.tRight + 10))
-    {           //adaptive calibration
-        //if (first) MORSELOGLN("p-tRight " + String(MorsePreferences::prefs.tRight));
-        //if (first) MORSELOG("rValue: "); if (first) MORSELOGLN(rValue);
-        //printOnScroll(1, INVERSE_BOLD, 0,  String(rValue) + " " + String(MorsePreferences::prefs.tRight));
-        MorsePreferences::prefs.tRight = (7 * MorsePreferences::prefs.tRight + ((rValue + rUntouched) / SENS_FACTOR)) / 8;
-        //MORSELOG("MorsePreferences::prefs.tRight: "); MORSELOGLN(MorsePreferences::prefs.tRight);
+    leftTouch.begin(l / 8);
+    rightTouch.begin(r / 8);
+
+    esp_timer_create_args_t timerArgs = { };
+    timerArgs.callback = &internal::sampleSensors;
+    timerArgs.name = "touch";
+    esp_timer_create(&timerArgs, &touchTimer);
+    esp_timer_start_periodic(touchTimer, samplePeriod);
+}
+
+uint16_t internal::readPad(touch_pad_t pad)
+{
+    uint16_t v = 0;
+    while (!v)
+    {
+        touch_pad_read_raw_data(pad, &v);           // ignore readings with value 0
     }
-    //first = false;
-    return (lValue < MorsePreferences::prefs.tLeft ? 2 : 0) + (rValue < MorsePreferences::prefs.tRight ? 1 : 0);
+    return v;
 }
 
-void internal::initSensors()
+void internal::sampleSensors(void *arg)
 {
-    int v;
-    lUntouched = rUntouched = 60;       /// new: we seek minimum
-    for (int i = 0; i < 8; ++i)
+    uint16_t l = 0, r = 0;
+    touch_pad_read_raw_data(leftPad, &l);
+    touch_pad_read_raw_data(rightPad, &r);
+
+    boolean queued = false;
+    portENTER_CRITICAL(&paddleMux);
+    uint8_t state = (leftTouch.update(l) ? 2 : 0) + (rightTouch.update(r) ? 1 : 0);
+    if (state != touchState)
     {
-        while (!(v = touchRead(LEFT)))
-        {
-            ;                                       // ignore readings with value 0
-        }
-        lUntouched += v;
-        //lUntouched = _min(lUntouched, v);
-        while (!(v = touchRead(RIGHT)))
-        {
-            ;                                       // ignore readings with value 0
-        }
-        rUntouched += v;
-        //rUntouched = _min(rUntouched, v);
+        touchState = state;
+        queued = queueLevels(micros());
     }
-    lUntouched /= 8;
-    rUntouched /= 8;
-    MorsePreferences::prefs.tLeft = lUntouched - 9;
-    MorsePreferences::prefs.tRight = rUntouched - 9;
+    portEXIT_CRITICAL(&paddleMux);
+    if (queued)
+    {
+        MorseSystem::wakeForPaddles();
+    }
+}
+
+/// enableTouchWakeUp lets a touch end a light sleep, at the thresholds of the filters (the touch peripheral
+/// keeps measuring while we sleep, the sampler does not)
+void MorseKeyer::enableTouchWakeUp()
+{
+    portENTER_CRITICAL(&paddleMux);
+    uint16_t left = leftTouch.getThreshold();
+    uint16_t right = rightTouch.getThreshold();
+    portEXIT_CRITICAL(&paddleMux);
+
+    touch_pad_set_thresh(leftPad, left);
+    touch_pad_set_thresh(rightPad, right);
+    esp_sleep_enable_touchpad_wakeup();
+}
+
+/// calibrateSensors adapts the touch thresholds - called by the background task, not for every sample
+void MorseKeyer::calibrateSensors()
+{
+    portENTER_CRITICAL(&paddleMux);
+    leftTouch.calibrate();
+    rightTouch.calibrate();
+    portEXIT_CRITICAL(&paddleMux);
 }
 
 void MorseKeyer::changeSpeed(int t)
@@ -587,6 +425,7 @@ void MorseKeyer::changeSpeed(int t)
     MorsePreferences::prefs.wpm += t;
     MorsePreferences::prefs.wpm = constrain(MorsePreferences::prefs.wpm, 5, 60);
     MorseKeyer::updateTimings();
+    MorseSessionLog::speed();
     MorseDisplay::displayCWspeed();                     // update display of CW speed
     MorsePreferences::charCounter = 0;                                    // reset character counter
 }
@@ -3,49 +3,23 @@
 
 #include <Arduino.h>
 
-// defines for keyer modi
-//
+#include "IambicKeyer.h"
+#include "SpeedController.h"
 
 namespace MorseKeyer
 {
 
-#define    IAMBICA      1
-// Curtis Mode A
-#define    IAMBICB      2
-// Curtis Mode B (with enhanced Curtis timing, set as parameter
-#define    ULTIMATIC    3
-// Ultimatic mode
-#define    NONSQUEEZE   4
-// Non-squeeze mode of dual-lever paddles - simulate a single-lever paddle
-
-///////////////////////////////////////////////////////////////////////////////
-//
-//  Iambic Keyer State Machine Defines
-
-    enum KSTYPE
-    {
-        IDLE_STATE, DIT, DAH, KEY_START, KEYED, INTER_ELEMENT
-    };
-
-//  keyerControl bit definitions
-
-#define     DIT_L      0x01     // Dit latch
-#define     DAH_L      0x02     // Dah latch
-#define     DIT_LAST   0x04     // Dit was last processed element
-
 //  Global Keyer Variables
 //
-    extern unsigned char keyerControl; // this holds the latches for the paddles and the DIT_LAST latch, see above
-
-    extern boolean DIT_FIRST; // first latched was dit?
+    extern IambicKeyer keyer;
     extern unsigned int ditLength;        // dit length in milliseconds - 100ms = 60bpm = 12 wpm
     extern unsigned int dahLength;        // dahs are 3 dits long
-    extern KSTYPE keyerState;
     extern uint8_t sensor;                 // what we read from checking the touch sensors
     extern boolean leftKey, rightKey;
     extern unsigned int interCharacterSpace;
     extern unsigned int interWordSpace;   // need to be properly initialised!
     extern unsigned int effWpm;                                // calculated effective speed in WpM
+    extern uint8_t wpm;                   // the character speed in use: the preference, unless the echo trainer adapts it
 
     extern boolean keyTx;             // we use this to decide if Tx should be keyed or not
 
@@ -57,10 +31,15 @@ namespace MorseKeyer
     void setup();
 
     void updateTimings();
+    void setTimings(const SpeedController::Timings &t);
     void keyTransmitter();
     void unkeyTransmitter();
     boolean doPaddleIambic();
+    boolean getWakeTime(unsigned long &at);
     boolean checkPaddles();
+    boolean paddlesSettled();
+    void calibrateSensors();
+    void enableTouchWakeUp();
     void clearPaddleLatches();
     void changeSpeed(int t);
 }
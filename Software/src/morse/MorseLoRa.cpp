@@ -14,12 +14,12 @@
 
 #include <Arduino.h>
 #include "SPIFFS.h"
-#include <SPI.h>           // library for SPI interface
-#include <LoRa.h>          // library for LoRa transceiver
 
 #include "MorseDisplay.h"
 #include "MorsePreferencesMenu.h"
 #include "MorseLoRa.h"
+#include "MorseSystem.h"
+#include "LoRaRadio.h"
 
 using namespace MorseLoRa;
 
@@ -30,21 +30,23 @@ uint16_t byteBuFree = 256;
 uint8_t nextBuWrite = 0;
 uint8_t nextBuRead = 0;
 
+LoRaRadio loRaRadio;
+Radio *radio = &loRaRadio;                  /// the transceiver; can be replaced by a simulation
 
 namespace internal
 {
-    void onReceive(int packetSize);
-    void storePacket(int rssi, String packet);
+    void onReceive(const uint8_t *data, uint8_t length, int rssi);
     uint8_t loRaBuRead(uint8_t* buIndex);
-    uint8_t loRaBuWrite(int rssi, String packet);
+    uint8_t loRaBuWrite(int rssi, const uint8_t *data, uint8_t length);
     void loraSystemSetup();
+    void startRadio();
 }
 
 void MorseLoRa::setup()
 {
     /// check if BLACK knob has been pressed on startup - if yes, we have to perform LoRa Setup
     delay(50);
-    if (SPIFFS.begin() && digitalRead(modeButtonPin) == LOW)
+    if (digitalRead(modeButtonPin) == LOW && SPIFFS.begin())
     {        // BLACK was pressed at start-up - checking for SPIFF so that programming 1st time w/o pull-up shows menu
         MorseDisplay::clearDisplay();
         MorseDisplay::printOnStatusLine(true, 0, "Release BLACK");
@@ -56,10 +58,14 @@ void MorseLoRa::setup()
         internal::loraSystemSetup();
     }
 
+    /// starting the transceiver takes a while and is not needed by most modes - do it later
+    MorseSystem::boot.defer("lora", internal::startRadio);
+}
+
+void internal::startRadio()
+{
     ////////////  Setup for LoRa
-    SPI.begin(SCK, MISO, MOSI, SS);
-    LoRa.setPins(SS, RST, DI0);
-    if (!LoRa.begin(MorsePreferences::prefs.loraQRG, PABOOSTx))
+    if (!radio->begin(MorsePreferences::prefs.loraQRG))
     {
         MORSELOGLN("Starting LoRa failed!");
         while (1)
@@ -67,25 +73,43 @@ void MorseLoRa::setup()
             ;
         }
     }
-    LoRa.setFrequency(MorsePreferences::prefs.loraQRG);    /// default = 434.150 MHz - Region 1 ISM Band, can be changed by system setup
-    LoRa.setSpreadingFactor(7);                         /// default
-    LoRa.setSignalBandwidth(250E3);                     /// 250 kHz
-    LoRa.noCrc();                                       /// we use error correction
-    LoRa.setSyncWord(MorsePreferences::prefs.loraSyncW);                      /// the default would be 0x34
+    radio->setSyncWord(MorsePreferences::prefs.loraSyncW);                      /// the default would be 0x34
 
     // register the receive callback
-    LoRa.onReceive(internal::onReceive);
-    /// initialise the serial number
+    radio->onReceive(internal::onReceive);
+}
+
+void MorseLoRa::setRadio(Radio *r)
+{
+    radio = r;
+}
+
+void MorseLoRa::setSyncWord(uint8_t syncWord)
+{
+    if (MorseSystem::boot.isDone(internal::startRadio))         // otherwise it is set when the radio is started
+    {
+        radio->setSyncWord(syncWord);
+    }
 }
 
 void MorseLoRa::idle()
 {
-    LoRa.idle();
+    if (MorseSystem::boot.isDone(internal::startRadio))         // a radio that has not been started is idle anyway
+    {
+        radio->idle();
+    }
 }
 
 void MorseLoRa::receive()
 {
-    LoRa.receive();
+    MorseSystem::boot.ensure(internal::startRadio);
+    radio->receive();
+}
+
+void MorseLoRa::sleep()
+{
+    MorseSystem::boot.ensure(internal::startRadio);             // after power on the chip is in standby - we want it asleep
+    radio->sleep();
 }
 
 //////// System Setup / LoRa Setup ///// Called when BALCK knob is pressed @ startup
@@ -107,34 +131,17 @@ void MorseLoRa::sendWithLora(const char loraTxBuffer[])
 {           // hand this string over as payload to the LoRA transceiver
     // send packet
     MORSELOGLN("MLR:sWL '" + String(loraTxBuffer) + "'");
-    LoRa.beginPacket();
-    LoRa.print(loraTxBuffer);
-    LoRa.endPacket();
-    LoRa.receive();
+    MorseSystem::boot.ensure(internal::startRadio);
+    radio->send((const uint8_t*) loraTxBuffer, strlen(loraTxBuffer));
+    radio->receive();
 }
 
-void internal::onReceive(int packetSize)
-{
-    String result;
-    result.reserve(64);
-    result = "";
-
-    // received a packet
-    // read packet
-    for (int i = 0; i < packetSize; i++)
-    {
-        result += (char) LoRa.read();
-    }
-
-    if (packetSize < 49)
-    {
-        internal::storePacket(LoRa.packetRssi(), result);
-    }
-    else
+void internal::onReceive(const uint8_t *data, uint8_t length, int rssi)
+{             // whenever we receive something, we just store it in our buffer
+    if (loRaBuWrite(rssi, data, length) == 0)
     {
-        MORSELOGLN("LoRa Packet longer than 48 bytes! Discarded...");
+        MORSELOGLN("LoRa Buffer full");
     }
-    // print RSSI of packet
 }
 
 //// new buffer code: unpack when needed, to save buffer space. We just use 256 bytes of buffer, instead of 32k!
@@ -153,7 +160,7 @@ void internal::onReceive(int packetSize)
 ////    r:  1 uint8_t rssi as a positive number
 ////    d:  (var. length) data packet as received by LoRa
 //// functions:
-////    int loRaBuWrite(int rssi, String packet): returns length of buffer if successful. otherwise 0
+////    int loRaBuWrite(int rssi, const uint8_t *data, uint8_t length): returns length of buffer if successful. otherwise 0
 ////    uint8_t loRaBuRead(uint8_t* buIndex): returns length of packet, and index where to read in buffer by reference
 ////    boolean loRaBuReady():  true if there is something in the buffer, false otherwise
 ////      example:
@@ -166,15 +173,15 @@ void internal::onReceive(int packetSize)
 ////            doSomethingWith(ourBuffer[myIndex], myLength);
 ////        }
 
-uint8_t internal::loRaBuWrite(int rssi, String packet)
+uint8_t internal::loRaBuWrite(int rssi, const uint8_t *data, uint8_t length)
 {
-////   int loRaBuWrite(int rssi, String packet): returns length of buffer if successful. otherwise 0
+////   int loRaBuWrite(int rssi, const uint8_t *data, uint8_t length): returns length of buffer if successful. otherwise 0
 ////   nextBuWrite where the next packet should be written; @write:
 ////       increment nextBuWrite by l to get new pointer; and decrement bytesBuFree by l to get new free space
     uint8_t l, posRssi;
 
     posRssi = (uint8_t) abs(rssi);
-    l = 2 + packet.length();
+    l = 2 + length;
     if (byteBuFree < l)
     {                               // buffer full - discard packet
         return 0;
@@ -182,9 +189,9 @@ uint8_t internal::loRaBuWrite(int rssi, String packet)
 
     loRaRxBuffer[nextBuWrite++] = l;
     loRaRxBuffer[nextBuWrite++] = posRssi;
-    for (int i = 0; i < packet.length(); ++i)
+    for (int i = 0; i < length; ++i)
     {       // do this for all chars in the packet
-        loRaRxBuffer[nextBuWrite++] = packet[i];       // at end nextBuWrite is alread where it should be
+        loRaRxBuffer[nextBuWrite++] = data[i];         // at end nextBuWrite is alread where it should be
     }
     byteBuFree -= l;
     return l;
@@ -221,15 +228,6 @@ uint8_t internal::loRaBuRead(uint8_t* buIndex)
     }
 }
 
-void internal::storePacket(int rssi, String packet)
-{             // whenever we receive something, we just store it in our buffer
-    if (loRaBuWrite(rssi, packet) == 0)
-    {
-        MORSELOGLN("LoRa Buffer full");
-    }
-}
-
-
 /// decodePacket analyzes packet as received and stored in buffer
 /// returns the header byte (protocol version*64 + 6bit packet serial number
 //// byte 0 (added by receiver): RSSI
@@ -1,12 +1,14 @@
 #ifndef MORSELORA_H_
 #define MORSELORA_H_
 
+#include "Radio.h"
+
 namespace MorseLoRa
 {
 
     struct RawPacket {
         ~RawPacket() {
-            delete payload;
+            free(payload);
         }
         int rssi;
         uint8_t* payload;
@@ -23,7 +25,10 @@ namespace MorseLoRa
 
 
     void setup();
+    void setRadio(Radio *r);
+    void setSyncWord(uint8_t syncWord);
     void idle();
+    void sleep();
 
     void sendWithLora(const char loraTxBuffer[]);
     boolean loRaBuReady();
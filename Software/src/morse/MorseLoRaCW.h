@@ -10,19 +10,24 @@ namespace MorseLoRaCW
     {
             int rssi;
             uint8_t header;
+            uint8_t station;
             int rxWpm;
             String payload;
             boolean valid = true;
 
             uint8_t protocolVersion() { return header >> 6; };
             String toString() {
-                return String((valid ? "ok" : "err")) + String(" ") + String(protocolVersion()) + " " + String(rssi) + " " + String(rxWpm) + " : " + payload;
+                return String((valid ? "ok" : "err")) + String(" ") + String(protocolVersion()) + " " + String(station) + " " + String(rssi) + " " + String(rxWpm) + " : " + payload;
             }
     } Packet;
 
     char* getTxBuffer();
     void cwForLora(int element);
-    Packet decodePacket();
+    uint8_t getStation();
+    void clearStreams();
+    void receiveIntoStreams();
+    boolean nextPacket(Packet &packet);
+    unsigned long getTargetDelay();
 }
 
 #endif /* MORSELORA_H_ */
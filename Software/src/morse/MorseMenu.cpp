@@ -26,13 +26,18 @@
 #include "MorseWifi.h"
 #include "MorseModeEchoTrainer.h"
 #include "MorseModeHeadCopying.h"
+#include "MorseModePileUp.h"
 #include "MorseModeTrx.h"
 #include "MorseModeKeyer.h"
+#include "MorseSessionLog.h"
 #include "MorseModeLoRa.h"
 #include "MorseModeDecoder.h"
 #include "MorseModeGenerator.h"
 #include "MorseModeKoch.h"
 #include "MorseModeTennis.h"
+#include "MorseDiagnostics.h"
+#include "MorseStats.h"
+#include "MorseFist.h"
 
 using namespace MorseMenu;
 
@@ -46,6 +51,15 @@ namespace internal
 
 ////// The MENU
 
+/// the diagnostics screen is only reachable if there is something to show
+#ifdef MORSE_PROFILING
+#define _lastTopItem _diagnostics
+#define _afterStats _diagnostics
+#else
+#define _lastTopItem _fistStats
+#define _afterStats _keyer
+#endif
+
 //////// variables and constants for the modus menu
 
 enum navi
@@ -54,15 +68,16 @@ enum navi
 };
 
 
+/// in the order of menuNo; the order in the menu comes from nav
 const MenuItem menuItems[] = {
         {"", _dummy, {0, 0, 0, 0, 0}, MorseText::NA, MorsePreferences::allOptions, true, 0, "", 0}, //
 
-        {"CW Keyer", _keyer, {0, _goToSleep, _gen, _dummy, 0}, MorseText::NA, MorsePreferences::keyerOptions, true,
+        {"CW Keyer", _keyer, {0, _lastTopItem, _gen, _dummy, 0}, MorseText::NA, MorsePreferences::keyerOptions, true,
                 0, "a", &morseModeKeyer}, //
 
         {"CW Generator", _gen, {0, _keyer, _echo, _dummy, _genRand}, MorseText::NA, MorsePreferences::generatorOptions, true,
                 0, "", 0}, //
-        {"Random", _genRand, {1, _genPlayer, _genAbb, _gen, 0}, MorseText::RANDOMS, MorsePreferences::generatorOptions, true,
+        {"Random", _genRand, {1, _genQso, _genAbb, _gen, 0}, MorseText::RANDOMS, MorsePreferences::generatorOptions, true,
                 0, "a", &morseModeGenerator}, //
         {"CW Abbrevs", _genAbb, {1, _genRand, _genWords, _gen, 0}, MorseText::ABBREVS, MorsePreferences::generatorOptions, true,
                 0, "a", &morseModeGenerator}, //
@@ -72,12 +87,12 @@ const MenuItem menuItems[] = {
                 0, "a", &morseModeGenerator}, //
         {"Mixed", _genMixed, {1, _genCalls, _genPlayer, _gen, 0}, MorseText::MIXED, MorsePreferences::generatorOptions, true,
                 0, "a", &morseModeGenerator}, //
-        {"File Player", _genPlayer, {1, _genMixed, _genRand, _gen, 0}, MorseText::PLAYER, MorsePreferences::playerOptions, true,
+        {"File Player", _genPlayer, {1, _genMixed, _genQso, _gen, 0}, MorseText::PLAYER, MorsePreferences::playerOptions, true,
                 0, "player", &morseModeGenerator}, //
 
         {"Echo Trainer", _echo, {0, _gen, _koch, _dummy, _echoRand}, MorseText::NA, MorsePreferences::echoTrainerOptions, true,
                 0, "", 0}, //
-        {"Random", _echoRand, {1, _echoPlayer, _echoAbb, _echo, 0}, MorseText::RANDOMS, MorsePreferences::echoTrainerOptions, true,
+        {"Random", _echoRand, {1, _echoQso, _echoAbb, _echo, 0}, MorseText::RANDOMS, MorsePreferences::echoTrainerOptions, true,
                 0, "a", &morseModeEchoTrainer}, //
         {"CW Abbrevs", _echoAbb, {1, _echoRand, _echoWords, _echo, 0}, MorseText::ABBREVS, MorsePreferences::echoTrainerOptions, true,
                 0, "a", &morseModeEchoTrainer}, //
@@ -87,7 +102,7 @@ const MenuItem menuItems[] = {
                 0, "a", &morseModeEchoTrainer}, //
         {"Mixed", _echoMixed, {1, _echoCalls, _echoPlayer, _echo, 0}, MorseText::MIXED, MorsePreferences::echoTrainerOptions, true,
                 0, "a", &morseModeEchoTrainer}, //
-        {"File Player", _echoPlayer, {1, _echoMixed, _echoRand, _echo, 0}, MorseText::PLAYER, MorsePreferences::echoPlayerOptions,
+        {"File Player", _echoPlayer, {1, _echoMixed, _echoQso, _echo, 0}, MorseText::PLAYER, MorsePreferences::echoPlayerOptions,
                 true, 0, "player", &morseModeEchoTrainer}, //
 
         {"Koch Trainer", _koch, {0, _echo, _head, _dummy, _kochSel}, MorseText::NA, MorsePreferences::kochEchoOptions, true,
@@ -120,7 +135,7 @@ const MenuItem menuItems[] = {
 
         {"Head Copying", _head, {0, _koch, _tennis, _dummy, _headRand}, MorseText::NA, MorsePreferences::headOptions, true,
                 0, "", 0}, //
-        {"Random", _headRand, {1, _headPlayer, _headAbb, _head, 0}, MorseText::RANDOMS, MorsePreferences::headOptions, true,
+        {"Random", _headRand, {1, _headQso, _headAbb, _head, 0}, MorseText::RANDOMS, MorsePreferences::headOptions, true,
                 0, "a", &morseModeHeadCopying}, //
         {"CW Abbrevs", _headAbb, {1, _headRand, _headWords, _head, 0}, MorseText::ABBREVS, MorsePreferences::headOptions, true,
                 0, "a", &morseModeHeadCopying}, //
@@ -130,13 +145,13 @@ const MenuItem menuItems[] = {
                 0, "a", &morseModeHeadCopying}, //
         {"Mixed", _headMixed, {1, _headCalls, _headPlayer, _head, 0}, MorseText::MIXED, MorsePreferences::headOptions, true,
                 0, "a", &morseModeHeadCopying}, //
-        {"File Player", _headPlayer, {1, _headMixed, _headRand, _head, 0}, MorseText::PLAYER, MorsePreferences::headOptions, true,
+        {"File Player", _headPlayer, {1, _headMixed, _headQso, _head, 0}, MorseText::PLAYER, MorsePreferences::headOptions, true,
                 0, "player", &morseModeHeadCopying}, //
 
-        {"Morse Tennis", _tennis, {0, _head, _trx, _dummy, 0}, MorseText::NA, MorsePreferences::morseTennisOptions, true,
+        {"Morse Tennis", _tennis, {0, _head, _pileUp, _dummy, 0}, MorseText::NA, MorsePreferences::morseTennisOptions, true,
                0, "", &morseModeTennis}, //
 
-        {"Transceiver", _trx, {0, _tennis, _decode, _dummy, _trxLora}, MorseText::NA, MorsePreferences::noOptions, true,
+        {"Transceiver", _trx, {0, _pileUp, _decode, _dummy, _trxLora}, MorseText::NA, MorsePreferences::noOptions, true,
                 0, "", 0}, //
         {"LoRa Trx", _trxLora, {1, _trxIcw, _trxIcw, _trx, 0}, MorseText::NA, MorsePreferences::loraTrxOptions, true,
                 0, "trx", &morseModeLoRa}, //
@@ -159,8 +174,27 @@ const MenuItem menuItems[] = {
         {"Update Firmw", _wifi_update, {1, _wifi_upload, _wifi_mac, _wifi, 0}, MorseText::NA, MorsePreferences::noOptions, false,
                 &MorseWifi::menuExec, "update", 0}, //
 
-        {"Go To Sleep", _goToSleep, {0, _wifi, _keyer, _dummy, 0}, MorseText::NA, MorsePreferences::noOptions, false,
-                &MorseSystem::menuExec, "sleep", 0}
+        {"Go To Sleep", _goToSleep, {0, _wifi, _charStats, _dummy, 0}, MorseText::NA, MorsePreferences::noOptions, false,
+                &MorseSystem::menuExec, "sleep", 0}, //
+
+        {"Diagnostics", _diagnostics, {0, _fistStats, _keyer, _dummy, 0}, MorseText::NA, MorsePreferences::noOptions, false,
+                &MorseDiagnostics::menuExec, "show", 0}, //
+
+        {"Char Stats", _charStats, {0, _goToSleep, _fistStats, _dummy, 0}, MorseText::NA, MorsePreferences::noOptions, false,
+                &MorseStats::menuExec, "show", 0}, //
+
+        {"Fist Stats", _fistStats, {0, _charStats, _afterStats, _dummy, 0}, MorseText::NA, MorsePreferences::noOptions, false,
+                &MorseFist::menuExec, "show", 0}, //
+
+        {"QSO", _genQso, {1, _genPlayer, _genRand, _gen, 0}, MorseText::QSO, MorsePreferences::generatorOptions, true,
+                0, "qso", &morseModeGenerator}, //
+        {"QSO", _echoQso, {1, _echoPlayer, _echoRand, _echo, 0}, MorseText::QSO, MorsePreferences::echoTrainerOptions, true,
+                0, "qso", &morseModeEchoTrainer}, //
+        {"QSO", _headQso, {1, _headPlayer, _headRand, _head, 0}, MorseText::QSO, MorsePreferences::headOptions, true,
+                0, "qso", &morseModeHeadCopying}, //
+
+        {"Pile-Up", _pileUp, {0, _tennis, _trx, _dummy, 0}, MorseText::NA, MorsePreferences::pileUpOptions, true,
+               0, "", &morseModePileUp}
 
 };
 
@@ -189,7 +223,13 @@ void MorseMenu::menu_()
     uint8_t newMenuPtr = MorsePreferences::prefs.menuPtr;
     uint8_t disp = 0;
     int t, command;
+    MorseMode *leaving = MorseMenu::getCurrentMenuItem()->mode;
 
+    if (leaving)
+    {
+        leaving->onLeave();
+    }
+    MorseSessionLog::end();
     MorseLoRa::idle();
     MorseMenu::cleanStartSettings();
     MorseDisplay::clearScroll();                  // clear the buffer
@@ -214,7 +254,6 @@ void MorseMenu::menu_()
         {
             quickStart = false;
             command = 1;
-            delay(500);
             MorseDisplay::printOnScrollFlash(2, REGULAR, 1, "QUICK START");
         }
         else
@@ -332,6 +371,10 @@ boolean internal::menuExec()
     Koch::setKochActive(false);
     MorseText::start(menuItems[MorsePreferences::prefs.menuPtr].generatorMode);
     MorsePreferences::currentOptions = menuItems[MorsePreferences::prefs.menuPtr].options;
+    if (menuItems[MorsePreferences::prefs.menuPtr].remember)
+    {
+        MorseSessionLog::begin(MorsePreferences::prefs.menuPtr);      // a practice session, not a utility like WiFi
+    }
 
     if (getCurrentMenuItem()->mode != 0)
     {
@@ -354,7 +397,7 @@ boolean internal::menuExec()
 void MorseMenu::cleanStartSettings()
 {
     MorseGenerator::generatorState = MorseGenerator::KEY_UP;
-    MorseKeyer::keyerState = MorseKeyer::IDLE_STATE;
+    MorseKeyer::keyer.reset(micros());
     Decoder::interWordTimer = 4294967000;   // almost the biggest possible unsigned long number :-) - do not output a space at the beginning
     MorseDisplay::displayTopLine();
 }
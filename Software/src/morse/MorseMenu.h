@@ -10,6 +10,8 @@
 namespace MorseMenu
 {
 
+    /// the values index menuItems[] and are stored in the preferences (menuPtr, quick start): new items are added at
+    /// the end, wherever they are in the menu - that is set by their navigation in menuItems[]
     enum menuNo
     {
         _dummy,
@@ -59,7 +61,14 @@ namespace MorseMenu
         _wifi_check,
         _wifi_upload,
         _wifi_update,
-        _goToSleep
+        _goToSleep,
+        _diagnostics,
+        _charStats,
+        _fistStats,
+        _genQso,
+        _echoQso,
+        _headQso,
+        _pileUp
     };
 
     typedef struct menuItem_t
@@ -29,6 +29,22 @@ class MorseMode
          */
         virtual void onPreferencesChanged() = 0;
 
+        /**
+         * Called when the user leaves the mode: back to the menu, or to sleep.
+         */
+        virtual void onLeave()
+        {
+        }
+
+        /**
+         * Tells when loop() has to be called next (in µs, like micros()), unless a paddle is touched.
+         * Returns false if the mode wants to be called at its period - the default.
+         */
+        virtual boolean getWakeTime(unsigned long &at)
+        {
+            return false;
+        }
+
 };
 
 #endif /* MORSEMODE_H_ */
@@ -18,6 +18,7 @@
 #include "MorseKeyer.h"
 #include "MorseGenerator.h"
 #include "MorseDisplay.h"
+#include "MorseSessionLog.h"
 
 MorseModeDecoder morseModeDecoder;
 
@@ -40,7 +41,7 @@ boolean MorseModeDecoder::menuExec(String mode)
 
     Decoder::startDecoder();
     Decoder::onCharacter = [](String s)
-    {   MorseDisplay::printToScroll(FONT_INCOMING, s);};
+    {   MorseDisplay::printToScroll(FONT_INCOMING, s); MorseSessionLog::decoded(s);};
     Decoder::onWordEnd = []()
     {   MorseDisplay::printToScroll(FONT_INCOMING, " ");};
 
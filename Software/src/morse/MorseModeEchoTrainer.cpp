@@ -18,10 +18,14 @@
 #include "MorseDisplay.h"
 #include "MorseGenerator.h"
 #include "MorsePlayerFile.h"
+#include "MorseQso.h"
 #include "MorseMachine.h"
 #include "MorseMenu.h"
 #include "decoder.h"
 #include "MorseInput.h"
+#include "MorseStats.h"
+#include "koch.h"
+#include "MorseSessionLog.h"
 
 MorseModeEchoTrainer morseModeEchoTrainer;
 
@@ -33,6 +37,10 @@ boolean MorseModeEchoTrainer::menuExec(String mode)
     {
         MorsePlayerFile::openAndSkip();
     }
+    else if (mode == "qso")
+    {
+        MorseQso::start();
+    }
     MorseModeEchoTrainer::startEcho();
     return true;
 }
@@ -41,6 +49,7 @@ void MorseModeEchoTrainer::startEcho()
 {
     MorseMachine::morseState = MorseMachine::echoTrainer;
     MorseGenerator::setStart();
+    kochHintShown = false;
 
     MorseInput::start(
     [](String r)
@@ -71,6 +80,7 @@ void MorseModeEchoTrainer::startEcho()
     MorseDisplay::printToScroll(REGULAR, "");      // clear the buffer
     MorseKeyer::keyTx = false;
     MorseModeEchoTrainer::onPreferencesChanged();
+    beginSpeed();
 
     metConfig.showFailedWord = !MorseMenu::isCurrentMenuItem(MorseMenu::_kochLearn);
     metConfig.generateStartSequence = false;
@@ -158,25 +168,48 @@ MorseModeEchoTrainer::echoStates MorseModeEchoTrainer::getState()
 void MorseModeEchoTrainer::storeCharInResponse(String symbol)
 {
     symbol = MorseText::proSignsToInternal(symbol);
+    unsigned int i = echoResponse.length();
+    if (i < CharStats::MAX_WORD)
+    {
+        unsigned long now = millis();
+        responseMs[i] = now - lastResponse < 0xffff ? now - lastResponse : 0xffff;
+        lastResponse = now;
+        for (unsigned int k = i + 1; k < i + symbol.length() && k < CharStats::MAX_WORD; ++k)
+        {
+            responseMs[k] = 0;
+        }
+    }
     echoResponse.concat(symbol);
 }
 
 ///////// evaluate the response in Echo Trainer Mode
+/// the pause before the next word (and the OK or ERR signal) is left to the generator: it does not start
+/// before genTimer, and meanwhile paddles, buttons and the display keep working
 void MorseModeEchoTrainer::echoTrainerEval()
 {
-    delay(MorseKeyer::interCharacterSpace / 2);
+    unsigned long pause = MorseKeyer::interCharacterSpace / 2 + MorseKeyer::interWordSpace;
+
+    MorseSessionLog::response(echoResponse);
+    MorseSessionLog::result(echoResponse == echoTrainerWord, getResponseTime());
+    if (echoResponse != "")                 // no answer at all says nothing about the characters
+    {
+        MorseStats::evaluate(echoTrainerWord, echoResponse, responseMs);
+        MorseStats::review(echoTrainerWord, echoResponse, responseMs);
+        MorseText::onEvaluated(echoTrainerWord);
+    }
+    if (MorsePreferences::prefs.spacedRepetition && Koch::isKochActive() && !kochHintShown
+            && MorseStats::schedule.isLearned(Koch::kochChars.substring(0, MorsePreferences::prefs.kochFilter).c_str()))
+    {
+        MorseDisplay::printToScroll(REGULAR, "Koch: next lesson?\n");
+        kochHintShown = true;
+    }
     if (echoResponse == echoTrainerWord)
     {
         echoTrainerState = SEND_WORD;
         MorseDisplay::printToScroll(BOLD, "OK\n");
         if (MorsePreferences::prefs.echoConf)
         {
-            MorseSound::soundSignalOK();
-        }
-        delay(MorseKeyer::interWordSpace);
-        if (MorsePreferences::prefs.speedAdapt)
-        {
-            MorseKeyer::changeSpeed(1);
+            pause += MorseSound::soundSignalOK();
         }
         MorseText::proceed();
     }
@@ -188,24 +221,73 @@ void MorseModeEchoTrainer::echoTrainerEval()
             MorseDisplay::printToScroll(BOLD, "ERR\n");
             if (MorsePreferences::prefs.echoConf)
             {
-                MorseSound::soundSignalERR();
+                pause += MorseSound::soundSignalERR();
             }
         }
         else
         {
             MorseDisplay::printToScroll(REGULAR, "\n");
         }
-
-        delay(MorseKeyer::interWordSpace);
-        if (MorsePreferences::prefs.speedAdapt)
-        {
-            MorseKeyer::changeSpeed(-1);
-        }
     }
+    if (MorsePreferences::prefs.speedAdapt)
+    {
+        adaptSpeed(echoResponse == echoTrainerWord);
+    }
+    MorseGenerator::genTimer = millis() + pause;
     echoResponse = "";
     MorseKeyer::clearPaddleLatches();
 }   // end of function
 
+/// beginSpeed starts the speed controller with the speed and the spacing of the preferences
+void MorseModeEchoTrainer::beginSpeed()
+{
+    speedController.begin(MorsePreferences::prefs.wpm, MorsePreferences::prefs.interCharSpace,
+            MorsePreferences::prefs.interWordSpace, MorsePreferences::prefs.adaptTarget);
+}
+
+/// adaptSpeed feeds the response into the speed controller, with the time it took compared to the time keying the
+/// word takes; the preferences are not changed before the session ends
+void MorseModeEchoTrainer::adaptSpeed(boolean right)
+{
+    if (MorseKeyer::ditLength != speedController.getTimings().ditLength)
+    {
+        beginSpeed();                       // the speed has been set by hand meanwhile: start from there
+    }
+    if (speedController.onWord(right, getResponseTime(), MorseKeyer::ditLength * MorseText::getDits(echoTrainerWord)))
+    {
+        MorseKeyer::setTimings(speedController.getTimings());
+        MorseDisplay::displayCWspeed();
+    }
+}
+
+/// getResponseTime is the time in ms from the prompt to the last character of the response
+unsigned long MorseModeEchoTrainer::getResponseTime()
+{
+    unsigned long response = 0;
+
+    for (unsigned int i = 0; i < echoResponse.length() && i < CharStats::MAX_WORD; ++i)
+    {
+        response += responseMs[i];
+    }
+    return response;
+}
+
+/// onLeave saves the speed the session has ended with
+void MorseModeEchoTrainer::onLeave()
+{
+    if (!speedController.isChanged())
+    {
+        return;
+    }
+    const SpeedController::Timings &t = speedController.getTimings();
+    MorsePreferences::prefs.wpm = t.wpm;
+    MorsePreferences::prefs.interCharSpace = t.charSpaceDits;
+    MorsePreferences::prefs.interWordSpace = t.wordSpaceDits;
+    MorsePreferences::writeSpeed();
+    MorseKeyer::updateTimings();
+    beginSpeed();
+}
+
 /**
  * @return: -1: NOOB,
  */
@@ -237,6 +319,8 @@ unsigned long MorseModeEchoTrainer::onGeneratorWordEnd()
             else
             {
                 MorseModeEchoTrainer::setState(MorseModeEchoTrainer::GET_ANSWER);
+                MorseKeyer::clearPaddleLatches();       // what the paddles did during the pause and the prompt does not count
+                MorseModeEchoTrainer::lastResponse = millis();
                 if (metConfig.showPrompt)
                 {
                     MorseDisplay::printToScroll(REGULAR, " ");
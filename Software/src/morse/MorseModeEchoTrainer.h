@@ -2,6 +2,8 @@
 #define MORSEMODEECHOTRAINER_H_
 
 #include "MorseMode.h"
+#include "CharStats.h"
+#include "SpeedController.h"
 
 class MorseModeEchoTrainer: public MorseMode
 {
@@ -15,6 +17,7 @@ class MorseModeEchoTrainer: public MorseMode
 
         boolean menuExec(String mode) override;
         void onPreferencesChanged() override;
+        void onLeave() override;
         boolean loop() override;
         boolean togglePause() override;
         void onFetchNewWord();
@@ -37,8 +40,12 @@ class MorseModeEchoTrainer: public MorseMode
 
         String echoResponse = "";
         String echoTrainerWord;
+        uint16_t responseMs[CharStats::MAX_WORD];  // per character of the response: ms since the previous one (or the prompt)
+        unsigned long lastResponse;               // when the previous character was keyed
         boolean echoStop;                         // for maxSequence
         boolean active;                           // flag for trainer mode
+        boolean kochHintShown;                    // the next Koch lesson has been suggested in this session
+        SpeedController speedController;          // adaptive speed: the speed of this session, saved when it ends
         int repeats;
         echoStates echoTrainerState;
 
@@ -48,6 +55,9 @@ class MorseModeEchoTrainer: public MorseMode
         void storeCharInResponse(String symbol);
         echoStates getState();
         void changeSpeed(int t);
+        void beginSpeed();
+        void adaptSpeed(boolean right);
+        unsigned long getResponseTime();
         unsigned long onGeneratorWordEnd();
         void onGeneratorNewWord(String newWord);
         void onLastWord();
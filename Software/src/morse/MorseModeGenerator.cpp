@@ -21,8 +21,10 @@
 #include "MorseKeyer.h"
 #include "MorseText.h"
 #include "MorsePlayerFile.h"
+#include "MorseQso.h"
 #include "MorseModeHeadCopying.h"
 #include "MorseLoRaCW.h"
+#include "MorseBand.h"
 
 MorseModeGenerator morseModeGenerator;
 
@@ -35,6 +37,10 @@ boolean MorseModeGenerator::menuExec(String mode)
     {
         MorsePlayerFile::openAndSkip();
     }
+    else if (mode == "qso")
+    {
+        MorseQso::start();
+    }
 
     MorseModeGenerator::startTrainer();
     MorseModeGenerator::onPreferencesChanged();
@@ -103,6 +109,13 @@ void MorseModeGenerator::onPreferencesChanged()
             MorseLoRaCW::cwForLora(e);
         }
     };
+    MorseBand::start();
+}
+
+/// onLeave stops noise, QSB and QRM
+void MorseModeGenerator::onLeave()
+{
+    MorseBand::stop();
 }
 
 boolean MorseModeGenerator::togglePause()
@@ -150,6 +163,18 @@ boolean MorseModeGenerator::loop()
     {
         MorseGenerator::generateCW();
     }
+    MorseBand::update();
 
     return false;
 }
+
+/// while paused, only a paddle (which wakes the mode task) or the user interface can change anything
+boolean MorseModeGenerator::getWakeTime(unsigned long &at)
+{
+    if (active)
+    {
+        return MorseGenerator::getWakeTime(at);
+    }
+    at = micros() + 100000;
+    return true;
+}
@@ -9,7 +9,9 @@ class MorseModeGenerator: public MorseMode
         boolean menuExec(String mode) override;
         boolean loop() override;
         void onPreferencesChanged() override;
+        void onLeave() override;
         boolean togglePause() override;
+        boolean getWakeTime(unsigned long &at) override;
 
     private:
         boolean active;
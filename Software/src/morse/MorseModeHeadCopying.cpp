@@ -4,6 +4,13 @@
 #include "MorseText.h"
 #include "MorseModeHeadCopying.h"
 #include "MorsePlayerFile.h"
+#include "MorseQso.h"
+#include "MorseMenu.h"
+#include "MorseInput.h"
+#include "MorseStats.h"
+#include "MorseSessionLog.h"
+#include "SpeedController.h"
+#include "MorseBand.h"
 
 MorseModeHeadCopying morseModeHeadCopying;
 
@@ -31,6 +38,10 @@ boolean MorseModeHeadCopying::menuExec(String mode)
     {
         MorsePlayerFile::openAndSkip();
     }
+    else if (mode == "qso")
+    {
+        MorseQso::start();
+    }
 
     autoStopState = off;
     MorseDisplay::getConfig()->autoFlush = false;
@@ -39,9 +50,53 @@ boolean MorseModeHeadCopying::menuExec(String mode)
     texCon->repeatEach = 1;
     texCon->generateStartSequence = false;
 
+    scoring = MorsePreferences::prefs.keyedAnswer;
+    if (scoring)
+    {
+        startScoring();
+    }
+    MorseBand::start();
     return true;
 }
 
+/// startScoring: the word is not shown before the answer has been keyed, and the scorer starts with the length of the
+/// preferences for what is generated, and the speed of the preferences
+void MorseModeHeadCopying::startScoring()
+{
+    uint8_t length = 0;
+
+    MorseInput::start([](String r)
+    {   morseModeHeadCopying.onCharacter(r);},
+    []()
+    {   morseModeHeadCopying.onWordEnd();});
+
+    MorseGenerator::Config *genCon = MorseGenerator::getConfig();
+    genCon->printChar = false;
+    genCon->wordEndMethod = MorseGenerator::nothing;
+    MorseDisplay::getConfig()->autoFlush = true;
+
+    switch (MorseText::getConfig()->generatorMode)
+    {
+        case MorseText::RANDOMS:
+            length = MorsePreferences::prefs.randomLength;
+            break;
+        case MorseText::CALLS:
+            length = MorsePreferences::prefs.callLength;
+            break;
+        case MorseText::ABBREVS:
+            length = MorsePreferences::prefs.abbrevLength;
+            break;
+        case MorseText::WORDS:
+            length = MorsePreferences::prefs.wordLength;
+            break;
+        default:
+            break;
+    }
+    active = answered = false;
+    scorer.begin(length, MorsePreferences::prefs.wpm);
+    applyLevel();
+}
+
 void MorseModeHeadCopying::startTrainer()
 {
     MorseGenerator::setStart();
@@ -59,18 +114,41 @@ void MorseModeHeadCopying::startTrainer()
 
 unsigned long MorseModeHeadCopying::onGeneratorWordEnd()
 {
+    if (scoring)
+    {
+        scorer.wordEnd(MorseText::getCurrentWord().c_str(), millis());
+        MorseKeyer::clearPaddleLatches();       // what the paddles did while the word was sent does not count
+        MorseDisplay::printToScroll(INVERSE_REGULAR, ">");
+        return -1;
+    }
     autoStopState = stop1;
     return -1;
 }
 
+/// isTouched is true once for each touch of a paddle
+boolean MorseModeHeadCopying::isTouched()
+{
+    boolean pressed = MorseKeyer::leftKey || MorseKeyer::rightKey;
+    boolean touched = pressed && !paddlesHeld;
+
+    paddlesHeld = pressed;
+    return touched;
+}
+
 boolean MorseModeHeadCopying::loop()
 {
-    boolean activeOld = MorseModeHeadCopying::active;
+    MorseBand::update();
+    if (scoring)
+    {
+        return scoringLoop();
+    }
 
-    if ((autoStopState == MorseModeHeadCopying::stop1) || MorseKeyer::leftKey || MorseKeyer::rightKey)
+    boolean activeOld = MorseModeHeadCopying::active;
+    boolean touched = isTouched();
+    if ((autoStopState == MorseModeHeadCopying::stop1) || touched)
     {                                    // touching a paddle starts and stops the generation of code
 
-        if (MorseKeyer::leftKey)
+        if (touched && MorseKeyer::leftKey)
         {
             MorseText::setRepeatLast();
             MorseDisplay::clearScrollBuffer();
@@ -82,10 +160,6 @@ boolean MorseModeHeadCopying::loop()
             MorseGenerator::getConfig()->wordEndMethod = MorseModeHeadCopying::wordEndMethod;
         }
 
-        // for debouncing:
-        while (MorseKeyer::checkPaddles())
-            ;                                                           // wait until paddles are released
-
         MorseModeHeadCopying::active = (autoStopState == MorseModeHeadCopying::off);
         switch (autoStopState)
         {
@@ -139,9 +213,123 @@ boolean MorseModeHeadCopying::loop()
     return false;
 }
 
+/// scoringLoop: a touch starts, then each word is sent, answered and scored; if there is no answer, we stop
+boolean MorseModeHeadCopying::scoringLoop()
+{
+    if (MorseGenerator::stopFlag)
+    {
+        active = MorseGenerator::stopFlag = false;
+        MorseGenerator::keyOut(false, true, 0, 0);
+        MorseDisplay::printOnStatusLine(true, 0, "Continue w/ Paddle");
+    }
+    if (!active)
+    {
+        if (isTouched())
+        {
+            active = true;
+            MorseMenu::cleanStartSettings();
+            MorseGenerator::genTimer = millis() + MorseKeyer::interWordSpace;
+        }
+        return false;
+    }
+    if (scorer.isWaiting())
+    {
+        if (answered || scorer.isTimedOut(millis()))
+        {
+            evaluate();
+        }
+        else if (MorseInput::doInput())
+        {
+            return true;
+        }
+        return false;
+    }
+    paddlesHeld = MorseKeyer::leftKey || MorseKeyer::rightKey;      // keying the answer is not a touch
+    MorseGenerator::generateCW();
+    return false;
+}
+
+void MorseModeHeadCopying::onCharacter(String symbol)
+{
+    MorseDisplay::printToScroll(FONT_OUTGOING, symbol);
+    scorer.character(MorseText::proSignsToInternal(symbol).c_str(), millis());
+}
+
+void MorseModeHeadCopying::onWordEnd()
+{
+    if (scorer.isWaiting() && scorer.getResponse()[0])
+    {
+        answered = true;
+    }
+}
+
+/// evaluate shows the word that was sent and the score of the answer, and makes the next words harder or easier
+void MorseModeHeadCopying::evaluate()
+{
+    String word = scorer.getWord();
+    String response = scorer.getResponse();
+    HeadCopyScorer::Result r = scorer.evaluate(millis());
+
+    answered = false;
+    MorseSessionLog::response(response);
+    MorseSessionLog::result(r.right, r.responseMs);
+    if (response != "")
+    {
+        MorseStats::evaluate(word, response, 0);
+    }
+    if (r.right)
+    {
+        MorseDisplay::printToScroll(BOLD, " OK");
+    }
+    else
+    {
+        MorseDisplay::printToScroll(BOLD, " ERR ");
+        MorseDisplay::printToScroll(INVERSE_REGULAR, MorseText::internalToProSigns(word));
+    }
+    MorseDisplay::printToScroll(REGULAR, " " + String(r.score) + "%\n");
+    if (r.levelChanged)
+    {
+        applyLevel();
+        MorseDisplay::printToScroll(REGULAR, "Level " + String((int) scorer.getLevel()) + "\n");
+    }
+    if (response == "")
+    {
+        active = false;                 // nobody there: stop
+        MorseGenerator::keyOut(false, true, 0, 0);
+        MorseDisplay::printOnStatusLine(true, 0, "Continue w/ Paddle");
+    }
+    MorseGenerator::genTimer = millis() + MorseKeyer::interWordSpace;
+    MorseKeyer::clearPaddleLatches();
+}
+
+/// applyLevel sets the length of the words and the speed of the scorer's level; the speed keeps the spacing of the
+/// preferences, and the preferences are not changed
+void MorseModeHeadCopying::applyLevel()
+{
+    SpeedController speed;
+
+    MorseText::getConfig()->maxLength = scorer.getLength();
+    speed.begin(scorer.getWpm(), MorsePreferences::prefs.interCharSpace, MorsePreferences::prefs.interWordSpace,
+            MorsePreferences::prefs.adaptTarget);
+    MorseKeyer::setTimings(speed.getTimings());
+    MorseDisplay::displayCWspeed();
+}
+
 void MorseModeHeadCopying::onPreferencesChanged()
 {
+    MorseBand::start();
+}
 
+/// onLeave goes back to the speed of the preferences, and stops noise, QSB and QRM
+void MorseModeHeadCopying::onLeave()
+{
+    MorseBand::stop();
+    if (scoring)
+    {
+        MorseText::getConfig()->maxLength = 0;
+        MorseKeyer::updateTimings();
+        scoring = false;
+    }
 }
 
 boolean MorseModeHeadCopying::togglePause()
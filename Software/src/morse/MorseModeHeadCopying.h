@@ -4,6 +4,7 @@
 #include <Arduino.h>
 #include "MorseMode.h"
 #include "MorseGenerator.h"
+#include "HeadCopyScorer.h"
 
 class MorseModeHeadCopying: public MorseMode
 {
@@ -20,13 +21,25 @@ class MorseModeHeadCopying: public MorseMode
         boolean menuExec(String mode) override;
         boolean loop() override;
         void onPreferencesChanged() override;
+        void onLeave() override;
         boolean togglePause() override;
+        void onCharacter(String symbol);
+        void onWordEnd();
 
     private:
         boolean active = false;
+        boolean paddlesHeld = false;            // a touch counts once: we wait for the paddles to be released (without waiting)
+        boolean scoring = false;                // keyed answer: the user keys what they have copied, and it is scored
+        boolean answered = false;               // the keyed answer is complete
+        HeadCopyScorer scorer;
 
         unsigned long onGeneratorWordEnd();
         void startTrainer();
+        void startScoring();
+        boolean isTouched();
+        boolean scoringLoop();
+        void evaluate();
+        void applyLevel();
 };
 
 extern MorseModeHeadCopying morseModeHeadCopying;
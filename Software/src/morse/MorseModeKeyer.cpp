@@ -46,6 +46,11 @@ boolean MorseModeKeyer::loop()
     return MorseKeyer::doPaddleIambic();
 }
 
+boolean MorseModeKeyer::getWakeTime(unsigned long &at)
+{
+    return MorseKeyer::getWakeTime(at);
+}
+
 void MorseModeKeyer::onPreferencesChanged()
 {
     unsigned char mode = MorsePreferences::prefs.keyTrainerMode;
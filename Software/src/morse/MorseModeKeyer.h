@@ -10,6 +10,7 @@ class MorseModeKeyer: public MorseMode
         void onPreferencesChanged() override;
         boolean loop() override;
         boolean togglePause() override;
+        boolean getWakeTime(unsigned long &at) override;
 };
 
 extern MorseModeKeyer morseModeKeyer;
@@ -17,6 +17,7 @@
 #include "MorseGenerator.h"
 #include "MorseModeGenerator.h"
 #include "MorseModeEchoTrainer.h"
+#include "MorseBand.h"
 
 MorseModeKoch morseModeKoch;
 
@@ -41,6 +42,7 @@ boolean MorseModeKoch::menuExec(String mode)
         MorseGenerator::startTrainer();
         generatorConfig->printDitDah = false;
         generatorConfig->wordEndMethod = MorseGenerator::spaceAndFlush;
+        MorseBand::start();
     }
     else if (mode == "echo")
     {
@@ -80,3 +82,8 @@ void MorseModeKoch::onPreferencesChanged()
 {
     return morseModeGenerator.onPreferencesChanged();
 }
+
+void MorseModeKoch::onLeave()
+{
+    morseModeGenerator.onLeave();
+}
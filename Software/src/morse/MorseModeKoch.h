@@ -11,6 +11,7 @@ class MorseModeKoch: public MorseMode
         boolean loop() override;
         boolean togglePause() override;
         void onPreferencesChanged() override;
+        void onLeave() override;
 
     private:
         String kochMode;
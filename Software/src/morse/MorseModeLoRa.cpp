@@ -64,6 +64,7 @@ boolean MorseModeLoRa::menuExec(String mode)
         genCon->timing = MorseGenerator::rx;
 
         MorseDisplay::getConfig()->autoFlush = true;
+        MorseLoRaCW::clearStreams();
 
         onPreferencesChanged();
 
@@ -74,6 +75,7 @@ boolean MorseModeLoRa::menuExec(String mode)
 
 boolean MorseModeLoRa::loop()
 {
+    MorseLoRaCW::receiveIntoStreams();                                      // sort what we received by sending station
     if (MorseInput::doInput())
     {
         return true;                                                        // we are busy keying and so need a very tight loop !
@@ -0,0 +1,211 @@
+/******************************************************************************************************************************
+ *  morse_3 Software for the Morserino-32 multi-functional Morse code machine, based on the Heltec WiFi LORA (ESP32) module ***
+ *  Copyright (C) 2018  Willi Kraml, OE1WKL                                                                                 ***
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this program.
+ *  If not, see <https://www.gnu.org/licenses/>.
+ *****************************************************************************************************************************/
+#include "MorseModePileUp.h"
+#include "MorsePreferences.h"
+#include "MorseMachine.h"
+#include "MorseDisplay.h"
+#include "MorseKeyer.h"
+#include "MorseSound.h"
+#include "MorseText.h"
+#include "MorseInput.h"
+#include "HeadCopyScorer.h"
+
+MorseModePileUp morseModePileUp;
+
+boolean MorseModePileUp::menuExec(String mode)
+{
+    MorsePreferences::currentOptions = MorsePreferences::pileUpOptions;
+    MorseMachine::morseState = MorseMachine::pileUp;
+    MorseDisplay::clear();
+    MorseDisplay::printOnScroll(0, REGULAR, 0, "Pile-Up       ");
+    MorseDisplay::printOnScroll(1, REGULAR, 0, "Key the calls ");
+    MorseDisplay::printOnScroll(2, REGULAR, 0, "you copy      ");
+    delay(1250);
+    MorseDisplay::clear();
+    MorseDisplay::displayTopLine();
+    MorseDisplay::clearScroll();
+
+    MorseInput::start([](String c)
+    {   morseModePileUp.onCharacter(c);},
+    []()
+    {   morseModePileUp.onWordEnd();});
+    MorseKeyer::keyTx = false;
+    MorseDisplay::getConfig()->autoFlush = true;
+
+    MorseSound::startMixer(MorsePreferences::prefs.sidetoneVolume, true);
+    worked = 0;
+    startPileUp();
+    return true;
+}
+
+boolean MorseModePileUp::loop()
+{
+    if (MorseInput::doInput())
+    {
+        return true;
+    }
+    if (answered)
+    {
+        evaluate();
+        return false;
+    }
+    if (isCalling())
+    {
+        quietSince = millis();
+        return false;
+    }
+    if (count == 0)
+    {
+        MorseDisplay::printToScroll(REGULAR, String(worked) + " QSOs\n");
+        startPileUp();
+    }
+    else if (callAgain || (answer == "" && millis() - quietSince > REPEAT))
+    {
+        call(-1);
+    }
+    return false;
+}
+
+/// startPileUp: 2 - MAX_CALLERS stations with different calls, pitches around the sidetone and speeds around the
+/// speed of the preferences; the levels leave room for the sidetone in the mix
+void MorseModePileUp::startPileUp()
+{
+    int pitch = MorseSound::notes[MorsePreferences::prefs.sidetoneFreq];
+    int wpm = MorsePreferences::prefs.wpm;
+
+    count = random(2, MAX_CALLERS + 1);
+    for (uint8_t i = 0; i < count; ++i)
+    {
+        Caller &c = callers[i];
+        boolean unique;
+        do
+        {
+            c.call = MorseText::getRandomCall(MorsePreferences::prefs.callLength);
+            unique = true;
+            for (uint8_t j = 0; j < i; ++j)
+            {
+                unique = unique && callers[j].call != c.call;
+            }
+        } while (!unique);
+        c.pitch = _max(300, pitch + (int) random(-300, 301));
+        c.wpm = _max(5, wpm + (int) random(-4, 5));
+        c.level = random(10, 21);
+    }
+    answer = "";
+    answered = false;
+    MorseDisplay::printToScroll(BOLD, String((int) count) + " calling\n");
+    call(-1);
+}
+
+/// call lets all stations call once (only < 0), each at a random time in the next 1.5 s, or one station call twice
+void MorseModePileUp::call(int8_t only)
+{
+    callAgain = false;
+    for (uint8_t i = 0; i < count; ++i)
+    {
+        const Caller &c = callers[i];
+        if (only < 0)
+        {
+            MorseSound::mixerSend(i, MorseText::toCode(c.call).c_str(), c.pitch, c.wpm, c.level, random(0, 1500));
+        }
+        else if (i == only)
+        {
+            MorseSound::mixerSend(i, MorseText::toCode(c.call + " " + c.call).c_str(), c.pitch, c.wpm, c.level, 0);
+        }
+    }
+}
+
+boolean MorseModePileUp::isCalling()
+{
+    for (uint8_t i = 0; i < MorseSound::mixerVoices; ++i)
+    {
+        if (MorseSound::isMixerSending(i))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void MorseModePileUp::onCharacter(String symbol)
+{
+    MorseDisplay::printToScroll(FONT_OUTGOING, symbol);
+    answer += symbol;
+}
+
+void MorseModePileUp::onWordEnd()
+{
+    if (answer != "")
+    {
+        answered = true;
+    }
+}
+
+/// evaluate: the station that was called answers and is logged; if none was, the one that is closest repeats its call,
+/// unless it is too far off - then they all call again
+void MorseModePileUp::evaluate()
+{
+    int8_t best = -1;
+    uint8_t distance = 255;
+
+    for (uint8_t i = 0; i < count; ++i)
+    {
+        uint8_t d = HeadCopyScorer::getDistance(callers[i].call.c_str(), answer.c_str());
+        if (d < distance)
+        {
+            distance = d;
+            best = i;
+        }
+    }
+
+    if (distance == 0)
+    {
+        const Caller &c = callers[best];
+        MorseDisplay::printToScroll(BOLD, " OK\n");
+        MorseSound::mixerSend(best, MorseText::toCode("r 5nn tu").c_str(), c.pitch, c.wpm, c.level, 300);
+        ++worked;
+        callers[best] = callers[--count];       // the last station takes its voice, once it is done (see loop())
+        callAgain = true;
+    }
+    else if (best >= 0 && distance <= _max(1, (int) callers[best].call.length() / 3))
+    {
+        MorseDisplay::printToScroll(BOLD, " ?\n");
+        call(best);
+    }
+    else
+    {
+        MorseDisplay::printToScroll(BOLD, " ERR\n");
+        callAgain = true;
+    }
+    answer = "";
+    answered = false;
+    MorseKeyer::clearPaddleLatches();
+}
+
+boolean MorseModePileUp::togglePause()
+{
+    return false;
+}
+
+void MorseModePileUp::onPreferencesChanged()
+{
+    MorseInput::setStraightKeyFromPrefs();
+}
+
+/// onLeave gives the tone PWM back to the sidetone
+void MorseModePileUp::onLeave()
+{
+    MorseSound::mixerStopAll();
+    MorseSound::stopMixer();
+}
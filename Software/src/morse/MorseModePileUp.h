@@ -0,0 +1,51 @@
+#ifndef MORSEMODEPILEUP_H_
+#define MORSEMODEPILEUP_H_
+
+#include <Arduino.h>
+#include "MorseMode.h"
+
+/// A pile-up: a few stations call at once, each with its own pitch, speed, level and start, mixed by MorseSound.
+/// The user keys the call they have copied: the station that was called exactly answers and is logged, one that was
+/// almost called repeats its call alone, and if nobody was meant, they all call again. When all are logged, the next
+/// pile-up starts.
+
+class MorseModePileUp: public MorseMode
+{
+    public:
+        static const uint8_t MAX_CALLERS = 4;
+        static const unsigned long REPEAT = 3000;   /// ms of silence before the stations call again
+
+        boolean menuExec(String mode) override;
+        boolean loop() override;
+        boolean togglePause() override;
+        void onPreferencesChanged() override;
+        void onLeave() override;
+        void onCharacter(String symbol);
+        void onWordEnd();
+
+    private:
+        struct Caller
+        {
+                String call;
+                uint16_t pitch;
+                uint8_t wpm;
+                uint8_t level;                  // 0 - 100 of the mix
+        };
+
+        Caller callers[MAX_CALLERS];            // callers[i] sends on voice i
+        uint8_t count = 0;                      // stations that still call
+        String answer = "";
+        boolean answered = false;
+        boolean callAgain = false;              // the stations call as soon as the last one is done
+        unsigned long quietSince = 0;
+        uint16_t worked = 0;
+
+        void startPileUp();
+        void call(int8_t only);
+        boolean isCalling();
+        void evaluate();
+};
+
+extern MorseModePileUp morseModePileUp;
+
+#endif /* MORSEMODEPILEUP_H_ */
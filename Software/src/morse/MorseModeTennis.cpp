@@ -65,6 +65,18 @@ TennisMachine::MessageSet *MorseModeTennis::ModeClient::getMsgSet()
     return &machine->getGameConfig()->msgSet;
 }
 
+void MorseModeTennis::ModeClient::progress(uint8_t matched, uint8_t total)
+{       // show how many words of the expected message have been keyed so far, in the free space left of the speed
+    if (matched == 0 || matched == total)
+    {
+        MorseDisplay::printOnStatusLine(false, 3, "    ");
+    }
+    else
+    {
+        MorseDisplay::vprintOnStatusLine(false, 3, "%1i/%1i ", _min(matched, 9), _min(total, 9));
+    }
+}
+
 void MorseModeTennis::updateMsgSet(uint8_t msgSetNo, TennisMachine::GameConfig& gameConfig)
 {
     gameConfig.msgSetNo = msgSetNo;
@@ -19,6 +19,7 @@ class MorseModeTennis: public MorseMode
                 void challengeSound(boolean ok);
                 void handle(TennisMachine::InitialMessageData *d);
                 TennisMachine::MessageSet* getMsgSet();
+                void progress(uint8_t matched, uint8_t total);
         };
 
         boolean menuExec(String mode);
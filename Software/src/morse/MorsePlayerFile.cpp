@@ -19,6 +19,7 @@
 #include "MorsePreferences.h"
 #include "MorseText.h"
 #include "koch.h"
+#include "MorseSystem.h"
 
 using namespace MorsePlayerFile;
 
@@ -26,6 +27,7 @@ namespace internal
 {
     String cleanUpText(String w);
     void reopen();
+    void mount();
 }
 
 const String playerFileName = "/player.txt";
@@ -33,6 +35,18 @@ const String playerFileName = "/player.txt";
 File file;
 
 void MorsePlayerFile::setup()
+{
+    /// mounting SPIFFS (and formatting it the very first time) is slow - do it when there is time
+    MorseSystem::boot.defer("spiffs", internal::mount);
+}
+
+/// ensureMounted is for everybody who wants to use SPIFFS before it has been mounted in the background
+void MorsePlayerFile::ensureMounted()
+{
+    MorseSystem::boot.ensure(internal::mount);
+}
+
+void internal::mount()
 {
     ///////////////////////// mount (or create) SPIFFS file system
 #define FORMAT_SPIFFS_IF_FAILED true
@@ -73,12 +87,14 @@ void MorsePlayerFile::setup()
 
 File MorsePlayerFile::openForWriting()
 {
+    ensureMounted();
     return SPIFFS.open(playerFileName, FILE_WRITE);
 }
 
 void MorsePlayerFile::openAndSkip()
 {
     uint32_t wcount = 0;
+    ensureMounted();
     file = SPIFFS.open(playerFileName);                            // open file
     //skip MorsePreferences::prefs.fileWordPointer words, as they have been played before
     wcount = MorsePreferences::prefs.fileWordPointer;
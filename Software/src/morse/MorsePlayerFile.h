@@ -7,6 +7,7 @@ namespace MorsePlayerFile
 {
 
     void setup();
+    void ensureMounted();
     String getWord();
     void skipWords(uint32_t count);
     File openForWriting();
@@ -0,0 +1,181 @@
+/******************************************************************************************************************************
+ *  morse_3 Software for the Morserino-32 multi-functional Morse code machine, based on the Heltec WiFi LORA (ESP32) module ***
+ *  Copyright (C) 2018  Willi Kraml, OE1WKL                                                                                 ***
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this program.
+ *  If not, see <https://www.gnu.org/licenses/>.
+ *****************************************************************************************************************************/
+#include "MorsePower.h"
+#include "MorseDisplay.h"
+#include "MorseKeyer.h"
+#include "MorseLoRa.h"
+#include "MorseMachine.h"
+#include "MorseSound.h"
+#include "MorseSystem.h"
+#include "morsedefs.h"
+#include "driver/gpio.h"
+#include "esp_sleep.h"
+
+using namespace MorsePower;
+
+namespace internal
+{
+    void lightSleep(unsigned long us);
+}
+
+/// the power profiles, by MorseMachine::morserinoMode: LoRa receiver needed, light sleep allowed,
+/// dim the display after ms without input, ms between refreshes of the dimmed display
+const PowerPolicy::Profile profiles[] =
+{
+    { false, true,  30000, 500 },           // morseKeyer
+    { true,  false, 30000, 500 },           // loraTrx
+    { true,  false, 30000, 500 },           // morseTennis
+    { false, false, 30000, 500 },           // morseTrx: the decoder samples the audio input all the time
+    { false, true,  30000, 500 },           // morseGenerator
+    { false, true,  30000, 500 },           // echoTrainer
+    { false, true,  30000, 500 },           // headCopying
+    { false, false, 30000, 500 },           // pileUp: the mixer puts out samples all the time
+    { false, false, 30000, 500 },           // morseDecoder
+    { true,  false, 0,     0 },             // shutDown
+    { true,  false, 0,     0 },             // measureNF
+    { true,  false, 0,     0 }              // invalid: as before
+};
+
+/// the pins that end a light sleep when their level changes, and their interrupt type while awake
+const struct
+{
+        int pin;
+        gpio_int_type_t awake;
+} wakePins[] =
+{
+    { leftPin, GPIO_INTR_ANYEDGE },
+    { rightPin, GPIO_INTR_ANYEDGE },
+    { PinCLK, GPIO_INTR_ANYEDGE },
+    { PinDT, GPIO_INTR_ANYEDGE },
+    { modeButtonPin, GPIO_INTR_DISABLE },
+    { volButtonPin, GPIO_INTR_DISABLE }
+};
+
+PowerPolicy MorsePower::policy;
+MorseMachine::morserinoMode profileMode = MorseMachine::invalid;
+volatile boolean paddleInput = false;
+boolean dimmed = false;
+
+void MorsePower::setup()
+{
+    policy.begin(micros());
+}
+
+/// update follows the mode (radio asleep when it is not needed) and dims the display; from the background task
+void MorsePower::update()
+{
+    unsigned long now = micros();
+
+    if (MorseMachine::getMode() != profileMode)
+    {
+        profileMode = MorseMachine::getMode();
+        policy.setProfile(profiles[profileMode], now);
+        if (!policy.isRadioOn())
+        {
+            MorseLoRa::sleep();
+        }
+    }
+    if (paddleInput)
+    {
+        paddleInput = false;
+        policy.onInput(now);
+    }
+    policy.update(now);
+    if (dimmed != (policy.getDisplay() == PowerPolicy::DISPLAY_DIMMED))
+    {
+        dimmed = !dimmed;
+        MorseDisplay::setDimmed(dimmed);
+    }
+}
+
+/// onInput is called for a button or the encoder; the display is back at once, in case a blocking menu follows
+void MorsePower::onInput()
+{
+    policy.onInput(micros());
+    if (dimmed)
+    {
+        dimmed = false;
+        MorseDisplay::setDimmed(false);
+    }
+}
+
+/// onPaddle is the same for a paddle, but from an interrupt handler: the next update() takes it over
+void IRAM_ATTR MorsePower::onPaddle()
+{
+    paddleInput = true;
+}
+
+/// wait spends the time until the next task is due as the power profile says: halted until the next
+/// interrupt, in light sleep, or not at all; called by the scheduler, from waitForEvent()
+void MorsePower::wait(unsigned long us)
+{
+    boolean busy = MorseSound::isSounding() || MorseSound::isMixing() || MorseKeyer::leftKey || MorseKeyer::rightKey;
+    PowerPolicy::Sleep how = policy.chooseSleep(us, busy);
+    unsigned long start = micros();
+
+    switch (how)
+    {
+        case PowerPolicy::LIGHT_SLEEP:
+            internal::lightSleep(us - PowerPolicy::WAKE_LATENCY);
+            break;
+        case PowerPolicy::WAIT:
+            MorseSystem::waitForNotification(us);
+            break;
+        default:
+            return;
+    }
+    policy.slept(how, micros() - start);
+}
+
+boolean MorsePower::mayRefresh()
+{
+    return policy.mayRefresh(micros());
+}
+
+/// lightSleep stops the clocks until the time is up, a pin changes or a touch paddle is touched. While we
+/// sleep, the pin interrupts are off (a level interrupt would not stop firing); an edge that woke us up is
+/// passed on to the paddle task, which reads the levels anyway.
+void internal::lightSleep(unsigned long us)
+{
+    for (auto &w : wakePins)
+    {
+        gpio_num_t pin = (gpio_num_t) w.pin;
+        gpio_intr_disable(pin);
+        gpio_wakeup_enable(pin, gpio_get_level(pin) ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL);
+    }
+    esp_sleep_enable_gpio_wakeup();
+    MorseKeyer::enableTouchWakeUp();
+    esp_sleep_enable_timer_wakeup(us);
+
+    esp_light_sleep_start();
+
+    for (auto &w : wakePins)
+    {
+        gpio_num_t pin = (gpio_num_t) w.pin;
+        gpio_wakeup_disable(pin);
+        gpio_set_intr_type(pin, w.awake);
+        if (w.awake != GPIO_INTR_DISABLE)
+        {
+            gpio_intr_enable(pin);
+        }
+    }
+    // only the sources enabled above: EXT0 (the button on GPIO 0, armed once in setup()) wakes us from deep sleep
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_GPIO);
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_TIMER);
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_TOUCHPAD);
+    if (esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_TIMER)
+    {
+        MorseSystem::wakeForPaddles();
+    }
+}
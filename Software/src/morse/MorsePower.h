@@ -0,0 +1,19 @@
+#ifndef MORSEPOWER_H_
+#define MORSEPOWER_H_
+
+#include <Arduino.h>
+#include "PowerPolicy.h"
+
+namespace MorsePower
+{
+    extern PowerPolicy policy;              /// the power profile of the current mode, and the estimate
+
+    void setup();
+    void update();
+    void onInput();
+    void onPaddle();
+    void wait(unsigned long us);
+    boolean mayRefresh();
+}
+
+#endif /* MORSEPOWER_H_ */
@@ -13,7 +13,6 @@
  *****************************************************************************************************************************/
 
 /////////////// READING and WRITING parameters from / into Non Volatile Storage, using ESP32 preferences
-#include <LoRa.h>          // library for LoRa transceiver
 
 #include "koch.h"
 #include "abbrev.h"
@@ -21,9 +20,11 @@
 #include "morsedefs.h"
 #include "decoder.h"
 #include "MorsePreferences.h"
+#include "PrefsStore.h"
 #include "MorsePreferencesMenu.h"
 #include "MorseDisplay.h"
 #include "MorseUI.h"
+#include "MorseLoRa.h"
 
 using namespace MorsePreferences;
 
@@ -53,6 +54,15 @@ const Item MorsePreferences::prefOption[] = { //
                 {posLoraTrainerMode, "Send via LoRa", sectionMain}, //
                 {posGoertzelBandwidth, "Bandwidth    ", sectionMain}, //
                 {posSpeedAdapt, "Adaptv. Speed", sectionMain}, //
+                {posAdaptTarget, "Adapt. Target", sectionMain}, //
+                {posAdaptiveText, "Adaptv. Text ", sectionMain}, //
+                {posSpacedRep, "Spaced Rep.  ", sectionMain}, //
+                {posKeyedAnswer, "Keyed Answer ", sectionMain}, //
+                {posAudioSynth, "Audio Synth  ", sectionMain}, //
+                {posBandNoise, "Band Noise   ", sectionMain}, //
+                {posQsb, "QSB          ", sectionMain}, //
+                {posQrm, "QRM          ", sectionMain}, //
+                {posLoraStationIds, "LoRa Stn. IDs", sectionLoRa}, //
                 {posKochSeq, "Koch Sequence", sectionMain}, //
                 {posKochFilter, "Koch         ", sectionMain}, //
                 {posLatency, "Latency      ", sectionMain}, //
@@ -76,21 +86,23 @@ const Item MorsePreferences::prefOption[] = { //
 prefPos MorsePreferences::keyerOptions[] = {posExtPaddles, posPolarity, posLatency, posCurtisMode, posCurtisBDahTiming, posCurtisBDotTiming,
         posACS, posKeyTrainerMode, sentinel};
 prefPos MorsePreferences::generatorOptions[] = {posInterWordSpace, posInterCharSpace, posRandomOption, posRandomLength, posCallLength,
-        posAbbrevLength, posWordLength, posMaxSequence, posTrainerDisplay, posWordDoubler, posKeyTrainerMode, posLoraTrainerMode, sentinel};
+        posAbbrevLength, posWordLength, posMaxSequence, posTrainerDisplay, posWordDoubler, posKeyTrainerMode, posLoraTrainerMode,
+        posBandNoise, posQsb, posQrm, sentinel};
 prefPos MorsePreferences::headOptions[] = {posRandomOption, posRandomLength, posCallLength, posAbbrevLength, posWordLength,
-        posKeyTrainerMode, posLoraTrainerMode, sentinel};
+        posKeyTrainerMode, posLoraTrainerMode, posKeyedAnswer, posBandNoise, posQsb, posQrm, sentinel};
 prefPos MorsePreferences::playerOptions[] = {posMaxSequence, posTrainerDisplay, posRandomFile, posWordDoubler, posKeyTrainerMode,
-        posLoraTrainerMode, sentinel};
+        posLoraTrainerMode, posBandNoise, posQsb, posQrm, sentinel};
 prefPos MorsePreferences::echoPlayerOptions[] = {posEchoToneShift, posMaxSequence, posRandomFile, posEchoRepeats, posEchoDisplay,
         posEchoConf, sentinel};
 prefPos MorsePreferences::echoTrainerOptions[] = {posEchoToneShift, posRandomOption, posRandomLength, posCallLength, posAbbrevLength,
-        posWordLength, posMaxSequence, posEchoRepeats, posEchoDisplay, posEchoConf, posSpeedAdapt, sentinel};
+        posWordLength, posMaxSequence, posEchoRepeats, posEchoDisplay, posEchoConf, posSpeedAdapt, posAdaptTarget, posAdaptiveText, posSpacedRep, sentinel};
 prefPos MorsePreferences::kochGenOptions[] = {posRandomLength, posAbbrevLength, posWordLength, posMaxSequence, posTrainerDisplay,
-        posWordDoubler, posKeyTrainerMode, posLoraTrainerMode, posKochSeq, sentinel};
+        posWordDoubler, posKeyTrainerMode, posLoraTrainerMode, posBandNoise, posQsb, posQrm, posKochSeq, sentinel};
 prefPos MorsePreferences::kochEchoOptions[] = {posEchoToneShift, posRandomLength, posAbbrevLength, posWordLength, posMaxSequence,
-        posEchoRepeats, posEchoDisplay, posEchoConf, posSpeedAdapt, posKochSeq, sentinel};
+        posEchoRepeats, posEchoDisplay, posEchoConf, posSpeedAdapt, posAdaptTarget, posAdaptiveText, posSpacedRep, posKochSeq, sentinel};
 prefPos MorsePreferences::morseTennisOptions[] = {posTennisMsgSet, posTennisScoringRules, posLoraSyncW, sentinel};
-prefPos MorsePreferences::loraTrxOptions[] = {posEchoToneShift, posLoraSyncW, sentinel};
+prefPos MorsePreferences::pileUpOptions[] = {posCallLength, posExtPaddles, posPolarity, posLatency, posCurtisMode, sentinel};
+prefPos MorsePreferences::loraTrxOptions[] = {posEchoToneShift, posLoraSyncW, posLoraStationIds, sentinel};
 prefPos MorsePreferences::extTrxOptions[] = {posEchoToneShift, posGoertzelBandwidth, sentinel};
 prefPos MorsePreferences::decoderOptions[] = {posGoertzelBandwidth, sentinel};
 
@@ -98,12 +110,55 @@ prefPos MorsePreferences::allOptions[] = {posClicks, posPitch, posStraightKey, p
         posCurtisBDahTiming, posCurtisBDotTiming, posACS, posEchoToneShift, posInterWordSpace, posInterCharSpace, posRandomOption,
         posRandomLength, posCallLength, posAbbrevLength, posWordLength, posMaxSequence, posTrainerDisplay, posRandomFile, posWordDoubler,
         posEchoRepeats, posEchoDisplay, posEchoConf, posKeyTrainerMode, posLoraTrainerMode, posLoraSyncW, posGoertzelBandwidth,
-        posSpeedAdapt, posKochSeq, posTimeOut, posQuickStart, sentinel};
+        posSpeedAdapt, posAdaptTarget, posAdaptiveText, posSpacedRep, posKeyedAnswer, posAudioSynth, posBandNoise, posQsb, posQrm, posLoraStationIds,
+        posKochSeq,
+        posTimeOut, posQuickStart, sentinel};
 
 prefPos MorsePreferences::noOptions[] = {};
 
 Preferences pref;               // use the Preferences library for storing and retrieving objects
 
+/// the Preferences library as storage for the preferences blob
+class NvsStorage: public PrefsStore::Storage
+{
+    public:
+        boolean begin(const char *name, boolean readOnly)
+        {
+            return pref.begin(name, readOnly);
+        }
+        void end()
+        {
+            pref.end();
+        }
+        size_t getBytesLength(const char *key)
+        {
+            return pref.getBytesLength(key);
+        }
+        size_t getBytes(const char *key, void *buffer, size_t length)
+        {
+            return pref.getBytes(key, buffer, length);
+        }
+        size_t putBytes(const char *key, const void *buffer, size_t length)
+        {
+            return pref.putBytes(key, buffer, length);
+        }
+        uint8_t getUChar(const char *key, uint8_t defaultValue)
+        {
+            return pref.getUChar(key, defaultValue);
+        }
+        boolean getBool(const char *key, boolean defaultValue)
+        {
+            return pref.getBool(key, defaultValue);
+        }
+        uint32_t getUInt(const char *key, uint32_t defaultValue)
+        {
+            return pref.getUInt(key, defaultValue);
+        }
+};
+
+NvsStorage nvsStorage;
+PrefsStore store(nvsStorage);
+
 /// variables for managing snapshots
 uint8_t MorsePreferences::memories[8];
 uint8_t MorsePreferences::memCounter;
@@ -120,8 +175,6 @@ MorsePrefs MorsePreferences::readPreferences(String repository)
     MorsePrefs p;
     unsigned int l = 15;
     char repName[l];
-    uint8_t temp;
-    uint32_t tempInt;
 
     boolean atStart = false;
 
@@ -131,199 +184,21 @@ MorsePrefs MorsePreferences::readPreferences(String repository)
     repository.toCharArray(repName, l);
     // MORSELOGLN("Reading from repository: " + String(repName));
     // read preferences from non-volatile storage
-    // if version cannot be read, we have a new ESP32 and need to write the preferences first
+    // if there is no blob yet, we read the keys of older versions and write the blob
 
-    if (atStart)
-        pref.begin(repName, false);                // open namespace in read/write mode
-    else
-        pref.begin(repName, true);                 // read only in all other cases
-
-    /// new code for reading preferences values - we check if we have a value, and if yes, we use it; if no, we use and write a default value
-
-    if (atStart)
-    {
-        if ((temp = pref.getUChar("version_major")) != p.version_major)
-            pref.putUChar("version_major", p.version_major);
-        if ((temp = pref.getUChar("version_minor")) != p.version_minor)
-            pref.putUChar("version_minor", p.version_minor);
-    }
-
-    if ((temp = pref.getUChar("sidetoneFreq")))
-        p.sidetoneFreq = temp;
-    else if (atStart)
-        pref.putUChar("sidetoneFreq", p.sidetoneFreq);
-
-    if ((temp = pref.getUChar("wpm")))
-        p.wpm = temp;
-    else if (atStart)
-        pref.putUChar("wpm", p.wpm);
-
-    if ((temp = pref.getUChar("sidetoneVolume", 255)) != 255)
-        p.sidetoneVolume = temp;
-    else if (atStart)
-        pref.putUChar("sidetoneVolume", p.sidetoneVolume);
-
-    if ((temp = pref.getUChar("keyermode")))
-        p.keyermode = temp;
-    else if (atStart)
-        pref.putUChar("keyermode", p.keyermode);
-
-    if ((temp = pref.getUChar("farnsworthMode")))
-        p.interCharSpace = temp;
-    else if (atStart)
-        pref.putUChar("farnsworthMode", p.interCharSpace);
-
-    if ((temp = pref.getUChar("ACSlength", 255)) != 255)
-        p.ACSlength = temp;
-    else if (atStart)
-        pref.putUChar("ACSlength", p.ACSlength);
-
-    if ((temp = pref.getUChar("keyTrainerMode", 255)) != 255)
-        p.keyTrainerMode = temp;
-    else if (atStart)
-        pref.putUChar("keyTrainerMode", p.keyTrainerMode);
-
-    if ((temp = pref.getUChar("randomLength")))
-        p.randomLength = temp;
-    else if (atStart)
-        pref.putUChar("randomLength", p.randomLength);
-
-    if ((temp = pref.getUChar("randomOption", 255)) != 255)
-        p.randomOption = temp;
-    else if (atStart)
-        pref.putUChar("randomOption", p.randomOption);
-
-    if ((temp = pref.getUChar("callLength", 255)) != 255)
-        p.callLength = temp;
-    else if (atStart)
-        pref.putUChar("callLength", p.callLength);
-
-    if ((temp = pref.getUChar("abbrevLength", 255)) != 255)
-        p.abbrevLength = temp;
-    else if (atStart)
-        pref.putUChar("abbrevLength", p.abbrevLength);
-
-    if ((temp = pref.getUChar("wordLength", 255)) != 255)
-        p.wordLength = temp;
-    else if (atStart)
-        pref.putUChar("wordLength", p.wordLength);
-
-    if ((temp = pref.getUChar("trainerDisplay", 255)) != 255)
-        p.trainerDisplay = temp;
-    else if (atStart)
-        pref.putUChar("trainerDisplay", p.trainerDisplay);
-
-    if ((temp = pref.getUChar("echoDisplay", 255)) != 255)
-        p.echoDisplay = temp;
-    else if (atStart)
-        pref.putUChar("echoDisplay", p.echoDisplay);
-
-    if ((temp = pref.getUChar("curtisBTiming", 255)) != 255)
-        p.curtisBTiming = temp;
-    else if (atStart)
-        pref.putUChar("curtisBTiming", p.curtisBTiming);
-
-    if ((temp = pref.getUChar("curtisBDotT", 255)) != 255)
-        p.curtisBDotTiming = temp;
-    else if (atStart)
-        pref.putUChar("curtisBDotT", p.curtisBDotTiming);
-
-    if ((temp = pref.getUChar("interWordSpace")))
-        p.interWordSpace = temp;
-    else if (atStart)
-        pref.putUChar("interWordSpace", p.interWordSpace);
-
-    if ((temp = pref.getUChar("echoRepeats", 255)) != 255)
-        p.echoRepeats = temp;
-    else if (atStart)
-        pref.putUChar("echoRepeats", p.echoRepeats);
-
-    if ((temp = pref.getUChar("echoToneShift", 255)) != 255)
-        p.echoToneShift = temp;
-    else if (atStart)
-        pref.putUChar("echoToneShift", p.echoToneShift);
+    store.load(repName, p, atStart);
 
     if (atStart)
     {
-        if ((temp = pref.getUChar("kochFilter")))
-            p.kochFilter = temp;
-        else
-            pref.putUChar("kochFilter", p.kochFilter);
+        pref.begin(repName, true);
+        p.wlanSSID = pref.getString("wlanSSID");
+        p.wlanPassword = pref.getString("wlanPassword");
+        pref.end();
+        if (p.snapShots)
+            updateMemory(p.snapShots);
     }
-
-    if ((temp = pref.getUChar("loraTrainerMode")))
-        p.loraTrainerMode = temp;
-    else if (atStart)
-        pref.putUChar("loraTrainerMode", p.loraTrainerMode);
-
-    if ((temp = pref.getUChar("goertzelBW")))
-        p.goertzelBandwidth = temp;
-    else if (atStart)
-        pref.putUChar("goertzelBW", p.goertzelBandwidth);
-
-    if ((temp = pref.getUChar("latency")))
-        p.latency = temp;
-    else if (atStart)
-        pref.putUChar("latency", p.latency);
-
-    if ((temp = pref.getUChar("randomFile")))
-        p.randomFile = temp;
-
-    if ((temp = pref.getUChar("lastExecuted")))
-        p.menuPtr = temp;
-    //MORSELOGLN("read: p.menuPtr = " + String(p.menuPtr));
-
-    if ((temp = pref.getUChar("timeOut")))
-        p.timeOut = temp;
-    else if (atStart)
-        pref.putUChar("timeOut", p.timeOut);
-
-    if ((temp = pref.getUChar("loraSyncW")))
-        p.loraSyncW = temp;
-    else if (atStart)
-        pref.putUChar("loraSyncW", p.loraSyncW);
-
-    if ((temp = pref.getUChar("maxSequence", p.maxSequence)))
-        p.maxSequence = temp;
-
-    p.useStraightKey = pref.getBool("useStraightKey");
-    p.didah = pref.getBool("didah", true);
-    p.useExtPaddle = pref.getBool("useExtPaddle");
-    p.encoderClicks = pref.getBool("encoderClicks", true);
-    p.echoConf = pref.getBool("echoConf", true);
-    p.wordDoubler = pref.getBool("wordDoubler");
-    p.speedAdapt = pref.getBool("speedAdapt");
-
-    p.wlanSSID = pref.getString("wlanSSID");
-    p.wlanPassword = pref.getString("wlanPassword");
-    p.fileWordPointer = pref.getUInt("fileWordPtr");
-    p.lcwoKochSeq = pref.getBool("lcwoKochSeq");
-    p.quickStart = pref.getBool("quickStart");
-
-    p.tennisMsgSet = pref.getUChar("tennisMsgSet");
-    p.tennisScoringRules = pref.getUChar("tennisScoring");
-
-    if (atStart)
-    {
-        if ((temp = pref.getUChar("loraBand")))
-            p.loraBand = temp;
-        else
-            p.loraBand = 0;
-
-        if ((tempInt = pref.getUInt("loraQRG")))
-        {
-            p.loraQRG = tempInt;
-        }
-        else
-            p.loraQRG = QRG433;
-
-        if ((temp = pref.getUChar("snapShots")))
-        {
-            p.snapShots = temp;
-            updateMemory(temp);
-        }  // end: we have snapshots
-    }  // endif atStart
-    pref.end();
+    else
+        PrefsStore::keepDeviceSettings(p, prefs);   // a snapshot does not change band, files, wifi etc.
 
     prefs = p;
     return p;
@@ -332,6 +207,7 @@ MorsePrefs MorsePreferences::readPreferences(String repository)
 void MorsePreferences::writePreferences(String repository)
 {
     MorsePrefs p = prefs;
+    MorsePrefs stored;
     unsigned int l = 15;
     char repName[l];
 
@@ -342,124 +218,31 @@ void MorsePreferences::writePreferences(String repository)
 //MORSELOGLN("Writing to repository: " + repository);
     repository.toCharArray(repName, l);
 
-    pref.begin(repName, false);                // open namespace in read/write mode
-
-    if (p.sidetoneFreq != pref.getUChar("sidetoneFreq"))
-        pref.putUChar("sidetoneFreq", p.sidetoneFreq);
-    if (p.useStraightKey != pref.getBool("useStraightKey"))
-        pref.putBool("useStraightKey", p.useStraightKey);
-    if (p.didah != pref.getBool("didah"))
-        pref.putBool("didah", p.didah);
-    if (p.keyermode != pref.getUChar("keyermode"))
-        pref.putUChar("keyermode", p.keyermode);
-    if (p.interCharSpace != pref.getUChar("farnsworthMode"))
-        pref.putUChar("farnsworthMode", p.interCharSpace);
-    if (p.useExtPaddle != pref.getBool("useExtPaddle"))
-        pref.putBool("useExtPaddle", p.useExtPaddle);
-    if (p.ACSlength != pref.getUChar("ACSlength"))
-        pref.putUChar("ACSlength", p.ACSlength);
-    if (p.keyTrainerMode != pref.getUChar("keyTrainerMode"))
-        pref.putUChar("keyTrainerMode", p.keyTrainerMode);
-    if (p.encoderClicks != pref.getBool("encoderClicks"))
-        pref.putBool("encoderClicks", p.encoderClicks);
-    if (p.randomLength != pref.getUChar("randomLength"))
-        pref.putUChar("randomLength", p.randomLength);
-    if (p.randomOption != pref.getUChar("randomOption"))
-        pref.putUChar("randomOption", p.randomOption);
-    if (p.callLength != pref.getUChar("callLength"))
-        pref.putUChar("callLength", p.callLength);
-    if (p.abbrevLength != pref.getUChar("abbrevLength"))
-    {
-        pref.putUChar("abbrevLength", p.abbrevLength);
-        if (morserino)
+    if (morserino)
+    {   // compare with what we had stored before, and update what depends on changed values
+        store.read(repName, stored);
+        if (p.abbrevLength != stored.abbrevLength)
             Koch::createKochAbbr(p.abbrevLength, p.kochFilter); // update the abbrev array!
-    }
-    if (p.wordLength != pref.getUChar("wordLength"))
-    {
-        pref.putUChar("wordLength", p.wordLength);
-        if (morserino)
+        if (p.wordLength != stored.wordLength)
             Koch::createKochWords(p.wordLength, p.kochFilter);  // update the word array!
-    }
-    if (p.trainerDisplay != pref.getUChar("trainerDisplay"))
-        pref.putUChar("trainerDisplay", p.trainerDisplay);
-    if (p.echoDisplay != pref.getUChar("echoDisplay"))
-        pref.putUChar("echoDisplay", p.echoDisplay);
-    if (p.curtisBTiming != pref.getUChar("curtisBTiming"))
-        pref.putUChar("curtisBTiming", p.curtisBTiming);
-    if (p.curtisBDotTiming != pref.getUChar("curtisBDotT"))
-        pref.putUChar("curtisBDotT", p.curtisBDotTiming);
-    if (p.interWordSpace != pref.getUChar("interWordSpace"))
-        pref.putUChar("interWordSpace", p.interWordSpace);
-    if (p.echoRepeats != pref.getUChar("echoRepeats"))
-        pref.putUChar("echoRepeats", p.echoRepeats);
-    if (p.echoToneShift != pref.getUChar("echoToneShift"))
-        pref.putUChar("echoToneShift", p.echoToneShift);
-    if (p.echoConf != pref.getBool("echoConf"))
-        pref.putBool("echoConf", p.echoConf);
-    if (morserino)
-    {
-        if (p.kochFilter != pref.getUChar("kochFilter"))
+        if (p.kochFilter != stored.kochFilter)
         {
-            pref.putUChar("kochFilter", p.kochFilter);
             Koch::createKochWords(p.wordLength, p.kochFilter);  // update the arrays!
             Koch::createKochAbbr(p.abbrevLength, p.kochFilter);
         }
-    }
-    if (p.lcwoKochSeq != pref.getBool("lcwoKochSeq"))
-    {
-        pref.putBool("lcwoKochSeq", p.lcwoKochSeq);
-        if (morserino)
+        if (p.lcwoKochSeq != stored.lcwoKochSeq)
         {
             Koch::updateKochChars(p.lcwoKochSeq);
             Koch::createKochWords(p.wordLength, p.kochFilter);  // update the arrays!
             Koch::createKochAbbr(p.abbrevLength, p.kochFilter);
         }
-    }
-    if (p.wordDoubler != pref.getBool("wordDoubler"))
-        pref.putBool("wordDoubler", p.wordDoubler);
-    if (p.speedAdapt != pref.getBool("speedAdapt"))
-        pref.putBool("speedAdapt", p.speedAdapt);
-    if (p.loraTrainerMode != pref.getUChar("loraTrainerMode"))
-        pref.putUChar("loraTrainerMode", p.loraTrainerMode);
-    if (p.goertzelBandwidth != pref.getUChar("goertzelBW"))
-    {
-        pref.putUChar("goertzelBW", p.goertzelBandwidth);
-        if (morserino)
+        if (p.goertzelBandwidth != stored.goertzelBandwidth)
             Decoder::setupGoertzel();
-    }
-    if (p.loraSyncW != pref.getUChar("loraSyncW"))
-    {
-        pref.putUChar("loraSyncW", p.loraSyncW);
-        if (morserino)
-            LoRa.setSyncWord(p.loraSyncW);
-    }
-    if (p.maxSequence != pref.getUChar("maxSequence"))
-        pref.putUChar("maxSequence", p.maxSequence);
-
-    if (p.latency != pref.getUChar("latency"))
-        pref.putUChar("latency", p.latency);
-    if (p.randomFile != pref.getUChar("randomFile"))
-        pref.putUChar("randomFile", p.randomFile);
-    if (p.timeOut != pref.getUChar("timeOut"))
-        pref.putUChar("timeOut", p.timeOut);
-    if (p.quickStart != pref.getBool("quickStart"))
-        pref.putBool("quickStart", p.quickStart);
-
-    if (p.tennisMsgSet != pref.getUChar("tennisMsgSet"))
-        pref.putUChar("tennisMsgSet", p.tennisMsgSet);
-    if (p.tennisScoringRules != pref.getUChar("tennisScoring"))
-        pref.putUChar("tennisScoring", p.tennisScoringRules);
-
-    if (p.snapShots != pref.getUChar("snapShots"))
-        pref.putUChar("snapShots", p.snapShots);
-
-    if (!morserino)
-    {
-        pref.putUChar("lastExecuted", p.menuPtr);   // store last executed command in snapshots
-        //MORSELOGLN("write: last executed: " + String(p.menuPtr));
+        if (p.loraSyncW != stored.loraSyncW)
+            MorseLoRa::setSyncWord(p.loraSyncW);
     }
 
-    pref.end();
+    store.save(repName, p);                     // one write, and only if anything has changed
 }
 
 boolean MorsePreferences::recallSnapshot()
@@ -550,54 +333,58 @@ void MorsePreferences::clearMemory(uint8_t ptr)
 
 void MorsePreferences::writeLoRaPrefs(uint8_t loraBand, uint32_t loraQRG)
 {
-    pref.begin("morserino", false);             // open the namespace as read/write
-    pref.putUChar("loraBand", loraBand);
-    pref.putUInt("loraQRG", loraQRG);
-    pref.end();
+    prefs.loraBand = loraBand;
+    prefs.loraQRG = loraQRG;
+    store.save("morserino", prefs);
 }
 
 void MorsePreferences::fireCharSeen(boolean wpmOnly)
 {
     ++charCounter;                         // count this character
 
-    // if we have seen 12 chars since changing speed, we write the config to Preferences
+    // if we have seen 12 chars since changing speed, we schedule writing the config to Preferences;
+    // it is written later from the main loop, so flash writes do not get into the way of keying
     if (charCounter == 12)
     {
-        pref.begin("morserino", false);             // open the namespace as read/write
-        pref.putUChar("wpm", MorsePreferences::prefs.wpm);
-        if (!wpmOnly)
-        {
-            pref.putUChar("tLeft", MorsePreferences::prefs.tLeft);
-            pref.putUChar("tRight", MorsePreferences::prefs.tRight);
-        }
-        pref.end();
+        store.markDirty(millis());
     }
 
 }
 
-void MorsePreferences::writeWordPointer()
+/// writeBehind is called from the main loop; it saves changes that have been scheduled, once things have calmed down
+void MorsePreferences::writeBehind()
 {
-    if ((prefs.fileWordPointer != pref.getUInt("fileWordPtr")))
-    {   // update word pointer if necessary (if we ran player before)
-        pref.begin("morserino", false);              // open the namespace as read/write
-        pref.putUInt("fileWordPtr", prefs.fileWordPointer);
-        pref.end();
+    store.writeBehind("morserino", prefs, millis());
+}
+
+/// flush saves scheduled changes right away, e.g. before we go to sleep
+void MorsePreferences::flush()
+{
+    if (store.isDirty())
+    {
+        store.save("morserino", prefs);
     }
 }
 
+void MorsePreferences::writeWordPointer()
+{
+    store.save("morserino", prefs);     // only writes if the word pointer (or anything else) has changed
+}
+
 void MorsePreferences::writeVolume()
 {
-    pref.begin("morserino", false);                     // open the namespace as read/write
-    if (pref.getUChar("sidetoneVolume") != MorsePreferences::prefs.sidetoneVolume)
-        pref.putUChar("sidetoneVolume", MorsePreferences::prefs.sidetoneVolume);  // store the last volume, if it has changed
-    pref.end();
+    store.markDirty(millis());          // the volume is often adjusted several times in a row
+}
+
+void MorsePreferences::writeSpeed()
+{
+    store.markDirty(millis());          // the speed of a session is written from the main loop, or before we sleep
 }
 
 void MorsePreferences::writeLastExecuted(uint8_t menuPtr)
 {
-    pref.begin("morserino", false);             // open the namespace as read/write
-    pref.putUChar("lastExecuted", menuPtr);   // store last executed command
-    pref.end();                                 // close namespace
+    prefs.menuPtr = menuPtr;            // store last executed command
+    store.save("morserino", prefs);
 }
 
 void MorsePreferences::writeWifiInfo(String SSID, String passwd)
@@ -611,4 +398,3 @@ void MorsePreferences::writeWifiInfo(String SSID, String passwd)
     pref.end();
 
 }
-
@@ -63,6 +63,15 @@ namespace internal
     void displayRandomFile();
     void displayGoertzelBandwidth();
     void displaySpeedAdapt();
+    void displayAdaptTarget();
+    void displayAdaptiveText();
+    void displaySpacedRep();
+    void displayKeyedAnswer();
+    void displayAudioSynth();
+    void displayBandNoise();
+    void displayQsb();
+    void displayQrm();
+    void displayLoraStationIds();
     void displayKochSeq();
     void displayTimeOut();
     void displayQuickStart();
@@ -206,6 +215,33 @@ void MorsePreferencesMenu::displayKeyerPreferencesMenu(int pos)
         case MorsePreferences::posSpeedAdapt:
             internal::displaySpeedAdapt();
             break;
+        case MorsePreferences::posAdaptTarget:
+            internal::displayAdaptTarget();
+            break;
+        case MorsePreferences::posAdaptiveText:
+            internal::displayAdaptiveText();
+            break;
+        case MorsePreferences::posSpacedRep:
+            internal::displaySpacedRep();
+            break;
+        case MorsePreferences::posKeyedAnswer:
+            internal::displayKeyedAnswer();
+            break;
+        case MorsePreferences::posAudioSynth:
+            internal::displayAudioSynth();
+            break;
+        case MorsePreferences::posBandNoise:
+            internal::displayBandNoise();
+            break;
+        case MorsePreferences::posQsb:
+            internal::displayQsb();
+            break;
+        case MorsePreferences::posQrm:
+            internal::displayQrm();
+            break;
+        case MorsePreferences::posLoraStationIds:
+            internal::displayLoraStationIds();
+            break;
         case MorsePreferences::posRandomFile:
             internal::displayRandomFile();
             break;
@@ -529,6 +565,60 @@ void internal::displaySpeedAdapt()
     MorseDisplay::printOnScroll(2, REGULAR, 1, MorsePreferences::prefs.speedAdapt ? "ON         " : "OFF        ");
 }
 
+void internal::displayAdaptTarget()
+{
+    MorseDisplay::vprintOnScroll(2, REGULAR, 1, "%i %% right", MorsePreferences::prefs.adaptTarget);
+}
+
+void internal::displayAdaptiveText()
+{
+    MorseDisplay::printOnScroll(2, REGULAR, 1, MorsePreferences::prefs.adaptiveText ? "ON         " : "OFF        ");
+}
+
+void internal::displaySpacedRep()
+{
+    MorseDisplay::printOnScroll(2, REGULAR, 1, MorsePreferences::prefs.spacedRepetition ? "ON         " : "OFF        ");
+}
+
+void internal::displayKeyedAnswer()
+{
+    MorseDisplay::printOnScroll(2, REGULAR, 1, MorsePreferences::prefs.keyedAnswer ? "ON         " : "OFF        ");
+}
+
+void internal::displayAudioSynth()
+{
+    MorseDisplay::printOnScroll(2, REGULAR, 1, MorsePreferences::prefs.audioSynth ? "ON         " : "OFF        ");
+}
+
+void internal::displayBandNoise()
+{
+    uint8_t n = MorsePreferences::prefs.bandNoise;
+    if (n == 0)
+        MorseDisplay::printOnScroll(2, REGULAR, 1, "Off        ");
+    else
+        MorseDisplay::vprintOnScroll(2, REGULAR, 1, "%s %i    ", n > 5 ? "Pink " : "White", (n - 1) % 5 + 1);
+}
+
+void internal::displayQsb()
+{
+    const char *qsb[] = { "Off        ", "Light      ", "Medium     ", "Deep       " };
+    MorseDisplay::printOnScroll(2, REGULAR, 1, qsb[MorsePreferences::prefs.qsb]);
+}
+
+void internal::displayQrm()
+{
+    uint8_t n = MorsePreferences::prefs.qrm;
+    if (n == 0)
+        MorseDisplay::printOnScroll(2, REGULAR, 1, "Off        ");
+    else
+        MorseDisplay::vprintOnScroll(2, REGULAR, 1, "%i Station%s ", n, n > 1 ? "s" : " ");
+}
+
+void internal::displayLoraStationIds()
+{
+    MorseDisplay::printOnScroll(2, REGULAR, 1, MorsePreferences::prefs.loraStationIds ? "ON (v2)    " : "Compatible ");
+}
+
 void internal::displayKochSeq()
 {
     MorseDisplay::printOnScroll(2, REGULAR, 1, MorsePreferences::prefs.lcwoKochSeq ? "LCWO      " : "M32 / JLMC");
@@ -880,6 +970,47 @@ boolean MorsePreferencesMenu::adjustKeyerPreference(MorsePreferences::prefPos po
                     MorsePreferences::prefs.speedAdapt = !MorsePreferences::prefs.speedAdapt;
                     internal::displaySpeedAdapt();
                     break;
+                case MorsePreferences::posAdaptTarget:
+                    MorsePreferences::prefs.adaptTarget += (t * 5);                     // 70 - 95 % in steps of 5
+                    MorsePreferences::prefs.adaptTarget = constrain(MorsePreferences::prefs.adaptTarget, 70, 95);
+                    internal::displayAdaptTarget();
+                    break;
+                case MorsePreferences::posAdaptiveText:
+                    MorsePreferences::prefs.adaptiveText = !MorsePreferences::prefs.adaptiveText;
+                    internal::displayAdaptiveText();
+                    break;
+                case MorsePreferences::posSpacedRep:
+                    MorsePreferences::prefs.spacedRepetition = !MorsePreferences::prefs.spacedRepetition;
+                    internal::displaySpacedRep();
+                    break;
+                case MorsePreferences::posKeyedAnswer:
+                    MorsePreferences::prefs.keyedAnswer = !MorsePreferences::prefs.keyedAnswer;
+                    internal::displayKeyedAnswer();
+                    break;
+                case MorsePreferences::posAudioSynth:
+                    MorsePreferences::prefs.audioSynth = !MorsePreferences::prefs.audioSynth;
+                    MorseSound::setSynth(MorsePreferences::prefs.audioSynth);
+                    internal::displayAudioSynth();
+                    break;
+                case MorsePreferences::posBandNoise:
+                    MorsePreferences::prefs.bandNoise += (t + 1);                       // 0 off, 1 - 5 white, 6 - 10 pink
+                    MorsePreferences::prefs.bandNoise = constrain(MorsePreferences::prefs.bandNoise - 1, 0, 10);
+                    internal::displayBandNoise();
+                    break;
+                case MorsePreferences::posQsb:
+                    MorsePreferences::prefs.qsb += (t + 1);
+                    MorsePreferences::prefs.qsb = constrain(MorsePreferences::prefs.qsb - 1, 0, 3);
+                    internal::displayQsb();
+                    break;
+                case MorsePreferences::posQrm:
+                    MorsePreferences::prefs.qrm += (t + 1);
+                    MorsePreferences::prefs.qrm = constrain(MorsePreferences::prefs.qrm - 1, 0, 3);
+                    internal::displayQrm();
+                    break;
+                case MorsePreferences::posLoraStationIds:
+                    MorsePreferences::prefs.loraStationIds = !MorsePreferences::prefs.loraStationIds;
+                    internal::displayLoraStationIds();
+                    break;
                 case MorsePreferences::posKochSeq:
                     MorsePreferences::prefs.lcwoKochSeq = !MorsePreferences::prefs.lcwoKochSeq;
                     internal::displayKochSeq();
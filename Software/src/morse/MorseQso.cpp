@@ -0,0 +1,104 @@
+/******************************************************************************************************************************
+ *  morse_3 Software for the Morserino-32 multi-functional Morse code machine, based on the Heltec WiFi LORA (ESP32) module ***
+ *  Copyright (C) 2018  Willi Kraml, OE1WKL                                                                                 ***
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this program.
+ *  If not, see <https://www.gnu.org/licenses/>.
+ *****************************************************************************************************************************/
+#include "SPIFFS.h"
+#include "MorseQso.h"
+#include "MorseDisplay.h"
+#include "MorsePlayerFile.h"
+#include "MorseText.h"
+#include "koch.h"
+
+using namespace MorseQso;
+
+namespace internal
+{
+    const char *GRAMMAR_FILE = "/qso.txt";
+
+    boolean loaded = false;
+
+    long randomNumber(long howBig);
+    void load();
+    void showError(uint16_t line);
+}
+
+QsoGenerator MorseQso::generator(internal::randomNumber);
+
+long internal::randomNumber(long howBig)
+{
+    return random(howBig);
+}
+
+/// start begins a new QSO, with serial number 1; the grammar is loaded the first time, and after an upload
+void MorseQso::start()
+{
+    if (!internal::loaded)
+    {
+        internal::load();
+        internal::loaded = true;
+    }
+    generator.restart(1);
+}
+
+/// getWord is the next word of the QSO, cleaned up like the words of the player file
+String MorseQso::getWord()
+{
+    char word[QsoGenerator::MAX_WORD + 1];
+
+    if (!generator.next(word))
+    {
+        return "";
+    }
+    String w = String(word);
+    w.toLowerCase();
+    w = MorseText::utf8umlaut(w);
+    return Koch::filterNonKoch(w);
+}
+
+File MorseQso::openForWriting()
+{
+    MorsePlayerFile::ensureMounted();
+    return SPIFFS.open(internal::GRAMMAR_FILE, FILE_WRITE);
+}
+
+/// onUploaded: a new grammar has been uploaded
+void MorseQso::onUploaded()
+{
+    internal::loaded = false;
+}
+
+/// load compiles the uploaded grammar, or the default one if there is none, or the uploaded one has an error
+void internal::load()
+{
+    MorsePlayerFile::ensureMounted();
+    if (SPIFFS.exists(GRAMMAR_FILE))
+    {
+        File file = SPIFFS.open(GRAMMAR_FILE);
+        String text = file.readString();            // only while we compile it
+        file.close();
+        if (generator.load(text.c_str(), text.length()) == QsoGenerator::OK)
+        {
+            return;
+        }
+        showError(generator.getErrorLine());
+    }
+    generator.load(QsoGenerator::DEFAULT_GRAMMAR, strlen(QsoGenerator::DEFAULT_GRAMMAR));
+}
+
+void internal::showError(uint16_t line)
+{
+    MorseDisplay::clear();
+    MorseDisplay::printOnScroll(0, REGULAR, 0, "QSO grammar:  ");
+    MorseDisplay::printOnScroll(1, REGULAR, 0, "Error, line " + String(line));
+    MorseDisplay::printOnScroll(2, REGULAR, 0, "Using default ");
+    delay(2500);
+}
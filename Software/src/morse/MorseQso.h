@@ -0,0 +1,18 @@
+#ifndef MORSEQSO_H_
+#define MORSEQSO_H_
+
+#include <Arduino.h>
+#include "FS.h"
+#include "QsoGenerator.h"
+
+namespace MorseQso
+{
+    extern QsoGenerator generator;          /// the QSOs of the generator; its grammar comes from /qso.txt in SPIFFS
+
+    void start();
+    String getWord();
+    File openForWriting();
+    void onUploaded();
+}
+
+#endif /* MORSEQSO_H_ */
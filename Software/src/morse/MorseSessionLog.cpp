@@ -0,0 +1,121 @@
+/******************************************************************************************************************************
+ *  morse_3 Software for the Morserino-32 multi-functional Morse code machine, based on the Heltec WiFi LORA (ESP32) module ***
+ *  Copyright (C) 2018  Willi Kraml, OE1WKL                                                                                 ***
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this program.
+ *  If not, see <https://www.gnu.org/licenses/>.
+ *****************************************************************************************************************************/
+#include "SPIFFS.h"
+#include "MorseSessionLog.h"
+#include "MorseKeyer.h"
+#include "MorsePlayerFile.h"
+
+using namespace MorseSessionLog;
+
+namespace internal
+{
+    const char *LOG_FILE = "/session.log";
+    const char *OLD_LOG_FILE = "/session.old";
+    const size_t MAX_LOG = 262144;          // bytes; then the log becomes the old one, and we start a new one
+
+    struct FileSink: public SessionLog::Sink
+    {
+            boolean append(const uint8_t *data, size_t n);
+    };
+
+    FileSink sink;
+}
+
+SessionLog MorseSessionLog::log(&internal::sink);
+
+/// append adds the buffered events to the log file; the previous log is kept, so there are always between MAX_LOG and
+/// twice as many bytes of history
+boolean internal::FileSink::append(const uint8_t *data, size_t n)
+{
+    MorsePlayerFile::ensureMounted();
+    File file = SPIFFS.open(LOG_FILE, FILE_APPEND);
+    if (!file)
+    {
+        return false;
+    }
+    size_t size = file.size();
+    if (size >= MAX_LOG)
+    {
+        file.close();
+        SPIFFS.remove(OLD_LOG_FILE);
+        SPIFFS.rename(LOG_FILE, OLD_LOG_FILE);
+        file = SPIFFS.open(LOG_FILE, FILE_APPEND);
+        if (!file)
+        {
+            return false;
+        }
+    }
+    boolean done = file.write(data, n) == n;
+    file.close();
+    return done;
+}
+
+/// begin starts the session of a mode, with the speed it starts with
+void MorseSessionLog::begin(uint8_t menuItem)
+{
+    log.begin(menuItem, MorseKeyer::wpm, MorseKeyer::effWpm, millis());
+}
+
+/// word: what the generator sends (in internal form, pro signs as one character)
+void MorseSessionLog::word(String &text, boolean repeated)
+{
+    log.word(text.c_str(), repeated, millis());
+}
+
+/// element: a mark the decoder has timed, and the space before it (straight key, or audio)
+void MorseSessionLog::element(unsigned long markMs, unsigned long spaceMs)
+{
+    log.element(markMs < 0xffff ? markMs : 0xffff, spaceMs < 0xffff ? spaceMs : 0xffff, millis());
+}
+
+void MorseSessionLog::response(String &text)
+{
+    log.response(text.c_str(), millis());
+}
+
+void MorseSessionLog::result(boolean right, uint32_t responseMs)
+{
+    log.result(right, responseMs, millis());
+}
+
+/// speed is called whenever the speed changes, by hand or because the echo trainer adapts it
+void MorseSessionLog::speed()
+{
+    log.speed(MorseKeyer::wpm, MorseKeyer::effWpm, millis());
+}
+
+void MorseSessionLog::decoded(String &text)
+{
+    log.decoded(text.c_str(), millis());
+}
+
+void MorseSessionLog::end()
+{
+    log.end(millis());
+}
+
+/// flushIfDue is called from the main loop, while the keyer and the generator are idle
+void MorseSessionLog::flushIfDue()
+{
+    if (log.isDue(millis()))
+    {
+        log.flush(millis());
+    }
+}
+
+/// flush writes what is in the buffer right away, e.g. before we go to sleep
+void MorseSessionLog::flush()
+{
+    log.flush(millis());
+}
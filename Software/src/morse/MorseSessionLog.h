@@ -0,0 +1,23 @@
+#ifndef MORSESESSIONLOG_H_
+#define MORSESESSIONLOG_H_
+
+#include <Arduino.h>
+#include "SessionLog.h"
+
+namespace MorseSessionLog
+{
+    extern SessionLog log;                  /// the practice sessions, on their way to /session.log in SPIFFS
+
+    void begin(uint8_t menuItem);
+    void word(String &text, boolean repeated);
+    void element(unsigned long markMs, unsigned long spaceMs);
+    void response(String &text);
+    void result(boolean right, uint32_t responseMs);
+    void speed();
+    void decoded(String &text);
+    void end();
+    void flushIfDue();
+    void flush();
+}
+
+#endif /* MORSESESSIONLOG_H_ */
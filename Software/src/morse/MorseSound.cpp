@@ -14,6 +14,9 @@
 
 #include "MorseSound.h"
 #include "MorsePreferences.h"
+#include "SoundSequencer.h"
+#include "esp_timer.h"
+#include "soc/ledc_struct.h"
 
 using namespace MorseSound;
 
@@ -26,9 +29,58 @@ int pwmResolution = 10;
 unsigned int volFreq = 32000; // this is the HF frequency we are using
 
 const int dutyCycleFiftyPercent = 512;
-const int dutyCycleTwentyPercent = 25;
 const int dutyCycleZero = 0;
 
+/////////////////////// parameters for the mixer: the samples are the duty cycle of the tone PWM
+const uint32_t carrierFreq = 78125;       // 80 MHz / 2^10, the fastest PWM with 10 bits; the speaker is the low pass
+const uint8_t sidetoneVoice = VoiceMixer::MAX_VOICES - 1;
+const uint8_t sidetoneLevel = 40;         // of the mix; the volume is set with the volume PWM, as without the mixer
+const uint16_t ringSize = 256;            // samples between the renderer and the sample timer; a power of 2
+const uint16_t lead = 96;                 // samples the renderer stays ahead (12 ms), so the sidetone is not late
+const uint16_t renderBlock = 32;
+const unsigned long renderPeriod = 4000;  // µs
+
+namespace internal
+{
+    class PwmOutput: public SoundSequencer::Output
+    {
+        public:
+            void tone(uint16_t frequency, uint8_t level, boolean lineOut) override;
+            void silence() override;
+
+        private:
+            uint16_t frequency = 0;
+            boolean lineOut = false;
+            uint8_t lastLevel = 0;
+    };
+
+    void startTicks();
+    void onTick(void *arg);
+    void onRender(void *arg);
+    void IRAM_ATTR onSample();
+    void IRAM_ATTR setDuty(uint8_t channel, uint32_t duty);
+    uint16_t volumeDuty(uint8_t level);
+    void setMixVolume(uint8_t volume);
+    void stopMixing();
+}
+
+internal::PwmOutput pwmOutput;
+SoundSequencer sequencer(&pwmOutput);
+SemaphoreHandle_t soundLock;                // the sequencer is used by the main loop and the timer task
+esp_timer_handle_t soundTimer;
+boolean ticking = false;
+
+VoiceMixer mixer;                           // inside soundLock, like the sequencer
+boolean mixing = false;
+boolean synth = false;                      // all sound comes from the mixer, not only while a mode needs it
+boolean mixLineOut = false;
+uint8_t mixVolume = 0;
+esp_timer_handle_t renderTimer;
+hw_timer_t *sampleTimer = 0;
+uint16_t ring[ringSize];                    // duty cycles; the renderer writes, the sample timer reads
+volatile uint16_t ringWrite = 0;
+volatile uint16_t ringRead = 0;
+
 //// functions for generating a tone....
 
 void MorseSound::setup()
@@ -45,68 +97,364 @@ void MorseSound::setup()
 
     ledcWrite(toneChannel, 0);
     ledcWrite(lineOutChannel, 0);
+
+    soundLock = xSemaphoreCreateMutex();
+    esp_timer_create_args_t timerArgs = { };
+    timerArgs.callback = &internal::onTick;
+    timerArgs.name = "sound";
+    esp_timer_create(&timerArgs, &soundTimer);
+
+    timerArgs.callback = &internal::onRender;
+    timerArgs.name = "mixer";
+    esp_timer_create(&timerArgs, &renderTimer);
 }
 
+/// pwmTone keys the sidetone (or changes its pitch); it ramps up from the timer, no need to wait for it
 void MorseSound::pwmTone(unsigned int frequency, unsigned int volume, boolean lineOut)
-{ // frequency in Hertz, volume in range 0 - 100; we use 10 bit resolution
-    const uint16_t vol[] =
-        {0, 1, 2, 3, 16, 150, 380, 580, 700, 880, 1023};
-    int i = uconstrain(volume / 10, 10);
-    //MORSELOGLN(vol[i]);
-    //MORSELOGLN(frequency);
+{ // frequency in Hertz, volume in range 0 - 100
+    xSemaphoreTake(soundLock, portMAX_DELAY);
+    internal::setMixVolume(volume);
+    sequencer.keyDown(frequency, volume, lineOut);
+    internal::startTicks();
+    xSemaphoreGive(soundLock);
+}
+
+void MorseSound::pwmNoTone()
+{      // stop playing a tone - it decays within a few ms, so it does not click
+    xSemaphoreTake(soundLock, portMAX_DELAY);
+    sequencer.keyUp();
+    internal::startTicks();
+    xSemaphoreGive(soundLock);
+}
+
+boolean MorseSound::isSounding()
+{
+    return sequencer.isSounding();
+}
+
+/// play queues a sequence of notes and returns at once; returns the time in ms it takes to play them
+unsigned long MorseSound::play(const SoundSequencer::Note *notes, uint8_t n)
+{
+    xSemaphoreTake(soundLock, portMAX_DELAY);
+    if (n)
+    {
+        internal::setMixVolume(notes[0].volume);
+    }
+    boolean queued = sequencer.play(notes, n);
+    internal::startTicks();
+    xSemaphoreGive(soundLock);
+    return queued ? SoundSequencer::getLength(notes, n) : 0;
+}
+
+void MorseSound::pwmClick(unsigned int volume)
+{                        /// generate a click on the speaker
+    if (!MorsePreferences::prefs.encoderClicks)
+        return;
+    const SoundSequencer::Note click[] = { { 250, 6, (uint8_t) volume }, { 280, 5, (uint8_t) volume } };
+    play(click, 2);
+}
+
+
+unsigned long MorseSound::soundSignalOK() {
+    uint8_t v = MorsePreferences::prefs.sidetoneVolume;
+    const SoundSequencer::Note ok[] = { { 440, 97, v }, { 587, 193, v } };
+    return play(ok, 2);
+}
+
+
+unsigned long MorseSound::soundSignalERR() {
+    const SoundSequencer::Note err[] = { { 311, 193, MorsePreferences::prefs.sidetoneVolume } };
+    return play(err, 1);
+}
+
+/// startMixer switches the tone PWM to samples of the mixer, for several signals at once; the volume is that of the
+/// sidetone, the voices share it, and the sidetone of the keyer is mixed in while the mixer runs
+void MorseSound::startMixer(unsigned int volume, boolean lineOut)
+{
+    xSemaphoreTake(soundLock, portMAX_DELAY);
+    if (mixing)
+    {
+        xSemaphoreGive(soundLock);
+        return;
+    }
+    pwmOutput.silence();
+    mixer.stopAll();
+    mixing = true;
+    mixLineOut = lineOut;
+    mixVolume = volume;
+    ringRead = ringWrite = 0;
+
+    ledcSetup(toneChannel, carrierFreq, pwmResolution);
+    ledcWrite(toneChannel, dutyCycleFiftyPercent);
     if (lineOut)
     {
-        ledcWriteTone(lineOutChannel, (double) frequency);
+        ledcSetup(lineOutChannel, carrierFreq, pwmResolution);
         ledcWrite(lineOutChannel, dutyCycleFiftyPercent);
     }
+    ledcWrite(volChannel, internal::volumeDuty(volume));
 
-    ledcWrite(volChannel, volFreq);
-    ledcWrite(volChannel, vol[i]);
-    ledcWriteTone(toneChannel, frequency);
+    sampleTimer = timerBegin(1, 80, true);                      // 1 µs
+    timerAttachInterrupt(sampleTimer, &internal::onSample, true);
+    timerAlarmWrite(sampleTimer, 1000000 / VoiceMixer::SAMPLE_RATE, true);
+    timerAlarmEnable(sampleTimer);
+    esp_timer_start_periodic(renderTimer, renderPeriod);
+    xSemaphoreGive(soundLock);
+}
 
-    if (i == 0)
-        ledcWrite(toneChannel, dutyCycleZero);
-    else if (i > 3)
-        ledcWrite(toneChannel, dutyCycleFiftyPercent);
+/// stopMixer goes back to the square wave of the tone PWM - unless the synthesizer is on: then the voices are
+/// stopped, and the mixer goes on with the sidetone
+void MorseSound::stopMixer()
+{
+    xSemaphoreTake(soundLock, portMAX_DELAY);
+    if (synth)
+    {
+        for (uint8_t i = 0; i < mixerVoices; ++i)
+        {
+            mixer.stop(i);
+        }
+    }
     else
-        ledcWrite(toneChannel, i * i * i + 4 + 2 * i);          /// an ugly hack to allow for lower volumes on headphones
+    {
+        internal::stopMixing();
+    }
+    xSemaphoreGive(soundLock);
+}
+
+/// setSynth switches between the synthesizer (everything from the mixer: sine waves with smooth edges, noise, fading)
+/// and the square wave of the tone PWM, the fallback
+void MorseSound::setSynth(boolean on)
+{
+    if (on)
+    {
+        startMixer(MorsePreferences::prefs.sidetoneVolume, true);
+    }
+    xSemaphoreTake(soundLock, portMAX_DELAY);
+    synth = on;
+    if (!on)
+    {
+        internal::stopMixing();
+    }
+    xSemaphoreGive(soundLock);
+}
 
+boolean MorseSound::isSynth()
+{
+    return synth;
 }
 
-void MorseSound::pwmNoTone()
-{      // stop playing a tone by changing duty cycle of the tone to 0
-    ledcWrite(toneChannel, dutyCycleTwentyPercent);
-    ledcWrite(lineOutChannel, dutyCycleTwentyPercent);
-    delayMicroseconds(125);
-    ledcWrite(toneChannel, dutyCycleZero);
-    ledcWrite(lineOutChannel, dutyCycleZero);
+/// setNoise puts white or pink noise (level 0 - 100, 0 is off) into the mix, while the mixer runs
+void MorseSound::setNoise(uint8_t level, boolean pink)
+{
+    xSemaphoreTake(soundLock, portMAX_DELAY);
+    mixer.setNoise(level, pink);
+    xSemaphoreGive(soundLock);
+}
 
+/// setFading lets the sidetone fade by depth percent, once in periodMs (0: no fading), while the mixer runs
+void MorseSound::setFading(uint8_t depth, uint16_t periodMs)
+{
+    xSemaphoreTake(soundLock, portMAX_DELAY);
+    mixer.setFading(sidetoneVoice, depth, periodMs);
+    xSemaphoreGive(soundLock);
 }
 
-void MorseSound::pwmClick(unsigned int volume)
-{                        /// generate a click on the speaker
-    if (!MorsePreferences::prefs.encoderClicks)
+/// mixerSend lets a voice (0 .. mixerVoices - 1) send code as in VoiceMixer::send()
+boolean MorseSound::mixerSend(uint8_t voice, const char *code, uint16_t frequency, uint8_t wpm, uint8_t level,
+        uint16_t delayMs)
+{
+    if (voice >= mixerVoices)
+    {
+        return false;
+    }
+    xSemaphoreTake(soundLock, portMAX_DELAY);
+    boolean sent = mixer.send(voice, code, frequency, wpm, level, delayMs);
+    xSemaphoreGive(soundLock);
+    return sent;
+}
+
+boolean MorseSound::isMixerSending(uint8_t voice)
+{
+    xSemaphoreTake(soundLock, portMAX_DELAY);
+    boolean sending = mixer.isSending(voice);
+    xSemaphoreGive(soundLock);
+    return sending;
+}
+
+/// isMixing is true while the mixer puts out samples - then the timers and the PWM must not stop for light sleep
+boolean MorseSound::isMixing()
+{
+    return mixing;
+}
+
+void MorseSound::mixerStopAll()
+{
+    xSemaphoreTake(soundLock, portMAX_DELAY);
+    for (uint8_t i = 0; i < mixerVoices; ++i)
+    {
+        mixer.stop(i);
+    }
+    xSemaphoreGive(soundLock);
+}
+
+/// stopMixing stops the timers of the mixer and gives the tone PWM back to the square wave (inside soundLock)
+void internal::stopMixing()
+{
+    if (!mixing)
+    {
         return;
-    pwmTone(250, volume, false);
-    delay(6);
-    pwmTone(280, volume, false);
-    delay(5);
-    pwmNoTone();
+    }
+    esp_timer_stop(renderTimer);
+    timerAlarmDisable(sampleTimer);
+    timerDetachInterrupt(sampleTimer);
+    timerEnd(sampleTimer);
+    sampleTimer = 0;
+    mixer.stopAll();
+    mixer.setNoise(0, false);
+    mixer.setFading(sidetoneVoice, 0, 0);
+    mixing = false;
+
+    ledcSetup(toneChannel, toneFreq, pwmResolution);
+    ledcSetup(lineOutChannel, toneFreq, pwmResolution);
+    pwmOutput.silence();
+}
+
+/// setMixVolume follows the volume of the sidetone with the volume PWM while the mixer runs (inside soundLock)
+void internal::setMixVolume(uint8_t volume)
+{
+    if (mixing && volume != mixVolume)
+    {
+        mixVolume = volume;
+        ledcWrite(volChannel, volumeDuty(volume));
+    }
+}
+
+/// onRender keeps the ring lead samples ahead of the sample timer, in blocks
+void internal::onRender(void *arg)
+{
+    int16_t samples[renderBlock];
+
+    xSemaphoreTake(soundLock, portMAX_DELAY);
+    while (mixing && (uint16_t) (ringWrite - ringRead) % ringSize + renderBlock <= lead)
+    {
+        mixer.render(samples, renderBlock);
+        uint16_t w = ringWrite;
+        for (uint16_t i = 0; i < renderBlock; ++i)
+        {
+            ring[w] = VoiceMixer::toDuty(samples[i], pwmResolution);
+            w = (w + 1) % ringSize;
+        }
+        ringWrite = w;
+    }
+    xSemaphoreGive(soundLock);
+}
+
+/// onSample puts out the next sample; if the renderer is late, the last one stays
+void IRAM_ATTR internal::onSample()
+{
+    uint16_t r = ringRead;
+
+    if (r != ringWrite)
+    {
+        setDuty(toneChannel, ring[r]);
+        if (mixLineOut)
+        {
+            setDuty(lineOutChannel, ring[r]);
+        }
+        ringRead = (r + 1) % ringSize;
+    }
+}
+
+/// setDuty writes the duty cycle of a PWM channel into the LEDC registers, as ledcWrite() does - but ledcWrite() takes
+/// a mutex and is not in IRAM, so the sample interrupt (which also runs while the flash cache is off) must not call it
+void IRAM_ATTR internal::setDuty(uint8_t channel, uint32_t duty)
+{
+    uint8_t group = channel / 8;                    // 0 - 7 high speed, 8 - 15 low speed
+    uint8_t c = channel % 8;
+
+    LEDC.channel_group[group].channel[c].duty.duty = duty << 4;      // the lowest 4 bits are the fraction
+    LEDC.channel_group[group].channel[c].conf0.sig_out_en = 1;
+    LEDC.channel_group[group].channel[c].conf1.duty_start = 1;
+    if (group)
+    {
+        LEDC.channel_group[group].channel[c].conf0.low_speed_update = 1;
+    }
 }
 
+/// startTicks runs the timer while the sequencer has something to do (inside soundLock)
+void internal::startTicks()
+{
+    if (!ticking && sequencer.isBusy())
+    {
+        ticking = true;
+        esp_timer_start_periodic(soundTimer, SoundSequencer::TICK);
+    }
+}
 
-void MorseSound::soundSignalOK() {
-    MorseSound::pwmTone(440, MorsePreferences::prefs.sidetoneVolume, false);
-    delay(97);
-    MorseSound::pwmNoTone();
-    MorseSound::pwmTone(587, MorsePreferences::prefs.sidetoneVolume, false);
-    delay(193);
-    MorseSound::pwmNoTone();
+void internal::onTick(void *arg)
+{
+    xSemaphoreTake(soundLock, portMAX_DELAY);
+    sequencer.tick();
+    if (!sequencer.isBusy())
+    {
+        ticking = false;
+        esp_timer_stop(soundTimer);
+    }
+    xSemaphoreGive(soundLock);
 }
 
+/// volumeDuty is the duty cycle of the volume PWM for a level (0 - 100)
+uint16_t internal::volumeDuty(uint8_t level)
+{ // we use 10 bit resolution
+    const uint16_t vol[] =
+        {0, 1, 2, 3, 16, 150, 380, 580, 700, 880, 1023};
+    return vol[uconstrain(level / 10, 10)];
+}
+
+/// tone sets the PWMs for a level of the envelope: the volume PWM follows the level, the tone PWM is only
+/// written when the frequency changes; line out is on or off. While the mixer runs, the level goes to the voice of
+/// the sidetone instead.
+void internal::PwmOutput::tone(uint16_t f, uint8_t level, boolean l)
+{
+    if (mixing)
+    {   // the mixer makes the ramps, along a raised cosine: key while the level goes up or stays, release when it decays
+        mixer.key(sidetoneVoice, f, level > 0 && level >= lastLevel ? sidetoneLevel : 0);
+        lastLevel = level;
+        return;
+    }
+    int i = uconstrain(level / 10, 10);
+
+    if (l && !lineOut)
+    {
+        ledcWriteTone(lineOutChannel, (double) f);
+        ledcWrite(lineOutChannel, dutyCycleFiftyPercent);
+    }
+    lineOut = l;
+
+    ledcWrite(volChannel, volumeDuty(level));
+    if (f != frequency)
+    {
+        ledcWriteTone(toneChannel, f);
+        frequency = f;
+    }
 
-void MorseSound::soundSignalERR() {
-    MorseSound::pwmTone(311, MorsePreferences::prefs.sidetoneVolume, false);
-    delay(193);
-    MorseSound::pwmNoTone();
+    if (i == 0)
+        ledcWrite(toneChannel, dutyCycleZero);
+    else if (i > 3)
+        ledcWrite(toneChannel, dutyCycleFiftyPercent);
+    else
+        ledcWrite(toneChannel, i * i * i + 4 + 2 * i);          /// an ugly hack to allow for lower volumes on headphones
+}
+
+void internal::PwmOutput::silence()
+{
+    if (mixing)
+    {
+        mixer.key(sidetoneVoice, 0, 0);
+        lastLevel = 0;
+        return;
+    }
+    ledcWrite(toneChannel, dutyCycleZero);
+    ledcWrite(lineOutChannel, dutyCycleZero);
+    frequency = 0;
+    lineOut = false;
 }
@@ -2,6 +2,8 @@
 #define MORSESOUND_H_
 
 #include <Arduino.h>
+#include "SoundSequencer.h"
+#include "VoiceMixer.h"
 
 namespace MorseSound
 {
@@ -11,9 +13,24 @@ namespace MorseSound
     void setup();
     void pwmTone(unsigned int frequency, unsigned int volume, boolean lineOut);
     void pwmNoTone();
+    boolean isSounding();
     void pwmClick(unsigned int volume);
-    void soundSignalOK();
-    void soundSignalERR();
+    unsigned long play(const SoundSequencer::Note *notes, uint8_t n);
+    unsigned long soundSignalOK();
+    unsigned long soundSignalERR();
+
+    const uint8_t mixerVoices = VoiceMixer::MAX_VOICES - 1;     // the last voice is the sidetone
+
+    void startMixer(unsigned int volume, boolean lineOut);
+    void stopMixer();
+    boolean mixerSend(uint8_t voice, const char *code, uint16_t frequency, uint8_t wpm, uint8_t level, uint16_t delayMs);
+    boolean isMixerSending(uint8_t voice);
+    boolean isMixing();
+    void mixerStopAll();
+    void setSynth(boolean on);
+    boolean isSynth();
+    void setNoise(uint8_t level, boolean pink);
+    void setFading(uint8_t depth, uint16_t periodMs);
 
 }
 
@@ -0,0 +1,213 @@
+/******************************************************************************************************************************
+ *  morse_3 Software for the Morserino-32 multi-functional Morse code machine, based on the Heltec WiFi LORA (ESP32) module ***
+ *  Copyright (C) 2018  Willi Kraml, OE1WKL                                                                                 ***
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this program.
+ *  If not, see <https://www.gnu.org/licenses/>.
+ *****************************************************************************************************************************/
+
+#include <Preferences.h>
+#include "MorseStats.h"
+#include "MorseDisplay.h"
+#include "MorseRotaryEncoder.h"
+#include "MorseSystem.h"
+#include "MorseText.h"
+#include "MorseUI.h"
+
+using namespace MorseStats;
+
+CharStats MorseStats::stats;
+SpacedRepetition MorseStats::schedule;
+
+namespace internal
+{
+    const char *NAME = "charstats";
+    const char *KEY = "table";
+    const char *SCHEDULE_KEY = "schedule";
+    const unsigned long WRITE_DELAY = 30000;    // ms after the last evaluation: we do not write the flash after each word
+    const uint8_t SHOWN = 24;                   // the worst characters on the stats screen
+    const uint16_t MIN_SENT = 5;                // characters sent less often are not shown
+
+    Preferences nvs;
+    boolean dirty = false;
+    unsigned long lastChange;
+
+    void save();
+    String printable(char c);
+    void showWorst(uint8_t top, uint8_t count, const char *worst);
+}
+
+/// setup reads the statistics and the schedule from non-volatile storage; if there are none (or they are damaged) we
+/// start from scratch
+void MorseStats::setup()
+{
+    CharStats::Blob blob;
+    SpacedRepetition::Blob scheduleBlob;
+
+    internal::nvs.begin(internal::NAME, true);
+    size_t length = internal::nvs.getBytes(internal::KEY, &blob, sizeof(blob));
+    size_t scheduleLength = internal::nvs.getBytes(internal::SCHEDULE_KEY, &scheduleBlob, sizeof(scheduleBlob));
+    internal::nvs.end();
+    if (!stats.fromBlob(blob, length))
+    {
+        stats.clear();
+    }
+    if (!schedule.fromBlob(scheduleBlob, scheduleLength))
+    {
+        schedule.clear();
+    }
+}
+
+/// evaluate feeds a response of the echo trainer into the statistics, both in internal form (pro signs as one character)
+CharStats::Result MorseStats::evaluate(String &expected, String &response, const uint16_t *responseMs)
+{
+    internal::dirty = true;
+    internal::lastChange = millis();
+    return stats.evaluate(expected.c_str(), response.c_str(), responseMs);
+}
+
+/// review moves the cards of the schedule on; a character counts as slow when it took half as long again as the
+/// average character
+void MorseStats::review(String &expected, String &response, const uint16_t *responseMs)
+{
+    internal::dirty = true;
+    internal::lastChange = millis();
+    schedule.review(expected.c_str(), response.c_str(), responseMs, stats.getMeanResponse() * 3 / 2);
+}
+
+/// writeBehind is called from the main loop; it saves the statistics once the trainer has been quiet for a while
+void MorseStats::writeBehind()
+{
+    if (internal::dirty && millis() - internal::lastChange >= internal::WRITE_DELAY)
+    {
+        internal::save();
+    }
+}
+
+/// flush saves the statistics right away, e.g. before we go to sleep
+void MorseStats::flush()
+{
+    if (internal::dirty)
+    {
+        internal::save();
+    }
+}
+
+void internal::save()
+{
+    CharStats::Blob blob;
+    SpacedRepetition::Blob scheduleBlob;
+
+    stats.toBlob(blob);
+    schedule.toBlob(scheduleBlob);
+    nvs.begin(NAME, false);
+    nvs.putBytes(KEY, &blob, sizeof(blob));
+    nvs.putBytes(SCHEDULE_KEY, &scheduleBlob, sizeof(scheduleBlob));
+    nvs.end();
+    dirty = false;
+}
+
+/// the stats screen: the characters with the highest error rates, three at a time, with their error rate, average
+/// response time and what was keyed instead the last time; encoder scrolls, RED sends the whole table as CSV over
+/// Serial, long RED clears the statistics and the schedule, BLACK leaves
+boolean MorseStats::menuExec(String mode)
+{
+    char worst[internal::SHOWN];
+    uint8_t count = stats.getWorst(worst, internal::SHOWN, internal::MIN_SENT);
+    uint8_t top = 0;
+    int t;
+
+    MorseDisplay::clearDisplay();
+    MorseDisplay::printOnStatusLine(true, 0, "Chr Err   ms  was");
+    internal::showWorst(top, count, worst);
+
+    while (true)
+    {
+        if ((t = MorseRotaryEncoder::checkEncoder()))
+        {
+            MorseUI::click();
+            int last = count > 3 ? count - 3 : 0;
+            top = constrain(top + t, 0, last);
+            internal::showWorst(top, count, worst);
+        }
+
+        MorseUI::modeButton.Update();
+        if (MorseUI::modeButton.clicks)
+        {
+            break;
+        }
+
+        MorseUI::volButton.Update();
+        switch (MorseUI::volButton.clicks)
+        {
+            case 1:
+                dumpCsv();
+                break;
+            case -1:
+                stats.clear();
+                schedule.clear();
+                internal::save();
+                count = top = 0;
+                internal::showWorst(top, count, worst);
+                break;
+        }
+        MorseSystem::checkShutDown(false);      // possibly time-out: go to sleep
+    }
+    MorseDisplay::clear();
+    return false;
+}
+
+/// dumpCsv prints one line for each character that has been sent or keyed
+void MorseStats::dumpCsv()
+{
+    Serial.println("char,sent,substituted,dropped,inserted,error_pct,response_ms,confused_with");
+    for (int i = 0; i < CharStats::SIZE; ++i)
+    {
+        char c = CharStats::FIRST + i;
+        const CharStats::Entry &e = stats.get(c);
+        if (!e.sent && !e.inserted)
+        {
+            continue;
+        }
+        Serial.printf("%s,%u,%u,%u,%u,%u,%u,%s\n", internal::printable(c).c_str(), e.sent, e.substituted, e.dropped,
+                e.inserted, stats.getErrorPercent(c), e.responseMs, e.confusedWith ? internal::printable(e.confusedWith).c_str() : "");
+    }
+}
+
+/// printable shows pro signs as such, and quotes what would upset a CSV reader
+String internal::printable(char c)
+{
+    String s(c);
+
+    MorseText::internalToProSigns(s);
+    if (c == ',' || c == '"')
+    {
+        s = c == ',' ? "\",\"" : "\"\"\"\"";
+    }
+    return s;
+}
+
+void internal::showWorst(uint8_t top, uint8_t count, const char *worst)
+{
+    MorseDisplay::clearScroll();
+    if (!count)
+    {
+        MorseDisplay::printOnScroll(0, REGULAR, 0, "No errors yet -");
+        MorseDisplay::printOnScroll(1, REGULAR, 0, "use the Echo");
+        MorseDisplay::printOnScroll(2, REGULAR, 0, "Trainer");
+        return;
+    }
+    for (int line = 0; line < 3 && top + line < count; ++line)
+    {
+        char c = worst[top + line];
+        const CharStats::Entry &e = stats.get(c);
+        MorseDisplay::vprintOnScroll(line, REGULAR, 0, "%-4.4s%3u%%%5u %-4.4s", printable(c).c_str(), stats.getErrorPercent(c),
+                e.responseMs, e.confusedWith ? printable(e.confusedWith).c_str() : "");
+    }
+}
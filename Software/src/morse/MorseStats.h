@@ -0,0 +1,22 @@
+#ifndef MORSESTATS_H_
+#define MORSESTATS_H_
+
+#include <Arduino.h>
+#include "CharStats.h"
+#include "SpacedRepetition.h"
+
+namespace MorseStats
+{
+    extern CharStats stats;                 /// what the echo trainer has learned about each character
+    extern SpacedRepetition schedule;       /// when each character (and each word that went wrong) is due again
+
+    void setup();
+    CharStats::Result evaluate(String &expected, String &response, const uint16_t *responseMs);
+    void review(String &expected, String &response, const uint16_t *responseMs);
+    void writeBehind();
+    void flush();
+    boolean menuExec(String mode);
+    void dumpCsv();
+}
+
+#endif /* MORSESTATS_H_ */
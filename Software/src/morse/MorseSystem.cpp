@@ -15,11 +15,78 @@
 #include "MorseSystem.h"
 #include "MorseDisplay.h"
 #include "MorsePreferences.h"
+#include "MorseLoRa.h"
+#include "MorsePower.h"
+#include "MorseStats.h"
+#include "MorseMenu.h"
+#include "MorseSessionLog.h"
 #include <WiFi.h>          // basic WiFi functionality
-#include <LoRa.h>          // library for LoRa transceiver
 
 using namespace MorseSystem;
 
+namespace internal
+{
+    void logBootPhase(const char *phase, unsigned long at, unsigned long took);
+}
+
+BootSequence MorseSystem::boot(millis, internal::logBootPhase);
+Scheduler MorseSystem::scheduler(micros, MorsePower::wait);
+uint8_t MorseSystem::paddlesTaskNo = Scheduler::NO_TASK;
+uint8_t MorseSystem::modeTaskNo = Scheduler::NO_TASK;
+TaskHandle_t loopTask = 0;                  // the task running loop(), blocked in waitForNotification()
+
+void internal::logBootPhase(const char *phase, unsigned long at, unsigned long took)
+{
+    Serial.printf("Boot: %-14s at %5lu ms (%lu ms)\n", phase, at, took);
+}
+
+/// waitForNotification blocks the main loop until the next task is due, or until wakeForPaddles(); meanwhile
+/// FreeRTOS runs its idle task, which halts the CPU until the next interrupt. Less than a tick is not worth blocking.
+void MorseSystem::waitForNotification(unsigned long us)
+{
+    TickType_t ticks = us / 1000 / portTICK_PERIOD_MS;
+
+    if (ticks == 0)
+    {
+        return;
+    }
+    if (!loopTask)
+    {
+        loopTask = xTaskGetCurrentTaskHandle();
+    }
+    ulTaskNotifyTake(pdTRUE, ticks);
+}
+
+/// wakeForPaddles releases the paddle and mode tasks at once, and ends waitForNotification(); called when a paddle
+/// edge has been queued, from the pin interrupt or the touch sampler (not inside a critical section)
+void IRAM_ATTR MorseSystem::wakeForPaddles()
+{
+    MorsePower::onPaddle();
+    if (paddlesTaskNo == Scheduler::NO_TASK)
+    {
+        return;
+    }
+    scheduler.wake(paddlesTaskNo);
+    scheduler.wake(modeTaskNo);
+    if (!loopTask)
+    {
+        return;
+    }
+    if (xPortInIsrContext())
+    {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(loopTask, &woken);
+        if (woken)
+        {
+            portYIELD_FROM_ISR();
+        }
+    }
+    else
+    {
+        xTaskNotifyGive(loopTask);
+    }
+}
+
 boolean MorseSystem::menuExec(String mode)
 {
     if (mode == "sleep")
@@ -91,7 +158,7 @@ void MorseSystem::checkShutDown(boolean enforce)
         MorseDisplay::clear();
         MorseDisplay::printOnScroll(1, INVERSE_BOLD, 0, "Power OFF...");
         MorseDisplay::printOnScroll(2, REGULAR, 0, "RED to turn ON");
-        MorseDisplay::displayDisplay();
+        MorseDisplay::displayNow();
         delay(1500);
         shutMeDown();
     }
@@ -99,8 +166,17 @@ void MorseSystem::checkShutDown(boolean enforce)
 
 void MorseSystem::shutMeDown()
 {
+    MorseMode *m = MorseMenu::getCurrentMenuItem()->mode;
+    if (m)
+    {
+        m->onLeave();                   // e.g. the speed the echo trainer has adapted
+    }
+    MorsePreferences::flush();            // save changes that are still waiting to be written
+    MorseStats::flush();
+    MorseSessionLog::end();
+    MorseSessionLog::flush();
     MorseDisplay::sleep();                //OLED sleep
-    LoRa.sleep();                   //LORA sleep
+    MorseLoRa::sleep();             //LORA sleep
     delay(50);
 #if BOARDVERSION == 3
     digitalWrite(Vext, HIGH);
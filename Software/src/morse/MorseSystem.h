@@ -2,12 +2,21 @@
 #define MORSESYSTEM_H_
 
 #include <Arduino.h>
+#include "BootSequence.h"
+#include "Scheduler.h"
 
 namespace MorseSystem
 {
+    extern BootSequence boot;               /// boot phases and subsystems that are started later
+    extern Scheduler scheduler;             /// runs the tasks of the main loop
+    extern uint8_t paddlesTaskNo;           /// the tasks woken up by a paddle edge
+    extern uint8_t modeTaskNo;
 
     boolean menuExec(String mode);
 
+    void wakeForPaddles();
+    void waitForNotification(unsigned long us);
+
     void resetTOT();
     void checkShutDown(boolean enforce);
 
@@ -20,18 +20,34 @@
 #include "abbrev.h"
 #include "MorseModeEchoTrainer.h"
 #include "MorsePlayerFile.h"
+#include "MorseQso.h"
+#include "MorseMachine.h"
+#include "MorseStats.h"
+#include "AdaptiveText.h"
+#include "MorseSessionLog.h"
 
 using namespace MorseText;
 
 namespace internal
 {
     String getRandomChars(int maxLength, int option);
-    String getRandomCall(int maxLength);
     String getRandomWord(int maxLength);
     String getRandomAbbrev(int maxLength);
     String getRandomCWChars(int option, int maxLength);
+    void getCharRange(int option, int &s, int &e);
 
     String fetchRandomWord();
+    int limit(int length);
+
+    boolean isAdaptive();
+    boolean isSpaced();
+    String getDueChars(String pool, int maxLength);
+    String getWeakChars(String pool, int maxLength);
+    String getWeakItem(AdaptiveText::Pool pool, AdaptiveText::Item item, uint16_t first, uint16_t n);
+    const char* englishWord(uint16_t i);
+    const char* abbreviation(uint16_t i);
+
+    AdaptiveText adaptive(MorseStats::stats);       // chooses what the user is weak at, in the echo trainer
 }
 
 const MorseChar MorseText::morseChars[] = { //
@@ -119,6 +135,7 @@ void MorseText::start(GEN_TYPE genType)
     onGeneratorNewWord = &voidFunction;
     config.generateStartSequence = true;
     config.generatorMode = genType;
+    config.maxLength = 0;
 }
 
 MorseText::Config* MorseText::getConfig()
@@ -149,6 +166,7 @@ void MorseText::proceed()
 String MorseText::generateWord()
 {
     String result = "";
+    boolean repeated = false;
 
     if (config.generateStartSequence == true)
     {                                 /// do the initial sequence in trainer mode, too
@@ -165,10 +183,12 @@ String MorseText::generateWord()
     {
         repeatLast = false;
         result = lastGeneratedWord;
+        repeated = true;
     }
     else if ((config.repeatEach == MorsePreferences::REPEAT_FOREVER) || repetitionsLeft)
     {
         result = lastGeneratedWord;
+        repeated = true;
         if (repetitionsLeft > 0)
         {
             repetitionsLeft -= 1;
@@ -182,6 +202,7 @@ String MorseText::generateWord()
     }       /// end if else - we either already had something in trainer mode, or we got a new word
 
     lastGeneratedWord = result;
+    MorseSessionLog::word(result, repeated);
     return result;
 
 }
@@ -190,26 +211,51 @@ String internal::fetchRandomWord()
 {
     String word = "";
 
+    if (isSpaced())
+    {
+        switch (config.generatorMode)
+        {
+            case WORDS:
+            case ABBREVS:
+            case MIXED:
+            case KOCH_MIXED:
+                if (MorseStats::schedule.nextWord())            // a word that went wrong is due again
+                {
+                    return String(MorseStats::schedule.nextWord());
+                }
+                break;
+            case KOCH_LEARN:
+                word = getDueChars(Koch::kochChars.substring(0, MorsePreferences::prefs.kochFilter), 1);
+                if (word != "")
+                {
+                    return word;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
     switch (config.generatorMode)
     {
         case RANDOMS:
         {
-            word = internal::getRandomChars(MorsePreferences::prefs.randomLength, MorsePreferences::prefs.randomOption);
+            word = internal::getRandomChars(limit(MorsePreferences::prefs.randomLength), MorsePreferences::prefs.randomOption);
             break;
         }
         case CALLS:
         {
-            word = internal::getRandomCall(MorsePreferences::prefs.callLength);
+            word = MorseText::getRandomCall(limit(MorsePreferences::prefs.callLength));
             break;
         }
         case ABBREVS:
         {
-            word = internal::getRandomAbbrev(MorsePreferences::prefs.abbrevLength);
+            word = internal::getRandomAbbrev(limit(MorsePreferences::prefs.abbrevLength));
             break;
         }
         case WORDS:
         {
-            word = internal::getRandomWord(MorsePreferences::prefs.wordLength);
+            word = internal::getRandomWord(limit(MorsePreferences::prefs.wordLength));
             break;
         }
         case KOCH_LEARN:
@@ -222,13 +268,13 @@ String internal::fetchRandomWord()
             switch (random(4))
             {
                 case 0:
-                    word = internal::getRandomWord(MorsePreferences::prefs.wordLength);
+                    word = internal::getRandomWord(limit(MorsePreferences::prefs.wordLength));
                     break;
                 case 1:
-                    word = internal::getRandomAbbrev(MorsePreferences::prefs.abbrevLength);
+                    word = internal::getRandomAbbrev(limit(MorsePreferences::prefs.abbrevLength));
                     break;
                 case 2:
-                    word = internal::getRandomCall(MorsePreferences::prefs.callLength);
+                    word = MorseText::getRandomCall(limit(MorsePreferences::prefs.callLength));
                     break;
                 case 3:
                     word = internal::getRandomChars(1, OPT_PUNCTPRO); // just a single pro-sign or interpunct
@@ -241,13 +287,13 @@ String internal::fetchRandomWord()
             switch (random(3))
             {
                 case 0:
-                    word = internal::getRandomWord(MorsePreferences::prefs.wordLength);
+                    word = internal::getRandomWord(limit(MorsePreferences::prefs.wordLength));
                     break;
                 case 1:
-                    word = internal::getRandomAbbrev(MorsePreferences::prefs.abbrevLength);
+                    word = internal::getRandomAbbrev(limit(MorsePreferences::prefs.abbrevLength));
                     break;
                 case 2:
-                    word = internal::getRandomChars(MorsePreferences::prefs.randomLength, OPT_KOCH); // Koch option!
+                    word = internal::getRandomChars(limit(MorsePreferences::prefs.randomLength), OPT_KOCH); // Koch option!
                     break;
             }
             break;
@@ -261,6 +307,11 @@ String internal::fetchRandomWord()
             word = MorsePlayerFile::getWord();
             break;
         }
+        case QSO:
+        {
+            word = MorseQso::getWord();
+            break;
+        }
         case NA:
         {
             break;
@@ -269,11 +320,30 @@ String internal::fetchRandomWord()
     return word;
 }
 
+/// limit applies the maximum length of the configuration to a length of the preferences (0 there means unlimited)
+int internal::limit(int length)
+{
+    return config.maxLength && (length == 0 || length > config.maxLength) ? config.maxLength : length;
+}
+
 String internal::getRandomCWChars(int option, int maxLength)
 {
     int s;
     int e;
 
+    getCharRange(option, s, e);
+    String result = "";
+    for (int i = 0; i < maxLength; ++i)
+    {
+        result += morseChars[random(s, e)].internal;
+    }
+
+    return result;
+}
+
+/// getCharRange: the characters of a random option are morseChars[s] .. morseChars[e - 1]
+void internal::getCharRange(int option, int &s, int &e)
+{
     switch (option)
     {
         case OPT_NUM:
@@ -336,37 +406,56 @@ String internal::getRandomCWChars(int option, int maxLength)
             e = OPT_PRO_end;
         }
     }
-
-    String result = "";
-    for (int i = 0; i < maxLength; ++i)
-    {
-        result += morseChars[random(s, e)].internal;
-    }
-
-    return result;
 }
 
 String internal::getRandomChars(int maxLength, int option)
 {             /// random char string, eg. group of 5, 9 differing character pools; maxLength = 1-6
-    String result;
+    String result = "";
+    String pool;
 
     if (maxLength > 6)
     {                                        // we use a random length!
         maxLength = random(2, maxLength - 3);                     // maxLength is max 10, so random upper limit is 7, means max 6 chars...
     }
 
-    if (Koch::isKochActive())
+    if (internal::isAdaptive() || internal::isSpaced())
+    {
+        if (Koch::isKochActive())
+        {
+            pool = Koch::kochChars.substring(0, MorsePreferences::prefs.kochFilter);
+        }
+        else
+        {
+            int s, e;
+            getCharRange(option, s, e);
+            for (int i = s; i < e; ++i)
+            {
+                pool += morseChars[i].internal;
+            }
+        }
+    }
+    if (internal::isSpaced())
     {
-        result = Koch::getRandomChars(maxLength);
+        result = internal::getDueChars(pool, maxLength);            // what is due first, the rest as usual
+        maxLength -= result.length();
+    }
+
+    if (internal::isAdaptive())
+    {
+        result += internal::getWeakChars(pool, maxLength);
+    }
+    else if (Koch::isKochActive())
+    {
+        result += Koch::getRandomChars(maxLength);
     }
     else
     {
-        result = internal::getRandomCWChars(option, maxLength);
+        result += internal::getRandomCWChars(option, maxLength);
     }
     return result;
 }
 
-String internal::getRandomCall(int maxLength)
+String MorseText::getRandomCall(int maxLength)
 {            // random call-sign like pattern, maxLength = 3 - 6, 0 returns any length
     const byte prefixType[] = {1, 0, 1, 2, 3, 1};         // 0 = a, 1 = aa, 2 = a9, 3 = 9a
     byte prefix;
@@ -441,6 +530,13 @@ String internal::getRandomWord(int maxLength)
 {        //// give me a random English word, max maxLength chars long (1-5) - 0 returns any length
     if (maxLength > 5)
         maxLength = 0;
+    if (isAdaptive())
+    {
+        if (Koch::isKochActive())
+            return getWeakItem(AdaptiveText::WORDS, Koch::getWord, 0, Koch::getWordCount());
+        uint16_t first = EnglishWords::WORDS_POINTER[maxLength];
+        return getWeakItem(AdaptiveText::WORDS, englishWord, first, EnglishWords::WORDS_NUMBER_OF_ELEMENTS - first);
+    }
     if (Koch::isKochActive())
         return Koch::getRandomWord();
     else
@@ -451,12 +547,135 @@ String internal::getRandomAbbrev(int maxLength)
 {        //// give me a random CW abbreviation , max maxLength chars long (1-5) - 0 returns any length
     if (maxLength > 5)
         maxLength = 0;
+    if (isAdaptive())
+    {
+        if (Koch::isKochActive())
+            return getWeakItem(AdaptiveText::ABBREVS, Koch::getAbbrev, 0, Koch::getAbbrevCount());
+        uint16_t first = Abbrev::ABBREV_POINTER[maxLength];
+        return getWeakItem(AdaptiveText::ABBREVS, abbreviation, first, Abbrev::ABBREV_NUMBER_OF_ELEMENTS - first);
+    }
     if (Koch::isKochActive())
         return Koch::getRandomAbbrev();
     else
         return Abbrev::getRandomAbbrev(maxLength);
 }
 
+/// the adaptive text is used in the echo trainer (and the Koch echo trainer) only: there we learn what the user gets wrong
+boolean internal::isAdaptive()
+{
+    return MorsePreferences::prefs.adaptiveText && MorseMachine::isMode(MorseMachine::echoTrainer);
+}
+
+/// spaced repetition, too, is for the echo trainer only: it needs the responses
+boolean internal::isSpaced()
+{
+    return MorsePreferences::prefs.spacedRepetition && MorseMachine::isMode(MorseMachine::echoTrainer);
+}
+
+/// getDueChars are the characters of pool that are due for review, most overdue first, at most maxLength and each once
+String internal::getDueChars(String pool, int maxLength)
+{
+    String result = "";
+    char c;
+
+    while ((int) result.length() < maxLength && (c = MorseStats::schedule.nextChar(pool.c_str(), result.c_str())))
+    {
+        result += c;
+    }
+    return result;
+}
+
+String internal::getWeakChars(String pool, int maxLength)
+{
+    String result = "";
+
+    adaptive.setChars(pool.c_str());
+    uint32_t total = adaptive.getTotal(AdaptiveText::CHARS);
+    for (int i = 0; i < maxLength && total; ++i)
+    {
+        result += adaptive.pickChar(random(total));
+    }
+    return result;
+}
+
+String internal::getWeakItem(AdaptiveText::Pool pool, AdaptiveText::Item item, uint16_t first, uint16_t n)
+{
+    adaptive.setList(pool, item, first, n);
+    uint32_t total = adaptive.getTotal(pool);
+    return total ? String(adaptive.pickItem(pool, random(total))) : String("");
+}
+
+const char* internal::englishWord(uint16_t i)
+{
+    return EnglishWords::words[i].c_str();
+}
+
+const char* internal::abbreviation(uint16_t i)
+{
+    return Abbrev::abbreviations[i].c_str();
+}
+
+/// onEvaluated is called with each word the echo trainer has evaluated, after the statistics have been updated
+void MorseText::onEvaluated(String &word)
+{
+    internal::adaptive.onEvaluated(word.c_str());
+}
+
+/// onWordListsChanged is called when the Koch word or abbreviation lists have been rebuilt
+void MorseText::onWordListsChanged()
+{
+    internal::adaptive.invalidate();
+}
+
+/// getDits is the length of a word in dits: its elements, the spaces inside its characters, and those between them
+unsigned int MorseText::getDits(String &word)
+{
+    unsigned int dits = 0;
+
+    for (unsigned int i = 0; i < word.length(); ++i)
+    {
+        int pos = findChar(word[i]);
+        if (pos < 0)
+        {
+            continue;
+        }
+        const String &code = morseChars[pos].code;
+        for (unsigned int k = 0; k < code.length(); ++k)
+        {
+            dits += code[k] == '1' ? 2 : 4;             // with the space after it
+        }
+        dits += 2;                                      // three dits between characters, one of them counted already
+    }
+    return dits > 3 ? dits - 3 : 0;
+}
+
+/// toCode turns a text into its elements, for VoiceMixer::send(): '1' dit, '2' dah, ' ' between the characters and
+/// '/' between the words
+String MorseText::toCode(String text)
+{
+    String code = "";
+
+    for (unsigned int i = 0; i < text.length(); ++i)
+    {
+        if (text[i] == ' ')
+        {
+            code += "/";
+            continue;
+        }
+        int pos = findChar(text[i]);
+        if (pos < 0)
+        {
+            continue;
+        }
+        if (code.length() && code[code.length() - 1] != '/')
+        {
+            code += " ";
+        }
+        code += morseChars[pos].code;
+    }
+    return code;
+}
+
 int MorseText::findChar(char c)
 {
     String cStr = String(c);
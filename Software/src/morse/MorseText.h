@@ -12,7 +12,7 @@ namespace MorseText
 
     enum GEN_TYPE
     {
-        NA, RANDOMS, ABBREVS, WORDS, CALLS, MIXED, PLAYER, KOCH_MIXED, KOCH_LEARN
+        NA, RANDOMS, ABBREVS, WORDS, CALLS, MIXED, PLAYER, KOCH_MIXED, KOCH_LEARN, QSO
     };
 
     typedef struct
@@ -20,6 +20,7 @@ namespace MorseText
             boolean generateStartSequence;
             uint8_t repeatEach = 1;
             GEN_TYPE generatorMode;          // trainer: what symbol (groups) are we going to send?            0 -  5
+            uint8_t maxLength = 0;           // 0: as long as the preferences say; otherwise no word is longer (head copying)
     } Config;
 
     extern Config config;
@@ -40,6 +41,11 @@ namespace MorseText
     String utf8umlaut(String s);
     String internalToProSigns(String &input);
     String proSignsToInternal(String &input);
+    void onEvaluated(String &word);
+    void onWordListsChanged();
+    unsigned int getDits(String &word);
+    String getRandomCall(int maxLength);                  // maxLength 3 - 6, 0 for any length
+    String toCode(String text);
 
 }
 
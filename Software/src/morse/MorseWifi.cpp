@@ -22,6 +22,7 @@
 #include "MorsePreferences.h"
 #include "MorseUI.h"
 #include "MorsePlayerFile.h"
+#include "MorseQso.h"
 #include "MorseSystem.h"
 
 //using namespace MorseWifi;
@@ -178,6 +179,8 @@ namespace internal
     void handleNotFound();
     bool handleFileRead(String path);
     void handleFileUpload();
+
+    boolean uploadingGrammar = false;       // a file ending in .qso is a QSO grammar, everything else the player file
 }
 
 boolean MorseWifi::menuExec(String mode)
@@ -489,6 +492,7 @@ bool internal::handleFileRead(String path)
         path += "index.html";          // If a folder is requested, send the index file
     String contentType = internal::getContentType(path);             // Get the MIME type
     String pathWithGz = path + ".gz";
+    MorsePlayerFile::ensureMounted();
     if (SPIFFS.exists(pathWithGz) || SPIFFS.exists(path))
     {     // If the file exists, either as a compressed archive, or normal
         if (SPIFFS.exists(pathWithGz))                            // If there's a compressed version available
@@ -512,7 +516,9 @@ void internal::handleFileUpload()
         if (!filename.startsWith("/"))
             filename = "/" + filename;
         //MORSELOG("handleFileUpload Name: "); MORSELOGLN(filename);
-        MorseWifi::fsUploadFile = MorsePlayerFile::openForWriting();     // Open the file for writing in SPIFFS (create if it doesn't exist)
+        filename.toLowerCase();
+        uploadingGrammar = filename.endsWith(".qso");
+        MorseWifi::fsUploadFile = uploadingGrammar ? MorseQso::openForWriting() : MorsePlayerFile::openForWriting();     // Open the file for writing in SPIFFS (create if it doesn't exist)
         filename = String();
     }
     else if (upload.status == UPLOAD_FILE_WRITE)
@@ -525,8 +531,15 @@ void internal::handleFileUpload()
         if (MorseWifi::fsUploadFile)
         {                                    // If the file was successfully created
             MorseWifi::fsUploadFile.close();                               // Close the file again
-            MorsePreferences::prefs.fileWordPointer = 0;                              // reset word counter for file player
-            MorsePreferences::writeWordPointer();
+            if (uploadingGrammar)
+            {
+                MorseQso::onUploaded();
+            }
+            else
+            {
+                MorsePreferences::prefs.fileWordPointer = 0;                              // reset word counter for file player
+                MorsePreferences::writeWordPointer();
+            }
 
             //MORSELOG("handleFileUpload Size: "); MORSELOGLN(upload.totalSize);
             //server.sendHeader("Location","/success.html");      // Redirect the client to the success page
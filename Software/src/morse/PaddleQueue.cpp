@@ -0,0 +1,90 @@
+/******************************************************************************************************************************
+ *  morse_3 Software for the Morserino-32 multi-functional Morse code machine, based on the Heltec WiFi LORA (ESP32) module ***
+ *  Copyright (C) 2018  Willi Kraml, OE1WKL                                                                                 ***
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this program.
+ *  If not, see <https://www.gnu.org/licenses/>.
+ *****************************************************************************************************************************/
+#include "PaddleQueue.h"
+
+PaddleQueue::PaddleQueue()
+{
+    clear();
+}
+
+void PaddleQueue::clear()
+{
+    head = 0;
+    count = 0;
+    overflows = 0;
+    for (int i = 0; i < 2; ++i)
+    {
+        level[i] = false;
+        lastEdge[i] = 0;
+    }
+}
+
+/// onLevel queues an edge if the level of the paddle has changed and the paddle is not locked out;
+/// returns true if an edge was queued
+boolean PaddleQueue::onLevel(uint8_t paddle, boolean pressed, uint32_t now)
+{
+    if (pressed == level[paddle] || now - lastEdge[paddle] < LOCKOUT)
+    {
+        return false;
+    }
+    if (count == SIZE)
+    {   // the consumer is far behind - better keep the old edges, they decide what has been latched
+        ++overflows;
+        return false;
+    }
+
+    Edge &e = edges[(head + count) % SIZE];
+    e.time = now;
+    e.paddle = paddle;
+    e.pressed = pressed;
+    ++count;
+
+    level[paddle] = pressed;
+    lastEdge[paddle] = now;
+    return true;
+}
+
+boolean PaddleQueue::pop(Edge &edge)
+{
+    if (!count)
+    {
+        return false;
+    }
+    edge = edges[head];
+    head = (head + 1) % SIZE;
+    --count;
+    return true;
+}
+
+uint8_t PaddleQueue::getCount()
+{
+    return count;
+}
+
+/// isPressed is the level of the last queued edge of the paddle
+boolean PaddleQueue::isPressed(uint8_t paddle)
+{
+    return level[paddle];
+}
+
+/// isSettled is true when both paddles are out of their lockout, and the queue is empty
+boolean PaddleQueue::isSettled(uint32_t now)
+{
+    return !count && now - lastEdge[LEFT] >= LOCKOUT && now - lastEdge[RIGHT] >= LOCKOUT;
+}
+
+uint16_t PaddleQueue::getOverflows()
+{
+    return overflows;
+}
@@ -0,0 +1,61 @@
+/*
+ * PaddleQueue.h
+ *
+ *  Timestamped paddle edges, from the interrupt handlers to the keyer.
+ */
+
+#ifndef PADDLEQUEUE_H_
+#define PADDLEQUEUE_H_
+
+#include "arduino.h"
+
+/// The external paddle pins raise an interrupt on every change, and the touch sampler reports its
+/// (already debounced) state every millisecond; both pass the new level of a paddle to onLevel(), together
+/// with the time in µs. Only real changes are queued, and after an accepted edge the paddle is locked out
+/// for LOCKOUT µs, so contact bounce does not fill the queue - the first edge is the one with the real time.
+/// A bounce that ends on the other level is corrected by the next call of onLevel() after the lockout: the
+/// paddle task calls it with the levels it polls, so the queue never stays out of step with the pins.
+/// Once isSettled() is true, that resync cannot change anything any more, and the paddle task may wait for
+/// the next interrupt instead of polling.
+///
+/// There is one consumer, which pops the edges in the order they happened. onLevel() and pop() are not
+/// synchronised here; on the device the callers do that (the ISRs run on the same core, inside a critical section).
+/// onLevel() is in IRAM, as it is called from the pin interrupt, also while the flash cache is off.
+
+class PaddleQueue
+{
+    public:
+        static const uint8_t SIZE = 16;
+        static const uint32_t LOCKOUT = 750;            /// µs after an edge in which the paddle is not looked at
+
+        enum Paddle
+        {
+            LEFT, RIGHT
+        };
+
+        struct Edge
+        {
+                uint32_t time;                          /// micros() when the edge happened
+                uint8_t paddle;
+                boolean pressed;
+        };
+
+        PaddleQueue();
+        void clear();
+        boolean IRAM_ATTR onLevel(uint8_t paddle, boolean pressed, uint32_t now);
+        boolean pop(Edge &edge);
+        uint8_t getCount();
+        boolean isPressed(uint8_t paddle);
+        boolean isSettled(uint32_t now);
+        uint16_t getOverflows();
+
+    private:
+        Edge edges[SIZE];
+        volatile uint8_t head;
+        volatile uint8_t count;
+        boolean level[2];
+        uint32_t lastEdge[2];
+        uint16_t overflows;
+};
+
+#endif /* PADDLEQUEUE_H_ */
@@ -0,0 +1,167 @@
+/******************************************************************************************************************************
+ *  morse_3 Software for the Morserino-32 multi-functional Morse code machine, based on the Heltec WiFi LORA (ESP32) module ***
+ *  Copyright (C) 2018  Willi Kraml, OE1WKL                                                                                 ***
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this program.
+ *  If not, see <https://www.gnu.org/licenses/>.
+ *****************************************************************************************************************************/
+#include "PowerPolicy.h"
+
+/// typical currents of the Heltec module at 240 MHz, WiFi off, with the OLED showing text
+const PowerPolicy::Currents PowerPolicy::CURRENTS =
+{
+    45000,          // run
+    20000,          // wait
+    1000,           // lightSleep (with the touch sensors still measuring)
+    11500,          // radioReceive
+    12000,          // displayFull
+    4000,           // displayDimmed
+    6000            // base
+};
+
+PowerPolicy::PowerPolicy()
+{
+    profile.radio = true;                   // until we know better: what the firmware always did
+    profile.lightSleep = false;
+    profile.dimAfter = 0;
+    profile.frameInterval = 0;
+    begin(0);
+}
+
+/// begin starts the estimate from scratch
+void PowerPolicy::begin(unsigned long now)
+{
+    display = DISPLAY_FULL;
+    lastInput = now;
+    lastRefresh = now;
+    lastAccount = now;
+    elapsed = 0;
+    waited = 0;
+    sleptLightly = 0;
+    radioTime = 0;
+    dimmedTime = 0;
+}
+
+/// setProfile switches to the profile of a new mode; this counts as input
+void PowerPolicy::setProfile(const Profile &p, unsigned long now)
+{
+    account(now);
+    profile = p;
+    lastInput = now;
+    display = DISPLAY_FULL;
+}
+
+const PowerPolicy::Profile& PowerPolicy::getProfile()
+{
+    return profile;
+}
+
+/// onInput is called for every paddle, button or encoder action; it brings the display back
+void PowerPolicy::onInput(unsigned long now)
+{
+    account(now);
+    lastInput = now;
+    display = DISPLAY_FULL;
+}
+
+/// update dims the display when there has been no input for long enough
+void PowerPolicy::update(unsigned long now)
+{
+    account(now);
+    if (display == DISPLAY_FULL && profile.dimAfter && now - lastInput >= profile.dimAfter * 1000)
+    {
+        display = DISPLAY_DIMMED;
+    }
+}
+
+/// chooseSleep decides how to spend the wait µs until the next task is due; busy: the sidetone sounds, or the mixer runs
+PowerPolicy::Sleep PowerPolicy::chooseSleep(unsigned long wait, boolean busy)
+{
+    if (wait < MIN_WAIT)
+    {
+        return RUN;
+    }
+    if (profile.lightSleep && !busy && wait >= MIN_LIGHT_SLEEP)
+    {
+        return LIGHT_SLEEP;
+    }
+    return WAIT;
+}
+
+/// slept tells how long the CPU has really waited or slept (an interrupt may have ended it early)
+void PowerPolicy::slept(Sleep how, unsigned long us)
+{
+    switch (how)
+    {
+        case WAIT:
+            waited += us;
+            break;
+        case LIGHT_SLEEP:
+            sleptLightly += us;
+            break;
+        default:
+            break;
+    }
+}
+
+PowerPolicy::Display PowerPolicy::getDisplay()
+{
+    return display;
+}
+
+/// mayRefresh is true if the display may be refreshed now; while it is dimmed, once per frameInterval only
+boolean PowerPolicy::mayRefresh(unsigned long now)
+{
+    if (display == DISPLAY_DIMMED && now - lastRefresh < profile.frameInterval * 1000)
+    {
+        return false;
+    }
+    lastRefresh = now;
+    return true;
+}
+
+boolean PowerPolicy::isRadioOn()
+{
+    return profile.radio;
+}
+
+/// getEstimate adds up the time in each state, weighted with its current
+PowerPolicy::Estimate PowerPolicy::getEstimate(unsigned long now)
+{
+    Estimate e;
+
+    account(now);
+    uint64_t idle = waited + sleptLightly;
+    uint64_t running = elapsed > idle ? elapsed - idle : 0;
+    uint64_t charge = running * CURRENTS.run + waited * CURRENTS.wait + sleptLightly * CURRENTS.lightSleep
+            + radioTime * CURRENTS.radioReceive + (elapsed - dimmedTime) * CURRENTS.displayFull
+            + dimmedTime * CURRENTS.displayDimmed + elapsed * CURRENTS.base;    // µA * µs
+
+    e.seconds = elapsed / 1000000;
+    e.microAmpHours = charge / 3600000000ULL;
+    e.averageMicroAmps = elapsed ? charge / elapsed : 0;
+    e.sleepPercent = elapsed ? sleptLightly * 100 / elapsed : 0;
+    return e;
+}
+
+void PowerPolicy::account(unsigned long now)
+{
+    unsigned long dt = now - lastAccount;
+
+    elapsed += dt;
+    if (profile.radio)
+    {
+        radioTime += dt;
+    }
+    if (display == DISPLAY_DIMMED)
+    {
+        dimmedTime += dt;
+    }
+    lastAccount = now;
+}
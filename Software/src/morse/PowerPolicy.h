@@ -0,0 +1,98 @@
+/*
+ * PowerPolicy.h
+ *
+ *  Decides how to sleep, when to dim the display and whether the radio listens - and estimates the current.
+ */
+
+#ifndef POWERPOLICY_H_
+#define POWERPOLICY_H_
+
+#include "arduino.h"
+
+/// Each mode has a Profile: whether it needs the LoRa receiver, whether it may use light sleep between events,
+/// and after how long without input the display is dimmed and refreshed less often. The main loop asks
+/// chooseSleep() what to do with the time until the next task is due: nothing (too short), wait for an
+/// interrupt with the CPU halted, or light sleep, which also stops the clocks - but then the sidetone would
+/// stop as well, so not while it sounds (or a paddle is held, as its release would not wake us up). Light
+/// sleep ends WAKE_LATENCY µs early, so the deadline is kept.
+///
+/// The policy also keeps track of the time spent in each state, and getEstimate() turns that into an
+/// estimate of the charge drawn from the battery, with the typical currents of the board in CURRENTS.
+/// It does not touch any hardware: the caller passes in all times (in µs, wrapping like micros()) and does
+/// what the policy decides.
+
+class PowerPolicy
+{
+    public:
+        static const unsigned long MIN_WAIT = 1000;             /// µs, shorter waits are not worth it
+        static const unsigned long MIN_LIGHT_SLEEP = 5000;      /// µs, shorter ones cost more than they save
+        static const unsigned long WAKE_LATENCY = 1000;         /// µs from the wake-up to the running task
+
+        enum Sleep
+        {
+            RUN, WAIT, LIGHT_SLEEP
+        };
+
+        enum Display
+        {
+            DISPLAY_FULL, DISPLAY_DIMMED
+        };
+
+        struct Profile
+        {
+                boolean radio;                  /// the mode needs the LoRa receiver
+                boolean lightSleep;             /// the mode may sleep lightly between events
+                unsigned long dimAfter;         /// ms without input before the display is dimmed, 0 = never
+                unsigned long frameInterval;    /// ms between display refreshes while dimmed
+        };
+
+        struct Currents
+        {
+                uint16_t run;                   /// all in µA: CPU running
+                uint16_t wait;                  /// CPU halted, waiting for an interrupt
+                uint16_t lightSleep;
+                uint16_t radioReceive;
+                uint16_t displayFull;
+                uint16_t displayDimmed;
+                uint16_t base;                  /// regulator, battery measurement, LED
+        };
+
+        struct Estimate
+        {
+                unsigned long seconds;
+                unsigned long microAmpHours;
+                unsigned long averageMicroAmps;
+                uint8_t sleepPercent;           /// of the time in light sleep
+        };
+
+        static const Currents CURRENTS;
+
+        PowerPolicy();
+        void begin(unsigned long now);
+        void setProfile(const Profile &p, unsigned long now);
+        const Profile& getProfile();
+        void onInput(unsigned long now);
+        void update(unsigned long now);
+        Sleep chooseSleep(unsigned long wait, boolean busy);
+        void slept(Sleep how, unsigned long us);
+        Display getDisplay();
+        boolean mayRefresh(unsigned long now);
+        boolean isRadioOn();
+        Estimate getEstimate(unsigned long now);
+
+    private:
+        Profile profile;
+        Display display;
+        unsigned long lastInput;
+        unsigned long lastRefresh;
+        unsigned long lastAccount;
+        uint64_t elapsed;
+        uint64_t waited;
+        uint64_t sleptLightly;
+        uint64_t radioTime;
+        uint64_t dimmedTime;
+
+        void account(unsigned long now);
+};
+
+#endif /* POWERPOLICY_H_ */
@@ -0,0 +1,373 @@
+/******************************************************************************************************************************
+ *  morse_3 Software for the Morserino-32 multi-functional Morse code machine, based on the Heltec WiFi LORA (ESP32) module ***
+ *  Copyright (C) 2018  Willi Kraml, OE1WKL                                                                                 ***
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this program.
+ *  If not, see <https://www.gnu.org/licenses/>.
+ *****************************************************************************************************************************/
+#include <string.h>
+#include "PrefsStore.h"
+
+using namespace MorsePreferences;
+
+const char *PrefsStore::KEY = "prefs";
+
+namespace
+{
+    /// packs the values, little endian
+    struct Writer
+    {
+            uint8_t *p;
+
+            void field(uint8_t &v)
+            {
+                *p++ = v;
+            }
+            void field(boolean &v)
+            {
+                *p++ = v ? 1 : 0;
+            }
+            void field(uint32_t &v)
+            {
+                for (int i = 0; i < 4; ++i)
+                {
+                    *p++ = (v >> (8 * i)) & 0xff;
+                }
+            }
+    };
+
+    /// unpacks the values; what is missing at the end (because the blob is older) keeps its default
+    struct Reader
+    {
+            const uint8_t *p;
+            const uint8_t *end;
+
+            void field(uint8_t &v)
+            {
+                if (p + 1 <= end)
+                {
+                    v = *p++;
+                }
+            }
+            void field(boolean &v)
+            {
+                if (p + 1 <= end)
+                {
+                    v = *p++ != 0;
+                }
+            }
+            void field(uint32_t &v)
+            {
+                if (p + 4 <= end)
+                {
+                    v = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+                    p += 4;
+                }
+            }
+    };
+}
+
+/// transfer is the one list of all preferences stored in the blob - append new ones at the end!
+template<class IO> void PrefsStore::transfer(IO &io, MorsePrefs &p)
+{
+    io.field(p.sidetoneFreq);
+    io.field(p.sidetoneVolume);
+    io.field(p.useStraightKey);
+    io.field(p.didah);
+    io.field(p.keyermode);
+    io.field(p.interCharSpace);
+    io.field(p.useExtPaddle);
+    io.field(p.ACSlength);
+    io.field(p.encoderClicks);
+    io.field(p.randomLength);
+    io.field(p.randomOption);
+    io.field(p.callLength);
+    io.field(p.abbrevLength);
+    io.field(p.wordLength);
+    io.field(p.trainerDisplay);
+    io.field(p.curtisBTiming);
+    io.field(p.curtisBDotTiming);
+    io.field(p.interWordSpace);
+    io.field(p.echoRepeats);
+    io.field(p.echoDisplay);
+    io.field(p.kochFilter);
+    io.field(p.wordDoubler);
+    io.field(p.echoToneShift);
+    io.field(p.echoConf);
+    io.field(p.keyTrainerMode);
+    io.field(p.loraTrainerMode);
+    io.field(p.goertzelBandwidth);
+    io.field(p.speedAdapt);
+    io.field(p.latency);
+    io.field(p.randomFile);
+    io.field(p.lcwoKochSeq);
+    io.field(p.timeOut);
+    io.field(p.quickStart);
+    io.field(p.loraSyncW);
+    io.field(p.wpm);
+    io.field(p.menuPtr);
+    io.field(p.fileWordPointer);
+    io.field(p.loraBand);
+    io.field(p.loraQRG);
+    io.field(p.snapShots);
+    io.field(p.maxSequence);
+    io.field(p.tennisMsgSet);
+    io.field(p.tennisScoringRules);
+    io.field(p.adaptiveText);
+    io.field(p.spacedRepetition);
+    io.field(p.adaptTarget);
+    io.field(p.keyedAnswer);
+    io.field(p.audioSynth);
+    io.field(p.bandNoise);
+    io.field(p.qsb);
+    io.field(p.qrm);
+    io.field(p.loraStationIds);
+}
+
+PrefsStore::PrefsStore(Storage &s) :
+        storage(s)
+{
+    dirty = false;
+    lastChange = 0;
+}
+
+/// load reads the preferences of namespace name into p; if there is no valid blob yet, they are read from the
+/// old single keys, and - for the main namespace - the blob is written. Returns false if the namespace is empty.
+boolean PrefsStore::load(const char *name, MorsePrefs &p, boolean main)
+{
+    if (read(name, p))
+    {
+        return true;
+    }
+
+    if (!storage.begin(name, !main))
+    {
+        return false;
+    }
+    readLegacy(storage, p, main);
+    storage.end();
+    if (main)
+    {
+        save(name, p);
+    }
+    return true;
+}
+
+/// read reads the blob of namespace name into p; returns false (and leaves p alone) if there is no valid blob
+boolean PrefsStore::read(const char *name, MorsePrefs &p)
+{
+    uint8_t buffer[MAX_SIZE];
+    size_t length = 0;
+
+    if (storage.begin(name, true))
+    {
+        length = storage.getBytesLength(KEY);
+        if (length <= MAX_SIZE)
+        {
+            length = storage.getBytes(KEY, buffer, length);
+        }
+        else
+        {
+            length = 0;
+        }
+        storage.end();
+    }
+    return length && decode(buffer, length, p);
+}
+
+/// save writes the blob, if it differs from the stored one; returns true if it had to be written
+boolean PrefsStore::save(const char *name, const MorsePrefs &p)
+{
+    uint8_t buffer[MAX_SIZE], stored[MAX_SIZE];
+    uint8_t length = encode(p, buffer);
+    boolean written = false;
+
+    dirty = false;
+    if (!storage.begin(name, false))
+    {
+        return false;
+    }
+    if (storage.getBytesLength(KEY) != length || storage.getBytes(KEY, stored, length) != length
+            || memcmp(stored, buffer, length) != 0)
+    {
+        written = storage.putBytes(KEY, buffer, length) == length;
+    }
+    storage.end();
+    return written;
+}
+
+/// markDirty notes that something has changed that should be saved, but not right now
+void PrefsStore::markDirty(unsigned long now)
+{
+    dirty = true;
+    lastChange = now;
+}
+
+boolean PrefsStore::isDirty()
+{
+    return dirty;
+}
+
+/// writeBehind saves p if it has been marked dirty and nothing has changed for WRITE_DELAY ms
+boolean PrefsStore::writeBehind(const char *name, const MorsePrefs &p, unsigned long now)
+{
+    if (!dirty || now - lastChange < WRITE_DELAY)
+    {
+        return false;
+    }
+    return save(name, p);
+}
+
+/// encode packs p into buffer (at least MAX_SIZE bytes) and returns the length of the blob
+uint8_t PrefsStore::encode(const MorsePrefs &p, uint8_t *buffer)
+{
+    Writer w;
+    w.p = buffer + HEADER_SIZE;
+    transfer(w, const_cast<MorsePrefs&>(p));
+
+    uint8_t payload = w.p - buffer - HEADER_SIZE;
+    uint16_t crc = crc16(buffer + HEADER_SIZE, payload);
+    buffer[0] = LAYOUT_VERSION;
+    buffer[1] = payload;
+    buffer[2] = crc & 0xff;
+    buffer[3] = crc >> 8;
+    return payload + HEADER_SIZE;
+}
+
+/// decode unpacks a blob into p; returns false (and leaves p alone) if the blob is damaged
+boolean PrefsStore::decode(const uint8_t *buffer, size_t length, MorsePrefs &p)
+{
+    if (length < HEADER_SIZE || buffer[0] == 0 || buffer[1] != length - HEADER_SIZE
+            || crc16(buffer + HEADER_SIZE, buffer[1]) != (buffer[2] | (buffer[3] << 8)))
+    {
+        return false;
+    }
+    // layouts only ever grow at the end, so we can read newer ones as well
+    Reader r;
+    r.p = buffer + HEADER_SIZE;
+    r.end = buffer + length;
+    transfer(r, p);
+    return true;
+}
+
+/// CRC-16/CCITT-FALSE
+uint16_t PrefsStore::crc16(const uint8_t *data, size_t length)
+{
+    uint16_t crc = 0xffff;
+    while (length--)
+    {
+        crc ^= (uint16_t) *data++ << 8;
+        for (int i = 0; i < 8; ++i)
+        {
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+/// readLegacy reads the preferences from the single keys of former versions, exactly as they used to be read:
+/// a key that is missing (or, for most of them, zero) leaves the default; main is true for namespace "morserino"
+void PrefsStore::readLegacy(Storage &s, MorsePrefs &p, boolean main)
+{
+    uint8_t temp;
+    uint32_t tempInt;
+
+    if ((temp = s.getUChar("sidetoneFreq")))
+        p.sidetoneFreq = temp;
+    if ((temp = s.getUChar("wpm")))
+        p.wpm = temp;
+    if ((temp = s.getUChar("sidetoneVolume", 255)) != 255)
+        p.sidetoneVolume = temp;
+    if ((temp = s.getUChar("keyermode")))
+        p.keyermode = temp;
+    if ((temp = s.getUChar("farnsworthMode")))
+        p.interCharSpace = temp;
+    if ((temp = s.getUChar("ACSlength", 255)) != 255)
+        p.ACSlength = temp;
+    if ((temp = s.getUChar("keyTrainerMode", 255)) != 255)
+        p.keyTrainerMode = temp;
+    if ((temp = s.getUChar("randomLength")))
+        p.randomLength = temp;
+    if ((temp = s.getUChar("randomOption", 255)) != 255)
+        p.randomOption = temp;
+    if ((temp = s.getUChar("callLength", 255)) != 255)
+        p.callLength = temp;
+    if ((temp = s.getUChar("abbrevLength", 255)) != 255)
+        p.abbrevLength = temp;
+    if ((temp = s.getUChar("wordLength", 255)) != 255)
+        p.wordLength = temp;
+    if ((temp = s.getUChar("trainerDisplay", 255)) != 255)
+        p.trainerDisplay = temp;
+    if ((temp = s.getUChar("echoDisplay", 255)) != 255)
+        p.echoDisplay = temp;
+    if ((temp = s.getUChar("curtisBTiming", 255)) != 255)
+        p.curtisBTiming = temp;
+    if ((temp = s.getUChar("curtisBDotT", 255)) != 255)
+        p.curtisBDotTiming = temp;
+    if ((temp = s.getUChar("interWordSpace")))
+        p.interWordSpace = temp;
+    if ((temp = s.getUChar("echoRepeats", 255)) != 255)
+        p.echoRepeats = temp;
+    if ((temp = s.getUChar("echoToneShift", 255)) != 255)
+        p.echoToneShift = temp;
+    if (main && (temp = s.getUChar("kochFilter")))
+        p.kochFilter = temp;
+    if ((temp = s.getUChar("loraTrainerMode")))
+        p.loraTrainerMode = temp;
+    if ((temp = s.getUChar("goertzelBW")))
+        p.goertzelBandwidth = temp;
+    if ((temp = s.getUChar("latency")))
+        p.latency = temp;
+    if ((temp = s.getUChar("randomFile")))
+        p.randomFile = temp;
+    if ((temp = s.getUChar("lastExecuted")))
+        p.menuPtr = temp;
+    if ((temp = s.getUChar("timeOut")))
+        p.timeOut = temp;
+    if ((temp = s.getUChar("loraSyncW")))
+        p.loraSyncW = temp;
+    if ((temp = s.getUChar("maxSequence", p.maxSequence)))
+        p.maxSequence = temp;
+
+    p.useStraightKey = s.getBool("useStraightKey");
+    p.didah = s.getBool("didah", true);
+    p.useExtPaddle = s.getBool("useExtPaddle");
+    p.encoderClicks = s.getBool("encoderClicks", true);
+    p.echoConf = s.getBool("echoConf", true);
+    p.wordDoubler = s.getBool("wordDoubler");
+    p.speedAdapt = s.getBool("speedAdapt");
+    p.fileWordPointer = s.getUInt("fileWordPtr");
+    p.lcwoKochSeq = s.getBool("lcwoKochSeq");
+    p.quickStart = s.getBool("quickStart");
+    p.tennisMsgSet = s.getUChar("tennisMsgSet");
+    p.tennisScoringRules = s.getUChar("tennisScoring");
+
+    if (main)
+    {
+        p.loraBand = s.getUChar("loraBand");
+        if ((tempInt = s.getUInt("loraQRG")))
+            p.loraQRG = tempInt;
+        else
+            p.loraQRG = QRG433;
+        if ((temp = s.getUChar("snapShots")))
+            p.snapShots = temp;
+    }
+}
+
+/// keepDeviceSettings takes over into a recalled snapshot what belongs to the device rather than to a snapshot
+void PrefsStore::keepDeviceSettings(MorsePrefs &snapshot, const MorsePrefs &current)
+{
+    snapshot.kochFilter = current.kochFilter;
+    snapshot.fileWordPointer = current.fileWordPointer;
+    snapshot.loraBand = current.loraBand;
+    snapshot.loraQRG = current.loraQRG;
+    snapshot.snapShots = current.snapShots;
+    snapshot.wlanSSID = current.wlanSSID;
+    snapshot.wlanPassword = current.wlanPassword;
+}
@@ -0,0 +1,73 @@
+/*
+ * PrefsStore.h
+ *
+ *  Stores the preferences as one versioned, CRC checked blob in non-volatile storage.
+ */
+
+#ifndef PREFSSTORE_H_
+#define PREFSSTORE_H_
+
+#include "arduino.h"
+#include "MorsePrefs.h"
+
+/// Instead of one NVS entry per preference, all preferences of a namespace ("morserino" or one of the snapshots
+/// "snap0" .. "snap7") are packed into a single blob: a header (layout version, payload length, CRC-16 of the
+/// payload) followed by the values. Saving compares with what is stored and writes the whole blob with one
+/// putBytes() only if something changed. New preferences must be appended at the end of transfer(); an older
+/// blob simply lacks them and they keep their defaults.
+///
+/// Changes that come in bursts (speed and volume adjustments) are not written at once: markDirty() starts a timer
+/// that every further change restarts, and writeBehind(), called from the main loop, saves once the timer has expired.
+///
+/// A namespace without a blob is read the old way, one key per preference, and the blob is written; the old keys
+/// are left alone, so an older firmware still finds them.
+///
+/// WiFi credentials are rarely written and stay in keys of their own.
+
+class PrefsStore
+{
+    public:
+        /// the few operations we need from the ESP32 Preferences library, so it can be replaced for testing
+        class Storage
+        {
+            public:
+                virtual ~Storage() {};
+                virtual boolean begin(const char *name, boolean readOnly) = 0;
+                virtual void end() = 0;
+                virtual size_t getBytesLength(const char *key) = 0;
+                virtual size_t getBytes(const char *key, void *buffer, size_t length) = 0;
+                virtual size_t putBytes(const char *key, const void *buffer, size_t length) = 0;
+                virtual uint8_t getUChar(const char *key, uint8_t defaultValue = 0) = 0;
+                virtual boolean getBool(const char *key, boolean defaultValue = false) = 0;
+                virtual uint32_t getUInt(const char *key, uint32_t defaultValue = 0) = 0;
+        };
+
+        static const uint8_t LAYOUT_VERSION = 1;
+        static const uint8_t HEADER_SIZE = 4;
+        static const uint8_t MAX_SIZE = 96;
+        static const unsigned long WRITE_DELAY = 5000;  /// ms without further changes before a change is written
+        static const char *KEY;
+
+        PrefsStore(Storage &storage);
+        boolean load(const char *name, MorsePreferences::MorsePrefs &p, boolean main);
+        boolean read(const char *name, MorsePreferences::MorsePrefs &p);
+        boolean save(const char *name, const MorsePreferences::MorsePrefs &p);
+        void markDirty(unsigned long now);
+        boolean isDirty();
+        boolean writeBehind(const char *name, const MorsePreferences::MorsePrefs &p, unsigned long now);
+
+        static uint8_t encode(const MorsePreferences::MorsePrefs &p, uint8_t *buffer);
+        static boolean decode(const uint8_t *buffer, size_t length, MorsePreferences::MorsePrefs &p);
+        static uint16_t crc16(const uint8_t *data, size_t length);
+        static void readLegacy(Storage &storage, MorsePreferences::MorsePrefs &p, boolean main);
+        static void keepDeviceSettings(MorsePreferences::MorsePrefs &snapshot, const MorsePreferences::MorsePrefs &current);
+
+    private:
+        Storage &storage;
+        boolean dirty;
+        unsigned long lastChange;
+
+        template<class IO> static void transfer(IO &io, MorsePreferences::MorsePrefs &p);
+};
+
+#endif /* PREFSSTORE_H_ */
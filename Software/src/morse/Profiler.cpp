@@ -0,0 +1,157 @@
+/******************************************************************************************************************************
+ *  morse_3 Software for the Morserino-32 multi-functional Morse code machine, based on the Heltec WiFi LORA (ESP32) module ***
+ *  Copyright (C) 2018  Willi Kraml, OE1WKL                                                                                 ***
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this program.
+ *  If not, see <https://www.gnu.org/licenses/>.
+ *****************************************************************************************************************************/
+#include <stdio.h>
+
+#include "Profiler.h"
+
+const char *Profiler::CSV_HEADER = "section,count,min_us,avg_us,max_us,p99_us";
+
+Profiler::Counter Profiler::counter = 0;
+uint32_t Profiler::ticksPerUs = 1;
+Profiler::Section *Profiler::first = 0;
+
+Profiler::Section::Section(const char *name) :
+        name(name)
+{
+    reset();
+    next = first;                   // sections register themselves
+    first = this;
+}
+
+void Profiler::Section::record(uint32_t ticks)
+{
+    if (count == 0 || ticks < min)
+    {
+        min = ticks;
+    }
+    if (ticks > max)
+    {
+        max = ticks;
+    }
+    ++count;
+    sum += ticks;
+    ++histogram[bucket(ticks)];
+}
+
+void Profiler::Section::reset()
+{
+    count = 0;
+    min = 0;
+    max = 0;
+    sum = 0;
+    for (int i = 0; i < BUCKETS; ++i)
+    {
+        histogram[i] = 0;
+    }
+}
+
+/// getSummary returns the statistics in ticks; the percentile is the upper end of its bucket (but never above max)
+Profiler::Summary Profiler::Section::getSummary()
+{
+    Summary s = { count, min, count ? (uint32_t) (sum / count) : 0, max, 0 };
+
+    uint32_t wanted = count - count / 100;         // 99% of the values are not larger than p99
+    uint32_t seen = 0;
+    for (int i = 0; i < BUCKETS && count; ++i)
+    {
+        seen += histogram[i];
+        if (seen >= wanted)
+        {
+            s.p99 = bucketLimit(i) < max ? bucketLimit(i) : max;
+            break;
+        }
+    }
+    return s;
+}
+
+const char* Profiler::Section::getName()
+{
+    return name;
+}
+
+Profiler::Section* Profiler::Section::getNext()
+{
+    return next;
+}
+
+Profiler::Scope::Scope(Section &section) :
+        section(section), start(now())
+{
+}
+
+Profiler::Scope::~Scope()
+{
+    section.record(now() - start);
+}
+
+void Profiler::setCounter(Counter c, uint32_t ticks)
+{
+    counter = c;
+    ticksPerUs = ticks ? ticks : 1;
+}
+
+uint32_t Profiler::now()
+{
+    return counter ? counter() : 0;
+}
+
+Profiler::Section* Profiler::getFirst()
+{
+    return first;
+}
+
+void Profiler::resetAll()
+{
+    for (Section *s = first; s; s = s->getNext())
+    {
+        s->reset();
+    }
+}
+
+Profiler::Summary Profiler::inMicros(Summary t)
+{
+    Summary us = { t.count, t.min / ticksPerUs, t.avg / ticksPerUs, t.max / ticksPerUs, t.p99 / ticksPerUs };
+    return us;
+}
+
+/// formatCsv writes one line (without line end) in the columns of CSV_HEADER
+int Profiler::formatCsv(Section &section, char *buf, size_t size)
+{
+    Summary s = inMicros(section.getSummary());
+    return snprintf(buf, size, "%s,%lu,%lu,%lu,%lu,%lu", section.getName(), (unsigned long) s.count, (unsigned long) s.min,
+            (unsigned long) s.avg, (unsigned long) s.max, (unsigned long) s.p99);
+}
+
+/// bucket: values below 4 have a bucket of their own, above that every power of two is split into four
+uint8_t Profiler::bucket(uint32_t ticks)
+{
+    if (ticks < 4)
+    {
+        return ticks;
+    }
+    uint8_t e = 31 - __builtin_clz(ticks);          // ticks is in [2^e, 2^(e+1))
+    return 4 * (e - 1) + ((ticks >> (e - 2)) & 3);
+}
+
+/// bucketLimit returns the largest value that falls into bucket
+uint32_t Profiler::bucketLimit(uint8_t bucket)
+{
+    if (bucket < 4)
+    {
+        return bucket;
+    }
+    uint8_t e = bucket / 4 + 1;
+    uint32_t lower = (uint32_t) (4 + bucket % 4) << (e - 2);
+    return lower + ((uint32_t) 1 << (e - 2)) - 1;
+}
@@ -0,0 +1,93 @@
+/*
+ * Profiler.h
+ *
+ *  Run time statistics of named code sections, for finding out where the time of the main loop goes.
+ */
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include "arduino.h"
+#include "morsedefs.h"
+
+/// Put MORSE_PROFILE("name") at the start of a block to measure how long the block takes. The first time
+/// the block runs, the macro creates a static Section. Sections register themselves for good, so they must
+/// never be destroyed. Every time the block runs, a Scope reads a counter (the CPU cycle counter on the
+/// device) when it is created and again when it goes out of scope. Without MORSE_PROFILING (see
+/// morsedefs.h) the macro expands to nothing.
+///
+/// Every section keeps count, min, max, sum and a histogram with four buckets per power of two (so any
+/// value is off by at most 25%), from which the 99th percentile is estimated - about 500 bytes per section,
+/// and no allocation.
+
+#ifdef MORSE_PROFILING
+#define MORSE_PROFILE(name) static Profiler::Section profileSection(name); Profiler::Scope profileScope(profileSection)
+#else
+#define MORSE_PROFILE(name)
+#endif
+
+class Profiler
+{
+    public:
+        typedef uint32_t (*Counter)();
+
+        static const uint8_t BUCKETS = 124;            /// enough for all 32 bit values
+        static const char *CSV_HEADER;
+
+        struct Summary
+        {
+                uint32_t count;
+                uint32_t min;
+                uint32_t avg;
+                uint32_t max;
+                uint32_t p99;
+        };
+
+        class Section
+        {
+            public:
+                Section(const char *name);
+                void record(uint32_t ticks);
+                void reset();
+                Summary getSummary();
+                const char* getName();
+                Section* getNext();
+
+            private:
+                const char *name;
+                uint32_t count;
+                uint32_t min;
+                uint32_t max;
+                uint64_t sum;
+                uint32_t histogram[BUCKETS];
+                Section *next;
+        };
+
+        class Scope
+        {
+            public:
+                Scope(Section &section);
+                ~Scope();
+
+            private:
+                Section &section;
+                uint32_t start;
+        };
+
+        static void setCounter(Counter counter, uint32_t ticksPerUs);
+        static uint32_t now();
+        static Section* getFirst();
+        static void resetAll();
+        static Summary inMicros(Summary ticks);
+        static int formatCsv(Section &section, char *buf, size_t size);
+
+        static uint8_t bucket(uint32_t ticks);
+        static uint32_t bucketLimit(uint8_t bucket);
+
+    private:
+        static Counter counter;
+        static uint32_t ticksPerUs;
+        static Section *first;
+};
+
+#endif /* PROFILER_H_ */
@@ -0,0 +1,484 @@
+/******************************************************************************************************************************
+ *  morse_3 Software for the Morserino-32 multi-functional Morse code machine, based on the Heltec WiFi LORA (ESP32) module ***
+ *  Copyright (C) 2018  Willi Kraml, OE1WKL                                                                                 ***
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this program.
+ *  If not, see <https://www.gnu.org/licenses/>.
+ *****************************************************************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "QsoGenerator.h"
+
+/// the grammar we use when the user has not uploaded one: contest QSOs and short rag chews
+const char QsoGenerator::DEFAULT_GRAMMAR[] =
+        "# QSO grammar of the Morserino-32 - see the manual on how to write your own\n"
+        "qso = {contest} | {contest} | {ragchew} | {ragchew} | {ragchew}\n"
+        "\n"
+        "# contest: the running station calls, the other one answers, they exchange report and serial number\n"
+        "contest = {cqtest} {answer} {runexch} {dxexch} {tu}\n"
+        "cqtest = cq test $run $run | cq test $run $run test | test $run | cq $run $run test\n"
+        "answer = $dx | $dx | $dx $dx\n"
+        "runexch = $dx 5nn %c | $dx 5nn %c | $dx 599 %n | 5nn %c\n"
+        "dxexch = tu 5nn $nr | r 5nn $nr | 5nn $nr | 599 $nr tu\n"
+        "nr = {d}{d} | {d}{d}{d} | 0{d}{d} | {d}\n"
+        "tu = tu $run | tu | tu $run test | tu qrz?\n"
+        "run = {call}\n"
+        "dx = {call}\n"
+        "\n"
+        "# rag chew: a CQ, the answer, a report each way, and the good bye\n"
+        "ragchew = {cq} {reply} {first} {second} {bye}\n"
+        "cq = cq cq cq de $a $a $a k | cq cq de $a $a pse k | cq de $a $a $a k\n"
+        "reply = $a de $b $b <kn> | $a de $b $b $b k | $a de $b $b ar\n"
+        "first = $b de $a {greet} {tnx} = {rpt} = name $namea $namea = qth $qtha $qtha = {hw} $b de $a <kn>\n"
+        "second = $a de $b r r {greet} $namea tnx fer rprt = ur rst $rstb $rstb = name $nameb $nameb\n"
+        "     = qth $qthb $qthb = {rig} = {wx} = {hw} $a de $b <kn>\n"
+        "bye = $b de $a r r tnx $nameb fer qso = {cu} 73 $b de $a <sk> | $b de $a fb $nameb tnx qso = 73 es {cu} <sk> ee\n"
+        "greet = ge | gm | ga | gd | fb om | hi\n"
+        "tnx = tnx fer call | tnx call | tnx fer ur call\n"
+        "rpt = ur rst $rsta $rsta | ur rst is $rsta $rsta | rst $rsta $rsta\n"
+        "rsta = {rst}\n"
+        "rstb = {rst}\n"
+        "rst = 599 | 599 | 579 | 589 | 569 | 559 | 449 | 339\n"
+        "hw = hw? | hw cpy? | so hw? | bk\n"
+        "rig = rig {rigname} es ant {ant} | rig hr {rigname} pwr {pwr}w ant {ant} | rig {rigname} {pwr}w\n"
+        "rigname = ic7300 | ft991 | k3 | ts590 | ft817 | kx3 | qcx | ic705 | hb\n"
+        "pwr = 5 | 10 | 50 | 100 | 100 | 400\n"
+        "ant = dipole | vertical | yagi | gp | loop | efhw | windom | lw\n"
+        "wx = wx {sky} es {temp}c | wx hr {sky} temp {temp}c | wx {sky}\n"
+        "sky = sunny | cloudy | rain | fb | cold | warm | snow | windy\n"
+        "temp = {d} | 1{d} | 2{d} | 3{d}\n"
+        "cu = cu agn | gl | cu | hpe cu agn | gud dx\n"
+        "namea = {name}\n"
+        "nameb = {name}\n"
+        "name = john | bob | tom | jim | mike | dave | bill | peter | hans | fritz | klaus | uwe | jan | ole | paul | joe\n"
+        "     | ed | al | ken | ray | rick | chris | tony | frank | andy | steve | gerd | wolf | marc | jean | luc | karl\n"
+        "     | max | walt | fred | ann | mary | sue | eva | ute | gaby | lars | pedro | ivan | yuri | taro\n"
+        "qtha = {qth}\n"
+        "qthb = {qth}\n"
+        "qth = berlin | munich | hamburg | vienna | graz | bern | paris | lyon | london | dublin | rome | madrid | oslo\n"
+        "     | prague | warsaw | boston | denver | dallas | ottawa | tokyo | sydney | bonn | kiel | linz | basel\n"
+        "a = {call}\n"
+        "b = {call}\n"
+        "\n"
+        "# call signs\n"
+        "call = {pfx}{d}{l}{l} | {pfx}{d}{l}{l}{l} | {pfx}{d}{l}{l}{l} | {pfx}{d}{l} | {pfx}{d}{l}{l}/p\n"
+        "pfx = dl | dk | dj | df | do | g | m | f | on | pa | oe | i | ea | sm | la | oh | ok | sp | ha | yo | lz\n"
+        "     | k | w | n | ve | ja | vk | zl | ua | ur | 9a | s5 | yu | ct | ei | hb\n"
+        "d = 0 | 1 | 2 | 3 | 4 | 5 | 6 | 7 | 8 | 9\n"
+        "l = a | b | c | d | e | f | g | h | i | j | k | l | m | n | o | p | q | r | s | t | u | v | w | x | y | z\n";
+
+QsoGenerator::QsoGenerator(Random r)
+{
+    random = r;
+    codeSize = 0;
+    ruleCount = 0;
+    valueCount = 0;
+    errorLine = 0;
+    restart(1);
+}
+
+/// load compiles a grammar; if it has an error, there are no rules afterwards, and getErrorLine() tells where it is
+QsoGenerator::Error QsoGenerator::load(const char *text, size_t length)
+{
+    Name names[MAX_RULES];
+    const char *bodies[MAX_RULES];
+    const char *end = text + length;
+    const char *p = text;
+    Error e = OK;
+
+    codeSize = 0;
+    ruleCount = 0;
+    valueCount = 0;
+    errorLine = 0;
+    restart(1);
+
+    /// first the names, so a rule can use the rules below it: a rule starts on a line that does not start with a blank
+    for (const char *line = text; line < end && e == OK; line = nextLine(line, end))
+    {
+        if (isBlank(*line) || *line == '#')
+        {
+            continue;
+        }
+        p = line;
+        if (ruleCount == MAX_RULES)
+        {
+            e = TOO_MANY_RULES;
+            break;
+        }
+        p = skipName(line, end);
+        names[ruleCount].p = line;
+        names[ruleCount].n = p - line;
+        while (p < end && (*p == ' ' || *p == '\t'))
+        {
+            ++p;
+        }
+        if (p == line || names[ruleCount].n > MAX_NAME || p == end || *p != '=' || findRule(names, line, names[ruleCount].n) >= 0)
+        {
+            e = SYNTAX;                                 // no name, no '=', or the name is there already
+        }
+        else
+        {
+            rules[ruleCount].value = 0;
+            bodies[ruleCount++] = p + 1;
+        }
+    }
+
+    /// then the bodies, up to the next rule
+    for (uint8_t i = 0; i < ruleCount && e == OK; ++i)
+    {
+        const char *bodyEnd = i + 1 < ruleCount ? names[i + 1].p : end;
+        boolean blank = false;
+        boolean empty = true;
+
+        rules[i].start = codeSize;
+        rules[i].alternatives = 1;
+        for (p = bodies[i]; p < bodyEnd && e == OK;)
+        {
+            char c = *p++;
+
+            if (c == '#')
+            {
+                while (p < bodyEnd && *p != '\n')
+                {
+                    ++p;
+                }
+                continue;
+            }
+            if (isBlank(c))
+            {
+                blank = !empty;
+                continue;
+            }
+            if (c == '|')
+            {
+                emitCode(ALT);
+                blank = false;
+                empty = true;
+                if (++rules[i].alternatives == 0)
+                {
+                    e = TOO_LONG;
+                }
+                continue;
+            }
+            if (blank)
+            {
+                emitCode(' ');
+            }
+            blank = false;
+            empty = false;
+
+            const char *q = skipName(p, bodyEnd);
+            int r = findRule(names, p, q - p);
+            switch (c)
+            {
+                case '{':
+                    if (q == bodyEnd || *q != '}')
+                    {
+                        e = SYNTAX;
+                        break;
+                    }
+                    if (r < 0)
+                    {
+                        e = UNKNOWN_RULE;
+                        break;
+                    }
+                    emitCode(RULE);
+                    emitCode(r + 1);
+                    p = q + 1;
+                    break;
+                case '$':
+                    if (r < 0)
+                    {
+                        e = q == p ? SYNTAX : UNKNOWN_RULE;
+                        break;
+                    }
+                    if (!rules[r].value)
+                    {
+                        if (valueCount == MAX_VALUES)
+                        {
+                            e = TOO_MANY_VALUES;
+                            break;
+                        }
+                        rules[r].value = ++valueCount;
+                    }
+                    emitCode(VALUE);
+                    emitCode(r + 1);
+                    p = q;
+                    break;
+                case '%':
+                    if (p < bodyEnd && (*p == 'n' || *p == 'c'))
+                    {
+                        emitCode(*p++ == 'n' ? SERIAL : CUT_SERIAL);
+                    }
+                    else
+                    {
+                        e = SYNTAX;
+                    }
+                    break;
+                default:
+                    if ((uint8_t) c > ' ')
+                    {
+                        emitCode(c);
+                    }
+                    break;
+            }
+        }
+        emitCode(END);
+        if (e == OK && codeSize > MAX_CODE)
+        {
+            e = TOO_LONG;
+        }
+    }
+
+    if (e == OK && !ruleCount)
+    {
+        e = NO_RULES;
+    }
+    if (e != OK)
+    {
+        errorLine = lineOf(text, p);
+        ruleCount = 0;
+    }
+    return e;
+}
+
+/// getErrorLine is the line (counted from 1) where load() found an error
+uint16_t QsoGenerator::getErrorLine()
+{
+    return errorLine;
+}
+
+/// restart drops the QSO under way; the next word starts a new one, with the serial number given
+void QsoGenerator::restart(uint16_t s)
+{
+    depth = 0;
+    serial = s;
+    qsos = 0;
+    memset(bound, 0, sizeof(bound));
+}
+
+/// next puts the next word into word (MAX_WORD + 1 chars); false if the grammar does not make any words
+boolean QsoGenerator::next(char *word)
+{
+    boolean started = false;
+
+    length = 0;
+    word[0] = 0;
+    if (!ruleCount)
+    {
+        return false;
+    }
+    while (true)
+    {
+        if (!depth)
+        {
+            if (length)
+            {
+                return true;                            // the last word of the QSO
+            }
+            if (started)
+            {
+                return false;                           // a whole QSO without a word
+            }
+            startQso();
+            started = true;
+            continue;
+        }
+
+        Frame &f = stack[depth - 1];
+        char c = *f.p++;
+        uint8_t r;
+        switch (c)
+        {
+            case END:
+            case ALT:
+                --depth;
+                break;
+            case RULE:
+                push(*f.p++ - 1, 0);
+                break;
+            case VALUE:
+                r = *f.p++ - 1;
+                if (!bound[rules[r].value - 1])
+                {
+                    bound[rules[r].value - 1] = true;
+                    values[rules[r].value - 1][0] = 0;
+                    push(r, rules[r].value);
+                }
+                else if (depth < MAX_DEPTH)
+                {
+                    stack[depth].p = values[rules[r].value - 1];    // the text is played like a rule: it ends with END
+                    stack[depth++].capture = 0;
+                }
+                break;
+            case SERIAL:
+            case CUT_SERIAL:
+                emitSerial(c == CUT_SERIAL, word);
+                break;
+            default:
+                if (emit(c, word))
+                {
+                    return true;
+                }
+                break;
+        }
+    }
+}
+
+/// getSerial is the serial number of the QSO under way
+uint16_t QsoGenerator::getSerial()
+{
+    return serial;
+}
+
+uint32_t QsoGenerator::getQsoCount()
+{
+    return qsos;
+}
+
+/// getCodeSize is the size of the compiled grammar in bytes
+uint16_t QsoGenerator::getCodeSize()
+{
+    return codeSize;
+}
+
+void QsoGenerator::emitCode(char c)
+{
+    if (codeSize < MAX_CODE)
+    {
+        code[codeSize] = c;
+    }
+    if (codeSize <= MAX_CODE)
+    {
+        ++codeSize;                                     // one more than MAX_CODE: it did not fit
+    }
+}
+
+int QsoGenerator::findRule(const Name *names, const char *name, uint8_t n)
+{
+    for (uint8_t i = 0; n && i < ruleCount; ++i)
+    {
+        if (names[i].n == n && !strncmp(names[i].p, name, n))
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+const char* QsoGenerator::skipName(const char *p, const char *end)
+{
+    while (p < end && ((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z') || (*p >= '0' && *p <= '9') || *p == '_'))
+    {
+        ++p;
+    }
+    return p;
+}
+
+const char* QsoGenerator::nextLine(const char *p, const char *end)
+{
+    while (p < end && *p++ != '\n')
+    {
+    }
+    return p;
+}
+
+boolean QsoGenerator::isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+uint16_t QsoGenerator::lineOf(const char *text, const char *p)
+{
+    uint16_t line = 1;
+
+    for (; text < p; ++text)
+    {
+        line += *text == '\n';
+    }
+    return line;
+}
+
+/// push starts one of the alternatives of a rule, chosen at random
+void QsoGenerator::push(uint8_t r, uint8_t capture)
+{
+    const char *p = code + rules[r].start;
+
+    if (depth == MAX_DEPTH)
+    {
+        return;
+    }
+    for (long k = rules[r].alternatives > 1 ? random(rules[r].alternatives) : 0; k > 0;)
+    {
+        switch (*p++)
+        {
+            case RULE:
+            case VALUE:
+                ++p;
+                break;
+            case ALT:
+                --k;
+                break;
+            default:
+                break;
+        }
+    }
+    stack[depth].p = p;
+    stack[depth++].capture = capture;
+}
+
+void QsoGenerator::startQso()
+{
+    if (qsos)
+    {
+        ++serial;
+    }
+    ++qsos;
+    memset(bound, 0, sizeof(bound));
+    push(0, 0);
+}
+
+/// emit adds a character to the word, and to the values being captured; true when a blank ends the word
+boolean QsoGenerator::emit(char c, char *word)
+{
+    for (uint8_t i = 0; i < depth; ++i)
+    {
+        if (stack[i].capture)
+        {
+            char *v = values[stack[i].capture - 1];
+            size_t n = strnlen(v, MAX_VALUE);
+            if (n < MAX_VALUE)
+            {
+                v[n] = c;
+                v[n + 1] = 0;
+            }
+        }
+    }
+    if (c == ' ')
+    {
+        return length > 0;
+    }
+    if (length < MAX_WORD)
+    {
+        word[length++] = c;
+        word[length] = 0;
+    }
+    return false;
+}
+
+void QsoGenerator::emitSerial(boolean cut, char *word)
+{
+    char digits[8];
+
+    snprintf(digits, sizeof(digits), "%03u", serial);
+    for (const char *d = digits; *d; ++d)
+    {
+        emit(cut && *d == '0' ? 't' : cut && *d == '9' ? 'n' : *d, word);
+    }
+}
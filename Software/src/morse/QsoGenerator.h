@@ -0,0 +1,117 @@
+/*
+ * QsoGenerator.h
+ *
+ *  Generates QSOs - contest exchanges, rag chews - from a small grammar, one word at a time.
+ */
+
+#ifndef QSOGENERATOR_H_
+#define QSOGENERATOR_H_
+
+#include "arduino.h"
+
+/// The grammar is a text of rules, one per line (a line that starts with a blank continues the rule above it; '#'
+/// starts a comment):
+///
+///     qso = {cq} {answer} {report} {bye}
+///     cq = cq cq de $mycall $mycall k | cq test $mycall test
+///     mycall = {letter}{digit}{letter}{letter}
+///
+/// A rule is a list of alternatives, separated by '|'; each time the rule is used, one of them is chosen at random
+/// (write an alternative twice to make it twice as likely). In an alternative, {name} is replaced by the rule of that
+/// name, $name by the value the rule had the first time it was used in this QSO (so the calls, names and the like stay
+/// the same throughout the QSO), %n by the serial number of the QSO, three digits, and %c by the same with cut numbers
+/// (t for 0, n for 9). Everything else is text; blanks separate the words, and there is no blank between what stands
+/// side by side. The first rule is a QSO; when it is done, the next QSO starts with new values and the next serial
+/// number.
+///
+/// load() compiles the grammar into a byte code: the text with the names replaced by rule numbers, the blanks
+/// collapsed, and the alternatives separated by ALT. The caller may throw the text away after that. next() walks the
+/// byte code with a stack of at most MAX_DEPTH rules, and returns as soon as it has a word - so the memory needed is
+/// the same however long a QSO is. A rule that would go deeper than MAX_DEPTH (a rule that uses itself without end)
+/// is left out.
+///
+/// The random numbers come from a function given to the constructor, so tests can choose them.
+
+class QsoGenerator
+{
+    public:
+        static const uint16_t MAX_CODE = 4096;
+        static const uint8_t MAX_RULES = 64;
+        static const uint8_t MAX_VALUES = 16;
+        static const uint8_t MAX_VALUE = 24;        /// characters of a $value, blanks included
+        static const uint8_t MAX_DEPTH = 12;
+        static const uint8_t MAX_WORD = 24;
+        static const uint8_t MAX_NAME = 16;
+
+        enum Error
+        {
+            OK, NO_RULES, TOO_MANY_RULES, TOO_MANY_VALUES, TOO_LONG, SYNTAX, UNKNOWN_RULE
+        };
+
+        typedef long (*Random)(long howBig);        /// 0 .. howBig - 1
+
+        static const char DEFAULT_GRAMMAR[];
+
+        QsoGenerator(Random r);
+        Error load(const char *text, size_t length);
+        uint16_t getErrorLine();
+        void restart(uint16_t serial);
+        boolean next(char *word);
+        uint16_t getSerial();
+        uint32_t getQsoCount();
+        uint16_t getCodeSize();
+
+    private:
+        enum Code
+        {
+            END, ALT, RULE, VALUE, SERIAL, CUT_SERIAL
+        };
+
+        struct Name
+        {
+                const char *p;                      // in the text of the grammar, while it is loaded
+                uint8_t n;
+        };
+
+        struct Rule
+        {
+                uint16_t start;
+                uint8_t alternatives;
+                uint8_t value;                      // 1 + its slot in values if it is used as $name, 0 if not
+        };
+
+        struct Frame
+        {
+                const char *p;
+                uint8_t capture;                    // 1 + the slot this frame fills, 0 if none
+        };
+
+        Random random;
+        char code[MAX_CODE];
+        uint16_t codeSize;
+        Rule rules[MAX_RULES];
+        uint8_t ruleCount;
+        uint8_t valueCount;
+        uint16_t errorLine;
+
+        char values[MAX_VALUES][MAX_VALUE + 1];
+        boolean bound[MAX_VALUES];
+        Frame stack[MAX_DEPTH];
+        uint8_t depth;
+        uint16_t serial;
+        uint32_t qsos;
+        uint8_t length;                             // of the word being put together
+
+        void emitCode(char c);
+        int findRule(const Name *names, const char *name, uint8_t n);
+        static const char* skipName(const char *p, const char *end);
+        static const char* nextLine(const char *p, const char *end);
+        static boolean isBlank(char c);
+        static uint16_t lineOf(const char *text, const char *p);
+        void push(uint8_t rule, uint8_t capture);
+        void startQso();
+        boolean emit(char c, char *word);
+        void emitSerial(boolean cut, char *word);
+};
+
+#endif /* QSOGENERATOR_H_ */
@@ -0,0 +1,35 @@
+/*
+ * Radio.h
+ *
+ *  Interface between the LoRa functions and the transceiver, so they can also run on top of a
+ *  simulated radio (see UdpRadio).
+ */
+
+#ifndef RADIO_H_
+#define RADIO_H_
+
+#include "arduino.h"
+
+class Radio
+{
+    public:
+        static const uint8_t MAX_PACKET = 48;           /// longer packets are discarded by the receiver
+
+        /// called for each received packet; with the LoRa transceiver this happens in interrupt context
+        typedef void (*ReceiveCallback)(const uint8_t *data, uint8_t length, int rssi);
+
+        virtual ~Radio() = default;
+        virtual boolean begin(long frequency) = 0;
+        virtual void setSyncWord(uint8_t syncWord) = 0;
+        virtual void send(const uint8_t *data, uint8_t length) = 0;
+        virtual void receive() = 0;
+        virtual void idle() = 0;
+        virtual void sleep() = 0;
+        virtual void poll() {};                         /// for radios that do not deliver packets by themselves
+        void onReceive(ReceiveCallback cb) {callback = cb;};
+
+    protected:
+        ReceiveCallback callback = 0;
+};
+
+#endif /* RADIO_H_ */
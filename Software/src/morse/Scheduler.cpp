@@ -0,0 +1,223 @@
+/******************************************************************************************************************************
+ *  morse_3 Software for the Morserino-32 multi-functional Morse code machine, based on the Heltec WiFi LORA (ESP32) module ***
+ *  Copyright (C) 2018  Willi Kraml, OE1WKL                                                                                 ***
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this program.
+ *  If not, see <https://www.gnu.org/licenses/>.
+ *****************************************************************************************************************************/
+#include "Scheduler.h"
+
+Scheduler::Scheduler(Clock clock, Sleep sleep) :
+        clock(clock), sleep(sleep), count(0), load(), loadStart(0)
+{
+}
+
+/// add registers a task that is released for the first time right away; returns its number, or NO_TASK
+uint8_t Scheduler::add(const char *name, TaskFunction run, unsigned long period, uint8_t priority)
+{
+    if (count == MAX_TASKS)
+    {
+        return NO_TASK;
+    }
+    Task &t = tasks[count];
+    t.name = name;
+    t.run = run;
+    t.period = period;
+    t.priority = priority;
+    t.release = clock();
+    t.hurry = false;
+    t.deferred = false;
+    t.woken = false;
+    t.stats = Stats();
+    return count++;
+}
+
+/// runOnce runs the most urgent task that has been released, or else a task that is in a hurry;
+/// returns false if there was nothing to do
+boolean Scheduler::runOnce()
+{
+    unsigned long start = clock();
+    ++load.iterations;
+    for (int k = 0; k < count; ++k)
+    {
+        if (tasks[k].woken)
+        {
+            tasks[k].woken = false;
+            if ((long) (tasks[k].release - start) > 0)
+            {
+                tasks[k].release = start;
+            }
+        }
+    }
+
+    uint8_t i = pick(start);
+    boolean released = i != NO_TASK;
+    if (!released)
+    {
+        i = pickHurried();
+        if (i == NO_TASK)
+        {
+            unsigned long wait = timeToNextRelease(start);
+            if (sleep && wait)
+            {
+                sleep(wait);
+                load.idle += clock() - start;
+            }
+            return false;
+        }
+    }
+
+    Task &t = tasks[i];
+    t.deferred = false;
+    t.hurry = t.run();
+    unsigned long end = clock();
+    unsigned long took = end - start;
+    load.busy += took;
+
+    ++t.stats.runs;
+    t.stats.totalTime += took;
+    if (took > t.stats.maxTime)
+    {
+        t.stats.maxTime = took;
+    }
+    if (t.deferred && !t.hurry)
+    {
+        t.release = t.deferredTo;
+    }
+    if (!released)
+    {
+        return true;
+    }
+
+    unsigned long latency = start - t.release;
+    if (latency > t.stats.maxLatency)
+    {
+        t.stats.maxLatency = latency;
+    }
+    if (end - t.release > t.period)
+    {   // finished after its deadline
+        ++t.stats.overruns;
+    }
+
+    if (t.deferred && !t.hurry)
+    {
+        return true;
+    }
+    t.release += t.period;
+    if ((long) (end - t.release) >= (long) t.period)
+    {   // we missed at least one release completely - do not try to catch up
+        t.release = end - (end - t.release) % t.period;
+    }
+    return true;
+}
+
+/// defer is called by a task while it runs: it has nothing to do before until, so its next release is then
+void Scheduler::defer(uint8_t task, unsigned long until)
+{
+    tasks[task].deferred = true;
+    tasks[task].deferredTo = until;
+}
+
+/// wake releases a task right away; it can be called from an interrupt handler, so it is in IRAM
+void Scheduler::wake(uint8_t task)
+{
+    tasks[task].woken = true;
+}
+
+/// timeToNextRelease returns how long the scheduler has nothing to do, 0 if some task is due or in a hurry
+unsigned long Scheduler::timeToNextRelease(unsigned long now)
+{
+    long wait = 0x7fffffff;
+
+    for (int i = 0; i < count; ++i)
+    {
+        Task &t = tasks[i];
+        if (t.hurry || t.woken)
+        {
+            return 0;
+        }
+        long d = (long) (t.release - now);
+        if (d < wait)
+        {
+            wait = d;
+        }
+    }
+    return wait > 0 ? wait : 0;
+}
+
+uint8_t Scheduler::getTaskCount()
+{
+    return count;
+}
+
+const char* Scheduler::getName(uint8_t task)
+{
+    return tasks[task].name;
+}
+
+Scheduler::Stats Scheduler::getStats(uint8_t task)
+{
+    return tasks[task].stats;
+}
+
+Scheduler::Load Scheduler::getLoad()
+{
+    Load l = load;
+    l.elapsed = clock() - loadStart;
+    return l;
+}
+
+void Scheduler::resetStats()
+{
+    for (int i = 0; i < count; ++i)
+    {
+        tasks[i].stats = Stats();
+    }
+    load = Load();
+    loadStart = clock();
+}
+
+/// pick returns the released task with the earliest deadline; times are compared relative to now,
+/// so this still works when the clock wraps around
+uint8_t Scheduler::pick(unsigned long now)
+{
+    uint8_t best = NO_TASK;
+    long bestDeadline = 0;
+
+    for (int i = 0; i < count; ++i)
+    {
+        Task &t = tasks[i];
+        if ((long) (t.release - now) > 0)
+        {
+            continue;
+        }
+        long deadline = (long) (t.release + t.period - now);
+        if (best == NO_TASK || deadline < bestDeadline || (deadline == bestDeadline && t.priority > tasks[best].priority))
+        {
+            best = i;
+            bestDeadline = deadline;
+        }
+    }
+    return best;
+}
+
+/// pickHurried returns the task with the highest priority among those in a hurry
+uint8_t Scheduler::pickHurried()
+{
+    uint8_t best = NO_TASK;
+
+    for (int i = 0; i < count; ++i)
+    {
+        if (tasks[i].hurry && (best == NO_TASK || tasks[i].priority > tasks[best].priority))
+        {
+            best = i;
+        }
+    }
+    return best;
+}
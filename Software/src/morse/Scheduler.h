@@ -0,0 +1,99 @@
+/*
+ * Scheduler.h
+ *
+ *  Cooperative scheduler for the tasks of the main loop.
+ */
+
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+#include "arduino.h"
+
+/// Every task is released once per period and should have finished before its next release (its deadline).
+/// Tasks are not preempted: runOnce() picks the released task with the earliest deadline (the higher
+/// priority if two deadlines are equal) and runs it to its end. So a task with a short period is never
+/// kept waiting for longer than the longest run of another task.
+///
+/// A task function returns true if it is in a hurry and wants to run again as soon as possible (like a mode
+/// that is in the middle of a character). Such extra runs only use the time that is left when no released
+/// task is waiting, so a task in a hurry cannot starve the others.
+///
+/// For every task the number of runs, run time, latency (time from release to start) and overruns
+/// (finished after its deadline) are recorded. Releases that have been missed completely are skipped,
+/// so a late task does not run several times in a row to catch up.
+///
+/// A task that knows it has nothing to do for a while (the keyer between two elements, the generator during
+/// a pause) calls defer() while it runs, and is not released before that time. wake() releases a task right
+/// away - also from an interrupt handler, when a paddle is pressed; then the task runs at its period again
+/// until it defers once more. When nothing has been released, runOnce() passes the time until the next
+/// release to the sleep function, which may return earlier (when it is woken up). The time spent there is
+/// the idle time of the load statistics - the time the CPU could spend in a low power state.
+///
+/// All times are in µs; the clock is passed in, so the scheduler can be used without hardware.
+
+class Scheduler
+{
+    public:
+        typedef boolean (*TaskFunction)();
+        typedef unsigned long (*Clock)();
+        typedef void (*Sleep)(unsigned long us);
+
+        static const uint8_t MAX_TASKS = 8;
+        static const uint8_t NO_TASK = 0xff;
+
+        struct Stats
+        {
+                unsigned long runs;
+                unsigned long totalTime;
+                unsigned long maxTime;
+                unsigned long maxLatency;
+                unsigned long overruns;
+        };
+
+        struct Load
+        {
+                unsigned long iterations;   /// calls of runOnce()
+                unsigned long elapsed;      /// since the last resetStats()
+                unsigned long busy;         /// in tasks
+                unsigned long idle;         /// in the sleep function
+        };
+
+        Scheduler(Clock clock, Sleep sleep = 0);
+        uint8_t add(const char *name, TaskFunction run, unsigned long period, uint8_t priority);
+        boolean runOnce();
+        void defer(uint8_t task, unsigned long until);
+        void IRAM_ATTR wake(uint8_t task);
+        unsigned long timeToNextRelease(unsigned long now);
+        uint8_t getTaskCount();
+        const char* getName(uint8_t task);
+        Stats getStats(uint8_t task);
+        Load getLoad();
+        void resetStats();
+
+    private:
+        struct Task
+        {
+                const char *name;
+                TaskFunction run;
+                unsigned long period;
+                uint8_t priority;
+                unsigned long release;      /// the next regular run
+                boolean hurry;              /// wants to run again before that
+                boolean deferred;           /// has called defer() in this run
+                unsigned long deferredTo;
+                volatile boolean woken;
+                Stats stats;
+        };
+
+        Clock clock;
+        Sleep sleep;
+        Task tasks[MAX_TASKS];
+        uint8_t count;
+        Load load;
+        unsigned long loadStart;
+
+        uint8_t pick(unsigned long now);
+        uint8_t pickHurried();
+};
+
+#endif /* SCHEDULER_H_ */
@@ -0,0 +1,272 @@
+/******************************************************************************************************************************
+ *  morse_3 Software for the Morserino-32 multi-functional Morse code machine, based on the Heltec WiFi LORA (ESP32) module ***
+ *  Copyright (C) 2018  Willi Kraml, OE1WKL                                                                                 ***
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this program.
+ *  If not, see <https://www.gnu.org/licenses/>.
+ *****************************************************************************************************************************/
+#include <string.h>
+#include "SessionLog.h"
+
+/// how many numbers each event type has, and if a text follows them
+static const struct
+{
+        uint8_t count;
+        boolean text;
+        const char *name;
+} SCHEMA[SessionLog::TYPES] =
+{
+    { 0, false, "none" },
+    { 4, false, "session" },
+    { 1, true, "word" },
+    { 2, false, "element" },
+    { 0, true, "response" },
+    { 2, false, "result" },
+    { 2, false, "speed" },
+    { 0, true, "decoded" },
+    { 0, false, "end" }
+};
+
+SessionLog::SessionLog(Sink *s)
+{
+    sink = s;
+    used = 0;
+    active = false;
+    last = 0;
+    lastFlush = 0;
+    written = 0;
+    dropped = 0;
+}
+
+/// begin starts a session; the time of the events is counted from here
+void SessionLog::begin(uint8_t menuItem, uint8_t wpm, uint8_t effWpm, unsigned long now)
+{
+    const uint32_t v[] = { VERSION, menuItem, wpm, effWpm };
+
+    if (active)
+    {
+        end(now);
+    }
+    active = true;
+    last = now;
+    add(SESSION, v, 4, 0, now);
+}
+
+void SessionLog::word(const char *text, boolean repeated, unsigned long now)
+{
+    const uint32_t v[] = { repeated };
+    add(WORD, v, 1, text, now);
+}
+
+void SessionLog::element(uint16_t markMs, uint16_t spaceMs, unsigned long now)
+{
+    const uint32_t v[] = { markMs, spaceMs };
+    add(ELEMENT, v, 2, 0, now);
+}
+
+void SessionLog::response(const char *text, unsigned long now)
+{
+    add(RESPONSE, 0, 0, text, now);
+}
+
+void SessionLog::result(boolean right, uint32_t responseMs, unsigned long now)
+{
+    const uint32_t v[] = { right, responseMs };
+    add(RESULT, v, 2, 0, now);
+}
+
+void SessionLog::speed(uint8_t wpm, uint8_t effWpm, unsigned long now)
+{
+    const uint32_t v[] = { wpm, effWpm };
+    add(SPEED, v, 2, 0, now);
+}
+
+void SessionLog::decoded(const char *text, unsigned long now)
+{
+    add(DECODED, 0, 0, text, now);
+}
+
+void SessionLog::end(unsigned long now)
+{
+    add(END, 0, 0, 0, now);
+    active = false;
+}
+
+boolean SessionLog::isActive()
+{
+    return active;
+}
+
+/// isDue is true when the buffer is half full, or has waited for FLUSH_INTERVAL
+boolean SessionLog::isDue(unsigned long now)
+{
+    return used >= BUFFER / 2 || (used && now - lastFlush >= FLUSH_INTERVAL);
+}
+
+/// flush hands the buffer to the sink; if the sink fails, the buffer is lost
+boolean SessionLog::flush(unsigned long now)
+{
+    boolean ok = !used || sink->append(buffer, used);
+
+    if (ok)
+    {
+        written += used;
+    }
+    else
+    {
+        ++dropped;
+    }
+    used = 0;
+    lastFlush = now;
+    return ok;
+}
+
+/// getWritten: bytes handed to the sink so far
+uint32_t SessionLog::getWritten()
+{
+    return written;
+}
+
+/// getDropped: events that did not fit into the buffer, and buffers the sink did not take
+uint32_t SessionLog::getDropped()
+{
+    return dropped;
+}
+
+void SessionLog::add(Type type, const uint32_t *values, uint8_t count, const char *text, unsigned long now)
+{
+    uint8_t payload[MAX_EVENT];
+    uint8_t length = 0;
+
+    if (!active)
+    {
+        return;
+    }
+    for (int i = 0; i < count; ++i)
+    {
+        length += putVarint(payload + length, values[i]);
+    }
+    if (text)
+    {
+        size_t n = strlen(text);
+        n = n < MAX_TEXT ? n : MAX_TEXT;
+        memcpy(payload + length, text, n);
+        length += n;
+    }
+
+    uint8_t head[11];
+    uint8_t h = 0;
+    head[h++] = type;
+    h += putVarint(head + h, now - last);
+    h += putVarint(head + h, length);
+    if (used + h + length > BUFFER)
+    {
+        ++dropped;
+        return;
+    }
+    memcpy(buffer + used, head, h);
+    memcpy(buffer + used + h, payload, length);
+    used += h + length;
+    last = now;
+}
+
+/// putVarint writes v into p, 1 - 5 bytes; returns how many
+uint8_t SessionLog::putVarint(uint8_t *p, uint32_t v)
+{
+    uint8_t n = 0;
+
+    while (v >= 0x80)
+    {
+        p[n++] = (v & 0x7f) | 0x80;
+        v >>= 7;
+    }
+    p[n++] = v;
+    return n;
+}
+
+/// getVarint reads a varint from at most n bytes; returns how many it took, 0 if it is not complete
+uint8_t SessionLog::getVarint(const uint8_t *p, size_t n, uint32_t &v)
+{
+    v = 0;
+    for (uint8_t i = 0; i < n && i < 5; ++i)
+    {
+        v |= (uint32_t) (p[i] & 0x7f) << (7 * i);
+        if (!(p[i] & 0x80))
+        {
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+const char* SessionLog::getName(uint8_t type)
+{
+    return type < TYPES ? SCHEMA[type].name : "unknown";
+}
+
+SessionLog::Reader::Reader(const uint8_t *d, size_t n)
+{
+    data = d;
+    size = n;
+    pos = 0;
+    time = 0;
+    skipped = 0;
+}
+
+/// next parses the next event it knows; false at the end of the log (or where it is cut off)
+boolean SessionLog::Reader::next(Record &record)
+{
+    while (pos < size)
+    {
+        uint32_t delta, length;
+        uint8_t type = data[pos];
+        uint8_t a = getVarint(data + pos + 1, size - pos - 1, delta);
+        uint8_t b = a ? getVarint(data + pos + 1 + a, size - pos - 1 - a, length) : 0;
+        if (!b || pos + 1 + a + b + length > size)
+        {
+            pos = size;
+            return false;
+        }
+        const uint8_t *payload = data + pos + 1 + a + b;
+        pos += 1 + a + b + length;
+        time = type == SESSION ? 0 : time + delta;
+        if (type == NONE || type >= TYPES)
+        {
+            ++skipped;
+            continue;
+        }
+
+        size_t p = 0;
+        record.type = type;
+        record.time = time;
+        record.count = 0;
+        for (int i = 0; i < SCHEMA[type].count && p < length; ++i)
+        {
+            uint8_t n = getVarint(payload + p, length - p, record.values[i]);
+            if (!n)
+            {
+                break;
+            }
+            p += n;
+            record.count = i + 1;
+        }
+        size_t n = SCHEMA[type].text ? length - p : 0;
+        n = n < MAX_TEXT ? n : MAX_TEXT;
+        memcpy(record.text, payload + p, n);
+        record.text[n] = 0;
+        return true;
+    }
+    return false;
+}
+
+/// getSkipped: events of types the reader does not know
+size_t SessionLog::Reader::getSkipped()
+{
+    return skipped;
+}
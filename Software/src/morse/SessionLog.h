@@ -0,0 +1,112 @@
+/*
+ * SessionLog.h
+ *
+ *  A compact binary log of practice sessions: what was generated, keyed, answered, and how fast.
+ */
+
+#ifndef SESSIONLOG_H_
+#define SESSIONLOG_H_
+
+#include "arduino.h"
+
+/// Every event is written as
+///
+///     type (1 byte), ms since the previous event (varint), length of the payload (varint), payload
+///
+/// where the payload is the numbers of the event type (varints), followed by its text, if it has one. A reader that
+/// does not know an event type skips it. Varints are little endian base 128: 7 bits per byte, the top bit set on all
+/// but the last byte - a pause of less than 128 ms takes one byte, one of up to 16 s two.
+///
+/// The events go into a RAM buffer of BUFFER bytes; the main loop calls flush() when isDue() and the keyer is idle,
+/// so writing to flash never gets into the way of keying. If the buffer is full, events are dropped (and counted) -
+/// a gap in the log is better than a stall.
+///
+/// Reader parses a log (several sessions, one after the other) into Records, for the host tool and the tests.
+
+class SessionLog
+{
+    public:
+        static const uint16_t BUFFER = 512;
+        static const unsigned long FLUSH_INTERVAL = 10000;      /// ms
+        static const uint8_t VERSION = 1;
+        static const uint8_t MAX_TEXT = 32;
+        static const uint8_t MAX_VALUES = 4;
+
+        enum Type
+        {
+            NONE,
+            SESSION,                /// version, menu item, wpm, effective wpm
+            WORD,                   /// repeated (0/1); text: the word generated
+            ELEMENT,                /// ms of a mark keyed, ms of the space before it
+            RESPONSE,               /// text: what the user keyed
+            RESULT,                 /// right (0/1), ms the response took
+            SPEED,                  /// wpm, effective wpm
+            DECODED,                /// text: a character the decoder has read
+            END,
+            TYPES
+        };
+
+        struct Record
+        {
+                uint8_t type;
+                uint32_t time;                  /// ms since the start of the session
+                uint8_t count;                  /// of values
+                uint32_t values[MAX_VALUES];
+                char text[MAX_TEXT + 1];
+        };
+
+        struct Sink
+        {
+                virtual boolean append(const uint8_t *data, size_t n) = 0;
+        };
+
+        class Reader
+        {
+            public:
+                Reader(const uint8_t *data, size_t n);
+                boolean next(Record &record);
+                size_t getSkipped();
+
+            private:
+                const uint8_t *data;
+                size_t size;
+                size_t pos;
+                uint32_t time;
+                size_t skipped;
+        };
+
+        SessionLog(Sink *s);
+        void begin(uint8_t menuItem, uint8_t wpm, uint8_t effWpm, unsigned long now);
+        void word(const char *text, boolean repeated, unsigned long now);
+        void element(uint16_t markMs, uint16_t spaceMs, unsigned long now);
+        void response(const char *text, unsigned long now);
+        void result(boolean right, uint32_t responseMs, unsigned long now);
+        void speed(uint8_t wpm, uint8_t effWpm, unsigned long now);
+        void decoded(const char *text, unsigned long now);
+        void end(unsigned long now);
+        boolean isActive();
+        boolean isDue(unsigned long now);
+        boolean flush(unsigned long now);
+        uint32_t getWritten();
+        uint32_t getDropped();
+
+        static uint8_t putVarint(uint8_t *p, uint32_t v);
+        static uint8_t getVarint(const uint8_t *p, size_t n, uint32_t &v);
+        static const char* getName(uint8_t type);
+
+    private:
+        static const uint8_t MAX_EVENT = 3 + 2 * 5 + MAX_VALUES * 5 + MAX_TEXT;
+
+        Sink *sink;
+        uint8_t buffer[BUFFER];
+        uint16_t used;
+        boolean active;
+        unsigned long last;             // time of the previous event
+        unsigned long lastFlush;
+        uint32_t written;
+        uint32_t dropped;
+
+        void add(Type type, const uint32_t *values, uint8_t count, const char *text, unsigned long now);
+};
+
+#endif /* SESSIONLOG_H_ */
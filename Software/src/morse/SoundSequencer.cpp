@@ -0,0 +1,188 @@
+/******************************************************************************************************************************
+ *  morse_3 Software for the Morserino-32 multi-functional Morse code machine, based on the Heltec WiFi LORA (ESP32) module ***
+ *  Copyright (C) 2018  Willi Kraml, OE1WKL                                                                                 ***
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this program.
+ *  If not, see <https://www.gnu.org/licenses/>.
+ *****************************************************************************************************************************/
+#include "SoundSequencer.h"
+
+SoundSequencer::SoundSequencer(Output *o)
+{
+    output = o;
+    head = 0;
+    count = 0;
+    phase = IDLE;
+    keyed = false;
+    frequency = 0;
+    volume = 0;
+    level = 0;
+    lineOut = false;
+    remaining = 0;
+}
+
+/// play queues notes, and starts the first one if nothing plays; false if they do not fit into the queue
+boolean SoundSequencer::play(const Note *notes, uint8_t n)
+{
+    if (count + n > QUEUE)
+    {
+        return false;
+    }
+    for (int i = 0; i < n; ++i)
+    {
+        queue[(head + count) % QUEUE] = notes[i];
+        ++count;
+    }
+    if (phase == IDLE)
+    {
+        next();
+        step();
+    }
+    return true;
+}
+
+/// keyDown starts the sidetone (or changes its pitch); the queued notes are dropped
+void SoundSequencer::keyDown(uint16_t f, uint8_t v, boolean l)
+{
+    count = 0;
+    keyed = true;
+    frequency = f;
+    volume = v;
+    lineOut = l;
+    if (level > volume)
+    {
+        level = volume;
+    }
+    phase = ATTACK;
+    step();
+}
+
+void SoundSequencer::keyUp()
+{
+    if (!keyed)
+    {
+        return;
+    }
+    keyed = false;
+    phase = DECAY;
+    step();
+}
+
+/// tick moves the voice on by one TICK
+void SoundSequencer::tick()
+{
+    switch (phase)
+    {
+        case ATTACK:
+        case HOLD:
+            if (!keyed && --remaining == 0)
+            {
+                phase = DECAY;
+            }
+            break;
+        case REST:
+            if (--remaining == 0)
+            {
+                next();
+            }
+            break;
+        default:
+            break;
+    }
+    step();
+}
+
+/// isBusy is true as long as tick() has something to do
+boolean SoundSequencer::isBusy()
+{
+    return phase != IDLE && phase != SUSTAIN;
+}
+
+boolean SoundSequencer::isSounding()
+{
+    return phase != IDLE;
+}
+
+/// getLength is the time in ms the notes take to play: each tone decays for RAMP - 1 ticks, the next note
+/// starts with the tick that would have silenced it (a tone shorter than its attack decays sooner)
+unsigned long SoundSequencer::getLength(const Note *notes, uint8_t n)
+{
+    unsigned long ms = 0;
+    for (int i = 0; i < n; ++i)
+    {
+        ms += notes[i].duration + (notes[i].frequency ? (RAMP - 1) * TICK / 1000 : 0);
+    }
+    return ms;
+}
+
+/// step does the ramps, one level per tick; the first step of an attack or decay is done at once
+void SoundSequencer::step()
+{
+    uint8_t stepSize = (volume + RAMP - 1) / RAMP;
+
+    switch (phase)
+    {
+        case ATTACK:
+            level = level + stepSize < volume ? level + stepSize : volume;
+            output->tone(frequency, level, lineOut);
+            if (level == volume)
+            {
+                phase = keyed ? SUSTAIN : HOLD;
+            }
+            break;
+        case DECAY:
+            level = level > stepSize ? level - stepSize : 0;
+            if (level > 0)
+            {
+                output->tone(frequency, level, lineOut);
+                break;
+            }
+            next();
+            if (phase == ATTACK)
+            {
+                step();                             // the next tone takes over at once
+            }
+            else
+            {
+                output->silence();
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/// next takes the next note from the queue, or goes idle
+void SoundSequencer::next()
+{
+    if (!count)
+    {
+        phase = IDLE;
+        return;
+    }
+    const Note &n = queue[head];
+    head = (head + 1) % QUEUE;
+    --count;
+
+    remaining = n.duration * 1000 / TICK;
+    if (remaining == 0)
+    {
+        remaining = 1;
+    }
+    if (n.frequency == 0)
+    {
+        phase = REST;
+        return;
+    }
+    frequency = n.frequency;
+    volume = n.volume;
+    lineOut = false;
+    level = 0;
+    phase = ATTACK;
+}
@@ -0,0 +1,73 @@
+/*
+ * SoundSequencer.h
+ *
+ *  Plays the sidetone and short tone sequences with attack and decay ramps, driven by a timer.
+ */
+
+#ifndef SOUNDSEQUENCER_H_
+#define SOUNDSEQUENCER_H_
+
+#include "arduino.h"
+
+/// There is one voice. It is either keyed (keyDown() until keyUp(), for the sidetone of the keyer and the
+/// generator), or it plays the notes that play() has queued, one after the other - the audio cues like the
+/// OK and ERR signals, and the encoder click. Keying has priority: keyDown() drops the queued notes.
+///
+/// Every tone starts with an attack ramp and ends with a decay ramp of RAMP ticks, so it does not click;
+/// a keyDown() while the tone decays ramps up again from where it is. tick() is called every TICK µs from
+/// a timer, as long as isBusy() - nobody has to wait for a tone: keyDown(), keyUp() and play() return at
+/// once, and start the ramp right away. The Output does what the sound hardware has to do.
+
+class SoundSequencer
+{
+    public:
+        static const uint8_t QUEUE = 16;
+        static const unsigned long TICK = 1000;     /// µs between two calls of tick()
+        static const uint8_t RAMP = 4;              /// ticks of the attack and of the decay
+
+        struct Note
+        {
+                uint16_t frequency;                 /// Hz, 0 = rest
+                uint16_t duration;                  /// ms from the start of the attack to the start of the decay
+                uint8_t volume;                     /// 0 - 100
+        };
+
+        struct Output
+        {
+                virtual void tone(uint16_t frequency, uint8_t level, boolean lineOut) = 0;
+                virtual void silence() = 0;
+        };
+
+        SoundSequencer(Output *o);
+        boolean play(const Note *notes, uint8_t n);
+        void keyDown(uint16_t frequency, uint8_t volume, boolean lineOut);
+        void keyUp();
+        void tick();
+        boolean isBusy();
+        boolean isSounding();
+        static unsigned long getLength(const Note *notes, uint8_t n);
+
+    private:
+        enum Phase
+        {
+            IDLE, ATTACK, HOLD, SUSTAIN, DECAY, REST
+        };
+
+        Output *output;
+        Note queue[QUEUE];
+        uint8_t head;
+        uint8_t count;
+
+        Phase phase;
+        boolean keyed;
+        uint16_t frequency;
+        uint8_t volume;
+        uint8_t level;
+        boolean lineOut;
+        unsigned long remaining;                    // ticks until the decay (or the end of a rest)
+
+        void step();
+        void next();
+};
+
+#endif /* SOUNDSEQUENCER_H_ */
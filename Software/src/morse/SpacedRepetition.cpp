@@ -0,0 +1,266 @@
+/******************************************************************************************************************************
+ *  morse_3 Software for the Morserino-32 multi-functional Morse code machine, based on the Heltec WiFi LORA (ESP32) module ***
+ *  Copyright (C) 2018  Willi Kraml, OE1WKL                                                                                 ***
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this program.
+ *  If not, see <https://www.gnu.org/licenses/>.
+ *****************************************************************************************************************************/
+#include <stddef.h>
+#include <string.h>
+#include "SpacedRepetition.h"
+#include "CharStats.h"
+#include "PrefsStore.h"
+
+SpacedRepetition::SpacedRepetition()
+{
+    clear();
+}
+
+void SpacedRepetition::clear()
+{
+    clock = 0;
+    memset(chars, 0, sizeof(chars));
+    memset(words, 0, sizeof(words));
+}
+
+/// review grades the characters of a response and the word, and moves the clock on by one word; responseMs has one
+/// time per character of the response (or is 0), a character that took longer than slowMs is only graded 4
+void SpacedRepetition::review(const char *expected, const char *response, const uint16_t *responseMs, uint16_t slowMs)
+{
+    CharStats::Edit edits[2 * CharStats::MAX_WORD];
+    char seen[CharStats::MAX_WORD + 1] = { };
+    uint8_t grades[CharStats::MAX_WORD];
+    uint8_t n = 0;
+    uint8_t distance = 0;
+    uint8_t i = 0;
+    uint8_t j = 0;
+
+    /// each character gets the worst grade it has in this word
+    uint8_t steps = CharStats::align(expected, response, edits);
+    for (int k = 0; k < steps; ++k)
+    {
+        uint8_t g;
+        switch (edits[k])
+        {
+            case CharStats::MATCH:
+                g = responseMs && slowMs && responseMs[j] > slowMs ? 4 : 5;
+                break;
+            case CharStats::INSERT:
+                ++distance;
+                ++j;
+                continue;
+            default:
+                g = 1;
+                ++distance;
+                break;
+        }
+        char *s = strchr(seen, expected[i]);
+        if (!s)
+        {
+            seen[n] = expected[i];
+            grades[n++] = g;
+        }
+        else if (g < grades[s - seen])
+        {
+            grades[s - seen] = g;
+        }
+        ++i;
+        if (edits[k] != CharStats::DELETE)
+        {
+            ++j;
+        }
+    }
+    for (int k = 0; k < n; ++k)
+    {
+        char text[2] = { seen[k], 0 };
+        Card *card = find(chars, CHARS, text);
+        grade(card ? *card : *add(chars, CHARS, text), grades[k], clock);
+    }
+
+    /// words of two or more characters that were wrong go into the drill deck, until they are right for long enough
+    size_t length = strlen(expected);
+    if (length >= 2 && length <= WORD_LENGTH)
+    {
+        Card *word = find(words, WORDS, expected);
+        if (distance)
+        {
+            grade(word ? *word : *add(words, WORDS, expected), distance == 1 ? 2 : 1, clock);
+        }
+        else if (word)
+        {
+            grade(*word, 5, clock);
+            if (word->interval >= RETIRE)
+            {
+                word->text[0] = 0;
+            }
+        }
+    }
+    ++clock;
+}
+
+/// nextChar is the character of pool, not in exclude, that is most overdue - or else the first one that has never been
+/// reviewed; 0 if there is none
+char SpacedRepetition::nextChar(const char *pool, const char *exclude)
+{
+    char best = 0;
+    char unseen = 0;
+    uint32_t bestDue = clock + 1;
+
+    for (; *pool; ++pool)
+    {
+        if (exclude && strchr(exclude, *pool))
+        {
+            continue;
+        }
+        const Card *card = findChar(*pool);
+        if (!card)
+        {
+            unseen = unseen ? unseen : *pool;
+        }
+        else if (card->due < bestDue)
+        {
+            best = *pool;
+            bestDue = card->due;
+        }
+    }
+    return best ? best : unseen;
+}
+
+/// nextWord is the drill word that is most overdue; 0 if none is due
+const char* SpacedRepetition::nextWord()
+{
+    const Card *best = 0;
+
+    for (int i = 0; i < WORDS; ++i)
+    {
+        if (words[i].text[0] && words[i].due <= clock && (!best || words[i].due < best->due))
+        {
+            best = &words[i];
+        }
+    }
+    return best ? best->text : 0;
+}
+
+/// isLearned is true when all characters of pool have been right often enough to reach an interval of MATURE
+boolean SpacedRepetition::isLearned(const char *pool)
+{
+    for (; *pool; ++pool)
+    {
+        const Card *card = findChar(*pool);
+        if (!card || card->interval < MATURE)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+const SpacedRepetition::Card* SpacedRepetition::findChar(char c)
+{
+    char text[2] = { c, 0 };
+    return find(chars, CHARS, text);
+}
+
+const SpacedRepetition::Card* SpacedRepetition::findWord(const char *word)
+{
+    return find(words, WORDS, word);
+}
+
+uint32_t SpacedRepetition::getClock()
+{
+    return clock;
+}
+
+/// grade is the SM-2 step for one card
+void SpacedRepetition::grade(Card &card, uint8_t grade, uint32_t clock)
+{
+    if (grade < 3)
+    {
+        if (card.repetitions)
+        {
+            ++card.lapses;
+        }
+        card.repetitions = 0;
+        card.interval = 1;
+    }
+    else
+    {
+        uint32_t interval = card.repetitions == 0 ? FIRST_INTERVAL :
+                            card.repetitions == 1 ? SECOND_INTERVAL : (uint32_t) card.interval * card.easiness / 100;
+        card.interval = interval < 0xffff ? interval : 0xffff;
+        if (card.repetitions < 0xff)
+        {
+            ++card.repetitions;
+        }
+    }
+    int d = 5 - grade;
+    int easiness = card.easiness + 10 - d * (8 + d * 2);
+    card.easiness = easiness > MIN_EASINESS ? easiness : MIN_EASINESS;
+    card.due = clock + card.interval;
+}
+
+void SpacedRepetition::toBlob(Blob &blob)
+{
+    blob.version = LAYOUT_VERSION;
+    blob.reserved = 0;
+    blob.clock = clock;
+    memcpy(blob.chars, chars, sizeof(chars));
+    memcpy(blob.words, words, sizeof(words));
+    blob.crc = PrefsStore::crc16((const uint8_t*) &blob.clock, sizeof(Blob) - offsetof(Blob, clock));
+}
+
+/// fromBlob takes the decks from a blob read from storage; returns false (and leaves the decks alone) if it is damaged
+/// or of another layout
+boolean SpacedRepetition::fromBlob(const Blob &blob, size_t length)
+{
+    if (length != sizeof(Blob) || blob.version != LAYOUT_VERSION
+            || blob.crc != PrefsStore::crc16((const uint8_t*) &blob.clock, sizeof(Blob) - offsetof(Blob, clock)))
+    {
+        return false;
+    }
+    clock = blob.clock;
+    memcpy(chars, blob.chars, sizeof(chars));
+    memcpy(words, blob.words, sizeof(words));
+    return true;
+}
+
+SpacedRepetition::Card* SpacedRepetition::find(Card *deck, uint8_t size, const char *text)
+{
+    for (int i = 0; i < size; ++i)
+    {
+        if (deck[i].text[0] && !strncmp(deck[i].text, text, WORD_LENGTH + 1))
+        {
+            return &deck[i];
+        }
+    }
+    return 0;
+}
+
+/// add makes a new card; if the deck is full, it takes the place of the card with the longest interval
+SpacedRepetition::Card* SpacedRepetition::add(Card *deck, uint8_t size, const char *text)
+{
+    Card *card = &deck[0];
+
+    for (int i = 0; i < size; ++i)
+    {
+        if (!deck[i].text[0])
+        {
+            card = &deck[i];
+            break;
+        }
+        if (deck[i].interval > card->interval)
+        {
+            card = &deck[i];
+        }
+    }
+    memset(card, 0, sizeof(Card));
+    strncpy(card->text, text, WORD_LENGTH);
+    card->easiness = START_EASINESS;
+    return card;
+}
@@ -0,0 +1,88 @@
+/*
+ * SpacedRepetition.h
+ *
+ *  SM-2 style scheduling of characters and drill words for the echo trainer.
+ */
+
+#ifndef SPACEDREPETITION_H_
+#define SPACEDREPETITION_H_
+
+#include "arduino.h"
+
+/// Each character, and each word the user got wrong, has a Card: how easy it is (the SM-2 easiness factor, times 100),
+/// how often in a row it was right, and when it is due again. review() grades every character of a response (5 = right
+/// and quick, 4 = right but slow, 1 = wrong or missing) and the word as a whole, and moves the cards on:
+///
+///     grade < 3:  repetitions = 0, interval = 1
+///     otherwise:  interval = FIRST_INTERVAL, SECOND_INTERVAL, then interval * easiness
+///     easiness += 10 - (5 - grade) * (8 + (5 - grade) * 2), at least 130
+///
+/// The M32 has no real time clock, and a day means little for a trainer that is used in sessions - so time is counted
+/// in words: every review() moves the clock on by one, and intervals are in words.
+///
+/// nextChar() chooses from a pool (e.g. the Koch characters learned so far) the character that is most overdue; only
+/// when nothing is due, a character without a card is next, in the order of the pool. nextWord() returns
+/// a drill word that is due. A word that has been right for RETIRE words leaves the drill deck; if a deck is full, the
+/// card with the longest interval makes room. isLearned() tells when all characters of a pool have reached MATURE -
+/// time for the next Koch lesson.
+///
+/// Both decks go into non-volatile storage as one Blob, with a layout version and a CRC.
+
+class SpacedRepetition
+{
+    public:
+        static const uint8_t CHARS = 64;
+        static const uint8_t WORDS = 32;
+        static const uint8_t WORD_LENGTH = 7;
+        static const uint16_t FIRST_INTERVAL = 3;
+        static const uint16_t SECOND_INTERVAL = 10;
+        static const uint16_t MATURE = 30;
+        static const uint16_t RETIRE = 200;
+        static const uint16_t MIN_EASINESS = 130;
+        static const uint16_t START_EASINESS = 250;
+        static const uint8_t LAYOUT_VERSION = 1;
+
+        struct Card
+        {
+                char text[WORD_LENGTH + 1];     /// the character or word, in internal form; empty: no card
+                uint16_t easiness;              /// SM-2 easiness factor * 100
+                uint8_t repetitions;            /// right in a row
+                uint8_t lapses;                 /// how often it was wrong after it had been right
+                uint16_t interval;              /// words
+                uint32_t due;                   /// clock
+        };
+
+        struct Blob
+        {
+                uint8_t version;
+                uint8_t reserved;
+                uint16_t crc;
+                uint32_t clock;
+                Card chars[CHARS];
+                Card words[WORDS];
+        };
+
+        SpacedRepetition();
+        void clear();
+        void review(const char *expected, const char *response, const uint16_t *responseMs, uint16_t slowMs);
+        char nextChar(const char *pool, const char *exclude);
+        const char* nextWord();
+        boolean isLearned(const char *pool);
+        const Card* findChar(char c);
+        const Card* findWord(const char *word);
+        uint32_t getClock();
+        void toBlob(Blob &blob);
+        boolean fromBlob(const Blob &blob, size_t length);
+
+        static void grade(Card &card, uint8_t grade, uint32_t clock);
+
+    private:
+        uint32_t clock;
+        Card chars[CHARS];
+        Card words[WORDS];
+
+        static Card* find(Card *deck, uint8_t size, const char *text);
+        static Card* add(Card *deck, uint8_t size, const char *text);
+};
+
+#endif /* SPACEDREPETITION_H_ */
@@ -0,0 +1,148 @@
+/******************************************************************************************************************************
+ *  morse_3 Software for the Morserino-32 multi-functional Morse code machine, based on the Heltec WiFi LORA (ESP32) module ***
+ *  Copyright (C) 2018  Willi Kraml, OE1WKL                                                                                 ***
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this program.
+ *  If not, see <https://www.gnu.org/licenses/>.
+ *****************************************************************************************************************************/
+#include "SpeedController.h"
+
+/// the word PARIS, the unit of speed: 31 dits of elements and the spaces inside characters, 4 spaces between its
+/// characters and one space after it
+static const uint16_t PARIS_ELEMENTS = 31;
+
+SpeedController::SpeedController()
+{
+    begin(15, 3, 7, 90);
+}
+
+/// begin starts a session with the speed and the spacing of the preferences
+void SpeedController::begin(uint8_t wpm, uint8_t interCharSpace, uint8_t interWordSpace, uint8_t targetPercent)
+{
+    target = targetPercent;
+    sum = 0;
+    count = 0;
+    step = START_STEP;
+    direction = 0;
+    sameDirection = 0;
+
+    startWpm = wpm;
+    startInterCharSpace = interCharSpace;
+    startInterWordSpace = interWordSpace > interCharSpace + 4 ? interWordSpace : interCharSpace + 4;
+
+    uint16_t spaces = 4 * startInterCharSpace + startInterWordSpace;
+    uint16_t maxStretch = MAX_INTER_CHAR_SPACE * SCALE / startInterCharSpace;      // how far the spaces may grow
+    if (MAX_INTER_WORD_SPACE * SCALE / startInterWordSpace < maxStretch)
+    {
+        maxStretch = MAX_INTER_WORD_SPACE * SCALE / startInterWordSpace;
+    }
+    startSpeed = 50UL * startWpm * SCALE / (PARIS_ELEMENTS + spaces);
+    minSpeed = 50UL * startWpm * SCALE * SCALE / (PARIS_ELEMENTS * SCALE + (uint32_t) maxStretch * spaces);
+    minSpeed = minSpeed > MIN_WPM * SCALE ? minSpeed : MIN_WPM * SCALE;
+    maxSpeed = (uint32_t) startSpeed * MAX_WPM / startWpm;
+    speed = startSpeed;
+    update();
+}
+
+/// onWord scores a response, and adapts the speed; true if it has changed
+boolean SpeedController::onWord(boolean right, unsigned long responseMs, unsigned long keyingMs)
+{
+    uint8_t score = 0;
+    if (right)
+    {
+        score = keyingMs && responseMs > SLOW * keyingMs ? 50 : 100;
+    }
+    if (count == MAX_WORDS)
+    {
+        sum /= 2;
+        count /= 2;
+    }
+    sum += score;
+    ++count;
+
+    int diff = (int) getAccuracy() - target;
+    if (count < MIN_WORDS || (diff >= -DEADBAND && diff <= DEADBAND))
+    {
+        return false;
+    }
+
+    int8_t d = diff > 0 ? 1 : -1;
+    if (direction && d != direction)
+    {
+        step = step / 2 > MIN_STEP ? step / 2 : MIN_STEP;
+        sameDirection = 0;
+    }
+    else if (direction && ++sameDirection >= SPEEDUP)
+    {
+        step = step * 2 < MAX_STEP ? step * 2 : MAX_STEP;
+        sameDirection = 0;
+    }
+    direction = d;
+
+    int32_t s = (int32_t) speed + d * step;
+    s = s < minSpeed ? minSpeed : s > maxSpeed ? maxSpeed : s;
+    sum = 0;                                        // what comes next is at the new speed
+    count = 0;
+    if (s == speed)
+    {
+        return false;
+    }
+    speed = s;
+    update();
+    return true;
+}
+
+/// getAccuracy is the average score since the last step, in percent
+uint8_t SpeedController::getAccuracy()
+{
+    return count ? sum / count : 0;
+}
+
+/// getSpeed is the effective speed, in 1/SCALE WpM
+uint16_t SpeedController::getSpeed()
+{
+    return speed;
+}
+
+/// isChanged is true when the speed is not that of the preferences any more
+boolean SpeedController::isChanged()
+{
+    return speed != startSpeed;
+}
+
+const SpeedController::Timings& SpeedController::getTimings()
+{
+    return timings;
+}
+
+/// update computes the timings for the effective speed: faster characters above the start speed, longer spaces below
+void SpeedController::update()
+{
+    uint16_t spaces = 4 * startInterCharSpace + startInterWordSpace;
+    uint32_t charSpeed = startWpm * SCALE;                          // 1/SCALE WpM
+    uint32_t stretch = SCALE;                                       // of the spaces, in 1/SCALE
+
+    if (speed >= startSpeed)
+    {
+        charSpeed = (uint32_t) startWpm * SCALE * speed / startSpeed;
+    }
+    else
+    {   // 50 dits per word at the character speed, of which PARIS_ELEMENTS are not spaces
+        uint32_t dits = 50UL * startWpm * SCALE * SCALE / speed;     // 1/SCALE dits
+        stretch = (dits - PARIS_ELEMENTS * SCALE) / spaces;
+    }
+    timings.wpm = (charSpeed + SCALE / 2) / SCALE;
+    timings.ditLength = 1200UL * SCALE / charSpeed;
+    timings.interCharacterSpace = (uint32_t) timings.ditLength * startInterCharSpace * stretch / SCALE;
+    timings.interWordSpace = (uint32_t) timings.ditLength * startInterWordSpace * stretch / SCALE;
+    timings.charSpaceDits = (startInterCharSpace * stretch + SCALE / 2) / SCALE;
+    timings.wordSpaceDits = (startInterWordSpace * stretch + SCALE / 2) / SCALE;
+    timings.effWpm = 60000UL
+            / (PARIS_ELEMENTS * timings.ditLength + 4 * timings.interCharacterSpace + timings.interWordSpace);
+}
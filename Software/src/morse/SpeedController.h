@@ -0,0 +1,82 @@
+/*
+ * SpeedController.h
+ *
+ *  Adapts the speed of the echo trainer so that the user gets a target share of the words right.
+ */
+
+#ifndef SPEEDCONTROLLER_H_
+#define SPEEDCONTROLLER_H_
+
+#include "arduino.h"
+
+/// onWord() scores each response - 100 when it was right, half of it when it was right but took more than SLOW times
+/// as long as keying the word, 0 when it was wrong. The accuracy is the average score of the words since the speed
+/// last changed (older words weigh less once there are MAX_WORDS of them). After at least MIN_WORDS words, if it is
+/// more than DEADBAND percent off the target, the effective speed takes a step towards it - a staircase: the step
+/// starts at START_STEP, halves whenever the direction turns (down to MIN_STEP), and doubles after SPEEDUP steps in
+/// the same direction (up to MAX_STEP). So a new user gets to the right speed soon, and then the speed stays put
+/// instead of going up and down with every word.
+///
+/// The effective speed is turned into timings the Farnsworth way: above the speed the session started with, the
+/// character speed goes up, with the spacing (in dits) of the preferences; below it, the characters keep their speed
+/// and the spaces between characters and words get longer, in proportion. None of this is saved: the caller takes
+/// getTimings() into the keyer, and writes the preferences (the character speed and the spacing in dits of
+/// getTimings()) when the session ends.
+
+class SpeedController
+{
+    public:
+        static const uint8_t SCALE = 16;            /// speeds are in 1/SCALE WpM
+        static const uint8_t MIN_WPM = 5;
+        static const uint8_t MAX_WPM = 60;
+        static const uint8_t MIN_WORDS = 8;
+        static const uint8_t MAX_WORDS = 32;
+        static const uint8_t DEADBAND = 5;          /// percent around the target
+        static const uint8_t START_STEP = 16;       /// 1 WpM
+        static const uint8_t MIN_STEP = 2;
+        static const uint8_t MAX_STEP = 64;
+        static const uint8_t SPEEDUP = 2;
+        static const uint8_t SLOW = 2;
+        static const uint8_t MAX_INTER_CHAR_SPACE = 24;
+        static const uint8_t MAX_INTER_WORD_SPACE = 45;
+
+        struct Timings
+        {
+                uint8_t wpm;                        /// character speed
+                uint8_t effWpm;                     /// with the spaces, as MorseKeyer::updateTimings() computes it
+                unsigned int ditLength;             /// ms
+                unsigned int interCharacterSpace;   /// ms
+                unsigned int interWordSpace;        /// ms
+                uint8_t charSpaceDits;              /// rounded, for the preferences
+                uint8_t wordSpaceDits;              /// rounded, for the preferences
+        };
+
+        SpeedController();
+        void begin(uint8_t wpm, uint8_t interCharSpace, uint8_t interWordSpace, uint8_t targetPercent);
+        boolean onWord(boolean right, unsigned long responseMs, unsigned long keyingMs);
+        uint8_t getAccuracy();
+        uint16_t getSpeed();
+        boolean isChanged();
+        const Timings& getTimings();
+
+    private:
+        uint8_t target;
+        uint16_t sum;                               // of the scores since the last step
+        uint8_t count;
+        uint16_t step;
+        int8_t direction;                           // of the last step
+        uint8_t sameDirection;                      // steps in a row
+
+        uint8_t startWpm;
+        uint8_t startInterCharSpace;
+        uint8_t startInterWordSpace;
+        uint16_t startSpeed;                        // the effective speed of the preferences
+        uint16_t minSpeed;
+        uint16_t maxSpeed;
+        uint16_t speed;                             // effective, 1/SCALE WpM
+        Timings timings;
+
+        void update();
+};
+
+#endif /* SPEEDCONTROLLER_H_ */
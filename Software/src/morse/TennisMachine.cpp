@@ -26,7 +26,7 @@ void TennisMachine::loop()
 void TennisMachine::onMessageTransmit(WordBuffer &message)
 {
     MORSELOGLN("TM::oMT " + message.get());
-    if (message.matches("<sk>"))
+    if (patterns.sk.advance(message, slots()))
     {
         MORSELOGLN("TM::oMT got <sk>");
         message.getAndClear();
@@ -58,6 +58,8 @@ void TennisMachine::switchToState(State *newState)
         currentState->onLeave();
     }
 
+    // the new state expects other words - start over with what is in the buffer
+    patterns.reset();
     newState->onEnter();
     currentState = newState;
 }
@@ -67,12 +69,61 @@ const char* TennisMachine::getState()
     return currentState->getName();
 }
 
-String TennisMachine::renderPattern(String pattern)
+void TennisMachine::setGameConfig(GameConfig &c)
 {
-    String out = pattern;
-    out.replace("$dx", gameState.dx.call);
-    out.replace("$us", gameState.us.call);
-    return out;
+    config = c;
+    compilePatterns();
+}
+
+/// compilePatterns prepares the patterns of the message set, so they need not be interpreted for every word
+void TennisMachine::compilePatterns()
+{
+    MessageSet &m = config.msgSet;
+    patterns.cqCall.compile(m.cqCall.c_str());
+    patterns.dxdepat.compile(m.dxdepat.c_str());
+    patterns.dxdeus.compile(m.dxdeus.c_str());
+    patterns.usdedx.compile(m.usdedx.c_str());
+    patterns.usdepat.compile(m.usdepat.c_str());
+    patterns.sendChallenge.compile(m.sendChallenge.c_str());
+    patterns.reset();
+}
+
+void TennisMachine::Patterns::reset()
+{
+    cqCall.reset();
+    dxdepat.reset();
+    dxdeus.reset();
+    usdedx.reset();
+    usdepat.reset();
+    sendChallenge.reset();
+    challenge.reset();
+    anyWord.reset();
+    sk.reset();
+    ka.reset();
+}
+
+/// slots returns what the placeholders of the patterns stand for right now
+TennisPattern::Slots TennisMachine::slots()
+{
+    TennisPattern::Slots s;
+    s.value[TennisPattern::SLOT_DX] = gameState.dx.call.c_str();
+    s.value[TennisPattern::SLOT_US] = gameState.us.call.c_str();
+    s.value[TennisPattern::SLOT_CHALLENGE] = gameState.challenge.c_str();
+    return s;
+}
+
+/// advance feeds the words keyed since the last call into pattern and tells the client how far they match
+boolean TennisMachine::advance(TennisPattern &pattern, WordBuffer &message)
+{
+    boolean matched = pattern.advance(message, slots());
+    client->progress(pattern.getProgress(), pattern.getLength());
+    return matched;
+}
+
+/// matches checks a received message against pattern
+boolean TennisMachine::matches(TennisPattern &pattern, WordBuffer &message)
+{
+    return pattern.matches(message, slots());
 }
 
 TennisMachine::GameState TennisMachine::getGameState()
@@ -146,9 +197,9 @@ void TennisMachine::StateInitial::onMessageReceive(String rawMessage)
     MORSELOGLN("StateInitial received " + message);
     machine->client->print("DX proposing " + machine->client->getMsgSet()->name + "\n");
     WordBuffer msgBuf(message);
-    if (msgBuf.matches(machine->client->getMsgSet()->cqCall))
+    if (machine->matches(machine->patterns.cqCall, msgBuf))
     {
-        String dxCall = msgBuf.getMatch();
+        String dxCall = machine->patterns.cqCall.getMatch(msgBuf);
         machine->gameState.dx.call = dxCall;
         machine->client->printReceivedMessage(message);
         machine->switchToState(&machine->stateInviteReceived);
@@ -157,12 +208,12 @@ void TennisMachine::StateInitial::onMessageReceive(String rawMessage)
 
 void TennisMachine::StateInitial::onMessageTransmit(WordBuffer &message)
 {
-    String pattern = machine->client->getMsgSet()->cqCall;
-    if (message.matches(pattern))
+    TennisPattern &pattern = machine->patterns.cqCall;
+    if (machine->advance(pattern, message))
     {
-        String us = message.getMatch();
+        String us = pattern.getMatch(message);
         MORSELOGLN("StateInitial sent cq - off to invite sent - our call: '" + us + "'");
-        String text = message.getFullPatternMatch();
+        String text = pattern.getFullMatch(message);
         InitialMessageEnvelope msg;
         msg.d.msgSet = machine->config.msgSetNo;
         msg.d.scoring = machine->config.scoringNo;
@@ -207,12 +258,12 @@ void TennisMachine::StateInviteReceived::onMessageReceive(String message)
 
 void TennisMachine::StateInviteReceived::onMessageTransmit(WordBuffer &message)
 {
-    String pattern = machine->renderPattern(machine->client->getMsgSet()->dxdepat);
-    if (message.matches(pattern))
+    TennisPattern &pattern = machine->patterns.dxdepat;
+    if (machine->advance(pattern, message))
     {
-        String us = message.getMatch();
+        String us = pattern.getMatch(message);
         MORSELOGLN("ACK sent - off to answered");
-        machine->client->sendAndPrint(message.getFullPatternMatch());
+        machine->client->sendAndPrint(pattern.getFullMatch(message));
         message.getAndClear();
         machine->gameState.us.call = us;
         machine->switchToState(&machine->stateInviteAnswered);
@@ -247,8 +298,9 @@ void TennisMachine::StateInviteAnswered::onLeave()
 void TennisMachine::StateInviteAnswered::onMessageReceive(String message)
 {
     MORSELOGLN("StateInviteAnswered received '" + message + "'");
-    String pattern = machine->renderPattern(machine->client->getMsgSet()->usdedx);
-    if (message == pattern)
+    WordBuffer msgBuf(message);
+    TennisPattern &pattern = machine->patterns.usdedx;
+    if (machine->matches(pattern, msgBuf) && msgBuf.getWordCount() == pattern.getLength())
     {
         MORSELOGLN("Game between " + machine->gameState.dx.call + " and " + machine->gameState.us.call);
         machine->client->print("Game starts.\n");
@@ -285,11 +337,11 @@ void TennisMachine::StateInviteSent::onLeave()
 void TennisMachine::StateInviteSent::onMessageReceive(String message)
 {
     MORSELOGLN("StateInviteSent received '" + message + "'");
-    String pattern = machine->renderPattern(machine->client->getMsgSet()->usdepat);
+    TennisPattern &pattern = machine->patterns.usdepat;
     WordBuffer msgBuf(message);
-    if (msgBuf.matches(pattern))
+    if (machine->matches(pattern, msgBuf))
     {
-        String dxCall = msgBuf.getMatch();
+        String dxCall = pattern.getMatch(msgBuf);
         MORSELOGLN("Received ACK from " + dxCall + " - off to state invite accepted");
         machine->client->printReceivedMessage(message);
         machine->gameState.dx.call = dxCall;
@@ -329,10 +381,10 @@ void TennisMachine::StateInviteAccepted::onMessageReceive(String message)
 
 void TennisMachine::StateInviteAccepted::onMessageTransmit(WordBuffer &message)
 {
-    String pattern = machine->renderPattern(machine->client->getMsgSet()->dxdeus);
-    if (message.matches(pattern))
+    TennisPattern &pattern = machine->patterns.dxdeus;
+    if (machine->advance(pattern, message))
     {
-        machine->client->sendAndPrint(pattern);
+        machine->client->sendAndPrint(pattern.getFullMatch(message));
         machine->client->print("Game starts.\n");
         message.getAndClear();
         machine->switchToState(&machine->stateStartRoundSender);
@@ -368,10 +420,11 @@ void TennisMachine::StateStartRoundSender::onMessageReceive(String message)
 
 void TennisMachine::StateStartRoundSender::onMessageTransmit(WordBuffer &message)
 {
-    if (message.matches(machine->client->getMsgSet()->sendChallenge))
+    TennisPattern &pattern = machine->patterns.sendChallenge;
+    if (machine->advance(pattern, message))
     {
         // Send test passed
-        String challenge = message.getMatch();
+        String challenge = pattern.getMatch(message);
         machine->gameState.challenge = challenge;
         machine->client->sendAndPrint(challenge);
         machine->client->challengeSound(true);
@@ -449,11 +502,11 @@ void TennisMachine::StateStartRoundReceiver::onLeave()
 void TennisMachine::StateStartRoundReceiver::onMessageReceive(String message)
 {
     MORSELOGLN("StateStartRoundReceiver received " + message);
-    String pattern = "#";
+    TennisPattern &pattern = machine->patterns.anyWord;
     WordBuffer msgBuf(message);
-    if (msgBuf.matches(pattern))
+    if (machine->matches(pattern, msgBuf))
     {
-        String challenge = msgBuf.getMatch();
+        String challenge = pattern.getMatch(msgBuf);
         machine->gameState.challenge = challenge;
         machine->client->printReceivedMessage(message);
         machine->switchToState(&machine->stateChallengeReceived);
@@ -493,7 +546,7 @@ void TennisMachine::StateChallengeReceived::onMessageReceive(String message)
 
 void TennisMachine::StateChallengeReceived::onMessageTransmit(WordBuffer &message)
 {
-    if (message.matches(machine->gameState.challenge))
+    if (machine->advance(machine->patterns.challenge, message))
     {
         // Challenge passed
         machine->client->print(" OK\n");
@@ -535,7 +588,7 @@ void TennisMachine::StateEnd::onMessageReceive(String message)
 
 void TennisMachine::StateEnd::onMessageTransmit(WordBuffer &message)
 {
-    if (message.matches("<ka>"))
+    if (machine->patterns.ka.advance(message, machine->slots()))
     {
         machine->client->print("\n");
         machine->switchToState(&machine->stateInitial);
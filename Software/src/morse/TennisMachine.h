@@ -4,6 +4,7 @@
 #include "morsedefs.h"
 #include "MorseMode.h"
 #include "WordBuffer.h"
+#include "TennisPattern.h"
 
 class TennisMachine
 {
@@ -63,13 +64,14 @@ class TennisMachine
             virtual void challengeSound(boolean ok) = 0;
             virtual void handle(InitialMessageData *d) = 0;
             virtual MessageSet* getMsgSet() = 0;
+            virtual void progress(uint8_t matched, uint8_t total) {};     /// how far the keyed words match what is expected
 
             TennisMachine *machine;
         };
 
 
         void setClient(Client *c) {client = c; client->machine = this;};
-        void setGameConfig(GameConfig &c) {config = c;};
+        void setGameConfig(GameConfig &c);
         GameConfig *getGameConfig();
 
         void start();
@@ -220,8 +222,27 @@ class TennisMachine
         WordBuffer sendBuffer;
         WordBuffer receiveBuffer;
 
+        struct Patterns
+        {
+                TennisPattern cqCall;
+                TennisPattern dxdepat;
+                TennisPattern dxdeus;
+                TennisPattern usdedx;
+                TennisPattern usdepat;
+                TennisPattern sendChallenge;
+                TennisPattern challenge{"$challenge"};
+                TennisPattern anyWord{"#"};
+                TennisPattern sk{"<sk>"};
+                TennisPattern ka{"<ka>"};
+
+                void reset();
+        } patterns;
+
         void switchToState(State *newState);
-        String renderPattern(String pattern);
+        void compilePatterns();
+        TennisPattern::Slots slots();
+        boolean advance(TennisPattern &pattern, WordBuffer &message);
+        boolean matches(TennisPattern &pattern, WordBuffer &message);
 };
 
 #endif /* MORSEMODETENNIS_H_ */
@@ -0,0 +1,263 @@
+/******************************************************************************************************************************
+ *  morse_3 Software for the Morserino-32 multi-functional Morse code machine, based on the Heltec WiFi LORA (ESP32) module ***
+ *  Copyright (C) 2020  Matthias Jordan, DL4MAT
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this program.
+ *  If not, see <https://www.gnu.org/licenses/>.
+ *****************************************************************************************************************************/
+#include <string.h>
+#include "TennisPattern.h"
+
+static const char *slotNames[TennisPattern::SLOTS] = { "$dx", "$us", "$challenge" };
+
+TennisPattern::TennisPattern()
+{
+    compile("");
+}
+
+TennisPattern::TennisPattern(const char *pattern)
+{
+    compile(pattern);
+}
+
+/// compile returns false if the pattern is empty or too long; such a pattern never matches
+boolean TennisPattern::compile(const char *pattern)
+{
+    count = 0;
+    literals = 0;
+    firstWildcard = NONE;
+    valid = strlen(pattern) <= MAX_LENGTH;
+    reset();
+    if (!valid)
+    {
+        text[0] = 0;
+        return false;
+    }
+    strcpy(text, pattern);
+
+    uint8_t i = 0;
+    while (text[i])
+    {
+        if (text[i] == ' ')
+        {
+            ++i;
+            continue;
+        }
+        uint8_t start = i;
+        while (text[i] && text[i] != ' ')
+        {
+            ++i;
+        }
+        uint8_t length = i - start;
+
+        if (count == MAX_TOKENS)
+        {
+            valid = false;
+            return false;
+        }
+        Token &t = tokens[count];
+        t.kind = LITERAL;
+        if (length == 1 && text[start] == '#')
+        {
+            t.kind = WILDCARD;
+            if (firstWildcard == NONE)
+            {
+                firstWildcard = count;
+            }
+        }
+        for (uint8_t s = 0; s < SLOTS; ++s)
+        {
+            if (strlen(slotNames[s]) == length && strncmp(text + start, slotNames[s], length) == 0)
+            {
+                t.kind = SLOT;
+                t.value = s;
+            }
+        }
+        if (t.kind == LITERAL)
+        {
+            t.value = intern(text + start, length);
+        }
+        ++count;
+    }
+    valid = count > 0;
+    return valid;
+}
+
+boolean TennisPattern::isValid()
+{
+    return valid;
+}
+
+/// reset forgets all partial matches; the next call of advance() reads the word buffer from its beginning
+void TennisPattern::reset()
+{
+    state = 1;
+    generation = 0;
+    next = 0;
+}
+
+/// advance reads the words added to the buffer since the last call and returns true if the buffer now ends
+/// with the pattern. If the buffer has been cleared in between, it starts over.
+boolean TennisPattern::advance(WordBuffer &words, const Slots &slots)
+{
+    unsigned int end = words.getWordCount();
+    if (words.getGeneration() != generation || next > end)
+    {
+        reset();
+        generation = words.getGeneration();
+    }
+    if (end - next > WordBuffer::MAX_TOKENS)
+    {   // we cannot see these words anymore - they are too old to be part of a match anyway
+        state = 1;
+        next = end - WordBuffer::MAX_TOKENS;
+    }
+    for (; next < end; ++next)
+    {
+        state = step(state, words, next, slots);
+    }
+    return isMatched();
+}
+
+/// matches returns true if the buffer ends with the pattern; unlike advance() it reads all words
+/// and does not change the state
+boolean TennisPattern::matches(WordBuffer &words, const Slots &slots)
+{
+    unsigned int end = words.getWordCount();
+    unsigned int i = end > WordBuffer::MAX_TOKENS ? end - WordBuffer::MAX_TOKENS : 0;
+    uint16_t s = 1;
+
+    for (; i < end; ++i)
+    {
+        s = step(s, words, i, slots);
+    }
+    return valid && (s & (1 << count));
+}
+
+boolean TennisPattern::isMatched()
+{
+    return valid && (state & (1 << count));
+}
+
+/// getProgress returns how many words of the pattern the most advanced partial match has got
+uint8_t TennisPattern::getProgress()
+{
+    for (uint8_t n = count; n > 0; --n)
+    {
+        if (state & (1 << n))
+        {
+            return n;
+        }
+    }
+    return 0;
+}
+
+uint8_t TennisPattern::getLength()
+{
+    return count;
+}
+
+/// getMatch returns the word that matched the wildcard; call it right after a successful match
+String TennisPattern::getMatch(WordBuffer &words)
+{
+    if (firstWildcard == NONE)
+    {
+        return String("");
+    }
+    unsigned int i = words.getWordCount() - count + firstWildcard;
+    return words.getWords(i, i + 1);
+}
+
+/// getFullMatch returns the words that matched the pattern; call it right after a successful match
+String TennisPattern::getFullMatch(WordBuffer &words)
+{
+    unsigned int end = words.getWordCount();
+    return words.getWords(end - count, end);
+}
+
+uint8_t TennisPattern::intern(const char *word, uint8_t length)
+{
+    uint8_t l = lookup(word, length);
+    if (l == NONE)
+    {
+        l = literals++;
+        literalStart[l] = word - text;
+        literalLength[l] = length;
+    }
+    return l;
+}
+
+uint8_t TennisPattern::lookup(const char *word, unsigned int length)
+{
+    for (uint8_t l = 0; l < literals; ++l)
+    {
+        if (literalLength[l] == length && strncmp(text + literalStart[l], word, length) == 0)
+        {
+            return l;
+        }
+    }
+    return NONE;
+}
+
+/// step advances all partial matches by word i of the buffer
+uint16_t TennisPattern::step(uint16_t state, WordBuffer &words, unsigned int i, const Slots &slots)
+{
+    const char *word;
+    unsigned int length;
+    uint16_t reached = 1;                               // a new match may start with every word
+
+    if (!valid || !words.getWord(i, word, length))
+    {
+        return reached;
+    }
+    uint8_t literal = lookup(word, length);
+
+    for (uint8_t p = 0; p < count; ++p)
+    {
+        if ((state & (1 << p)) && accepts(p, literal, words, i, slots))
+        {
+            reached |= 1 << (p + 1);
+        }
+    }
+    return reached;
+}
+
+/// accepts is true if token p of the pattern matches word i of the buffer
+boolean TennisPattern::accepts(uint8_t p, uint8_t literal, WordBuffer &words, unsigned int i, const Slots &slots)
+{
+    const char *word, *other;
+    unsigned int length, otherLength;
+
+    switch (tokens[p].kind)
+    {
+        case LITERAL:
+            return literal == tokens[p].value;
+
+        case SLOT:
+        {
+            const char *value = slots.value[tokens[p].value];
+            words.getWord(i, word, length);
+            return value && strlen(value) == length && strncmp(word, value, length) == 0;
+        }
+
+        case WILDCARD:
+            words.getWord(i, word, length);
+            if (memchr(word, '*', length))
+            {
+                return false;
+            }
+            if (p == firstWildcard)
+            {
+                return true;
+            }
+            // all wildcards have to match the same word as the first one
+            words.getWord(i - (p - firstWildcard), other, otherLength);
+            return length == otherLength && strncmp(word, other, length) == 0;
+    }
+    return false;
+}
@@ -0,0 +1,83 @@
+/*
+ * TennisPattern.h
+ *
+ *  Message set patterns of Morse Tennis, compiled once and matched word by word.
+ */
+
+#ifndef TENNISPATTERN_H_
+#define TENNISPATTERN_H_
+
+#include "arduino.h"
+#include "WordBuffer.h"
+
+/// A pattern is a list of words: literal words, the placeholders $dx, $us and $challenge (slots, filled in
+/// when matching), and the wildcard # for any word - all # of a pattern have to be the same word.
+///
+/// Compiling resolves placeholders to slot numbers and interns the literal words, so that each received or keyed
+/// word is compared only once with the literals. Matching works like a shift-and automaton: bit n of the
+/// state is set if the last n words match the first n words of the pattern. Every new word advances all these
+/// partial matches at once; the pattern matches when bit "length" is set, i.e. the buffer ends with the pattern.
+/// The longest partial match tells how far the user has got with the message.
+
+class TennisPattern
+{
+    public:
+        enum Slot
+        {
+            SLOT_DX, SLOT_US, SLOT_CHALLENGE, SLOTS
+        };
+
+        struct Slots
+        {
+                const char *value[SLOTS];
+        };
+
+        static const uint8_t MAX_LENGTH = 64;
+        static const uint8_t MAX_TOKENS = 15;          /// the state has one bit for each token, plus one
+        static const uint8_t NONE = 0xff;
+
+        TennisPattern();
+        TennisPattern(const char *pattern);
+        boolean compile(const char *pattern);
+        boolean isValid();
+        void reset();
+        boolean advance(WordBuffer &words, const Slots &slots);
+        boolean matches(WordBuffer &words, const Slots &slots);
+        boolean isMatched();
+        uint8_t getProgress();
+        uint8_t getLength();
+        String getMatch(WordBuffer &words);
+        String getFullMatch(WordBuffer &words);
+
+    private:
+        enum Kind
+        {
+            LITERAL, SLOT, WILDCARD
+        };
+
+        struct Token
+        {
+                uint8_t kind;
+                uint8_t value;                          /// literal word or slot number
+        };
+
+        char text[MAX_LENGTH + 1];
+        uint8_t literalStart[MAX_TOKENS];
+        uint8_t literalLength[MAX_TOKENS];
+        uint8_t literals;
+        Token tokens[MAX_TOKENS];
+        uint8_t count;
+        uint8_t firstWildcard;
+        boolean valid;
+
+        uint16_t state;
+        unsigned int generation;                        /// of the word buffer advance() has been reading
+        unsigned int next;                              /// the next word advance() has to read
+
+        uint8_t intern(const char *word, uint8_t length);
+        uint8_t lookup(const char *word, unsigned int length);
+        uint16_t step(uint16_t state, WordBuffer &words, unsigned int i, const Slots &slots);
+        boolean accepts(uint8_t p, uint8_t literal, WordBuffer &words, unsigned int i, const Slots &slots);
+};
+
+#endif /* TENNISPATTERN_H_ */
@@ -0,0 +1,126 @@
+/******************************************************************************************************************************
+ *  morse_3 Software for the Morserino-32 multi-functional Morse code machine, based on the Heltec WiFi LORA (ESP32) module ***
+ *  Copyright (C) 2018  Willi Kraml, OE1WKL                                                                                 ***
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this program.
+ *  If not, see <https://www.gnu.org/licenses/>.
+ *****************************************************************************************************************************/
+#include "TouchFilter.h"
+
+TouchFilter::TouchFilter()
+{
+    begin(0);
+}
+
+/// begin starts over with the average reading of the untouched pad
+void TouchFilter::begin(uint16_t untouched)
+{
+    previous[0] = previous[1] = untouched;
+    baseline16 = untouched * 16;
+    touched16 = 0;
+    touched = false;
+    agree = 0;
+    idleSum = idleCount = 0;
+    touchSum = touchCount = 0;
+    setThreshold();
+}
+
+/// update processes one sample and returns the debounced state
+boolean TouchFilter::update(uint16_t raw)
+{
+    if (raw == 0)
+    {
+        return touched;
+    }
+
+    uint16_t lo = previous[0] < previous[1] ? previous[0] : previous[1];
+    uint16_t hi = previous[0] < previous[1] ? previous[1] : previous[0];
+    uint16_t median = raw < lo ? lo : (raw > hi ? hi : raw);
+    previous[0] = previous[1];
+    previous[1] = raw;
+
+    boolean want = median < (touched ? release : threshold);
+    if (want != touched)
+    {
+        if (++agree >= DEBOUNCE)
+        {
+            touched = want;
+            agree = 0;
+        }
+    }
+    else
+    {
+        agree = 0;
+    }
+
+    if (touched && want)
+    {
+        if (touchCount < 0xffff)
+        {
+            touchSum += median;
+            ++touchCount;
+        }
+    }
+    else if (!touched && !want)
+    {
+        if (idleCount < 0xffff)
+        {
+            idleSum += median;
+            ++idleCount;
+        }
+    }
+    return touched;
+}
+
+boolean TouchFilter::isTouched()
+{
+    return touched;
+}
+
+/// calibrate moves baseline and touched level by an eighth towards what has been seen since the last call
+void TouchFilter::calibrate()
+{
+    if (idleCount >= 8)
+    {
+        uint16_t mean16 = idleSum * 16 / idleCount;
+        baseline16 = (7 * (uint32_t) baseline16 + mean16) / 8;
+    }
+    if (touchCount >= 4)
+    {
+        uint16_t mean16 = touchSum * 16 / touchCount;
+        touched16 = touched16 ? (7 * (uint32_t) touched16 + mean16) / 8 : mean16;
+    }
+    idleSum = idleCount = 0;
+    touchSum = touchCount = 0;
+    setThreshold();
+}
+
+uint16_t TouchFilter::getBaseline()
+{
+    return baseline16 / 16;
+}
+
+uint16_t TouchFilter::getThreshold()
+{
+    return threshold;
+}
+
+void TouchFilter::setThreshold()
+{
+    uint16_t baseline = baseline16 / 16;
+    uint16_t margin = baseline / MARGIN > 2 ? baseline / MARGIN : 2;
+    uint16_t highest = baseline > margin ? baseline - margin : 0;
+
+    threshold = highest;
+    if (touched16 && (2 * baseline16 + touched16) / 48 < highest)
+    {
+        threshold = (2 * baseline16 + touched16) / 48;
+    }
+    release = threshold + (baseline - threshold) / 2;
+}
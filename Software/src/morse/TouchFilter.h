@@ -0,0 +1,57 @@
+/*
+ * TouchFilter.h
+ *
+ *  Debouncing and calibration of one capacitive touch paddle.
+ */
+
+#ifndef TOUCHFILTER_H_
+#define TOUCHFILTER_H_
+
+#include "arduino.h"
+
+/// The touch peripheral measures the pads by itself; every sample of a pad is passed to update(), which
+/// only does what has to be done for every sample, in constant time:
+///  - readings of 0 are ignored (the peripheral returns them now and then),
+///  - the median of the last three readings is used, so a single spike (from the PWM audio or the LoRa
+///    transmitter) is not seen at all,
+///  - the pad counts as touched below the threshold, and as released only halfway back to the baseline,
+///  - and the state changes only after DEBOUNCE samples in a row have agreed.
+///
+/// A touch lowers the reading. calibrate() is called now and then (not for every sample) and adapts the
+/// threshold from what update() has collected since: the untouched level (baseline) follows the readings
+/// while the pad is not touched, the touched level follows the readings while it is; the threshold is a
+/// third of the way from the baseline to the touched level (light touches should count, too), but never
+/// closer to the baseline than an MARGIN-th of it.
+
+class TouchFilter
+{
+    public:
+        static const uint8_t DEBOUNCE = 3;
+        static const uint8_t MARGIN = 8;            /// threshold is at least baseline / MARGIN below the baseline
+
+        TouchFilter();
+        void begin(uint16_t untouched);
+        boolean update(uint16_t raw);
+        boolean isTouched();
+        void calibrate();
+        uint16_t getBaseline();
+        uint16_t getThreshold();
+
+    private:
+        uint16_t previous[2];
+        uint16_t baseline16;                        /// scaled by 16
+        uint16_t touched16;                         /// scaled by 16, 0 while we have not seen a touch
+        uint16_t threshold;
+        uint16_t release;
+        boolean touched;
+        uint8_t agree;
+
+        uint32_t idleSum;
+        uint16_t idleCount;
+        uint32_t touchSum;
+        uint16_t touchCount;
+
+        void setThreshold();
+};
+
+#endif /* TOUCHFILTER_H_ */
@@ -0,0 +1,222 @@
+/******************************************************************************************************************************
+ *  morse_3 Software for the Morserino-32 multi-functional Morse code machine, based on the Heltec WiFi LORA (ESP32) module ***
+ *  Copyright (C) 2018  Willi Kraml, OE1WKL                                                                                 ***
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this program.
+ *  If not, see <https://www.gnu.org/licenses/>.
+ *****************************************************************************************************************************/
+
+#ifndef ESP_PLATFORM
+
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <chrono>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "UdpRadio.h"
+
+/// every datagram starts with this header; the rest is the packet as it would be sent over the air
+struct DatagramHeader
+{
+        char magic[4];
+        uint32_t sender;
+        int32_t frequency;
+        uint8_t syncWord;
+} __attribute__((packed));
+
+static const char MAGIC[4] = { 'M', '3', '2', 'L' };
+
+UdpRadio::UdpRadio() : UdpRadio(Config())
+{
+}
+
+UdpRadio::UdpRadio(Config c) : config(c)
+{
+    static uint32_t instances = 0;
+    id = ((uint32_t) getpid() << 8) ^ ++instances;
+    seed = c.seed ^ id;
+}
+
+UdpRadio::~UdpRadio()
+{
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+}
+
+/// begin joins the multicast group on the loopback interface; returns false if the host does not support this
+boolean UdpRadio::begin(long f)
+{
+    frequency = f;
+    if (fd >= 0)
+    {
+        return true;
+    }
+
+    fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    int one = 1;
+    unsigned char loop = 1;
+    struct in_addr loopback;
+    struct ip_mreq membership;
+    struct sockaddr_in address;
+
+    loopback.s_addr = htonl(INADDR_LOOPBACK);
+    membership.imr_multiaddr.s_addr = inet_addr(config.group);
+    membership.imr_interface = loopback;
+
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(config.port);
+
+    boolean ok = setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) == 0;
+#ifdef SO_REUSEPORT
+    ok = ok && setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) == 0;
+#endif
+    ok = ok && bind(fd, (struct sockaddr*) &address, sizeof(address)) == 0;
+    ok = ok && setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) == 0;
+    ok = ok && setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, &loopback, sizeof(loopback)) == 0;
+    ok = ok && setsockopt(fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop)) == 0;
+    ok = ok && fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK) == 0;
+
+    if (!ok)
+    {
+        close(fd);
+        fd = -1;
+    }
+    return ok;
+}
+
+void UdpRadio::setSyncWord(uint8_t s)
+{
+    syncWord = s;
+}
+
+void UdpRadio::send(const uint8_t *data, uint8_t length)
+{
+    if (fd < 0)
+    {
+        return;
+    }
+
+    uint8_t datagram[sizeof(DatagramHeader) + 255];
+    DatagramHeader *header = (DatagramHeader*) datagram;
+    memcpy(header->magic, MAGIC, sizeof(MAGIC));
+    header->sender = id;
+    header->frequency = frequency;
+    header->syncWord = syncWord;
+    memcpy(datagram + sizeof(DatagramHeader), data, length);
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = inet_addr(config.group);
+    address.sin_port = htons(config.port);
+
+    /// like the transceiver, we are not receiving while we send
+    mode = IDLE;
+    if (sendto(fd, datagram, sizeof(DatagramHeader) + length, 0, (struct sockaddr*) &address, sizeof(address)) > 0)
+    {
+        ++stats.sent;
+    }
+}
+
+void UdpRadio::receive()
+{
+    mode = RECEIVE;
+}
+
+void UdpRadio::idle()
+{
+    mode = IDLE;
+}
+
+void UdpRadio::sleep()
+{
+    mode = SLEEP;
+}
+
+/// poll fetches everything that has been sent on our channel and delivers the packets that are due
+void UdpRadio::poll()
+{
+    if (fd < 0)
+    {
+        return;
+    }
+
+    uint8_t datagram[sizeof(DatagramHeader) + 255];
+    ssize_t n;
+    while ((n = recv(fd, datagram, sizeof(datagram), 0)) > 0)
+    {
+        DatagramHeader *header = (DatagramHeader*) datagram;
+        size_t length = n - sizeof(DatagramHeader);
+        if (n < (ssize_t) sizeof(DatagramHeader) || memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 || header->sender == id
+                || header->frequency != frequency || header->syncWord != syncWord || mode != RECEIVE)
+        {   // not for us, or we are not listening
+            continue;
+        }
+        if (length > MAX_PACKET || nextRandom() % 100 < config.lossPercent)
+        {
+            ++stats.lost;
+            continue;
+        }
+
+        Pending p;
+        p.due = now() + config.delay + (config.jitter ? nextRandom() % (config.jitter + 1) : 0);
+        if (p.due < lastDue)
+        {   // packets do not overtake each other on the air
+            p.due = lastDue;
+        }
+        lastDue = p.due;
+        p.rssi = config.rssi + (config.rssiSpread ? (int) (nextRandom() % (2 * config.rssiSpread + 1)) - config.rssiSpread : 0);
+        p.length = length;
+        memcpy(p.data, datagram + sizeof(DatagramHeader), length);
+        pending.push_back(p);
+    }
+
+    unsigned long t = now();
+    while (!pending.empty() && pending.front().due <= t)
+    {
+        Pending p = pending.front();
+        pending.erase(pending.begin());
+        ++stats.received;
+        if (callback)
+        {
+            callback(p.data, p.length, p.rssi);
+        }
+    }
+}
+
+UdpRadio::Stats UdpRadio::getStats()
+{
+    return stats;
+}
+
+unsigned long UdpRadio::now()
+{
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+uint32_t UdpRadio::nextRandom()
+{
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 16) & 0x7fff;
+}
+
+#endif /* ESP_PLATFORM */
@@ -0,0 +1,82 @@
+/*
+ * UdpRadio.h
+ *
+ *  Simulated radio for Linux hosts: packets are exchanged via UDP multicast on the loopback interface,
+ *  so several instances (in one or in several processes) can talk to each other. Loss, delay and
+ *  RSSI can be configured.
+ */
+
+#ifndef UDPRADIO_H_
+#define UDPRADIO_H_
+
+#ifndef ESP_PLATFORM
+
+#include <vector>
+#include "Radio.h"
+
+class UdpRadio: public Radio
+{
+    public:
+        struct Config
+        {
+                const char *group = "239.255.77.32";
+                uint16_t port = 7732;
+                uint8_t lossPercent = 0;            /// packets lost on the way to this receiver
+                unsigned long delay = 0;            /// ms until a packet is delivered
+                unsigned long jitter = 0;           /// plus up to this many ms
+                int rssi = -60;
+                int rssiSpread = 0;                 /// received rssi is rssi +/- rssiSpread
+                uint32_t seed = 1;
+        };
+
+        struct Stats
+        {
+                unsigned long sent;
+                unsigned long received;
+                unsigned long lost;
+        };
+
+        UdpRadio();
+        UdpRadio(Config c);
+        ~UdpRadio();
+        boolean begin(long frequency) override;
+        void setSyncWord(uint8_t syncWord) override;
+        void send(const uint8_t *data, uint8_t length) override;
+        void receive() override;
+        void idle() override;
+        void sleep() override;
+        void poll() override;
+        Stats getStats();
+        static unsigned long now();
+
+    private:
+        enum Mode
+        {
+            SLEEP, IDLE, RECEIVE
+        };
+
+        struct Pending
+        {
+                unsigned long due;
+                int rssi;
+                uint8_t length;
+                uint8_t data[MAX_PACKET];
+        };
+
+        Config config;
+        int fd = -1;
+        uint32_t id;
+        long frequency = 0;
+        uint8_t syncWord = 0x34;
+        Mode mode = IDLE;
+        uint32_t seed;
+        unsigned long lastDue = 0;
+        std::vector<Pending> pending;
+        Stats stats = Stats();
+
+        uint32_t nextRandom();
+};
+
+#endif /* ESP_PLATFORM */
+
+#endif /* UDPRADIO_H_ */
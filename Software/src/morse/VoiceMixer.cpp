@@ -0,0 +1,314 @@
+/******************************************************************************************************************************
+ *  morse_3 Software for the Morserino-32 multi-functional Morse code machine, based on the Heltec WiFi LORA (ESP32) module ***
+ *  Copyright (C) 2018  Willi Kraml, OE1WKL                                                                                 ***
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this program.
+ *  If not, see <https://www.gnu.org/licenses/>.
+ *****************************************************************************************************************************/
+#include <string.h>
+#include "VoiceMixer.h"
+
+/// sin(x) * 32767 for x = 0 .. 90 degrees, in 64 steps
+const uint16_t VoiceMixer::QUARTER_SINE[65] =
+{
+    0, 804, 1608, 2410, 3212, 4011, 4808, 5602, 6393, 7179, 7962, 8739, 9512, 10278, 11039, 11793,
+    12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530, 18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+    23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790, 27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+    30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971, 32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+    32767
+};
+
+/// (1 - cos(x)) / 2 * 256 for x = 0 .. 180 degrees, in RAMP steps: the attack (and backwards the decay)
+const uint16_t VoiceMixer::RAISED_COSINE[RAMP + 1] =
+{
+    0, 1, 2, 6, 10, 15, 22, 29, 37, 47, 57, 68, 79, 91, 103, 115,
+    128, 141, 153, 165, 177, 188, 199, 209, 219, 227, 234, 241, 246, 250, 254, 255,
+    256
+};
+
+VoiceMixer::VoiceMixer()
+{
+    memset(voices, 0, sizeof(voices));
+    memset(pinkRows, 0, sizeof(pinkRows));
+    noiseLevel = 0;
+    pink = false;
+    noise = 2463534242UL;
+    noiseCount = 0;
+    pinkSum = 0;
+}
+
+/// send lets a voice send code (level 0 - 100), starting delayMs from now; false if the code is too long
+boolean VoiceMixer::send(uint8_t voice, const char *code, uint16_t frequency, uint8_t wpm, uint8_t level,
+        uint16_t delayMs)
+{
+    if (voice >= MAX_VOICES || strlen(code) > MAX_CODE)
+    {
+        return false;
+    }
+    Voice &v = voices[voice];
+    strcpy(v.code, code);
+    v.pos = 0;
+    v.sending = true;
+    v.keyed = false;
+    v.remaining = (uint32_t) delayMs * SAMPLE_RATE / 1000;
+    v.dit = getDitSamples(wpm);
+    v.step = getStep(frequency);
+    v.level = v.gain = (level > 100 ? 100 : level) * 256 / 100;
+    return true;
+}
+
+/// key keys a voice, or releases it (level 0); it ramps up or decays from where it is
+void VoiceMixer::key(uint8_t voice, uint16_t frequency, uint8_t level)
+{
+    if (voice >= MAX_VOICES)
+    {
+        return;
+    }
+    Voice &v = voices[voice];
+    v.sending = false;
+    v.keyed = level > 0;
+    if (level)
+    {
+        v.step = getStep(frequency);
+        v.level = v.gain = (level > 100 ? 100 : level) * 256 / 100;
+    }
+}
+
+/// setTone sounds a voice at a level (0 - 100; 0 is off) until it is set again; the caller does the ramps
+void VoiceMixer::setTone(uint8_t voice, uint16_t frequency, uint8_t level)
+{
+    if (voice >= MAX_VOICES)
+    {
+        return;
+    }
+    Voice &v = voices[voice];
+    v.sending = false;
+    v.keyed = level > 0;
+    v.envelope = level > 0 ? RAMP : 0;
+    v.step = getStep(frequency);
+    v.level = v.gain = (level > 100 ? 100 : level) * 256 / 100;
+}
+
+/// setFading lets the level of a voice go down by depth percent and up again, once in periodMs (0: no fading)
+void VoiceMixer::setFading(uint8_t voice, uint8_t depth, uint16_t periodMs)
+{
+    if (voice >= MAX_VOICES)
+    {
+        return;
+    }
+    Voice &v = voices[voice];
+    v.fadeDepth = periodMs ? (depth > 100 ? 100 : depth) * 256 / 100 : 0;
+    v.fadePhase = 1UL << 30;                        // starts at the top
+    v.fadeStep = periodMs ? ((uint64_t) BLOCK * 1000 << 32) / ((uint32_t) periodMs * SAMPLE_RATE) : 0;
+    v.gain = v.level;
+}
+
+/// setNoise adds white or pink (-3 dB per octave) noise to the mix, level 0 - 100 (0: none)
+void VoiceMixer::setNoise(uint8_t level, boolean p)
+{
+    noiseLevel = (level > 100 ? 100 : level) * 256 / 100;
+    pink = p;
+}
+
+/// stop ends what a voice sends; a mark that is on decays
+void VoiceMixer::stop(uint8_t voice)
+{
+    if (voice < MAX_VOICES)
+    {
+        voices[voice].sending = false;
+        voices[voice].keyed = false;
+    }
+}
+
+void VoiceMixer::stopAll()
+{
+    for (uint8_t i = 0; i < MAX_VOICES; ++i)
+    {
+        stop(i);
+    }
+}
+
+boolean VoiceMixer::isSending(uint8_t voice)
+{
+    return voice < MAX_VOICES && voices[voice].sending;
+}
+
+/// isBusy is true as long as render() makes a sound, or will make one
+boolean VoiceMixer::isBusy()
+{
+    if (noiseLevel)
+    {
+        return true;
+    }
+    for (uint8_t i = 0; i < MAX_VOICES; ++i)
+    {
+        if (voices[i].sending || voices[i].keyed || voices[i].envelope)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// render puts the next n samples into out; the voices are added up in blocks, each voice in a loop of its own
+void VoiceMixer::render(int16_t *out, uint16_t n)
+{
+    int32_t mix[BLOCK];
+
+    while (n)
+    {
+        uint16_t k = n < BLOCK ? n : BLOCK;
+
+        memset(mix, 0, sizeof(mix));
+        for (uint8_t i = 0; i < MAX_VOICES; ++i)
+        {
+            Voice &v = voices[i];
+            if (!v.sending && !v.keyed && !v.envelope)
+            {
+                continue;
+            }
+            fade(v);
+            for (uint16_t s = 0; s < k; ++s)
+            {
+                if (v.sending)
+                {
+                    while (v.sending && !v.remaining)
+                    {
+                        next(v);
+                    }
+                    if (v.remaining)
+                    {
+                        --v.remaining;
+                    }
+                }
+                if (v.keyed)
+                {
+                    v.envelope += v.envelope < RAMP;
+                }
+                else if (v.envelope)
+                {
+                    --v.envelope;
+                }
+                if (v.envelope)
+                {
+                    mix[s] += (sine(v.phase) * (int32_t) (v.gain * RAISED_COSINE[v.envelope])) >> 16;
+                }
+                v.phase += v.step;
+            }
+        }
+        if (noiseLevel)
+        {
+            addNoise(mix, k);
+        }
+        for (uint16_t s = 0; s < k; ++s)
+        {
+            *out++ = mix[s] > 32767 ? 32767 : mix[s] < -32768 ? -32768 : mix[s];
+        }
+        n -= k;
+    }
+}
+
+/// toDuty is the duty cycle of a PWM with a resolution of bits for a sample; silence is half of the full range
+uint16_t VoiceMixer::toDuty(int16_t sample, uint8_t bits)
+{
+    return ((int32_t) sample + 32768) >> (16 - bits);
+}
+
+/// getDitSamples is the length of a dit in samples: 1200 ms / wpm
+uint16_t VoiceMixer::getDitSamples(uint8_t wpm)
+{
+    return (uint32_t) SAMPLE_RATE * 6 / 5 / (wpm ? wpm : 1);
+}
+
+/// next starts the next element (or the space after a mark), or ends the code
+void VoiceMixer::next(Voice &v)
+{
+    if (v.keyed)
+    {
+        v.keyed = false;
+        v.remaining = v.dit;                        // the space inside the character
+        return;
+    }
+    switch (v.code[v.pos])
+    {
+        case 0:
+            v.sending = false;
+            return;
+        case '1':
+            v.keyed = true;
+            v.remaining = v.dit;
+            break;
+        case '2':
+            v.keyed = true;
+            v.remaining = 3 * v.dit;
+            break;
+        case ' ':
+            v.remaining = 2 * v.dit;                // with the space after the last element: 3 dits
+            break;
+        case '/':
+            v.remaining = 6 * v.dit;                // 7 dits
+            break;
+        default:
+            v.remaining = 0;
+            break;
+    }
+    ++v.pos;
+}
+
+/// fade sets the gain of a voice for the next block
+void VoiceMixer::fade(Voice &v)
+{
+    if (!v.fadeDepth)
+    {
+        v.gain = v.level;
+        return;
+    }
+    int32_t s = sine(v.fadePhase);
+    uint16_t g = 256 - ((v.fadeDepth * (uint32_t) (32767 - s)) >> 16);
+    v.gain = (v.level * g) >> 8;
+    v.fadePhase += v.fadeStep;
+}
+
+/// addNoise: white noise from a xorshift generator; pink noise the Voss-McCartney way - PINK_ROWS rows of white noise,
+/// row i is renewed every 2^(i + 1) samples, and their sum with a white sample is the pink one
+void VoiceMixer::addNoise(int32_t *mix, uint16_t n)
+{
+    for (uint16_t s = 0; s < n; ++s)
+    {
+        noise ^= noise << 13;
+        noise ^= noise >> 17;
+        noise ^= noise << 5;
+        int32_t w = (int16_t) (noise >> 16);
+        if (pink)
+        {
+            uint8_t row = __builtin_ctz(++noiseCount);
+            if (row < PINK_ROWS)
+            {
+                pinkSum += (w >> 2) - pinkRows[row];
+                pinkRows[row] = w >> 2;
+            }
+            w = pinkSum + (w >> 2);                 // about as loud as the white noise
+        }
+        mix[s] += (w * noiseLevel) >> 8;
+    }
+}
+
+uint32_t VoiceMixer::getStep(uint16_t frequency)
+{
+    return ((uint64_t) frequency << 32) / SAMPLE_RATE;
+}
+
+/// sine of the phase (a full turn is 2^32), from the quarter wave
+int16_t VoiceMixer::sine(uint32_t phase)
+{
+    uint8_t i = phase >> 24;
+    uint8_t k = i & 63;
+    int16_t s = QUARTER_SINE[i & 64 ? 64 - k : k];
+    return i & 128 ? -s : s;
+}
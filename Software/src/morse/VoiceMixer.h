@@ -0,0 +1,89 @@
+/*
+ * VoiceMixer.h
+ *
+ *  Mixes several CW signals - each with its own pitch, speed, level, start and fading - and noise into one stream of
+ *  samples.
+ */
+
+#ifndef VOICEMIXER_H_
+#define VOICEMIXER_H_
+
+#include "arduino.h"
+
+/// Each voice is a sine oscillator (a phase accumulator and a quarter wave table) with an envelope. A voice either
+/// sends code - send() takes the elements of the characters as in MorseText ('1' dit, '2' dah), ' ' between the
+/// characters and '/' between the words, and keys itself, starting delayMs later - or it is keyed from outside: key()
+/// keys it with its ramps (that is how the sidetone gets into the mix), setTone() sounds it at once, without them.
+///
+/// A keyed voice ramps up and down in RAMP samples (4 ms) along a raised cosine, so its spectrum ends a few hundred Hz
+/// around the pitch and it does not click; the ramps take the time of the element they start. A voice can fade in and
+/// out (QSB, setFading()), and there can be white or pink noise below the voices (setNoise()). render() adds it all up
+/// into 16 bit samples, and clips them: the levels should add up to 100 or less to stay clean. toDuty() turns a
+/// sample into the duty cycle of a PWM with a carrier well above the audio frequencies, so the speaker and the line
+/// out act as the low pass.
+///
+/// All in integers, with the phase and the timing in samples, so it can run from a timer and renders the same on
+/// the host, e.g. into a WAV file.
+
+class VoiceMixer
+{
+    public:
+        static const uint8_t MAX_VOICES = 8;
+        static const uint16_t SAMPLE_RATE = 8000;
+        static const uint8_t RAMP = 32;             /// samples of an attack or decay
+        static const uint8_t MAX_CODE = 96;
+        static const uint8_t BLOCK = 32;            /// samples rendered at once; the fading changes once per block
+
+        VoiceMixer();
+        boolean send(uint8_t voice, const char *code, uint16_t frequency, uint8_t wpm, uint8_t level, uint16_t delayMs);
+        void key(uint8_t voice, uint16_t frequency, uint8_t level);
+        void setTone(uint8_t voice, uint16_t frequency, uint8_t level);
+        void setFading(uint8_t voice, uint8_t depth, uint16_t periodMs);
+        void setNoise(uint8_t level, boolean pink);
+        void stop(uint8_t voice);
+        void stopAll();
+        boolean isSending(uint8_t voice);
+        boolean isBusy();
+        void render(int16_t *out, uint16_t n);
+        static uint16_t toDuty(int16_t sample, uint8_t bits);
+        static uint16_t getDitSamples(uint8_t wpm);
+
+    private:
+        static const uint16_t QUARTER_SINE[65];
+        static const uint16_t RAISED_COSINE[RAMP + 1];
+        static const uint8_t PINK_ROWS = 8;
+
+        struct Voice
+        {
+                char code[MAX_CODE + 1];
+                uint8_t pos;                        // of the next element in code
+                boolean sending;
+                boolean keyed;
+                uint32_t remaining;                 // samples until the next element (or the end of the delay)
+                uint16_t dit;                       // samples
+                uint32_t phase;
+                uint32_t step;
+                uint16_t level;                     // 0 - 256
+                uint16_t gain;                      // the level, faded; 0 - 256
+                uint8_t envelope;                   // 0 - RAMP
+                uint16_t fadeDepth;                 // 0 - 256
+                uint32_t fadePhase;
+                uint32_t fadeStep;                  // per block
+        };
+
+        Voice voices[MAX_VOICES];
+        uint16_t noiseLevel;                        // 0 - 256
+        boolean pink;
+        uint32_t noise;                             // state of the xorshift generator
+        uint32_t noiseCount;
+        int16_t pinkRows[PINK_ROWS];
+        int32_t pinkSum;
+
+        void next(Voice &v);
+        void fade(Voice &v);
+        void addNoise(int32_t *mix, uint16_t n);
+        static uint32_t getStep(uint16_t frequency);
+        static int16_t sine(uint32_t phase);
+};
+
+#endif /* VOICEMIXER_H_ */
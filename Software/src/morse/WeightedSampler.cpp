@@ -0,0 +1,103 @@
+/******************************************************************************************************************************
+ *  morse_3 Software for the Morserino-32 multi-functional Morse code machine, based on the Heltec WiFi LORA (ESP32) module ***
+ *  Copyright (C) 2018  Willi Kraml, OE1WKL                                                                                 ***
+ *
+ *  This program is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+ *  of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with this program.
+ *  If not, see <https://www.gnu.org/licenses/>.
+ *****************************************************************************************************************************/
+#include "WeightedSampler.h"
+
+WeightedSampler::WeightedSampler()
+{
+    clear(0);
+}
+
+/// clear makes n items of weight 0
+void WeightedSampler::clear(uint16_t n)
+{
+    size = n < CAPACITY ? n : CAPACITY;
+    for (int i = 0; i <= CAPACITY; ++i)
+    {
+        tree[i] = 0;
+    }
+    for (int i = 0; i < CAPACITY; ++i)
+    {
+        weights[i] = 0;
+    }
+    for (top = 1; top * 2 <= size; top *= 2)
+    {
+        ;
+    }
+}
+
+/// build sets the weights of n items: each node adds itself to its parent, so this is O(n)
+void WeightedSampler::build(const uint16_t *w, uint16_t n)
+{
+    clear(n);
+    for (int i = 1; i <= size; ++i)
+    {
+        weights[i - 1] = w[i - 1];
+        tree[i] += w[i - 1];
+        int parent = i + (i & -i);
+        if (parent <= size)
+        {
+            tree[parent] += tree[i];
+        }
+    }
+}
+
+void WeightedSampler::set(uint16_t i, uint16_t weight)
+{
+    if (i >= size)
+    {
+        return;
+    }
+    int32_t delta = (int32_t) weight - weights[i];
+    weights[i] = weight;
+    for (int k = i + 1; k <= size; k += k & -k)
+    {
+        tree[k] += delta;
+    }
+}
+
+uint16_t WeightedSampler::get(uint16_t i)
+{
+    return i < size ? weights[i] : 0;
+}
+
+uint16_t WeightedSampler::getSize()
+{
+    return size;
+}
+
+uint32_t WeightedSampler::getTotal()
+{
+    uint32_t total = 0;
+    for (int k = size; k > 0; k -= k & -k)
+    {
+        total += tree[k];
+    }
+    return total;
+}
+
+/// pick returns the item i with sum(weights[0 .. i-1]) <= r < sum(weights[0 .. i]); items of weight 0 are never picked
+uint16_t WeightedSampler::pick(uint32_t r)
+{
+    uint16_t i = 0;
+
+    for (uint16_t step = top; step > 0; step /= 2)
+    {
+        if (i + step <= size && tree[i + step] <= r)
+        {
+            i += step;
+            r -= tree[i];
+        }
+    }
+    return i < size ? i : (size ? size - 1 : 0);
+}
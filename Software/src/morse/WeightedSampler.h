@@ -0,0 +1,40 @@
+/*
+ * WeightedSampler.h
+ *
+ *  Picks items at random, each with a probability proportional to its weight; weights can change at any time.
+ */
+
+#ifndef WEIGHTEDSAMPLER_H_
+#define WEIGHTEDSAMPLER_H_
+
+#include "arduino.h"
+
+/// The weights are kept in a Fenwick tree (binary indexed tree): every node holds the sum of a range of weights whose
+/// length is the lowest set bit of its index. set() changes one weight and the O(log n) sums that contain it; pick()
+/// walks down from the largest power of two and finds the item where the running sum passes r, also in O(log n).
+/// build() sets all weights at once in O(n).
+///
+/// pick() takes the random number from the caller, r in [0, getTotal()), so tests can choose it.
+
+class WeightedSampler
+{
+    public:
+        static const uint16_t CAPACITY = 256;
+
+        WeightedSampler();
+        void build(const uint16_t *weights, uint16_t n);
+        void clear(uint16_t n);
+        void set(uint16_t i, uint16_t weight);
+        uint16_t get(uint16_t i);
+        uint16_t getSize();
+        uint32_t getTotal();
+        uint16_t pick(uint32_t r);
+
+    private:
+        uint32_t tree[CAPACITY + 1];            // 1-based
+        uint16_t weights[CAPACITY];
+        uint16_t size;
+        uint16_t top;                           // the largest power of two <= size
+};
+
+#endif /* WEIGHTEDSAMPLER_H_ */
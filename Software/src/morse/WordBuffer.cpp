@@ -11,6 +11,7 @@
  *  You should have received a copy of the GNU General Public License along with this program.
  *  If not, see <https://www.gnu.org/licenses/>.
  *****************************************************************************************************************************/
+#include <string.h>
 #include "WordBuffer.h"
 
 WordBuffer::WordBuffer()
@@ -20,13 +21,13 @@ WordBuffer::WordBuffer()
 
 WordBuffer::WordBuffer(const char* initial)
 {
-    buffer += initial;
+    append(initial);
     endWord();
 }
 
 WordBuffer::WordBuffer(String initial)
 {
-    buffer += initial;
+    append(initial.c_str());
     endWord();
 }
 
@@ -34,7 +35,7 @@ void WordBuffer::handleWordEnd()
 {
     if (wordEnd)
     {
-        buffer += " ";
+        append(" ");
         wordEnd = false;
     }
 }
@@ -42,14 +43,14 @@ void WordBuffer::handleWordEnd()
 void WordBuffer::addWord(String word)
 {
     handleWordEnd();
-    buffer += word;
+    append(word.c_str());
     endWord();
 }
 
 void WordBuffer::addChar(String c)
 {
     handleWordEnd();
-    buffer += c;
+    append(c.c_str());
 }
 
 void WordBuffer::endWord()
@@ -62,6 +63,9 @@ String WordBuffer::getAndClear()
     String tmp = buffer;
     buffer = "";
     wordEnd = false;
+    tokenCount = 0;
+    inToken = false;
+    ++generation;
     return tmp;
 }
 
@@ -70,17 +74,87 @@ String WordBuffer::get()
     return buffer;
 }
 
-String* split(String s)
+/// append adds s to the buffer and keeps track of where its words start and end
+void WordBuffer::append(const char *s)
 {
-    int i = s.lastIndexOf(' ');
-    if (i == -1)
+    unsigned int pos = buffer.length();
+    buffer += s;
+
+    for (; *s; ++s, ++pos)
     {
-        return new String[2]{"", s};
+        if (*s == ' ')
+        {
+            inToken = false;
+        }
+        else if (inToken)
+        {
+            ++tokens[(tokenCount - 1) % MAX_TOKENS].length;
+        }
+        else
+        {
+            Token &t = tokens[tokenCount++ % MAX_TOKENS];
+            t.start = pos;
+            t.length = 1;
+            inToken = true;
+        }
     }
-    String token = s.substring(i + 1);
-    String rest = s.substring(0, i);
-    String *r = new String[2]{rest, token};
-    return r;
+}
+
+/// token returns the i-th word, counted from the right (0 = most recent)
+const WordBuffer::Token& WordBuffer::token(unsigned int i)
+{
+    return tokens[(tokenCount - 1 - i) % MAX_TOKENS];
+}
+
+WordBuffer::Pattern::Pattern()
+{
+    compile("");
+}
+
+WordBuffer::Pattern::Pattern(const char *pattern)
+{
+    compile(pattern);
+}
+
+void WordBuffer::Pattern::compile(const char *pattern)
+{
+    count = 0;
+    valid = strlen(pattern) <= MAX_LENGTH;
+    if (!valid)
+    {
+        text[0] = 0;
+        return;
+    }
+    strcpy(text, pattern);
+
+    for (uint8_t i = 0; text[i]; ++i)
+    {
+        if (text[i] == ' ')
+        {
+            continue;
+        }
+        if (i == 0 || text[i - 1] == ' ')
+        {
+            if (count == MAX_TOKENS)
+            {
+                valid = false;
+                return;
+            }
+            start[count] = i;
+            length[count] = 0;
+            ++count;
+        }
+        ++length[count - 1];
+    }
+    for (uint8_t i = 0; i < count; ++i)
+    {
+        wildcard[i] = length[i] == 1 && text[start[i]] == '#';
+    }
+}
+
+boolean WordBuffer::Pattern::isValid() const
+{
+    return valid;
 }
 
 /*
@@ -93,72 +167,76 @@ String* split(String s)
  * Buffer contains "cq de w1aw", pattern is "cq de #", returns "w1aw".
  * Buffer contains "cq de w1aw w1aw", pattern is cq de # #", returns "w1aw".
  * Buffer contains "cq de w1aw w1aa", pattern is cq de # #", returns "".
+ *
+ * Words of buffer and pattern are compared in place, so matching does not allocate memory;
+ * only a successful match copies the results.
  */
-boolean WordBuffer::matches(String pattern)
+boolean WordBuffer::matches(const Pattern &pattern)
 {
-    String tmppat = pattern;
-    String tmpbuf = buffer;
-    String wildcardContent = "";
-    do
+    if (!pattern.valid)
     {
-        String *p = split(tmppat);
-        String *b = split(tmpbuf);
-        if (p[1] == "#")
+        return false;
+    }
+    if (pattern.count == 0)
+    {   // the empty pattern matches the empty buffer only
+        if (tokenCount)
         {
-            String wcc = b[1];
+            return false;
+        }
+        match = "";
+        fullPatternMatch = "";
+        return true;
+    }
+    if (pattern.count > tokenCount)
+    {
+        return false;
+    }
 
-            if (!textOK(wcc)) {
+    const char *text = buffer.c_str();
+    const Token *wildcardContent = 0;
+    for (uint8_t i = 0; i < pattern.count; ++i)
+    {
+        const Token &b = token(i);
+        uint8_t p = pattern.count - 1 - i;
+        if (pattern.wildcard[p])
+        {
+            if (memchr(text + b.start, '*', b.length))
+            {
                 return false;
             }
-
-            if (wildcardContent == "")
+            if (!wildcardContent)
             {
-                wildcardContent = wcc;
+                wildcardContent = &b;
             }
-            else if (wcc != wildcardContent)
+            else if (b.length != wildcardContent->length
+                    || strncmp(text + b.start, text + wildcardContent->start, b.length) != 0)
             {
                 // Repeat wildcard mismatch
                 return false;
             }
         }
-        else if (p[1] != b[1])
+        else if (b.length != pattern.length[p] || strncmp(text + b.start, pattern.text + pattern.start[p], b.length) != 0)
         {
             // word mismatch
             return false;
         }
-        tmppat = *p;
-        tmpbuf = *b;
     }
-    while ((tmppat != "") && (tmpbuf != ""));
 
-    if ((tmppat != "") && (tmpbuf == ""))
-    {
-        wildcardContent = "";
-        return false;
-    }
-    else
-    {
-        match = wildcardContent;
-        fullPatternMatch = trim(buffer.substring(tmpbuf.length()));
-        return true;
-    }
+    match = wildcardContent ? buffer.substring(wildcardContent->start, wildcardContent->start + wildcardContent->length) : String("");
+    unsigned int first = token(pattern.count - 1).start;
+    fullPatternMatch = buffer.substring(first, token(0).start + token(0).length);
+    return true;
 }
 
-boolean WordBuffer::textOK(String s) {
-    int i = s.indexOf('*');
-    return (i == -1);
+boolean WordBuffer::matches(const char *pattern)
+{
+    Pattern p(pattern);
+    return matches(p);
 }
 
-String WordBuffer::trim(String in) {
-    String out = in;
-    while ((out.length() != 0) && (out.substring(0, 1) == " ")) {
-        out = out.substring(1);
-    }
-    unsigned int l = out.length();
-    while (((l = out.length()) != 0) && (out.substring(l-1, l) == " ")) {
-        out = out.substring(0, l-1);
-    }
-    return out;
+boolean WordBuffer::matches(String pattern)
+{
+    return matches(pattern.c_str());
 }
 
 String WordBuffer::getMatch()
@@ -175,3 +253,40 @@ boolean WordBuffer::operator==(String other)
 {
     return buffer == other;
 }
+
+/// getWordCount returns the number of words added since the buffer was cleared
+unsigned int WordBuffer::getWordCount()
+{
+    return tokenCount;
+}
+
+/// getWord points text to the i-th word since the buffer was cleared (counted from 0); the text is not terminated
+/// after the word and stays valid until the buffer changes. Only the most recent MAX_TOKENS words are available.
+boolean WordBuffer::getWord(unsigned int i, const char *&text, unsigned int &length)
+{
+    if (i >= tokenCount || tokenCount - i > MAX_TOKENS)
+    {
+        return false;
+    }
+    const Token &t = token(tokenCount - 1 - i);
+    text = buffer.c_str() + t.start;
+    length = t.length;
+    return true;
+}
+
+/// getWords returns the words from ... to (exclusive) as they are in the buffer
+String WordBuffer::getWords(unsigned int from, unsigned int to)
+{
+    if (from >= to || to > tokenCount || tokenCount - from > MAX_TOKENS)
+    {
+        return String("");
+    }
+    const Token &last = token(tokenCount - to);
+    return buffer.substring(token(tokenCount - 1 - from).start, last.start + last.length);
+}
+
+/// getGeneration changes whenever the buffer is cleared, so a reader can tell that the words it has seen are gone
+unsigned int WordBuffer::getGeneration()
+{
+    return generation;
+}
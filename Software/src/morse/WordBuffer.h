@@ -13,6 +13,32 @@
 class WordBuffer
 {
     public:
+        static const uint8_t MAX_TOKENS = 32;           /// words of the buffer we can match against (the most recent ones)
+
+        /// A pattern split into words once, so it can be matched again and again without any allocation.
+        /// The word # is a wildcard for "any word".
+        class Pattern
+        {
+            public:
+                static const uint8_t MAX_LENGTH = 80;
+                static const uint8_t MAX_TOKENS = 16;
+
+                Pattern();
+                Pattern(const char *pattern);
+                void compile(const char *pattern);
+                boolean isValid() const;
+
+            private:
+                friend class WordBuffer;
+
+                char text[MAX_LENGTH + 1];
+                uint8_t start[MAX_TOKENS];
+                uint8_t length[MAX_TOKENS];
+                boolean wildcard[MAX_TOKENS];
+                uint8_t count;
+                boolean valid;
+        };
+
         WordBuffer();
         WordBuffer(const char* initial);
         WordBuffer(String initial);
@@ -22,19 +48,35 @@ class WordBuffer
         void endWord();
         String getAndClear();
         String get();
+        boolean matches(const Pattern &pattern);
+        boolean matches(const char *pattern);
         boolean matches(String pattern);
         String getMatch();
         String getFullPatternMatch();
         boolean operator==(String other);
+        unsigned int getWordCount();
+        boolean getWord(unsigned int i, const char *&text, unsigned int &length);
+        String getWords(unsigned int from, unsigned int to);
+        unsigned int getGeneration();
 
     private:
+        struct Token
+        {
+                unsigned int start;
+                unsigned int length;
+        };
+
         String buffer;
         String match;
         String fullPatternMatch;
         boolean wordEnd = false;
+        Token tokens[MAX_TOKENS];                       /// ring of the most recent words in buffer
+        unsigned int tokenCount = 0;                    /// number of words added since the last clear
+        boolean inToken = false;                        /// the last word may still grow
+        unsigned int generation = 0;                    /// counts the calls of getAndClear()
         void handleWordEnd();
-        String trim(String in);
-        boolean textOK(String s);
+        void append(const char *s);
+        const Token& token(unsigned int i);
 };
 
 #endif /* WORDBUFFER_H_ */
@@ -22,6 +22,9 @@
 #include "MorseModeEchoTrainer.h"
 #include "MorseSound.h"
 #include "MorseText.h"
+#include "Profiler.h"
+#include "MorseSessionLog.h"
+#include "MorseFist.h"
 
 using namespace Decoder;
 
@@ -122,7 +125,6 @@ unsigned long Decoder::ditAvg, Decoder::dahAvg; /// average values of dit and da
 
 byte Decoder::treeptr = 0;                          // pointer used to navigate within the linked list representing the dichotomic tree
 
-unsigned long Decoder::acsTimer = 0;            // timer to use for automatic character spacing (ACS)
 boolean Decoder::speedChanged = true;
 
 unsigned long Decoder::interWordTimer = 0;      // timer to detect interword spaces
@@ -468,6 +470,7 @@ boolean internal::doDecode()
 
 boolean Decoder::doDecodeShow()
 {
+    MORSE_PROFILE("doDecodeShow");
     boolean isCoding = internal::doDecode();
     if (Decoder::speedChanged)
     {
@@ -486,6 +489,7 @@ void internal::ON_()
     MorseGenerator::keyOut(true, Decoder::internal::keyTx, MorseSound::notes[MorsePreferences::prefs.sidetoneFreq], MorsePreferences::prefs.sidetoneVolume);
 
     MorseDisplay::drawInputStatus(true);
+    MorseFist::fist.space(lowDuration);
 
     if (lowDuration < Decoder::ditAvg * 2.4)                    // if we had an inter-element pause,
         internal::recalculateDit(lowDuration);                    // use it to adjust speed
@@ -498,6 +502,7 @@ void internal::OFF_()
 
     highDuration = timeNow - startTimeHigh;
     startTimeLow = timeNow;
+    MorseSessionLog::element(highDuration, lowDuration);
 
     if (highDuration > (Decoder::ditAvg * 0.5) && highDuration < (Decoder::dahAvg * 2.5))
     {    /// filter out VERY short and VERY long highs
@@ -505,12 +510,14 @@ void internal::OFF_()
         { /// we got a dit -
             Decoder::treeptr = Decoder::CWtree[Decoder::treeptr].dit;
             internal::recalculateDit(highDuration);
+            MorseFist::fist.mark(false, highDuration);
             onDit();
         }
         else
         {        /// we got a dah
             Decoder::treeptr = Decoder::CWtree[Decoder::treeptr].dah;
             internal::recalculateDah(highDuration);
+            MorseFist::fist.mark(true, highDuration);
             onDah();
         }
     }
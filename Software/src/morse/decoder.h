@@ -50,7 +50,6 @@ namespace Decoder
 
     extern byte treeptr;                          // pointer used to navigate within the linked list representing the dichotomic tree
 
-    extern unsigned long acsTimer;            // timer to use for automatic character spacing (ACS)
     extern boolean speedChanged;
 
     extern unsigned long interWordTimer;      // timer to detect interword spaces
@@ -16,9 +16,16 @@
 #include "abbrev.h"
 #include "english_words.h"
 #include "MorseGenerator.h"
+#include "MorseSystem.h"
+#include "MorseText.h"
 
 using namespace Koch;
 
+namespace internal
+{
+    void createTables();
+}
+
 const String morserinoKochChars = "mkrsuaptlowi.njef0yv,g5/q9zh38b?427c1d6x-=K+SNAV@:";
 const String lcwoKochChars = "kmuresnaptlwi.jz=foy,vg5/q92h38b?47c1d60x-K+ASNV@:";
 
@@ -33,6 +40,12 @@ void Koch::setup()
     else
         kochChars = morserinoKochChars;
 
+    /// the word lists are only needed for generating words - build them when there is time
+    MorseSystem::boot.defer("koch", internal::createTables);
+}
+
+void internal::createTables()
+{
     //// populate the array for abbreviations and words according to length and Koch filter
     createKochWords(MorsePreferences::prefs.wordLength, MorsePreferences::prefs.kochFilter);  //
     createKochAbbr(MorsePreferences::prefs.abbrevLength, MorsePreferences::prefs.kochFilter);
@@ -104,10 +117,12 @@ void Koch::createKochWords(uint8_t maxl, uint8_t koch)
             kochWords[numberOfWords++] = EnglishWords::words[i];
         }
     }
+    MorseText::onWordListsChanged();
 }
 
 String Koch::getRandomWord()
 {
+    MorseSystem::boot.ensure(internal::createTables);
     return kochWords[random(numberOfWords)];
 }
 
@@ -127,13 +142,38 @@ void Koch::createKochAbbr(uint8_t maxl, uint8_t koch)
             kochAbbr[numberOfAbbr++] = Abbrev::abbreviations[i];
         }
     }
+    MorseText::onWordListsChanged();
 }
 
 String Koch::getRandomAbbrev()
 {
+    MorseSystem::boot.ensure(internal::createTables);
     return kochAbbr[random(numberOfAbbr)];
 }
 
+/// the Koch words and abbreviations one by one, for choosing them by weight
+uint16_t Koch::getWordCount()
+{
+    MorseSystem::boot.ensure(internal::createTables);
+    return numberOfWords;
+}
+
+const char* Koch::getWord(uint16_t i)
+{
+    return kochWords[i].c_str();
+}
+
+uint16_t Koch::getAbbrevCount()
+{
+    MorseSystem::boot.ensure(internal::createTables);
+    return numberOfAbbr;
+}
+
+const char* Koch::getAbbrev(uint16_t i)
+{
+    return kochAbbr[i].c_str();
+}
+
 String Koch::filterNonKoch(String w)
 {
     if (!isKochActive())
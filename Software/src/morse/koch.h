@@ -19,6 +19,10 @@ namespace Koch
     String getRandomChars(int maxLength);
     String getRandomWord();
     String getRandomAbbrev();
+    uint16_t getWordCount();
+    const char* getWord(uint16_t i);
+    uint16_t getAbbrevCount();
+    const char* getAbbrev(uint16_t i);
     boolean isKochActive();
     void setKochActive(boolean newActive);
     void createKochWords(uint8_t maxl, uint8_t koch);
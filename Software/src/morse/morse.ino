@@ -65,6 +65,11 @@
 #include "MorseModeTrx.h"
 #include "MorseModeKeyer.h"
 #include "MorseModeKoch.h"
+#include "MorseDiagnostics.h"
+#include "MorsePower.h"
+#include "MorseStats.h"
+#include "MorseSessionLog.h"
+#include "Profiler.h"
 
 ////////////////////////////////////////////////////////////////////
 // encoder subroutines
@@ -81,92 +86,47 @@ int IRAM_ATTR checkEncoder()
     return MorseRotaryEncoder::checkEncoder();
 }
 
-////////////////////////   S E T U P /////////////////////////////
-
-void setup()
-{
-
-    Serial.begin(115200);
-    delay(200); // give me time to bring up serial monitor
-
-    // enable Vext
-#if BOARDVERSION == 3
-    pinMode(Vext, OUTPUT);
-    digitalWrite(Vext, LOW);
-#endif
-
-    // set up the encoder - we need external pull-ups as the pins used do not have built-in pull-ups!
-    pinMode(PinCLK, INPUT_PULLUP);
-    pinMode(PinDT, INPUT_PULLUP);
-    pinMode(keyerPin, OUTPUT);        // we can use the built-in LED to show when the transmitter is being keyed
-    pinMode(leftPin, INPUT);          // external keyer left paddle
-    pinMode(rightPin, INPUT);         // external keyer right paddle
-
-    /// enable deep sleep
-    esp_sleep_enable_ext0_wakeup(GPIO_NUM_0, (esp_sleep_ext1_wakeup_mode_t) 0); //1 = High, 0 = Low
-    analogSetAttenuation(ADC_0db);
-
-// we MUST reset the OLED RST pin for 50 ms! for the old board only, but as it does not hurt we do it anyway
-//#if BOARDVERSION == 2
-    pinMode(OLED_RST, OUTPUT);
-    digitalWrite(OLED_RST, LOW);     // set GPIO16 low to reset OLED
-    delay(50);
-    digitalWrite(OLED_RST, HIGH);    // while OLED is running, must set GPIO16 in high
-//# endif
-
-    MorseDisplay::init();
-    MorseSound::setup();
-
-    //call ISR when any high/low changed seen
-    //on any of the enoder pins
-    attachInterrupt(digitalPinToInterrupt(PinDT), isr, CHANGE);
-    attachInterrupt(digitalPinToInterrupt(PinCLK), isr, CHANGE);
-
-    MorseRotaryEncoder::setup();
-
-    // set up for encoder button
-    pinMode(modeButtonPin, INPUT);
-    pinMode(volButtonPin, INPUT_PULLUP);               // external pullup for all GPIOS > 32 with ESP32-LORA
-                                                       // wake up also works without external pullup! Interesting!
-
-    MorseUI::setup();
-
-    // read preferences from non-volatile storage
-    // if version cannot be read, we have a new ESP32 and need to write the preferences first
-    MorsePreferences::readPreferences("morserino");
-
-    Koch::setup();
-    MorseLoRa::setup();
-    MorsePlayerFile::setup();
-    MorseDisplay::displayStartUp();
-
-    MorseMenu::setup();
-    MorseMenu::menu_();
-} /////////// END setup()
-
-///////////////////////// THE MAIN LOOP - do this OFTEN! /////////////////////////////////
+////////////////////////   T A S K S   O F   T H E   M A I N   L O O P /////////////////////////////
 
-void loop()
+/// the paddle and mode tasks are woken by every paddle edge; in between they only run when there is something to do
+boolean paddlesTask()
 {
-    int t;
-
     MorseKeyer::checkPaddles();
+    if (MorseKeyer::paddlesSettled())
+    {
+        MorseSystem::scheduler.defer(MorseSystem::paddlesTaskNo, micros() + 100000);
+    }
+    return false;
+}
 
+boolean modeTask()
+{
     MorseMode* m = MorseMenu::getCurrentMenuItem()->mode;
+    unsigned long at;
 
-    if (m != 0)
+    // true if we're in a hurry and want to be called again as soon as possible
+    boolean hurry = m != 0 && m->loop();
+    if (!hurry && m != 0 && m->getWakeTime(at))
     {
-        if (m->loop())
-        {
-            // We're in a hurry, so we cut it short
-            return;
-        }
+        MorseSystem::scheduler.defer(MorseSystem::modeTaskNo, at);
     }
+    return hurry;
+}
 
-    // if we have time check for button presses
+boolean uiTask()
+{
+    int t;
+    MorseMode* m;
 
-    MorseUI::modeButton.Update();
-    MorseUI::volButton.Update();
+    {
+        MORSE_PROFILE("buttons");
+        MorseUI::modeButton.Update();
+        MorseUI::volButton.Update();
+    }
+    if (MorseUI::modeButton.clicks || MorseUI::volButton.clicks)
+    {
+        MorsePower::onInput();
+    }
 
     switch (MorseUI::volButton.clicks)
     {
@@ -221,8 +181,9 @@ void loop()
         case -1:
             // long click exits current mode and goes to top menu
             MorseMenu::menu_();
-            return;
+            return false;
         case 1:
+            m = MorseMenu::getCurrentMenuItem()->mode;
             if ((m != 0) && m->togglePause())
             {
                 MorseGenerator::keyOut(false, true, 0, 0);
@@ -249,6 +210,7 @@ void loop()
     // and we have time to check the encoder
     if ((t = checkEncoder()))
     {
+        MorsePower::onInput();
         MorseUI::click();
         switch (MorseMachine::encoderState)
         {
@@ -277,8 +239,122 @@ void loop()
                 break;
         }
     } // encoder 
-    MorseSystem::checkShutDown(false);         // check for time out
+    MorseDisplay::flushPending();           // what the dimmed display has not shown yet
+    return false;
+}
 
-}     /////////////////////// end of loop() /////////
+boolean backgroundTask()
+{
+    MorsePreferences::writeBehind();        // save preferences that have changed a while ago
+    MorseStats::writeBehind();              // ... and the character statistics of the echo trainer
+    MorseKeyer::calibrateSensors();         // adapt the touch paddles to humidity, temperature, ...
+    MorsePower::update();                   // radio and display as the power profile of the mode says
+    if (MorseKeyer::keyer.isIdle() && MorseGenerator::generatorState == MorseGenerator::KEY_UP)
+    {
+        MorseSessionLog::flushIfDue();      // write the session log, not while keying
+        MorseSystem::boot.runNext();        // and start one of the subsystems that have not been needed so far
+    }
+    MorseSystem::checkShutDown(false);      // check for time out
+    return false;
+}
+
+////////////////////////   S E T U P /////////////////////////////
+
+void setup()
+{
+
+    Serial.begin(115200);
+    if (esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_EXT0)
+    {
+        delay(200); // give me time to bring up serial monitor - but not when we are woken up by the user, who wants to get going
+    }
+    MorseSystem::boot.mark("serial");
+
+    // enable Vext
+#if BOARDVERSION == 3
+    pinMode(Vext, OUTPUT);
+    digitalWrite(Vext, LOW);
+#endif
+
+    // set up the encoder - we need external pull-ups as the pins used do not have built-in pull-ups!
+    pinMode(PinCLK, INPUT_PULLUP);
+    pinMode(PinDT, INPUT_PULLUP);
+    pinMode(keyerPin, OUTPUT);        // we can use the built-in LED to show when the transmitter is being keyed
+    pinMode(leftPin, INPUT);          // external keyer left paddle
+    pinMode(rightPin, INPUT);         // external keyer right paddle
+
+    /// enable deep sleep
+    esp_sleep_enable_ext0_wakeup(GPIO_NUM_0, (esp_sleep_ext1_wakeup_mode_t) 0); //1 = High, 0 = Low
+    analogSetAttenuation(ADC_0db);
+
+// we MUST reset the OLED RST pin for 50 ms! for the old board only, but as it does not hurt we do it anyway
+//#if BOARDVERSION == 2
+    pinMode(OLED_RST, OUTPUT);
+    digitalWrite(OLED_RST, LOW);     // set GPIO16 low to reset OLED
+    delay(50);
+    digitalWrite(OLED_RST, HIGH);    // while OLED is running, must set GPIO16 in high
+//# endif
+
+    MorseDisplay::init();
+    MorseSound::setup();
+    MorseSystem::boot.mark("display, sound");
+
+    //call ISR when any high/low changed seen
+    //on any of the enoder pins
+    attachInterrupt(digitalPinToInterrupt(PinDT), isr, CHANGE);
+    attachInterrupt(digitalPinToInterrupt(PinCLK), isr, CHANGE);
+
+    MorseRotaryEncoder::setup();
+
+    // set up for encoder button
+    pinMode(modeButtonPin, INPUT);
+    pinMode(volButtonPin, INPUT_PULLUP);               // external pullup for all GPIOS > 32 with ESP32-LORA
+                                                       // wake up also works without external pullup! Interesting!
+
+    MorseUI::setup();
+    MorseSystem::boot.mark("encoder, buttons");
+    MorseDiagnostics::setup();
+
+    // read preferences from non-volatile storage
+    // if version cannot be read, we have a new ESP32 and need to write the preferences first
+    MorsePreferences::readPreferences("morserino");
+    MorseSound::setSynth(MorsePreferences::prefs.audioSynth);
+    MorseStats::setup();
+    MorseSystem::boot.mark("preferences");
 
+    /// these only register what takes long (LoRa transceiver, SPIFFS, Koch word lists) - it is done later
+    Koch::setup();
+    MorseLoRa::setup();
+    MorsePlayerFile::setup();
+    MorseDisplay::displayStartUp();
+    MorseSystem::boot.mark("start-up screen");
+
+    /// show the start-up screen for a while (shorter with quick start) and use the time for the deferred steps
+    unsigned long splashEnd = millis() + (MorsePreferences::prefs.quickStart ? 1000 : 3000);
+    while ((long) (millis() - splashEnd) < 0)
+    {
+        if (!MorseSystem::boot.runNext())
+        {
+            delay(10);
+        }
+    }
+
+    MorsePower::setup();
 
+    /// the main loop is a set of tasks: period in µs, and the priority if two are due at the same time
+    MorseSystem::paddlesTaskNo = MorseSystem::scheduler.add("paddles", paddlesTask, 500, 3);
+    MorseSystem::modeTaskNo = MorseSystem::scheduler.add("mode", modeTask, 1000, 2);
+    MorseSystem::scheduler.add("ui", uiTask, 10000, 1);
+    MorseSystem::scheduler.add("background", backgroundTask, 100000, 0);
+
+    MorseMenu::setup();
+    MorseMenu::menu_();
+    MorseSystem::boot.mark("mode started");
+} /////////// END setup()
+
+///////////////////////// THE MAIN LOOP - do this OFTEN! /////////////////////////////////
+
+void loop()
+{
+    MorseSystem::scheduler.runOnce();
+}     /////////////////////// end of loop() /////////
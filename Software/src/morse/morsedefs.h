@@ -13,6 +13,9 @@ const String PROJECTNAME = "Morselino-32";
 #define MORSELOG(x) ;
 #endif
 
+/// uncomment to measure the run times of the main parts of the loop (see Profiler.h and the Diagnostics menu)
+//#define MORSE_PROFILING
+
 //////// Program Version
 #define BETA false
 
@@ -23,10 +26,12 @@ const String PROJECTNAME = "Morselino-32";
 #define BOARDVERSION  3
 
 ///////////////////////
-/////// protocol version for Lora - for the time being this is B01
-/////// the first version of the CW over LoRA protocol; future versions will be B02, B03, B00 (reserved for future use)
+/////// protocol version for Lora - B01 was the first version of the CW over LoRA protocol;
+/////// B10 adds a station id, so that receivers can tell several senders apart (B01 packets are still understood);
+/////// versions before it drop B10 packets, so B10 is only sent when the preference says so, or a B10 station has been heard
+/////// B11, B00 reserved for future use
 
-#define CWLORAVERSION B01
+#define CWLORAVERSION B10
 
 #define VERSION_MAJOR 2
 #define VERSION_MINOR 2
@@ -61,8 +66,6 @@ const int OLED_RST = 16;
 
 ///////////// Some GLOBAL defines
 
-// SENS_FACTOR is used for auto-calibrating sensitivity of touch paddles (somewhere between 2.0 and 2.5)
-#define SENS_FACTOR 2.22
 
 ///////////////////////////////      H A R D W A R E      ///////////////////////////////////////////
 //// Here are the definitions for the various hardware-related I/O pins of the ESP32
@@ -0,0 +1,121 @@
+/*
+ * AdaptiveTextTest.cpp
+ *
+ *  Tests for the adaptive choice of characters and words: the weaker the user is at something, the more often it comes.
+ */
+
+#include "TestSupport.h"
+#include "AdaptiveText.h"
+#include "AdaptiveTextTest.h"
+
+static const char *WORDS[] = { "tee", "ham", "tea", "eat", "mat", "hat" };
+
+static const char* word(uint16_t i)
+{
+    return WORDS[i];
+}
+
+/// the user gets h wrong every other time, and is slow with a; t, e and m are fine
+static void train(CharStats &stats)
+{
+    const uint16_t times[] = { 300, 300, 300 };
+    const uint16_t slow[] = { 300, 900, 300 };
+
+    for (int i = 0; i < 10; ++i)
+    {
+        stats.evaluate("tem", "tem", times);
+        stats.evaluate("hat", i % 2 ? "hat" : "sat", slow);
+    }
+}
+
+void test_AdaptiveText_weights()
+{
+    CharStats stats;
+
+    train(stats);
+    uint16_t mean = stats.getMeanResponse();
+    assertEquals("test_AdaptiveText_weights mean", 420, mean);
+    assertEquals("test_AdaptiveText_weights t", CharStats::WEIGHT, stats.getWeakness('t', mean));
+    assertEquals("test_AdaptiveText_weights h", CharStats::WEIGHT + 100, stats.getWeakness('h', mean));
+    assertEquals("test_AdaptiveText_weights a", CharStats::WEIGHT + 16, stats.getWeakness('a', mean));
+    assertEquals("test_AdaptiveText_weights unknown", CharStats::WEIGHT + 100, stats.getWeakness('q', mean));
+    assertEquals("test_AdaptiveText_weights word", (116 + 32 + 16) / 3, stats.getWeakness("hat", mean));
+}
+
+void test_AdaptiveText_chars()
+{
+    const int N = 30000;
+    CharStats stats;
+    AdaptiveText sut(stats);
+    int counts[128] = { };
+    uint32_t state = 3;
+
+    train(stats);
+    sut.setChars("temha");
+    uint32_t total = sut.getTotal(AdaptiveText::CHARS);
+    assertEquals("test_AdaptiveText_chars total", 16 * 3 + 116 + 32, total);
+    for (int i = 0; i < N; ++i)
+    {
+        state = state * 1664525 + 1013904223;
+        ++counts[(int) sut.pickChar((state >> 8) % total)];
+    }
+    printf("  per 1000 characters: t %d, e %d, m %d, h %d, a %d\n", counts['t'] * 1000 / N, counts['e'] * 1000 / N,
+            counts['m'] * 1000 / N, counts['h'] * 1000 / N, counts['a'] * 1000 / N);
+    assertTrue("test_AdaptiveText_chars h most often", counts['h'] > 6 * counts['t']);
+    assertTrue("test_AdaptiveText_chars a twice as often as e", counts['a'] > counts['e'] * 17 / 10);
+    assertEquals("test_AdaptiveText_chars nothing else", N, counts['t'] + counts['e'] + counts['m'] + counts['h'] + counts['a']);
+}
+
+void test_AdaptiveText_onEvaluated()
+{
+    CharStats stats;
+    AdaptiveText sut(stats);
+    AdaptiveText fresh(stats);
+
+    train(stats);
+    sut.setChars("temha");
+    sut.setList(AdaptiveText::WORDS, word, 1, 5);
+    uint32_t before = sut.getTotal(AdaptiveText::WORDS);
+    assertEquals("test_AdaptiveText_onEvaluated list", "ham", sut.pickItem(AdaptiveText::WORDS, 0));
+
+    for (int i = 0; i < 20; ++i)
+    {
+        stats.evaluate("hat", "hat", 0);                // h gets better
+        sut.onEvaluated("hat");
+    }
+    fresh.setChars("temha");
+    fresh.setList(AdaptiveText::WORDS, word, 1, 5);
+    assertEquals("test_AdaptiveText_onEvaluated chars as if built anew", fresh.getTotal(AdaptiveText::CHARS),
+            sut.getTotal(AdaptiveText::CHARS));
+    assertEquals("test_AdaptiveText_onEvaluated words rebuilt", fresh.getTotal(AdaptiveText::WORDS), sut.getTotal(AdaptiveText::WORDS));
+    assertTrue("test_AdaptiveText_onEvaluated words weigh less", sut.getTotal(AdaptiveText::WORDS) < before);
+}
+
+void test_AdaptiveText_words()
+{
+    CharStats stats;
+    AdaptiveText sut(stats);
+    int ham = 0;
+    int tee = 0;
+
+    train(stats);
+    sut.setList(AdaptiveText::WORDS, word, 0, 6);
+    uint32_t total = sut.getTotal(AdaptiveText::WORDS);
+    for (uint32_t r = 0; r < total; ++r)
+    {
+        String w(sut.pickItem(AdaptiveText::WORDS, r));
+        ham += w == "ham";
+        tee += w == "tee";
+    }
+    assertEquals("test_AdaptiveText_words tee", CharStats::WEIGHT, tee);
+    assertEquals("test_AdaptiveText_words ham", (116 + 32 + 16) / 3, ham);
+}
+
+void test_AdaptiveText()
+{
+    printf("Testing AdaptiveText\n");
+    test_AdaptiveText_weights();
+    test_AdaptiveText_chars();
+    test_AdaptiveText_onEvaluated();
+    test_AdaptiveText_words();
+}
@@ -0,0 +1,6 @@
+#ifndef ADAPTIVETEXTTEST_H_
+#define ADAPTIVETEXTTEST_H_
+
+void test_AdaptiveText();
+
+#endif /* ADAPTIVETEXTTEST_H_ */
@@ -0,0 +1,162 @@
+/*
+ * BootSequenceTest.cpp
+ *
+ *  Tests for the staged start-up: deferred steps run once, in order, or when they are needed first.
+ */
+
+#include <string>
+
+#include "TestSupport.h"
+#include "BootSequence.h"
+#include "BootSequenceTest.h"
+
+static unsigned long now;
+static std::string phases;
+
+static unsigned long fakeClock()
+{
+    return now;
+}
+
+static void logger(const char *phase, unsigned long at, unsigned long took)
+{
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%s@%lu+%lu ", phase, at, took);
+    phases += buf;
+}
+
+static int lora;
+static int koch;
+static BootSequence *current;
+
+static void startLoRa()
+{
+    now += 30;
+    ++lora;
+}
+
+static void createKochTables()
+{
+    now += 10;
+    ++koch;
+}
+
+static void useLoRa()
+{
+    current->ensure(startLoRa);         // like a radio function called from the step itself
+    now += 5;
+    ++lora;
+}
+
+static void reset()
+{
+    now = 0;
+    phases = "";
+    lora = 0;
+    koch = 0;
+}
+
+void test_BootSequence_marks()
+{
+    reset();
+    BootSequence sut(fakeClock, logger);
+
+    now = 200;
+    sut.mark("serial");
+    now = 260;
+    sut.mark("display");
+    assertEquals("test_BootSequence_marks", "serial@200+200 display@260+60 ", phases.c_str());
+}
+
+void test_BootSequence_runNext()
+{
+    reset();
+    BootSequence sut(fakeClock, logger);
+
+    sut.defer("lora", startLoRa);
+    sut.defer("koch", createKochTables);
+    sut.defer("lora", startLoRa);
+    assertFalse("test_BootSequence_runNext complete", sut.isComplete());
+    assertFalse("test_BootSequence_runNext lora pending", sut.isDone(startLoRa));
+
+    assertTrue("test_BootSequence_runNext 1", sut.runNext());
+    assertTrue("test_BootSequence_runNext 2", sut.runNext());
+    assertFalse("test_BootSequence_runNext 3", sut.runNext());
+    assertEquals("test_BootSequence_runNext lora", 1, lora);
+    assertEquals("test_BootSequence_runNext koch", 1, koch);
+    assertTrue("test_BootSequence_runNext complete", sut.isComplete());
+    assertEquals("test_BootSequence_runNext phases", "lora@30+30 koch@40+10 ", phases.c_str());
+
+    sut.mark("first element");
+    assertEquals("test_BootSequence_runNext mark", "lora@30+30 koch@40+10 first element@40+0 ", phases.c_str());
+}
+
+void test_BootSequence_ensure()
+{
+    reset();
+    BootSequence sut(fakeClock, logger);
+
+    sut.defer("lora", startLoRa);
+    sut.defer("koch", createKochTables);
+
+    sut.ensure(createKochTables);
+    sut.ensure(createKochTables);
+    assertEquals("test_BootSequence_ensure koch", 1, koch);
+    assertTrue("test_BootSequence_ensure koch done", sut.isDone(createKochTables));
+    assertFalse("test_BootSequence_ensure lora pending", sut.isDone(startLoRa));
+
+    assertTrue("test_BootSequence_ensure next", sut.runNext());
+    assertEquals("test_BootSequence_ensure lora", 1, lora);
+    assertFalse("test_BootSequence_ensure nothing left", sut.runNext());
+    assertEquals("test_BootSequence_ensure koch once", 1, koch);
+
+    // a step that was never deferred counts as done and is not run
+    assertTrue("test_BootSequence_ensure unknown", sut.isDone(useLoRa));
+    sut.ensure(useLoRa);
+    assertEquals("test_BootSequence_ensure unknown not run", 1, lora);
+}
+
+void test_BootSequence_reentrant()
+{
+    reset();
+    BootSequence sut(fakeClock, logger);
+    current = &sut;
+
+    sut.defer("lora", useLoRa);
+    sut.ensure(useLoRa);
+    assertEquals("test_BootSequence_reentrant", 1, lora);
+    assertEquals("test_BootSequence_reentrant phases", "lora@5+5 ", phases.c_str());
+}
+
+template<int N> static void filler()
+{
+    ++koch;
+}
+
+void test_BootSequence_full()
+{
+    reset();
+    BootSequence sut(fakeClock, logger);
+    BootSequence::Step fillers[] = { filler<0>, filler<1>, filler<2>, filler<3>, filler<4>, filler<5>, filler<6>, filler<7> };
+
+    for (int i = 0; i < BootSequence::MAX_STEPS; ++i)
+    {
+        sut.defer("filler", fillers[i]);
+    }
+    sut.defer("lora", startLoRa);
+    assertEquals("test_BootSequence_full no room: run at once", 1, lora);
+    assertEquals("test_BootSequence_full others wait", 0, koch);
+    while (sut.runNext())
+        ;
+    assertEquals("test_BootSequence_full all run", BootSequence::MAX_STEPS, koch);
+}
+
+void test_BootSequence()
+{
+    printf("Testing BootSequence\n");
+    test_BootSequence_marks();
+    test_BootSequence_runNext();
+    test_BootSequence_ensure();
+    test_BootSequence_reentrant();
+    test_BootSequence_full();
+}
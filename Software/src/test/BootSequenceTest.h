@@ -0,0 +1,6 @@
+#ifndef BOOTSEQUENCETEST_H_
+#define BOOTSEQUENCETEST_H_
+
+void test_BootSequence();
+
+#endif /* BOOTSEQUENCETEST_H_ */
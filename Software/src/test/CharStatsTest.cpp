@@ -0,0 +1,143 @@
+/*
+ * CharStatsTest.cpp
+ *
+ *  Tests for the alignment of responses and the per-character statistics.
+ */
+
+#include "TestSupport.h"
+#include "CharStats.h"
+#include "CharStatsTest.h"
+
+/// the edits as a string: = match, ~ substitution, + insertion, - deletion
+static String alignment(const char *expected, const char *response)
+{
+    CharStats::Edit edits[2 * CharStats::MAX_WORD];
+    const char symbols[] = "=~+-";
+    char s[2 * CharStats::MAX_WORD + 1];
+
+    uint8_t n = CharStats::align(expected, response, edits);
+    for (int i = 0; i < n; ++i)
+    {
+        s[i] = symbols[edits[i]];
+    }
+    s[n] = 0;
+    return String(s);
+}
+
+void test_CharStats_align()
+{
+    assertEquals("test_CharStats_align equal", "===", alignment("cat", "cat"));
+    assertEquals("test_CharStats_align substitution", "=~=", alignment("cat", "cut"));
+    assertEquals("test_CharStats_align deletion", "=-=", alignment("cat", "ct"));
+    assertEquals("test_CharStats_align insertion", "==+=", alignment("cat", "caet"));
+    assertEquals("test_CharStats_align empty response", "---", alignment("cat", ""));
+    assertEquals("test_CharStats_align empty word", "++", alignment("", "ee"));
+    assertEquals("test_CharStats_align shifted", "-====+", alignment("qrst1", "rst1e"));
+}
+
+void test_CharStats_evaluate()
+{
+    CharStats sut;
+    const uint16_t times[] = { 400, 800, 300 };
+
+    CharStats::Result r = sut.evaluate("bad", "dad", times);
+    assertEquals("test_CharStats_evaluate distance", 1, r.distance);
+    assertEquals("test_CharStats_evaluate matches", 2, r.matches);
+    assertEquals("test_CharStats_evaluate b sent", 1, sut.get('b').sent);
+    assertEquals("test_CharStats_evaluate b substituted", 1, sut.get('b').substituted);
+    assertEquals("test_CharStats_evaluate b confused with", 'd', sut.get('b').confusedWith);
+    assertEquals("test_CharStats_evaluate a time", 800, sut.get('a').responseMs);
+    assertEquals("test_CharStats_evaluate d time", 300, sut.get('d').responseMs);
+    assertEquals("test_CharStats_evaluate b no time", 0, sut.get('b').responseMs);
+
+    r = sut.evaluate("dog", "dg", 0);
+    assertEquals("test_CharStats_evaluate deletions", 1, r.deletions);
+    assertEquals("test_CharStats_evaluate o dropped", 1, sut.get('o').dropped);
+    assertEquals("test_CharStats_evaluate d sent twice", 2, sut.get('d').sent);
+    assertEquals("test_CharStats_evaluate d time kept", 300, sut.get('d').responseMs);
+
+    r = sut.evaluate("5N", "5nN", 0);             // N is <kn>
+    assertEquals("test_CharStats_evaluate insertions", 1, r.insertions);
+    assertEquals("test_CharStats_evaluate n inserted", 1, sut.get('n').inserted);
+    assertEquals("test_CharStats_evaluate n not sent", 0, sut.get('n').sent);
+    assertEquals("test_CharStats_evaluate kn sent", 1, sut.get('N').sent);
+
+    assertEquals("test_CharStats_evaluate b errors", 100, sut.getErrorPercent('b'));
+    assertEquals("test_CharStats_evaluate d errors", 0, sut.getErrorPercent('d'));
+    assertEquals("test_CharStats_evaluate outside the table", 0, sut.get('\t').sent);
+}
+
+void test_CharStats_averageAndAging()
+{
+    CharStats sut;
+    uint16_t t[] = { 1000 };
+
+    sut.evaluate("e", "e", t);
+    t[0] = 200;
+    sut.evaluate("e", "e", t);
+    assertEquals("test_CharStats_averageAndAging average", 900, sut.get('e').responseMs);
+
+    for (int i = 2; i < CharStats::AGE_LIMIT - 1; ++i)
+    {
+        sut.evaluate("e", i % 4 ? "e" : "i", 0);
+    }
+    assertEquals("test_CharStats_averageAndAging before", CharStats::AGE_LIMIT - 1, sut.get('e').sent);
+    assertEquals("test_CharStats_averageAndAging errors before", 999, sut.get('e').substituted);
+    sut.evaluate("e", "e", 0);
+    assertEquals("test_CharStats_averageAndAging halved", CharStats::AGE_LIMIT / 2, sut.get('e').sent);
+    assertEquals("test_CharStats_averageAndAging errors halved", 499, sut.get('e').substituted);
+    assertEquals("test_CharStats_averageAndAging rate kept", 24, sut.getErrorPercent('e'));
+}
+
+void test_CharStats_worst()
+{
+    CharStats sut;
+    char worst[3];
+
+    for (int i = 0; i < 10; ++i)
+    {
+        sut.evaluate("abcdef", i < 5 ? "xbcdef" : "abcdef", 0);        // a 50 %
+        sut.evaluate("cdef", i < 2 ? "cdf" : "cdef", 0);                // e 10 %
+        sut.evaluate("f", i < 3 ? "s" : "f", 0);                        // f 10 %
+        sut.evaluate("b", i < 9 ? "d" : "b", 0);                        // b 45 %
+    }
+    sut.evaluate("q", "m", 0);                                          // q 100 %, but only once
+
+    assertEquals("test_CharStats_worst count", 2, sut.getWorst(worst, 2, 5));
+    assertEquals("test_CharStats_worst first", 'a', worst[0]);
+    assertEquals("test_CharStats_worst second", 'b', worst[1]);
+    assertEquals("test_CharStats_worst with rare ones", 3, sut.getWorst(worst, 3, 1));
+    assertEquals("test_CharStats_worst rare first", 'q', worst[0]);
+    assertEquals("test_CharStats_worst third", 'b', worst[2]);
+}
+
+void test_CharStats_blob()
+{
+    CharStats sut;
+    CharStats copy;
+    CharStats::Blob blob;
+
+    sut.evaluate("test", "tst", 0);
+    sut.toBlob(blob);
+    assertTrue("test_CharStats_blob read", copy.fromBlob(blob, sizeof(blob)));
+    assertEquals("test_CharStats_blob t", 2, copy.get('t').sent);
+    assertEquals("test_CharStats_blob e", 1, copy.get('e').dropped);
+
+    blob.entries[5].sent ^= 1;
+    assertFalse("test_CharStats_blob damaged", copy.fromBlob(blob, sizeof(blob)));
+    sut.toBlob(blob);
+    assertFalse("test_CharStats_blob short", copy.fromBlob(blob, sizeof(blob) - 2));
+    blob.version = CharStats::LAYOUT_VERSION + 1;
+    assertFalse("test_CharStats_blob newer layout", copy.fromBlob(blob, sizeof(blob)));
+    assertEquals("test_CharStats_blob left alone", 2, copy.get('t').sent);
+}
+
+void test_CharStats()
+{
+    printf("Testing CharStats\n");
+    test_CharStats_align();
+    test_CharStats_evaluate();
+    test_CharStats_averageAndAging();
+    test_CharStats_worst();
+    test_CharStats_blob();
+}
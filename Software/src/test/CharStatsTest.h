@@ -0,0 +1,6 @@
+#ifndef CHARSTATSTEST_H_
+#define CHARSTATSTEST_H_
+
+void test_CharStats();
+
+#endif /* CHARSTATSTEST_H_ */
@@ -0,0 +1,179 @@
+/*
+ * FistAnalyzerTest.cpp
+ *
+ *  Tests for the fist analyzer: synthetic fists with known deviations from the book, and what it makes of them.
+ */
+
+#include "TestSupport.h"
+#include "FistAnalyzer.h"
+#include "FistAnalyzerTest.h"
+
+/// how a synthetic fist keys: ms of dit and dah, and of the spaces between elements, characters and words
+struct Fist
+{
+        unsigned long dit;
+        unsigned long dah;
+        unsigned long element;
+        unsigned long character;
+        unsigned long word;
+        unsigned long jitter;               /// every other element (and space) this much longer, the others shorter
+};
+
+/// key sends a pattern like ".- -... / -.-." the way the decoder would report it: each space before its mark
+static void key(FistAnalyzer &sut, const Fist &fist, const char *pattern, int times)
+{
+    int marks = 0;
+    int spaces = 0;
+
+    for (int t = 0; t < times; ++t)
+    {
+        unsigned long pause = 0;                // nothing before the first mark
+        for (const char *p = pattern; *p; ++p)
+        {
+            switch (*p)
+            {
+                case ' ':
+                    pause = pause == fist.word ? pause : fist.character;
+                    break;
+                case '/':
+                    pause = fist.word;
+                    break;
+                default:
+                    if (pause)
+                    {
+                        sut.space(pause + (spaces++ % 2 ? fist.jitter : -(long) fist.jitter));
+                    }
+                    sut.mark(*p == '-', (*p == '-' ? fist.dah : fist.dit) + (marks++ % 2 ? fist.jitter : -(long) fist.jitter));
+                    pause = fist.element;
+                    break;
+            }
+        }
+        sut.space(fist.word);
+    }
+}
+
+static const char *TEXT = "-.-. --.- / -.. . / -.. .-.. .---- .- -... -.-. / .--. ... . / -.-";
+
+void test_FistAnalyzer_book()
+{
+    FistAnalyzer sut;
+    const Fist fist = { 60, 180, 60, 180, 420, 0 };
+
+    key(sut, fist, TEXT, 10);
+    FistAnalyzer::Report r = sut.getReport(20);
+    assertEquals("test_FistAnalyzer_book marks", 10 * 45, r.marks);
+    assertEquals("test_FistAnalyzer_book wpm", 20, r.wpm);
+    assertEquals("test_FistAnalyzer_book ratio", 300, r.ratio);
+    assertEquals("test_FistAnalyzer_book weight", 50, r.weight);
+    assertEquals("test_FistAnalyzer_book dit spread", 0, r.ditSpread);
+    assertEquals("test_FistAnalyzer_book dah spread", 0, r.dahSpread);
+    assertEquals("test_FistAnalyzer_book space spread", 0, r.spaceSpread);
+    assertEquals("test_FistAnalyzer_book char space", 100, r.charSpace);
+    assertEquals("test_FistAnalyzer_book word space", 100, r.wordSpace);
+    assertEquals("test_FistAnalyzer_book words", 10 * 5, sut.get(FistAnalyzer::WORD).count);
+    assertEquals("test_FistAnalyzer_book characters", 10 * 9, sut.get(FistAnalyzer::CHARACTER).count);
+
+    r = sut.getReport(15);                  // the same fist, but 15 WpM selected: the spaces are too short
+    assertEquals("test_FistAnalyzer_book rushed char space", 75, r.charSpace);
+    assertEquals("test_FistAnalyzer_book rushed word space", 75, r.wordSpace);
+    assertEquals("test_FistAnalyzer_book keyed wpm", 20, r.wpm);
+}
+
+void test_FistAnalyzer_heavy()
+{
+    FistAnalyzer sut;
+    const Fist fist = { 80, 200, 40, 160, 400, 0 };     // the marks 20 ms too long, the spaces 20 ms too short
+
+    key(sut, fist, TEXT, 5);
+    FistAnalyzer::Report r = sut.getReport(20);
+    assertEquals("test_FistAnalyzer_heavy weight", 67, r.weight);
+    assertEquals("test_FistAnalyzer_heavy ratio", 250, r.ratio);
+    assertEquals("test_FistAnalyzer_heavy wpm", 15, r.wpm);
+    assertEquals("test_FistAnalyzer_heavy char space", 89, r.charSpace);
+
+    const Fist light = { 50, 170, 70, 190, 430, 0 };
+    sut.clear();
+    key(sut, light, TEXT, 5);
+    r = sut.getReport(20);
+    assertEquals("test_FistAnalyzer_heavy light weight", 42, r.weight);
+    assertEquals("test_FistAnalyzer_heavy light ratio", 340, r.ratio);
+}
+
+void test_FistAnalyzer_jitter()
+{
+    FistAnalyzer sut;
+    const Fist fist = { 60, 180, 60, 180, 420, 6 };     // +/- 6 ms: 10 % of a dit, 3 % of a dah
+
+    key(sut, fist, ".. .. .. .. / -- -- -- --", 50);
+    FistAnalyzer::Report r = sut.getReport(20);
+    assertEquals("test_FistAnalyzer_jitter dit mean", 60, sut.getMean(FistAnalyzer::DIT));
+    assertEquals("test_FistAnalyzer_jitter dit deviation", 6, sut.getDeviation(FistAnalyzer::DIT));
+    assertEquals("test_FistAnalyzer_jitter dit spread", 10, r.ditSpread);
+    assertEquals("test_FistAnalyzer_jitter dah spread", 3, r.dahSpread);
+    assertEquals("test_FistAnalyzer_jitter space spread", 10, r.spaceSpread);
+    assertEquals("test_FistAnalyzer_jitter ratio", 300, r.ratio);
+}
+
+void test_FistAnalyzer_spaces()
+{
+    FistAnalyzer sut;
+
+    sut.space(100);                         // no dit yet: we cannot tell what this is
+    assertEquals("test_FistAnalyzer_spaces before dits", 0, sut.get(FistAnalyzer::ELEMENT).count);
+    sut.mark(false, 50);
+    sut.space(99);
+    sut.space(100);
+    sut.space(249);
+    sut.space(250);
+    sut.space(699);
+    sut.space(700);                         // a pause
+    assertEquals("test_FistAnalyzer_spaces element", 1, sut.get(FistAnalyzer::ELEMENT).count);
+    assertEquals("test_FistAnalyzer_spaces character", 2, sut.get(FistAnalyzer::CHARACTER).count);
+    assertEquals("test_FistAnalyzer_spaces word", 2, sut.get(FistAnalyzer::WORD).count);
+
+    FistAnalyzer::Report r = sut.getReport(0);
+    assertEquals("test_FistAnalyzer_spaces no dah", 0, r.ratio);
+    assertEquals("test_FistAnalyzer_spaces no selected speed", 0, r.charSpace);
+
+    FistAnalyzer empty;
+    r = empty.getReport(20);
+    assertEquals("test_FistAnalyzer_spaces empty", 0, r.marks + r.wpm + r.ratio + r.weight + r.charSpace + r.wordSpace);
+}
+
+void test_FistAnalyzer_window()
+{
+    FistAnalyzer sut;
+
+    for (int i = 0; i < 2 * FistAnalyzer::WINDOW; ++i)
+    {
+        sut.mark(false, 100);
+    }
+    for (int i = 0; i < FistAnalyzer::WINDOW; ++i)         // the fist gets faster: the mean follows
+    {
+        sut.mark(false, 60);
+    }
+    uint16_t changing = sut.getDeviation(FistAnalyzer::DIT);
+    for (int i = 0; i < 3 * FistAnalyzer::WINDOW; ++i)     // ... and the spread of the change fades
+    {
+        sut.mark(false, 60);
+    }
+    assertEquals("test_FistAnalyzer_window count", FistAnalyzer::WINDOW, sut.get(FistAnalyzer::DIT).count);
+    assertEquals("test_FistAnalyzer_window mean", 61, sut.getMean(FistAnalyzer::DIT));
+    assertTrue("test_FistAnalyzer_window changing", changing > 10);
+    assertTrue("test_FistAnalyzer_window deviation", sut.getDeviation(FistAnalyzer::DIT) <= 5);
+
+    assertEquals("test_FistAnalyzer_window sqrt 0", 0, FistAnalyzer::squareRoot(0));
+    assertEquals("test_FistAnalyzer_window sqrt 99", 9, FistAnalyzer::squareRoot(99));
+    assertEquals("test_FistAnalyzer_window sqrt 100", 10, FistAnalyzer::squareRoot(100));
+    assertEquals("test_FistAnalyzer_window sqrt max", 65535, FistAnalyzer::squareRoot(0xffffffff));
+}
+
+void test_FistAnalyzer()
+{
+    printf("Testing FistAnalyzer\n");
+    test_FistAnalyzer_book();
+    test_FistAnalyzer_heavy();
+    test_FistAnalyzer_jitter();
+    test_FistAnalyzer_spaces();
+    test_FistAnalyzer_window();
+}
@@ -0,0 +1,6 @@
+#ifndef FISTANALYZERTEST_H_
+#define FISTANALYZERTEST_H_
+
+void test_FistAnalyzer();
+
+#endif /* FISTANALYZERTEST_H_ */
@@ -0,0 +1,171 @@
+/*
+ * HeadCopyScorerTest.cpp
+ *
+ *  Tests for scoring head copying: the score, capturing the answer with its timing, and the way the difficulty goes.
+ */
+
+#include <string.h>
+#include "TestSupport.h"
+#include "HeadCopyScorer.h"
+#include "HeadCopyScorerTest.h"
+
+/// answer lets sut send word at time now, and keys response one character every 300 ms, 500 ms after the word
+static HeadCopyScorer::Result answer(HeadCopyScorer &sut, const char *word, const char *response, unsigned long &now)
+{
+    char symbol[2] = { 0, 0 };
+
+    sut.wordEnd(word, now);
+    now += 200;
+    for (const char *p = response; *p; ++p)
+    {
+        now += 300;
+        symbol[0] = *p;
+        sut.character(symbol, now);
+    }
+    now += 400;
+    return sut.evaluate(now);
+}
+
+void test_HeadCopyScorer_score()
+{
+    assertEquals("test_HeadCopyScorer_score right", 100, HeadCopyScorer::score("cq", "cq"));
+    assertEquals("test_HeadCopyScorer_score dropped", 75, HeadCopyScorer::score("test", "tst"));
+    assertEquals("test_HeadCopyScorer_score substituted", 80, HeadCopyScorer::score("paris", "pxris"));
+    assertEquals("test_HeadCopyScorer_score inserted", 75, HeadCopyScorer::score("abcd", "abxcd"));
+    assertEquals("test_HeadCopyScorer_score nothing", 0, HeadCopyScorer::score("abc", ""));
+    assertEquals("test_HeadCopyScorer_score too much", 0, HeadCopyScorer::score("ab", "abxyz"));
+    assertEquals("test_HeadCopyScorer_score no word", 0, HeadCopyScorer::score("", "e"));
+    assertEquals("test_HeadCopyScorer_score distance", 2, HeadCopyScorer::getDistance("dl1abc", "dlabd"));
+}
+
+void test_HeadCopyScorer_capture()
+{
+    HeadCopyScorer sut;
+    unsigned long now = 1000;
+
+    assertFalse("test_HeadCopyScorer_capture not waiting", sut.isWaiting());
+    sut.character("e", now);                                // keyed before the word: ignored
+    HeadCopyScorer::Result r = answer(sut, "cq", "cq", now);
+    assertTrue("test_HeadCopyScorer_capture right", r.right);
+    assertEquals("test_HeadCopyScorer_capture score", 100, r.score);
+    assertEquals("test_HeadCopyScorer_capture latency", 500, r.latencyMs);
+    assertEquals("test_HeadCopyScorer_capture response", 800, r.responseMs);
+    assertEquals("test_HeadCopyScorer_capture response text", "cq", sut.getResponse());
+    assertFalse("test_HeadCopyScorer_capture done", sut.isWaiting());
+
+    sut.wordEnd("dl1abc", 10000);
+    sut.character("d", 11000);
+    sut.character("lA", 11500);                             // several characters at once, e.g. a word and a pro sign
+    assertEquals("test_HeadCopyScorer_capture symbols", "dlA", sut.getResponse());
+    r = sut.evaluate(12000);
+    assertFalse("test_HeadCopyScorer_capture wrong", r.right);
+    assertEquals("test_HeadCopyScorer_capture wrong distance", 4, r.distance);
+    assertEquals("test_HeadCopyScorer_capture wrong score", 33, r.score);
+    assertEquals("test_HeadCopyScorer_capture wrong word", "dl1abc", sut.getWord());
+
+    sut.wordEnd("tu", 20000);
+    assertFalse("test_HeadCopyScorer_capture waiting", sut.isTimedOut(20000 + HeadCopyScorer::TIMEOUT - 1));
+    assertTrue("test_HeadCopyScorer_capture timed out", sut.isTimedOut(20000 + HeadCopyScorer::TIMEOUT));
+    r = sut.evaluate(20000 + HeadCopyScorer::TIMEOUT);
+    assertEquals("test_HeadCopyScorer_capture timed out score", 0, r.score);
+    assertEquals("test_HeadCopyScorer_capture timed out latency", 0, r.latencyMs);
+    assertEquals("test_HeadCopyScorer_capture timed out response", HeadCopyScorer::TIMEOUT, r.responseMs);
+
+    sut.wordEnd("tu", 30000);
+    sut.character("t", 31000);
+    assertFalse("test_HeadCopyScorer_capture keying", sut.isTimedOut(30000 + 2 * HeadCopyScorer::TIMEOUT));
+}
+
+void test_HeadCopyScorer_levels()
+{
+    HeadCopyScorer sut;
+    unsigned long now = 0;
+    String levels;
+
+    sut.begin(3, 20);
+    assertEquals("test_HeadCopyScorer_levels start length", 3, sut.getLength());
+    assertEquals("test_HeadCopyScorer_levels start wpm", 20, sut.getWpm());
+    for (int i = 0; i < 7 * HeadCopyScorer::WINDOW; ++i)        // all right: up, up, up
+    {
+        if (answer(sut, "abc", "abc", now).levelChanged)
+        {
+            levels += String((unsigned long) sut.getLength()) + "/" + String((unsigned long) sut.getWpm()) + " ";
+        }
+    }
+    assertEquals("test_HeadCopyScorer_levels up", "4/20 4/21 5/21 5/22 6/22 6/23 6/24 ", levels);
+    assertEquals("test_HeadCopyScorer_levels level", 7, sut.getLevel());
+
+    levels = "";
+    for (int i = 0; i < 4 * HeadCopyScorer::WINDOW; ++i)        // half right: down
+    {
+        if (answer(sut, "abcd", "ab", now).levelChanged)
+        {
+            levels += String((unsigned long) sut.getLength()) + "/" + String((unsigned long) sut.getWpm()) + " ";
+        }
+    }
+    assertEquals("test_HeadCopyScorer_levels down", "6/23 6/22 5/22 5/21 ", levels);
+
+    for (int i = 0; i < 3 * HeadCopyScorer::WINDOW; ++i)        // three out of four right: stays (for longer now)
+    {
+        answer(sut, "abcd", i % 4 ? "abcd" : "", now);
+    }
+    assertEquals("test_HeadCopyScorer_levels stays", 3, sut.getLevel());
+    assertEquals("test_HeadCopyScorer_levels average", 75, sut.getAverage());
+
+    sut.begin(1, 6);                                            // as easy as it gets, almost
+    for (int i = 0; i < 4 * HeadCopyScorer::WINDOW; ++i)
+    {
+        answer(sut, "e", "", now);
+    }
+    assertEquals("test_HeadCopyScorer_levels easiest", -1, sut.getLevel());
+    assertEquals("test_HeadCopyScorer_levels easiest length", HeadCopyScorer::MIN_LENGTH, sut.getLength());
+    assertEquals("test_HeadCopyScorer_levels easiest wpm", 5, sut.getWpm());
+
+    sut.begin(0, 20);
+    assertEquals("test_HeadCopyScorer_levels unlimited length", HeadCopyScorer::MAX_LENGTH, sut.getLength());
+}
+
+/// a learner who copies a word right as long as it is at most capacity characters times WpM, and half of it beyond
+void test_HeadCopyScorer_simulation()
+{
+    const char *text = "abcdef";
+    const uint16_t capacity = 90;
+    HeadCopyScorer sut;
+    unsigned long now = 0;
+    int right = 0;
+    int words = 0;
+
+    sut.begin(2, 12);
+    for (int i = 0; i < 40 * HeadCopyScorer::WINDOW; ++i)
+    {
+        char word[HeadCopyScorer::MAX_LENGTH + 1];
+        strncpy(word, text, sut.getLength());
+        word[sut.getLength()] = 0;
+        char response[HeadCopyScorer::MAX_LENGTH + 1];
+        strcpy(response, word);
+        if (sut.getLength() * sut.getWpm() > capacity)
+        {
+            response[sut.getLength() / 2] = 0;
+        }
+        HeadCopyScorer::Result r = answer(sut, word, response, now);
+        if (i >= 20 * HeadCopyScorer::WINDOW)
+        {
+            right += r.right;
+            ++words;
+        }
+    }
+    uint16_t load = sut.getLength() * sut.getWpm();
+    printf("  simulation: settled at %u characters, %u WpM, %d %% right\n", sut.getLength(), sut.getWpm(),
+            right * 100 / words);
+    assertTrue("test_HeadCopyScorer_simulation near capacity", load > capacity * 3 / 4 && load <= capacity + 15);
+    assertTrue("test_HeadCopyScorer_simulation mostly right", right * 100 / words >= 75);
+}
+
+void test_HeadCopyScorer()
+{
+    printf("Testing HeadCopyScorer\n");
+    test_HeadCopyScorer_score();
+    test_HeadCopyScorer_capture();
+    test_HeadCopyScorer_levels();
+    test_HeadCopyScorer_simulation();
+}
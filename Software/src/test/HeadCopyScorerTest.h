@@ -0,0 +1,6 @@
+#ifndef HEADCOPYSCORERTEST_H_
+#define HEADCOPYSCORERTEST_H_
+
+void test_HeadCopyScorer();
+
+#endif /* HEADCOPYSCORERTEST_H_ */
@@ -0,0 +1,533 @@
+/*
+ * IambicKeyerTest.cpp
+ *
+ *  Tests for the paddle edge queue and the iambic keyer. Paddle actions are replayed through a PaddleQueue
+ *  into the keyer, like checkPaddles() does it; for comparison the same actions can be sampled at the
+ *  poll times only, which is what the keyer saw before it got the edges.
+ *
+ *  The exhaustive tests go through all keyer modes, Curtis B timings and latency settings and compare
+ *  with the rules as the manual states them, not with the tables of the keyer.
+ */
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "TestSupport.h"
+#include "PaddleQueue.h"
+#include "IambicKeyer.h"
+#include "IambicKeyerTest.h"
+
+static const uint32_t START = 1000000;             // µs - well away from 0
+
+struct Recorder: public IambicKeyer::Client
+{
+        std::string sent;
+        uint8_t elements = 0;
+        uint32_t now = 0;
+        uint32_t keyDownAt = 0;
+
+        boolean onIdle(boolean pressed) {return false;};
+        void onCharacterStart() {};
+        void onElement(boolean dah) {sent += dah ? '-' : '.';};
+        void keyDown() {++elements; keyDownAt = now;};
+        void keyUp() {};
+        void onCharacterEnd() {sent += ' ';};
+};
+
+/// a paddle action, in ms after the start
+struct Action
+{
+        uint32_t at;
+        uint8_t paddle;
+        boolean pressed;
+};
+
+struct Replay
+{
+        uint8_t mode = IAMBICB;
+        uint32_t pollUs = 1000;
+        boolean sampled = false;            /// look at the levels at the poll times only
+        uint8_t releaseElement = 0;         /// release both paddles ...
+        uint32_t releaseAfter = 0;          /// ... this many ms after the key down of this element
+        uint32_t untilMs = 1500;
+        uint8_t curtis = 0;                 /// Curtis B timing for dits and dahs, 0 = the defaults
+        uint8_t latency = 4;
+        boolean eventDriven = false;        /// call the keyer at the wake times and paddle edges only
+};
+
+static uint32_t updateCalls;
+
+static boolean levelAt(const std::vector<Action> &actions, uint8_t paddle, uint32_t t)
+{
+    boolean level = false;
+    for (const Action &a : actions)
+    {
+        if (a.paddle == paddle && START + a.at * 1000 <= t)
+        {
+            level = a.pressed;
+        }
+    }
+    return level;
+}
+
+static String replay(std::vector<Action> actions, const Replay &r)
+{
+    PaddleQueue queue;
+    IambicKeyer keyer;
+    Recorder rec;
+    IambicKeyer::Config config = { r.mode, true, 60, 35, 75, r.latency, 0 };
+    PaddleQueue::Edge edge;
+    size_t pending = 0;
+    boolean released = false;
+
+    if (r.curtis)
+    {
+        config.curtisBTiming = config.curtisBDotTiming = r.curtis;
+    }
+    keyer.setClient(&rec);
+    keyer.setConfig(config);
+    keyer.reset(START);
+    uint32_t end = START + r.untilMs * 1000;
+    for (uint32_t t = START; t < end; )
+    {
+        if (r.releaseElement && !released && rec.elements == r.releaseElement
+                && t >= rec.keyDownAt + r.releaseAfter * 1000)
+        {
+            uint32_t at = (rec.keyDownAt - START) / 1000 + r.releaseAfter;
+            actions.push_back( { at, PaddleQueue::RIGHT, false });
+            actions.push_back( { at, PaddleQueue::LEFT, false });
+            released = true;
+        }
+        if (r.sampled)
+        {
+            queue.onLevel(PaddleQueue::LEFT, levelAt(actions, PaddleQueue::LEFT, t), t);
+            queue.onLevel(PaddleQueue::RIGHT, levelAt(actions, PaddleQueue::RIGHT, t), t);
+        }
+        else
+        {
+            for (; pending < actions.size() && START + actions[pending].at * 1000 <= t; ++pending)
+            {
+                queue.onLevel(actions[pending].paddle, actions[pending].pressed, START + actions[pending].at * 1000);
+            }
+        }
+        while (queue.pop(edge))
+        {
+            keyer.paddleEdge(edge.paddle, edge.pressed, edge.time);
+        }
+        rec.now = t;
+        keyer.update(t);
+        ++updateCalls;
+
+        uint32_t next = t + r.pollUs, wake;
+        if (r.eventDriven)
+        {
+            next = end;
+            if (pending < actions.size())
+            {
+                next = START + actions[pending].at * 1000;
+            }
+            if (keyer.getWakeTime(wake) && wake < next)
+            {
+                next = wake;
+            }
+            if (r.releaseElement && !released && rec.elements == r.releaseElement)
+            {
+                next = std::min(next, rec.keyDownAt + r.releaseAfter * 1000);
+            }
+            next = std::max(next, t + 1);
+        }
+        t = next;
+    }
+    return String(rec.sent.c_str());
+}
+
+void test_PaddleQueue_bounce()
+{
+    PaddleQueue q;
+    PaddleQueue::Edge e;
+
+    assertTrue("press queued", q.onLevel(PaddleQueue::LEFT, true, START));
+    assertFalse("bounce ignored", q.onLevel(PaddleQueue::LEFT, false, START + 100));
+    assertFalse("no change", q.onLevel(PaddleQueue::LEFT, true, START + 200));
+    assertTrue("other paddle not locked", q.onLevel(PaddleQueue::RIGHT, true, START + 300));
+    assertFalse("bounce ends released", q.onLevel(PaddleQueue::LEFT, false, START + 500));
+    assertFalse("not settled in lockout", q.isSettled(START + 900));
+    assertTrue("settled level after lockout", q.onLevel(PaddleQueue::LEFT, false, START + 900));
+    assertEquals("count", 3, q.getCount());
+
+    assertTrue("pop 1", q.pop(e));
+    assertEquals("time of the first edge", START, e.time);
+    assertTrue("pressed", e.pressed);
+    assertTrue("pop 2", q.pop(e));
+    assertEquals("right paddle", PaddleQueue::RIGHT, e.paddle);
+    assertTrue("pop 3", q.pop(e));
+    assertEquals("release at resync", START + 900, e.time);
+    assertFalse("released", e.pressed);
+    assertFalse("empty", q.pop(e));
+    assertFalse("right paddle still locked", q.isSettled(START + 1000));
+    assertTrue("settled", q.isSettled(START + 1650));
+}
+
+void test_PaddleQueue_overflow()
+{
+    PaddleQueue q;
+    PaddleQueue::Edge e;
+    uint32_t t = START;
+
+    for (int i = 0; i < PaddleQueue::SIZE + 1; ++i)
+    {
+        q.onLevel(PaddleQueue::LEFT, (i & 1) == 0, t);
+        t += 1000;
+    }
+    assertEquals("full", PaddleQueue::SIZE, q.getCount());
+    assertEquals("overflows", 1, q.getOverflows());
+    assertFalse("level of the last queued edge", q.isPressed(PaddleQueue::LEFT));
+    assertTrue("oldest kept", q.pop(e) && e.time == START);
+    assertTrue("room again", q.onLevel(PaddleQueue::LEFT, true, t));
+}
+
+void test_IambicKeyer_single()
+{
+    Replay r;
+
+    assertEquals("dit", ". ", replay( { { 0, PaddleQueue::LEFT, true }, { 20, PaddleQueue::LEFT, false } }, r));
+    assertEquals("dah", "- ", replay( { { 0, PaddleQueue::RIGHT, true }, { 20, PaddleQueue::RIGHT, false } }, r));
+}
+
+/// squeeze for a C: dah first, release both in the last dit
+void test_IambicKeyer_modeAB()
+{
+    std::vector<Action> squeeze = { { 0, PaddleQueue::RIGHT, true }, { 5, PaddleQueue::LEFT, true } };
+    Replay r;
+    r.releaseElement = 4;
+
+    r.mode = IAMBICA;
+    r.releaseAfter = 50;
+    assertEquals("mode A", "-.-. ", replay(squeeze, r));
+
+    r.mode = IAMBICB;
+    assertEquals("mode B, released after Curtis time", "-.-.- ", replay(squeeze, r));
+    r.releaseAfter = 30;
+    assertEquals("mode B, released before Curtis time", "-.-. ", replay(squeeze, r));
+}
+
+/// dit first, then the dah paddle, both held into the third element
+void test_IambicKeyer_ultimatic_nonSqueeze()
+{
+    std::vector<Action> squeeze = { { 0, PaddleQueue::LEFT, true }, { 30, PaddleQueue::RIGHT, true } };
+    Replay r;
+    r.releaseElement = 3;
+    r.releaseAfter = 30;
+
+    r.mode = IAMBICA;
+    assertEquals("iambic", ".-. ", replay(squeeze, r));
+    r.mode = ULTIMATIC;
+    assertEquals("ultimatic", ".-- ", replay(squeeze, r));
+    r.mode = NONSQUEEZE;
+    assertEquals("non-squeeze", "... ", replay(squeeze, r));
+}
+
+/// taps that begin and end between two polls of a slow main loop
+void test_IambicKeyer_shortTaps()
+{
+    Replay r;
+    r.pollUs = 10000;
+
+    std::vector<Action> idleTap = { { 103, PaddleQueue::LEFT, true }, { 108, PaddleQueue::LEFT, false } };
+    assertEquals("tap in idle", ". ", replay(idleTap, r));
+    r.sampled = true;
+    assertEquals("tap in idle, sampled", "", replay(idleTap, r));
+    r.sampled = false;
+
+    // the dit is keyed from 0 to 60 ms, Curtis B time is off at 47 ms
+    std::vector<Action> curtisTap = { { 0, PaddleQueue::LEFT, true }, { 10, PaddleQueue::LEFT, false },
+            { 51, PaddleQueue::RIGHT, true }, { 54, PaddleQueue::RIGHT, false } };
+    assertEquals("tap after Curtis time", ".- ", replay(curtisTap, r));
+    r.sampled = true;
+    assertEquals("tap after Curtis time, sampled", ". ", replay(curtisTap, r));
+    r.sampled = false;
+    r.mode = IAMBICA;
+    assertEquals("tap over before the element ends, mode A", ". ", replay(curtisTap, r));
+}
+
+/// the same paddle is muted for (latency - 1) / 8 dits after an element
+void test_IambicKeyer_latency()
+{
+    Replay r;
+
+    std::vector<Action> early = { { 0, PaddleQueue::LEFT, true }, { 10, PaddleQueue::LEFT, false },
+            { 66, PaddleQueue::LEFT, true }, { 70, PaddleQueue::LEFT, false } };
+    assertEquals("tap while muted", ". ", replay(early, r));
+
+    std::vector<Action> late = { { 0, PaddleQueue::LEFT, true }, { 10, PaddleQueue::LEFT, false },
+            { 90, PaddleQueue::LEFT, true }, { 93, PaddleQueue::LEFT, false } };
+    assertEquals("tap after latency", ".. ", replay(late, r));
+}
+
+/// random short taps in idle state with a main loop that polls every 15 ms
+void test_IambicKeyer_tapRate()
+{
+    std::vector<Action> taps;
+    uint32_t seed = 4711, at = 100;
+    Replay r;
+    r.pollUs = 15000;
+
+    for (int i = 0; i < 100; ++i)
+    {
+        seed = seed * 1103515245 + 12345;
+        uint32_t length = 2 + (seed >> 16) % 8;
+        taps.push_back( { at, PaddleQueue::LEFT, true });
+        taps.push_back( { at + length, PaddleQueue::LEFT, false });
+        at += 300;
+    }
+    r.untilMs = at + 300;
+
+    std::string edges = replay(taps, r).c_str();
+    r.sampled = true;
+    std::string sampled = replay(taps, r).c_str();
+
+    int caught = 0, caughtSampled = 0;
+    for (char c : edges)
+    {
+        caught += c == '.';
+    }
+    for (char c : sampled)
+    {
+        caughtSampled += c == '.';
+    }
+    printf("  100 taps of 2..9 ms, polled every 15 ms: %d keyed from edges, %d from sampled levels\n", caught, caughtSampled);
+    assertEquals("all taps from edges", 100, caught);
+    assertTrue("sampling misses taps", caughtSampled < 100);
+}
+
+static const uint8_t MODES[] = { IAMBICA, IAMBICB, ULTIMATIC, NONSQUEEZE };
+static const char *MODE_NAMES[] = { "", "A", "B", "ultimatic", "non-squeeze" };
+
+static char *describe(char *buffer, uint8_t mode, const char *what, int a, int b, int c)
+{
+    sprintf(buffer, "mode %s, %s %d %d %d", MODE_NAMES[mode], what, a, b, c);
+    return buffer;
+}
+
+/// a tap of the opposite paddle during or after a single element: latched if it lasted until the
+/// Curtis time (mode B), 3 ms (non-squeeze) or the end of the element (A, ultimatic)
+void test_IambicKeyer_exhaustiveCurtis()
+{
+    char name[80];
+    int checked = 0, failed = 0;
+
+    for (uint8_t mode : MODES)
+    {
+        for (int dah = 0; dah < 2; ++dah)
+        {
+            uint8_t paddle = dah ? PaddleQueue::RIGHT : PaddleQueue::LEFT;
+            uint8_t opposite = dah ? PaddleQueue::LEFT : PaddleQueue::RIGHT;
+            uint32_t length = dah ? 180000 : 60000;
+            std::string element = dah ? "-" : ".";
+            std::string other = dah ? "." : "-";
+
+            for (int curtis = 0; curtis <= 100; curtis += 5)
+            {
+                uint32_t threshold;     // µs after key down
+                switch (mode)
+                {
+                    case IAMBICB:
+                        threshold = 2000 + length * curtis / 100;
+                        break;
+                    case NONSQUEEZE:
+                        threshold = 3000;
+                        break;
+                    default:
+                        threshold = length;
+                        break;
+                }
+                for (uint32_t at = 6; at < length / 1000 + 10; ++at)
+                {
+                    uint32_t releasedAt = (at + 2) * 1000;
+                    if (releasedAt + 1000 > threshold && releasedAt < threshold + 1000)
+                    {   // too close to call with 1 ms polls
+                        continue;
+                    }
+                    Replay r;
+                    r.mode = mode;
+                    r.curtis = curtis ? curtis : 1;
+                    r.untilMs = 600;
+                    std::string expected = element + (releasedAt >= threshold ? other : "") + " ";
+                    std::string actual = replay( { { 0, paddle, true }, { 5, paddle, false }, { at, opposite, true }, { at + 2, opposite, false } }, r).c_str();
+                    ++checked;
+                    if (actual != expected && failed++ < 5)
+                    {
+                        assertEquals(describe(name, mode, "element/curtis/tap", dah, curtis, at), expected, actual);
+                    }
+                }
+            }
+        }
+    }
+    printf("  Curtis timings: %d cases\n", checked);
+    assertEquals("Curtis timings, failed cases", 0, failed);
+}
+
+/// a tap of the same paddle between two elements: latched if it lasted until the latency time,
+/// (latency - 1) / 8 dits after key up, in every mode
+void test_IambicKeyer_exhaustiveLatency()
+{
+    char name[80];
+    int checked = 0, failed = 0;
+
+    for (uint8_t mode : MODES)
+    {
+        for (int dah = 0; dah < 2; ++dah)
+        {
+            uint8_t paddle = dah ? PaddleQueue::RIGHT : PaddleQueue::LEFT;
+            uint32_t keyUp = (dah ? 180 : 60) + 1;          // ms, the first poll after the end of the element
+            std::string element = dah ? "-" : ".";
+
+            for (uint8_t latency = 1; latency <= 8; ++latency)
+            {
+                uint32_t threshold = keyUp * 1000 + (latency - 1) * 60000 / 8;
+                for (uint32_t at = keyUp; at + 3 < keyUp + 60; ++at)
+                {
+                    uint32_t releasedAt = (at + 2) * 1000;
+                    if (releasedAt + 1000 > threshold && releasedAt < threshold + 1000)
+                    {
+                        continue;
+                    }
+                    Replay r;
+                    r.mode = mode;
+                    r.latency = latency;
+                    r.untilMs = 700;
+                    std::string expected = element + (releasedAt >= threshold ? element : "") + " ";
+                    std::string actual = replay( { { 0, paddle, true }, { 5, paddle, false }, { at, paddle, true }, { at + 2, paddle, false } }, r).c_str();
+                    ++checked;
+                    if (actual != expected && failed++ < 5)
+                    {
+                        assertEquals(describe(name, mode, "element/latency/tap", dah, latency, at), expected, actual);
+                    }
+                }
+            }
+        }
+    }
+    printf("  latency settings: %d cases\n", checked);
+    assertEquals("latency settings, failed cases", 0, failed);
+}
+
+/// both paddles held, released early in the n-th element: iambic alternates, ultimatic repeats the second
+/// paddle, non-squeeze the first one
+void test_IambicKeyer_exhaustiveSqueeze()
+{
+    char name[80];
+    int failed = 0;
+
+    for (uint8_t mode : MODES)
+    {
+        for (int dahFirst = 0; dahFirst < 2; ++dahFirst)
+        {
+            uint8_t first = dahFirst ? PaddleQueue::RIGHT : PaddleQueue::LEFT;
+            uint8_t second = dahFirst ? PaddleQueue::LEFT : PaddleQueue::RIGHT;
+            char a = dahFirst ? '-' : '.', b = dahFirst ? '.' : '-';
+
+            for (uint8_t n = 1; n <= 6; ++n)
+            {
+                std::string expected;
+                for (int i = 0; i < n; ++i)
+                {
+                    switch (mode)
+                    {
+                        case ULTIMATIC:
+                            expected += i == 0 ? a : b;
+                            break;
+                        case NONSQUEEZE:
+                            expected += a;
+                            break;
+                        default:
+                            expected += i % 2 ? b : a;
+                            break;
+                    }
+                }
+                expected += " ";
+
+                Replay r;
+                r.mode = mode;
+                r.releaseElement = n;
+                r.releaseAfter = 10;
+                r.untilMs = 2000;
+                std::string actual = replay( { { 0, first, true }, { 6, second, true } }, r).c_str();
+                if (actual != expected && failed++ < 5)
+                {
+                    assertEquals(describe(name, mode, "dah first/elements", dahFirst, n, 0), expected, actual);
+                }
+            }
+        }
+    }
+    assertEquals("squeezes, failed cases", 0, failed);
+}
+
+/// calling the keyer only at its wake times and at paddle edges gives the same elements
+void test_IambicKeyer_wakeTime()
+{
+    std::vector<Action> squeeze = { { 0, PaddleQueue::RIGHT, true }, { 5, PaddleQueue::LEFT, true } };
+    Replay r;
+    r.releaseElement = 7;
+    r.releaseAfter = 50;
+    r.untilMs = 3000;
+
+    updateCalls = 0;
+    String polled = replay(squeeze, r);
+    uint32_t polledCalls = updateCalls;
+
+    r.eventDriven = true;
+    updateCalls = 0;
+    String driven = replay(squeeze, r);
+    printf("  squeeze of 7 elements in 3 s: %u calls polled every ms, %u calls at wake times\n", polledCalls, updateCalls);
+    assertEquals("same elements", polled, driven);
+    assertEquals("elements", "-.-.-.- ", driven);
+    assertTrue("fewer calls", updateCalls < polledCalls / 50);
+}
+
+void test_IambicKeyer_benchmark()
+{
+    const int N = 2000000;
+    PaddleQueue::Edge edge;
+    PaddleQueue queue;
+    IambicKeyer keyer;
+    Recorder rec;
+    uint32_t t = START;
+
+    keyer.setClient(&rec);
+    keyer.reset(t);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < N; ++i)
+    {
+        t += 500;
+        queue.onLevel(PaddleQueue::LEFT, (i / 1000) % 2 == 0, t);   // squeeze for 0.5 s, pause for 0.5 s
+        queue.onLevel(PaddleQueue::RIGHT, (i / 1000) % 2 == 0, t);
+        while (queue.pop(edge))
+        {
+            keyer.paddleEdge(edge.paddle, edge.pressed, edge.time);
+        }
+        keyer.update(t);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    printf("  %ld ns per paddle poll and keyer update (host)\n",
+            (long) (std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / N));
+    assertTrue("keyed", rec.sent.size() > 1000);
+}
+
+void test_IambicKeyer()
+{
+    printf("Testing IambicKeyer\n");
+    test_PaddleQueue_bounce();
+    test_PaddleQueue_overflow();
+    test_IambicKeyer_single();
+    test_IambicKeyer_modeAB();
+    test_IambicKeyer_ultimatic_nonSqueeze();
+    test_IambicKeyer_shortTaps();
+    test_IambicKeyer_latency();
+    test_IambicKeyer_tapRate();
+    test_IambicKeyer_exhaustiveCurtis();
+    test_IambicKeyer_exhaustiveLatency();
+    test_IambicKeyer_exhaustiveSqueeze();
+    test_IambicKeyer_wakeTime();
+    test_IambicKeyer_benchmark();
+}
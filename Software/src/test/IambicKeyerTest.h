@@ -0,0 +1,6 @@
+#ifndef IAMBICKEYERTEST_H_
+#define IAMBICKEYERTEST_H_
+
+void test_IambicKeyer();
+
+#endif /* IAMBICKEYERTEST_H_ */
@@ -0,0 +1,232 @@
+/*
+ * JitterBufferTest.cpp
+ *
+ *  Tests for the adaptive playout delay; replays arrival time traces through the LoRa CW streams
+ *  and compares the spacing of the played words with playout as soon as a word has arrived.
+ */
+
+#include <string.h>
+#include <math.h>
+#include <vector>
+
+#include "TestSupport.h"
+#include "JitterBuffer.h"
+#include "LoRaCWPacket.h"
+#include "LoRaCWStreams.h"
+#include "JitterBufferTest.h"
+
+void test_JitterBuffer_noJitter()
+{
+    JitterBuffer sut;
+    unsigned long t = 0;
+
+    for (int over = 0; over < 3; ++over)
+    {
+        for (int i = 0; i < 5; ++i)
+        {
+            sut.onArrival(t, 1000, i == 0);
+            t += 1000;
+        }
+        t += 20000;
+    }
+    assertEquals("test_JitterBuffer_noJitter delay", 0, sut.getTargetDelay());
+    assertEquals("test_JitterBuffer_noJitter jitter", 0, sut.getJitter());
+}
+
+void test_JitterBuffer_learns()
+{
+    JitterBuffer sut;
+
+    // the words arrive 100 and 200 ms late, then 100 ms early: 300 ms delay would have been needed
+    sut.onArrival(0, 1000, true);
+    sut.onArrival(1100, 1000, false);
+    sut.onArrival(2300, 1000, false);
+    sut.onArrival(3200, 1000, false);
+    assertTrue("test_JitterBuffer_learns jitter", sut.getJitter() > 0);
+
+    sut.onArrival(30000, 1000, true);
+    assertEquals("test_JitterBuffer_learns 1", 300, sut.getTargetDelay());
+
+    // needs just 100 ms: shrink slowly
+    sut.onArrival(31100, 1000, false);
+    sut.onArrival(60000, 1000, true);
+    assertEquals("test_JitterBuffer_learns 2", 275, sut.getTargetDelay());
+
+    // needs 1000 ms: grow fast
+    sut.onArrival(62000, 1000, false);
+    sut.onArrival(90000, 1000, true);
+    assertEquals("test_JitterBuffer_learns 3", 637, sut.getTargetDelay());
+
+    // but never more than MAX_DELAY
+    sut.onArrival(100000, 1000, false);
+    sut.onArrival(130000, 1000, true);
+    sut.onArrival(140000, 1000, false);
+    sut.onArrival(170000, 1000, true);
+    assertEquals("test_JitterBuffer_learns 4", JitterBuffer::MAX_DELAY, sut.getTargetDelay());
+}
+
+/// trace replay: a single station sends several overs; every word arrives when it has been keyed,
+/// plus the hesitation of the operator, plus some delay on the way (loop latency, retries on the sender side)
+
+struct TraceWord
+{
+        int over;
+        unsigned long arrival;
+        unsigned long duration;
+        char elements[64];
+};
+
+struct TraceResult
+{
+        double gapVariance;
+        double meanGap;
+        double meanLatency;
+};
+
+static uint32_t traceRandom(uint32_t &seed)
+{
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 16) & 0x7fff;
+}
+
+static std::vector<TraceWord> createTrace(unsigned long hesitation, unsigned long transit, uint32_t seed)
+{
+    std::vector<TraceWord> trace;
+    const uint8_t wpm = 20;
+    unsigned long keyed = 0;
+
+    for (int over = 0; over < 6; ++over)
+    {
+        for (int w = 0; w < 10; ++w)
+        {
+            TraceWord word;
+            word.over = over;
+            int n = 0;
+            int chars = 2 + traceRandom(seed) % 5;
+            for (int c = 0; c < chars; ++c)
+            {
+                int elements = 1 + traceRandom(seed) % 4;
+                for (int e = 0; e < elements; ++e)
+                {
+                    word.elements[n++] = '1' + traceRandom(seed) % 2;
+                }
+                word.elements[n++] = '0';
+            }
+            word.elements[--n] = 0;
+            word.duration = LoRaCWPacket::durationDits(word.elements) * (1200 / wpm);
+            keyed += word.duration + (hesitation ? traceRandom(seed) % hesitation : 0);
+            word.arrival = keyed + (transit ? traceRandom(seed) % transit : 0);
+            trace.push_back(word);
+        }
+        keyed += 30000;
+    }
+    for (size_t i = 1; i < trace.size(); ++i)
+    {   // packets do not overtake each other
+        if (trace[i].arrival < trace[i - 1].arrival)
+        {
+            trace[i].arrival = trace[i - 1].arrival;
+        }
+    }
+    return trace;
+}
+
+static TraceResult evaluate(std::vector<TraceWord> &trace, std::vector<unsigned long> &start)
+{
+    double sum = 0, sumSq = 0, latency = 0;
+    int gaps = 0;
+
+    for (size_t i = 0; i < trace.size(); ++i)
+    {
+        latency += start[i] - trace[i].arrival;
+        if (i > 0 && trace[i].over == trace[i - 1].over)
+        {
+            double gap = (double) start[i] - (double) (start[i - 1] + trace[i - 1].duration);
+            sum += gap;
+            sumSq += gap * gap;
+            ++gaps;
+        }
+    }
+    TraceResult r;
+    r.meanGap = sum / gaps;
+    r.gapVariance = sumSq / gaps - r.meanGap * r.meanGap;
+    r.meanLatency = latency / trace.size();
+    return r;
+}
+
+/// without jitter buffer: every word is played as soon as it is there and the previous one has ended
+static TraceResult replayImmediate(std::vector<TraceWord> &trace)
+{
+    std::vector<unsigned long> start;
+    unsigned long end = 0;
+
+    for (TraceWord &w : trace)
+    {
+        // the generator looks for a new word every few ms
+        unsigned long s = w.arrival > end ? (w.arrival + 9) / 10 * 10 : end;
+        start.push_back(s);
+        end = s + w.duration;
+    }
+    return evaluate(trace, start);
+}
+
+static TraceResult replayBuffered(std::vector<TraceWord> &trace)
+{
+    LoRaCWStreams sut;
+    std::vector<unsigned long> start;
+    unsigned long busyUntil = 0;
+    size_t arrived = 0;
+
+    for (unsigned long now = 0; start.size() < trace.size(); now += 10)
+    {
+        for (; arrived < trace.size() && trace[arrived].arrival <= now; ++arrived)
+        {
+            LoRaCWPacket::Encoder encoder;
+            encoder.start(LoRaCWPacket::VERSION_2, arrived & 0x3f, 0x42, 20);
+            for (const char *p = trace[arrived].elements; *p; ++p)
+            {
+                encoder.addElement(*p - '0');
+            }
+            encoder.addElement(0);
+            encoder.addElement(3);
+            sut.push((const uint8_t*) encoder.getBuffer(), strlen(encoder.getBuffer()), -70, now);
+        }
+        if (now >= busyUntil && sut.next(now))
+        {
+            busyUntil = now + trace[start.size()].duration;
+            start.push_back(now);
+        }
+    }
+    return evaluate(trace, start);
+}
+
+void test_JitterBuffer_traces()
+{
+    const struct
+    {
+            const char *name;
+            unsigned long hesitation;
+            unsigned long transit;
+    } traces[] = { { "steady", 50, 20 }, { "hesitant", 600, 20 }, { "late packets", 100, 800 }, { "both", 600, 800 } };
+
+    for (auto &t : traces)
+    {
+        std::vector<TraceWord> trace = createTrace(t.hesitation, t.transit, 815);
+        TraceResult immediate = replayImmediate(trace);
+        TraceResult buffered = replayBuffered(trace);
+
+        printf("  %-12s immediate: gap variance %8.0f ms^2, mean gap %4.0f ms, latency %5.0f ms; buffered: gap variance %8.0f ms^2, mean gap %4.0f ms, latency %5.0f ms (+%.0f)\n",
+                t.name, immediate.gapVariance, immediate.meanGap, immediate.meanLatency, buffered.gapVariance, buffered.meanGap,
+                buffered.meanLatency, buffered.meanLatency - immediate.meanLatency);
+
+        assertTrue("test_JitterBuffer_traces variance", buffered.gapVariance <= immediate.gapVariance);
+        assertTrue("test_JitterBuffer_traces latency", buffered.meanLatency - immediate.meanLatency <= JitterBuffer::MAX_DELAY);
+    }
+}
+
+void test_JitterBuffer()
+{
+    printf("Testing JitterBuffer\n");
+    test_JitterBuffer_noJitter();
+    test_JitterBuffer_learns();
+    test_JitterBuffer_traces();
+}
@@ -0,0 +1,6 @@
+#ifndef JITTERBUFFERTEST_H_
+#define JITTERBUFFERTEST_H_
+
+void test_JitterBuffer();
+
+#endif /* JITTERBUFFERTEST_H_ */
@@ -0,0 +1,439 @@
+/*
+ * LoRaCWStreamsTest.cpp
+ *
+ *  Tests for the CW over LoRa packet codec and the per station streams,
+ *  including a simulation of several stations sending at the same time.
+ */
+
+#include <string.h>
+#include <vector>
+#include <algorithm>
+
+#include "TestSupport.h"
+#include "LoRaCWPacket.h"
+#include "LoRaCWStreams.h"
+#include "LoRaCWStreamsTest.h"
+
+/// the encoder as it was before protocol version 2 - version 1 packets must stay bit-identical
+static void legacyCwForLora(char *loraTxBuffer, int &pairCounter, uint8_t serial, uint8_t wpm, int element)
+{
+    uint8_t temp;
+
+    if (pairCounter == 0)
+    {
+        for (int i = 0; i < 32; ++i)
+        {
+            loraTxBuffer[i] = (char) 0;
+        }
+        loraTxBuffer[0] = serial % 64 + 64;
+        loraTxBuffer[1] |= wpm * 4;
+        pairCounter = 7;
+    }
+
+    temp = element & 3;
+    if (temp && (temp != 3))
+    {
+        temp = temp << (2 * (3 - (pairCounter % 4)));
+        loraTxBuffer[pairCounter / 4] |= temp;
+    }
+    if (temp != 3)
+    {
+        ++pairCounter;
+    }
+    else
+    {
+        --pairCounter;
+        if (pairCounter % 4 != 0)
+        {
+            temp = temp << (2 * (3 - (pairCounter % 4)));
+            loraTxBuffer[pairCounter / 4] |= temp;
+        }
+        pairCounter = 0;
+    }
+}
+
+static void encode(LoRaCWPacket::Encoder &encoder, uint8_t version, uint8_t serial, uint8_t station, uint8_t wpm, const char *elements)
+{
+    encoder.start(version, serial, station, wpm);
+    for (const char *p = elements; *p; ++p)
+    {
+        encoder.addElement(*p - '0');
+    }
+    encoder.addElement(0);
+    encoder.addElement(3);
+}
+
+static const char *testWords[] = { "1", "2", "1210", "2120212", "12101211012121", "2121022120", "1222201222201222201222201222201222201222",
+        "12222012222012222012222012222012222012222012222012222012222012222012222012222012222012222012222012222" };
+
+void test_LoRaCWPacket_legacyEncoding()
+{
+    for (const char *word : testWords)
+    {
+        char legacy[32];
+        int pairCounter = 0;
+        for (const char *p = word; *p; ++p)
+        {
+            legacyCwForLora(legacy, pairCounter, 17, 20, *p - '0');
+        }
+        legacyCwForLora(legacy, pairCounter, 17, 20, 0);
+        legacyCwForLora(legacy, pairCounter, 17, 20, 3);
+        if (strlen(word) > 100)
+        {
+            continue;       // the legacy encoder overflows its buffer here
+        }
+
+        LoRaCWPacket::Encoder encoder;
+        encode(encoder, LoRaCWPacket::VERSION_1, 17, 0, 20, word);
+        assertTrue("test_LoRaCWPacket_legacyEncoding", memcmp(legacy, encoder.getBuffer(), 32) == 0);
+    }
+}
+
+void test_LoRaCWPacket_roundtrip(uint8_t version)
+{
+    for (const char *word : testWords)
+    {
+        LoRaCWPacket::Encoder encoder;
+        encode(encoder, version, 42, 0xa5, 33, word);
+        const uint8_t *data = (const uint8_t*) encoder.getBuffer();
+        uint8_t length = strlen(encoder.getBuffer());
+
+        LoRaCWPacket::Header header;
+        assertTrue("test_LoRaCWPacket_roundtrip header", LoRaCWPacket::decodeHeader(data, length, header));
+        assertEquals("test_LoRaCWPacket_roundtrip version", version, header.version);
+        assertEquals("test_LoRaCWPacket_roundtrip serial", 42, header.serial);
+        assertEquals("test_LoRaCWPacket_roundtrip station", version == LoRaCWPacket::VERSION_2 ? 0xa5 : 0, header.station);
+        assertEquals("test_LoRaCWPacket_roundtrip wpm", 33, header.wpm);
+
+        char elements[LoRaCWPacket::MAX_ELEMENTS + 1];
+        LoRaCWPacket::decodeElements(data, length, elements, sizeof(elements));
+        if (strlen(word) < 100)
+        {
+            assertEquals("test_LoRaCWPacket_roundtrip elements", word, elements);
+        }
+        else
+        {   // too long for one packet: we get a truncated word, but no overflow
+            assertTrue("test_LoRaCWPacket_roundtrip truncated", strncmp(word, elements, strlen(elements)) == 0);
+            assertTrue("test_LoRaCWPacket_roundtrip length", length < LoRaCWPacket::TX_BUFFER_SIZE);
+        }
+    }
+}
+
+void test_LoRaCWPacket_invalid()
+{
+    LoRaCWPacket::Header header;
+    const uint8_t badVersion[] = { 0xc1, 0x50 };
+    const uint8_t badWpm[] = { 0x41, 0x04 };
+    const uint8_t shortV2[] = { 0x81, 0x12 };
+    assertFalse("test_LoRaCWPacket_invalid version", LoRaCWPacket::decodeHeader(badVersion, 2, header));
+    assertFalse("test_LoRaCWPacket_invalid wpm", LoRaCWPacket::decodeHeader(badWpm, 2, header));
+    assertFalse("test_LoRaCWPacket_invalid short", LoRaCWPacket::decodeHeader(shortV2, 2, header));
+}
+
+void test_LoRaCWPacket_durationDits()
+{
+    assertEquals("test_LoRaCWPacket_durationDits E", 8, LoRaCWPacket::durationDits("1"));
+    // PARIS
+    assertEquals("test_LoRaCWPacket_durationDits PARIS", 50, LoRaCWPacket::durationDits("122101201210110111"));
+}
+
+void test_LoRaCWPacket_stationFromId()
+{
+    uint8_t mac[6] = { 0x24, 0x0a, 0xc4, 0x11, 0x22, 0x33 };
+    for (int i = 0; i < 256; ++i)
+    {
+        mac[5] = i;
+        assertTrue("test_LoRaCWPacket_stationFromId", LoRaCWPacket::stationFromId(mac, 6) != 0);
+    }
+}
+
+static void pushWord(LoRaCWStreams &sut, uint8_t station, uint8_t serial, const char *elements, unsigned long now)
+{
+    LoRaCWPacket::Encoder encoder;
+    encode(encoder, LoRaCWPacket::VERSION_2, serial, station, 20, elements);
+    sut.push((const uint8_t*) encoder.getBuffer(), strlen(encoder.getBuffer()), -80, now);
+}
+
+void test_LoRaCWStreams_sequential()
+{
+    LoRaCWStreams sut;
+
+    pushWord(sut, 1, 1, "1", 0);
+    pushWord(sut, 2, 1, "2", 100);
+    pushWord(sut, 1, 2, "1", 1000);
+
+    const LoRaCWStreams::Word *w = sut.next(1000);
+    assertEquals("test_LoRaCWStreams_sequential 1", 1, w->header.station);
+    w = sut.next(1100);
+    assertEquals("test_LoRaCWStreams_sequential 2", 1, w->header.station);
+    assertEquals("test_LoRaCWStreams_sequential 3", 2, w->header.serial);
+
+    // station 1 may still continue its over
+    assertTrue("test_LoRaCWStreams_sequential 4", sut.next(1200) == 0);
+    w = sut.next(1000 + sut.holdTime(0));
+    assertEquals("test_LoRaCWStreams_sequential 5", 2, w->header.station);
+    assertEquals("test_LoRaCWStreams_sequential 6", 2, sut.getCurrentStation());
+    assertTrue("test_LoRaCWStreams_sequential 7", sut.isEmpty());
+    assertEquals("test_LoRaCWStreams_sequential switches", 1, sut.getStats().switches);
+}
+
+/// version 2 is only sent to a net in which it has been heard: version 1 receivers drop it
+void test_LoRaCWStreams_version2Heard()
+{
+    LoRaCWStreams sut;
+    LoRaCWPacket::Encoder encoder;
+
+    encode(encoder, LoRaCWPacket::VERSION_1, 1, 0, 20, "12");
+    sut.push((const uint8_t*) encoder.getBuffer(), strlen(encoder.getBuffer()), -80, 0);
+    assertFalse("test_LoRaCWStreams_version2Heard version 1", sut.hasHeardVersion2());
+    pushWord(sut, 3, 1, "12", 100);
+    assertTrue("test_LoRaCWStreams_version2Heard version 2", sut.hasHeardVersion2());
+    sut.clear();
+    assertFalse("test_LoRaCWStreams_version2Heard clear", sut.hasHeardVersion2());
+}
+
+void test_LoRaCWStreams_lossAndOverflow()
+{
+    LoRaCWStreams sut;
+
+    for (int i = 0; i < LoRaCWStreams::SLOTS + 2; ++i)
+    {
+        pushWord(sut, 7, i * 2, "12", i * 100);
+    }
+    LoRaCWStreams::Stats stats = sut.getStats();
+    assertEquals("test_LoRaCWStreams_lossAndOverflow received", LoRaCWStreams::SLOTS + 2, stats.received);
+    assertEquals("test_LoRaCWStreams_lossAndOverflow dropped", 2, stats.dropped);
+    assertEquals("test_LoRaCWStreams_lossAndOverflow lost", LoRaCWStreams::SLOTS + 1, stats.lost);
+
+    // more stations than streams: the one silent for the longest time is replaced as soon as it is played out
+    for (int i = 0; i < LoRaCWStreams::MAX_STREAMS; ++i)
+    {
+        pushWord(sut, 10 + i, 0, "1", 1000 + i);
+    }
+    assertEquals("test_LoRaCWStreams_lossAndOverflow no stream", 3, sut.getStats().dropped);
+
+    // a packet received twice is dropped, one that comes late is played, and neither counts as lost
+    LoRaCWStreams other;
+    pushWord(other, 1, 10, "1", 0);
+    pushWord(other, 1, 10, "1", 10);
+    pushWord(other, 1, 12, "1", 20);
+    pushWord(other, 1, 11, "1", 30);
+    pushWord(other, 1, 13, "1", 40);
+    stats = other.getStats();
+    assertEquals("test_LoRaCWStreams_lossAndOverflow duplicate received", 5, stats.received);
+    assertEquals("test_LoRaCWStreams_lossAndOverflow duplicate lost", 1, stats.lost);
+    int words = 0;
+    while (other.next(10000))
+    {
+        ++words;
+    }
+    assertEquals("test_LoRaCWStreams_lossAndOverflow duplicate words", 4, words);
+}
+
+/// millis() wraps around after 49 days: the stream that is replaced is the one silent for the longest time
+void test_LoRaCWStreams_wrap()
+{
+    LoRaCWStreams sut;
+    const unsigned long start = 0 - 0x100ul;                      // 0x100 ms before the wrap
+
+    pushWord(sut, 1, 1, "1", start);
+    for (int i = 1; i < LoRaCWStreams::MAX_STREAMS; ++i)
+    {
+        pushWord(sut, 1 + i, 1, "1", start + 0x100 * i);        // 0x100, 0x200, ... after the wrap
+    }
+    unsigned long now = start + 0x100 * LoRaCWStreams::MAX_STREAMS;
+    int words = 0;
+    for (; !sut.isEmpty(); now += 100)
+    {
+        words += sut.next(now) != 0;
+    }
+    assertEquals("test_LoRaCWStreams_wrap order", 4, sut.getCurrentStation());
+    now += LoRaCWStreams::MAX_HOLD;
+    pushWord(sut, 9, 1, "1", now);                              // replaces station 1, the oldest
+    pushWord(sut, 2, 4, "1", now + 100);                        // station 2 is still known: 2 packets lost
+    assertEquals("test_LoRaCWStreams_wrap words", LoRaCWStreams::MAX_STREAMS, words);
+    assertEquals("test_LoRaCWStreams_wrap lost", 2, sut.getStats().lost);
+    assertEquals("test_LoRaCWStreams_wrap dropped", 0, sut.getStats().dropped);
+}
+
+/// simulation of a net: several stations send overs that overlap in time; every word is sent as soon as it
+/// has been keyed, and the receiver plays one word after the other at the speed of the sender
+
+struct SimWord
+{
+        uint8_t station;
+        uint8_t over;
+        unsigned long arrival;
+        uint8_t wpm;
+        unsigned long duration;
+        char elements[64];
+};
+
+struct SimResult
+{
+        int words;
+        int interleavingErrors;
+        unsigned long avgLatency;
+        unsigned long maxLatency;
+};
+
+static uint32_t simRandom(uint32_t &seed)
+{
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 16) & 0x7fff;
+}
+
+static std::vector<SimWord> createTraffic(int stations, int overs, int wordsPerOver, uint32_t seed)
+{
+    std::vector<SimWord> traffic;
+    const uint8_t wpm[] = { 20, 15, 25, 18 };
+
+    for (int s = 0; s < stations; ++s)
+    {
+        unsigned long t = 700 * s;
+        for (int o = 0; o < overs; ++o)
+        {
+            for (int w = 0; w < wordsPerOver; ++w)
+            {
+                SimWord word;
+                word.station = s + 1;
+                word.over = o;
+                int n = 0;
+                int chars = 2 + simRandom(seed) % 5;
+                for (int c = 0; c < chars; ++c)
+                {
+                    int elements = 1 + simRandom(seed) % 4;
+                    for (int e = 0; e < elements; ++e)
+                    {
+                        word.elements[n++] = '1' + simRandom(seed) % 2;
+                    }
+                    word.elements[n++] = '0';
+                }
+                word.elements[--n] = 0;
+                word.wpm = wpm[s];
+                word.duration = LoRaCWPacket::durationDits(word.elements) * (1200 / wpm[s]);
+                t += word.duration + simRandom(seed) % 300;     // keying time plus a little hesitation
+                word.arrival = t;
+                traffic.push_back(word);
+            }
+            t += stations * 20000 + simRandom(seed) % 10000;     // listening to the others
+        }
+    }
+    std::stable_sort(traffic.begin(), traffic.end(), [](const SimWord &a, const SimWord &b) {
+        return a.arrival < b.arrival;
+    });
+    return traffic;
+}
+
+static SimResult evaluate(std::vector<const SimWord*> &played, std::vector<unsigned long> &latency)
+{
+    SimResult r = { (int) played.size(), 0, 0, 0 };
+    unsigned long sum = 0;
+
+    for (size_t i = 0; i < played.size(); ++i)
+    {
+        // a word interrupts an over if the station played before still has words of that over to come
+        if (i > 0 && played[i]->station != played[i - 1]->station)
+        {
+            for (size_t j = i + 1; j < played.size(); ++j)
+            {
+                if (played[j]->station == played[i - 1]->station && played[j]->over == played[i - 1]->over)
+                {
+                    ++r.interleavingErrors;
+                    break;
+                }
+            }
+        }
+        sum += latency[i];
+        r.maxLatency = latency[i] > r.maxLatency ? latency[i] : r.maxLatency;
+    }
+    r.avgLatency = played.size() ? sum / played.size() : 0;
+    return r;
+}
+
+static SimResult simulate(std::vector<SimWord> &traffic, boolean useStreams)
+{
+    LoRaCWStreams sut;
+    const SimWord *bySerial[8][64];
+    std::vector<const SimWord*> played;
+    std::vector<unsigned long> latency;
+    uint8_t serial[8] = { 0 };
+    unsigned long busyUntil = 0;
+    size_t arrived = 0;
+
+    unsigned long end = traffic.back().arrival + 300000;
+
+    for (unsigned long now = 0; played.size() < traffic.size() && now < end; now += 10)
+    {
+        for (; arrived < traffic.size() && traffic[arrived].arrival <= now; ++arrived)
+        {
+            const SimWord &w = traffic[arrived];
+            LoRaCWPacket::Encoder encoder;
+            encode(encoder, LoRaCWPacket::VERSION_2, serial[w.station], w.station, w.wpm, w.elements);
+            bySerial[w.station][serial[w.station]] = &w;
+            serial[w.station] = (serial[w.station] + 1) & 0x3f;
+            sut.push((const uint8_t*) encoder.getBuffer(), strlen(encoder.getBuffer()), -80, now);
+        }
+
+        if (now < busyUntil)
+        {
+            continue;
+        }
+
+        const SimWord *w = 0;
+        if (useStreams)
+        {
+            const LoRaCWStreams::Word *sw = sut.next(now);
+            if (sw)
+            {
+                w = bySerial[sw->header.station][sw->header.serial];
+            }
+        }
+        else if (played.size() < arrived)
+        {
+            w = &traffic[played.size()];
+        }
+
+        if (w)
+        {
+            played.push_back(w);
+            latency.push_back(now - w->arrival);
+            busyUntil = now + w->duration;
+        }
+    }
+    return evaluate(played, latency);
+}
+
+void test_LoRaCWStreams_simulation()
+{
+    for (int stations = 2; stations <= 4; ++stations)
+    {
+        std::vector<SimWord> traffic = createTraffic(stations, 3, 8, 4711 + stations);
+        SimResult fifo = simulate(traffic, false);
+        SimResult streams = simulate(traffic, true);
+
+        printf("  %d stations, %d words: FIFO %d interleavings, latency avg %lu max %lu ms; streams %d interleavings, latency avg %lu max %lu ms\n",
+                stations, fifo.words, fifo.interleavingErrors, fifo.avgLatency, fifo.maxLatency, streams.interleavingErrors,
+                streams.avgLatency, streams.maxLatency);
+
+        assertEquals("test_LoRaCWStreams_simulation words", fifo.words, streams.words);
+        assertTrue("test_LoRaCWStreams_simulation fifo interleaves", fifo.interleavingErrors > 0);
+        assertEquals("test_LoRaCWStreams_simulation streams", 0, streams.interleavingErrors);
+    }
+}
+
+void test_LoRaCWStreams()
+{
+    printf("Testing LoRaCWStreams\n");
+    test_LoRaCWPacket_legacyEncoding();
+    test_LoRaCWPacket_roundtrip(LoRaCWPacket::VERSION_1);
+    test_LoRaCWPacket_roundtrip(LoRaCWPacket::VERSION_2);
+    test_LoRaCWPacket_invalid();
+    test_LoRaCWPacket_durationDits();
+    test_LoRaCWPacket_stationFromId();
+    test_LoRaCWStreams_sequential();
+    test_LoRaCWStreams_version2Heard();
+    test_LoRaCWStreams_lossAndOverflow();
+    test_LoRaCWStreams_wrap();
+    test_LoRaCWStreams_simulation();
+}
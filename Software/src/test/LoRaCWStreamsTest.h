@@ -0,0 +1,6 @@
+#ifndef LORACWSTREAMSTEST_H_
+#define LORACWSTREAMSTEST_H_
+
+void test_LoRaCWStreams();
+
+#endif /* LORACWSTREAMSTEST_H_ */
@@ -0,0 +1,242 @@
+/*
+ * PowerPolicyTest.cpp
+ *
+ *  Tests for the power policy. The session traces are synthetic: words keyed at 20 WpM with pauses between
+ *  them and one long break, replayed through a main loop that wakes up for its user interface task every
+ *  10 ms and for every key edge, the way the scheduler does it on the Morserino.
+ */
+
+#include <vector>
+
+#include "TestSupport.h"
+#include "PowerPolicy.h"
+#include "PowerPolicyTest.h"
+
+static const PowerPolicy::Profile ALWAYS_ON = { true, false, 0, 0 };
+static const PowerPolicy::Profile KEYER = { false, true, 20000, 500 };
+static const PowerPolicy::Profile LORA = { true, false, 20000, 500 };
+
+static uint32_t seed;
+
+static uint32_t nextRandom()
+{
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 8) & 0xffffff;
+}
+
+struct Segment
+{
+        unsigned long length;           // µs
+        boolean sounding;               // key down: the sidetone is on
+        boolean input;                  // a paddle is pressed at the start
+};
+
+struct SessionResult
+{
+        PowerPolicy::Estimate estimate;
+        unsigned long refreshes;
+        unsigned long refused;
+};
+
+/// 10 minutes: keyed words (3 to 6 characters of 2 to 4 elements, dit = 60 ms) for 40 s, then 20 s of reading,
+/// and a break of 2 minutes in the middle
+static std::vector<Segment> keyerSession()
+{
+    const unsigned long dit = 60000;
+    std::vector<Segment> s;
+
+    seed = 4711;
+    for (int minute = 0; minute < 10; ++minute)
+    {
+        if (minute == 4 || minute == 5)
+        {
+            s.push_back( { 60000000, false, false });
+            continue;
+        }
+        unsigned long keyed = 0;
+        while (keyed < 40000000)
+        {
+            int chars = 3 + nextRandom() % 4;
+            for (int c = 0; c < chars; ++c)
+            {
+                int elements = 2 + nextRandom() % 3;
+                for (int e = 0; e < elements; ++e)
+                {
+                    unsigned long down = nextRandom() % 2 ? 3 * dit : dit;
+                    s.push_back( { down, true, true });
+                    s.push_back( { dit, false, false });
+                    keyed += down + dit;
+                }
+                s.push_back( { 2 * dit, false, false });
+                keyed += 2 * dit;
+            }
+            s.push_back( { 4 * dit, false, false });
+            keyed += 4 * dit;
+        }
+        s.push_back( { 60000000 - keyed, false, false });
+    }
+    return s;
+}
+
+/// replaySession runs the main loop over the trace: 300 µs of work for each wake-up, a refresh of the display
+/// every 100 ms, and the time until the next UI tick or key edge for the policy
+static SessionResult replaySession(const std::vector<Segment> &session, const PowerPolicy::Profile &profile)
+{
+    const unsigned long work = 300;
+    const unsigned long uiPeriod = 10000;
+    SessionResult r = { };
+    PowerPolicy sut;
+    unsigned long now = 0;
+    unsigned long nextFrame = 0;
+
+    sut.begin(now);
+    sut.setProfile(profile, now);
+    for (const Segment &seg : session)
+    {
+        unsigned long end = now + seg.length;
+        if (seg.input)
+        {
+            sut.onInput(now);
+        }
+        while (now < end)
+        {
+            now += work;
+            sut.update(now);
+            if (now >= nextFrame)
+            {
+                nextFrame += 100000;
+                if (sut.mayRefresh(now))
+                {
+                    ++r.refreshes;
+                }
+                else
+                {
+                    ++r.refused;
+                }
+            }
+            unsigned long next = (now / uiPeriod + 1) * uiPeriod;
+            if (next > end)
+            {
+                next = end;
+            }
+            if (next <= now)
+            {
+                continue;
+            }
+            unsigned long wait = next - now;
+            PowerPolicy::Sleep how = sut.chooseSleep(wait, seg.sounding);
+            if (how == PowerPolicy::LIGHT_SLEEP)
+            {
+                sut.slept(how, wait - PowerPolicy::WAKE_LATENCY);
+            }
+            else if (how == PowerPolicy::WAIT)
+            {
+                sut.slept(how, wait);
+            }
+            now = next;
+        }
+    }
+    r.estimate = sut.getEstimate(now);
+    return r;
+}
+
+void test_PowerPolicy_chooseSleep()
+{
+    PowerPolicy sut;
+
+    sut.setProfile(KEYER, 0);
+    assertEquals("test_PowerPolicy_chooseSleep too short", PowerPolicy::RUN, sut.chooseSleep(999, false));
+    assertEquals("test_PowerPolicy_chooseSleep short wait", PowerPolicy::WAIT, sut.chooseSleep(4999, false));
+    assertEquals("test_PowerPolicy_chooseSleep light sleep", PowerPolicy::LIGHT_SLEEP, sut.chooseSleep(5000, false));
+    assertEquals("test_PowerPolicy_chooseSleep not while sounding", PowerPolicy::WAIT, sut.chooseSleep(100000, true));
+
+    sut.setProfile(LORA, 0);
+    assertEquals("test_PowerPolicy_chooseSleep no light sleep for LoRa", PowerPolicy::WAIT, sut.chooseSleep(100000, false));
+    assertTrue("test_PowerPolicy_chooseSleep radio on for LoRa", sut.isRadioOn());
+    sut.setProfile(KEYER, 0);
+    assertFalse("test_PowerPolicy_chooseSleep radio off for keyer", sut.isRadioOn());
+}
+
+void test_PowerPolicy_dimming()
+{
+    PowerPolicy sut;
+
+    sut.begin(1000);
+    sut.setProfile(KEYER, 1000);
+    sut.update(20000999);
+    assertEquals("test_PowerPolicy_dimming full before dimAfter", PowerPolicy::DISPLAY_FULL, sut.getDisplay());
+    assertTrue("test_PowerPolicy_dimming refresh while full", sut.mayRefresh(20000999));
+    assertTrue("test_PowerPolicy_dimming refresh again while full", sut.mayRefresh(20001000));
+    sut.update(20001000);
+    assertEquals("test_PowerPolicy_dimming dimmed", PowerPolicy::DISPLAY_DIMMED, sut.getDisplay());
+    assertFalse("test_PowerPolicy_dimming throttled", sut.mayRefresh(20400000));
+    assertTrue("test_PowerPolicy_dimming frame interval", sut.mayRefresh(20501000));
+    assertFalse("test_PowerPolicy_dimming throttled again", sut.mayRefresh(20600000));
+
+    sut.onInput(20700000);
+    assertEquals("test_PowerPolicy_dimming input", PowerPolicy::DISPLAY_FULL, sut.getDisplay());
+    assertTrue("test_PowerPolicy_dimming refresh after input", sut.mayRefresh(20700000));
+
+    sut.setProfile(ALWAYS_ON, 20700000);
+    sut.update(500000000);
+    assertEquals("test_PowerPolicy_dimming never", PowerPolicy::DISPLAY_FULL, sut.getDisplay());
+}
+
+void test_PowerPolicy_estimate()
+{
+    PowerPolicy sut;
+    PowerPolicy::Estimate e;
+
+    sut.begin(0);
+    sut.setProfile(ALWAYS_ON, 0);
+    e = sut.getEstimate(3600000000UL);
+    unsigned long allOn = PowerPolicy::CURRENTS.run + PowerPolicy::CURRENTS.radioReceive
+            + PowerPolicy::CURRENTS.displayFull + PowerPolicy::CURRENTS.base;
+    assertEquals("test_PowerPolicy_estimate seconds", 3600, e.seconds);
+    assertEquals("test_PowerPolicy_estimate µAh in an hour", allOn, e.microAmpHours);
+    assertEquals("test_PowerPolicy_estimate average", allOn, e.averageMicroAmps);
+
+    sut.begin(0);
+    sut.setProfile(KEYER, 0);
+    sut.slept(PowerPolicy::WAIT, 250000);
+    sut.slept(PowerPolicy::LIGHT_SLEEP, 500000);
+    sut.update(1000000);
+    e = sut.getEstimate(1000000);
+    unsigned long mixed = (PowerPolicy::CURRENTS.run + PowerPolicy::CURRENTS.wait + 2 * PowerPolicy::CURRENTS.lightSleep) / 4
+            + PowerPolicy::CURRENTS.displayFull + PowerPolicy::CURRENTS.base;
+    assertEquals("test_PowerPolicy_estimate mixed", mixed, e.averageMicroAmps);
+    assertEquals("test_PowerPolicy_estimate sleep percent", 50, e.sleepPercent);
+}
+
+void test_PowerPolicy_session()
+{
+    std::vector<Segment> session = keyerSession();
+    SessionResult before = replaySession(session, ALWAYS_ON);
+    SessionResult keyer = replaySession(session, KEYER);
+    SessionResult lora = replaySession(session, LORA);
+
+    printf("  10 min keyer session, always on:     %5lu µA, %3u%% light sleep, %4lu refreshes\n",
+            before.estimate.averageMicroAmps, before.estimate.sleepPercent, before.refreshes);
+    printf("  10 min keyer session, keyer profile: %5lu µA, %3u%% light sleep, %4lu refreshes\n",
+            keyer.estimate.averageMicroAmps, keyer.estimate.sleepPercent, keyer.refreshes);
+    printf("  10 min keyer session, LoRa profile:  %5lu µA, %3u%% light sleep, %4lu refreshes\n",
+            lora.estimate.averageMicroAmps, lora.estimate.sleepPercent, lora.refreshes);
+
+    assertEquals("test_PowerPolicy_session length", 600, keyer.estimate.seconds);
+    assertEquals("test_PowerPolicy_session no light sleep always on", 0, before.estimate.sleepPercent);
+    assertEquals("test_PowerPolicy_session no light sleep with LoRa", 0, lora.estimate.sleepPercent);
+    assertEquals("test_PowerPolicy_session no refresh refused always on", 0, before.refused);
+    assertTrue("test_PowerPolicy_session mostly asleep", keyer.estimate.sleepPercent > 60);
+    assertTrue("test_PowerPolicy_session keyer saves a third", keyer.estimate.averageMicroAmps < before.estimate.averageMicroAmps / 3 * 2);
+    assertTrue("test_PowerPolicy_session LoRa saves something", lora.estimate.averageMicroAmps < before.estimate.averageMicroAmps);
+    assertTrue("test_PowerPolicy_session fewer refreshes in the break", keyer.refreshes < before.refreshes);
+}
+
+void test_PowerPolicy()
+{
+    printf("Testing PowerPolicy\n");
+    test_PowerPolicy_chooseSleep();
+    test_PowerPolicy_dimming();
+    test_PowerPolicy_estimate();
+    test_PowerPolicy_session();
+}
@@ -0,0 +1,6 @@
+#ifndef POWERPOLICYTEST_H_
+#define POWERPOLICYTEST_H_
+
+void test_PowerPolicy();
+
+#endif /* POWERPOLICYTEST_H_ */
@@ -0,0 +1,262 @@
+/*
+ * PrefsStoreTest.cpp
+ *
+ *  Tests for the preferences blob, with an in-memory replacement of NVS that counts what is written.
+ */
+
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "TestSupport.h"
+#include "PrefsStore.h"
+#include "PrefsStoreTest.h"
+
+using namespace MorsePreferences;
+
+class MemoryStorage: public PrefsStore::Storage
+{
+    public:
+        typedef std::map<std::string, std::vector<uint8_t>> Namespace;
+
+        std::map<std::string, Namespace> namespaces;
+        Namespace *open = 0;
+        unsigned long writes = 0;
+        unsigned long bytes = 0;
+
+        boolean begin(const char *name, boolean readOnly)
+        {
+            if (readOnly && !namespaces.count(name))
+            {
+                return false;
+            }
+            open = &namespaces[name];
+            return true;
+        }
+        void end()
+        {
+            open = 0;
+        }
+        size_t getBytesLength(const char *key)
+        {
+            return open->count(key) ? (*open)[key].size() : 0;
+        }
+        size_t getBytes(const char *key, void *buffer, size_t length)
+        {
+            if (!open->count(key) || (*open)[key].size() > length)
+            {
+                return 0;
+            }
+            std::vector<uint8_t> &v = (*open)[key];
+            memcpy(buffer, v.data(), v.size());
+            return v.size();
+        }
+        size_t putBytes(const char *key, const void *buffer, size_t length)
+        {
+            ++writes;
+            bytes += length;
+            (*open)[key] = std::vector<uint8_t>((const uint8_t*) buffer, (const uint8_t*) buffer + length);
+            return length;
+        }
+        uint8_t getUChar(const char *key, uint8_t defaultValue)
+        {
+            return open->count(key) ? (*open)[key][0] : defaultValue;
+        }
+        boolean getBool(const char *key, boolean defaultValue)
+        {
+            return open->count(key) ? (*open)[key][0] != 0 : defaultValue;
+        }
+        uint32_t getUInt(const char *key, uint32_t defaultValue)
+        {
+            uint32_t v;
+            return open->count(key) ? (memcpy(&v, (*open)[key].data(), 4), v) : defaultValue;
+        }
+
+        /// what former versions wrote, one key per value
+        void putUChar(const char *key, uint8_t v)
+        {
+            putBytes(key, &v, 1);
+        }
+        void putBool(const char *key, boolean v)
+        {
+            uint8_t b = v;
+            putBytes(key, &b, 1);
+        }
+        void putUInt(const char *key, uint32_t v)
+        {
+            putBytes(key, &v, 4);
+        }
+};
+
+static boolean same(MorsePrefs &a, MorsePrefs &b)
+{
+    uint8_t ba[PrefsStore::MAX_SIZE], bb[PrefsStore::MAX_SIZE];
+    uint8_t la = PrefsStore::encode(a, ba);
+    uint8_t lb = PrefsStore::encode(b, bb);
+    return la == lb && memcmp(ba, bb, la) == 0;
+}
+
+void test_PrefsStore_encode()
+{
+    MorsePrefs p, q;
+    p.wpm = 27;
+    p.didah = true;
+    p.loraQRG = 869150000;
+    p.tennisScoringRules = 0;
+    uint8_t buffer[PrefsStore::MAX_SIZE];
+    uint8_t length = PrefsStore::encode(p, buffer);
+    printf("  preferences blob: %d bytes\n", length);
+    assertTrue("test_PrefsStore_encode size", length <= PrefsStore::MAX_SIZE);
+
+    assertTrue("test_PrefsStore_encode decode", PrefsStore::decode(buffer, length, q));
+    assertEquals("test_PrefsStore_encode wpm", 27, q.wpm);
+    assertEquals("test_PrefsStore_encode didah", true, q.didah);
+    assertEquals("test_PrefsStore_encode qrg", 869150000, q.loraQRG);
+    assertEquals("test_PrefsStore_encode tennis", 0, q.tennisScoringRules);
+    assertTrue("test_PrefsStore_encode same", same(p, q));
+
+    // a damaged blob is refused and leaves the preferences alone
+    MorsePrefs r;
+    buffer[10] ^= 0x04;
+    assertFalse("test_PrefsStore_encode crc", PrefsStore::decode(buffer, length, r));
+    assertEquals("test_PrefsStore_encode crc wpm", 15, r.wpm);
+    buffer[10] ^= 0x04;
+    assertFalse("test_PrefsStore_encode short", PrefsStore::decode(buffer, length - 1, r));
+
+    // an older, shorter layout, without tennisScoringRules and what came later: the missing values keep their defaults
+    uint8_t older[PrefsStore::MAX_SIZE];
+    memcpy(older, buffer, length);
+    uint8_t payload = length - PrefsStore::HEADER_SIZE - 10;    // tennisScoringRules and the 9 after it, up to loraStationIds
+    older[1] = payload;
+    uint16_t crc = PrefsStore::crc16(older + PrefsStore::HEADER_SIZE, payload);
+    older[2] = crc & 0xff;
+    older[3] = crc >> 8;
+    MorsePrefs s;
+    assertTrue("test_PrefsStore_encode older", PrefsStore::decode(older, payload + PrefsStore::HEADER_SIZE, s));
+    assertEquals("test_PrefsStore_encode older wpm", 27, s.wpm);
+    assertEquals("test_PrefsStore_encode older tennis", 1, s.tennisScoringRules);
+}
+
+void test_PrefsStore_migration()
+{
+    MemoryStorage nvs;
+    nvs.begin("morserino", false);
+    nvs.putUChar("wpm", 22);
+    nvs.putUChar("sidetoneVolume", 0);
+    nvs.putUChar("randomOption", 0);
+    nvs.putUChar("farnsworthMode", 5);
+    nvs.putUChar("kochFilter", 17);
+    nvs.putBool("didah", false);
+    nvs.putBool("quickStart", true);
+    nvs.putUInt("fileWordPtr", 4711);
+    nvs.putUInt("loraQRG", 869150000);
+    nvs.putUChar("loraBand", 1);
+    nvs.putUChar("snapShots", 5);
+    nvs.putUChar("lastExecuted", 12);
+    nvs.end();
+    nvs.begin("snap0", false);
+    nvs.putUChar("wpm", 30);
+    nvs.putUChar("farnsworthMode", 4);
+    nvs.end();
+    unsigned long legacyWrites = nvs.writes;
+
+    PrefsStore sut(nvs);
+    MorsePrefs p;
+    assertTrue("test_PrefsStore_migration load", sut.load("morserino", p, true));
+    assertEquals("test_PrefsStore_migration wpm", 22, p.wpm);
+    assertEquals("test_PrefsStore_migration volume", 0, p.sidetoneVolume);
+    assertEquals("test_PrefsStore_migration option", 0, p.randomOption);
+    assertEquals("test_PrefsStore_migration space", 5, p.interCharSpace);
+    assertEquals("test_PrefsStore_migration koch", 17, p.kochFilter);
+    assertEquals("test_PrefsStore_migration didah", false, p.didah);
+    assertEquals("test_PrefsStore_migration clicks", true, p.encoderClicks);
+    assertEquals("test_PrefsStore_migration quick", true, p.quickStart);
+    assertEquals("test_PrefsStore_migration pointer", 4711, p.fileWordPointer);
+    assertEquals("test_PrefsStore_migration qrg", 869150000, p.loraQRG);
+    assertEquals("test_PrefsStore_migration band", 1, p.loraBand);
+    assertEquals("test_PrefsStore_migration snapshots", 5, p.snapShots);
+    assertEquals("test_PrefsStore_migration menu", 12, p.menuPtr);
+    assertEquals("test_PrefsStore_migration keyer", 2, p.keyermode);
+    assertEquals("test_PrefsStore_migration writes", 1, nvs.writes - legacyWrites);
+    assertEquals("test_PrefsStore_migration blob", 1, nvs.namespaces["morserino"].count(PrefsStore::KEY));
+
+    // from now on the blob is read
+    nvs.namespaces["morserino"]["wpm"][0] = 33;
+    MorsePrefs q;
+    assertTrue("test_PrefsStore_migration reload", sut.load("morserino", q, true));
+    assertTrue("test_PrefsStore_migration same", same(p, q));
+    assertEquals("test_PrefsStore_migration rewrites", 1, nvs.writes - legacyWrites);
+
+    // snapshots are migrated when read, but not written, and keep what belongs to the device
+    MorsePrefs snap;
+    assertTrue("test_PrefsStore_migration snap", sut.load("snap0", snap, false));
+    PrefsStore::keepDeviceSettings(snap, q);
+    assertEquals("test_PrefsStore_migration snap wpm", 30, snap.wpm);
+    assertEquals("test_PrefsStore_migration snap space", 4, snap.interCharSpace);
+    assertEquals("test_PrefsStore_migration snap koch", 17, snap.kochFilter);
+    assertEquals("test_PrefsStore_migration snap qrg", 869150000, snap.loraQRG);
+    assertEquals("test_PrefsStore_migration snap writes", 1, nvs.writes - legacyWrites);
+    MorsePrefs none;
+    assertFalse("test_PrefsStore_migration no snap", sut.load("snap3", none, false));
+
+    // an empty device starts with the defaults
+    MemoryStorage empty;
+    PrefsStore fresh(empty);
+    MorsePrefs d, defaults;
+    assertTrue("test_PrefsStore_migration fresh", fresh.load("morserino", d, true));
+    defaults.tennisScoringRules = 0;            // what former versions read from an empty namespace
+    defaults.didah = true;
+    assertTrue("test_PrefsStore_migration defaults", same(d, defaults));
+}
+
+void test_PrefsStore_writes()
+{
+    MemoryStorage nvs;
+    PrefsStore sut(nvs);
+    MorsePrefs p;
+    sut.load("morserino", p, true);
+    unsigned long writes = nvs.writes, bytes = nvs.bytes;
+
+    // nothing changed - nothing written
+    assertFalse("test_PrefsStore_writes unchanged", sut.save("morserino", p));
+    assertEquals("test_PrefsStore_writes unchanged count", 0, nvs.writes - writes);
+
+    p.keyermode = 3;
+    p.interCharSpace = 6;
+    assertTrue("test_PrefsStore_writes changed", sut.save("morserino", p));
+    assertEquals("test_PrefsStore_writes changed count", 1, nvs.writes - writes);
+    printf("  saving after changing 2 preferences: %lu write(s), %lu bytes (former layout: 2 writes of single keys, after up to 40 reads)\n",
+            nvs.writes - writes, nvs.bytes - bytes);
+
+    // a burst of speed changes while keying: written once, when things have calmed down
+    writes = nvs.writes;
+    unsigned long t = 1000;
+    for (int i = 0; i < 10; ++i)
+    {
+        p.wpm = 16 + i;
+        sut.markDirty(t);
+        t += 2000;
+        assertFalse("test_PrefsStore_writes burst", sut.writeBehind("morserino", p, t));
+    }
+    assertEquals("test_PrefsStore_writes burst count", 0, nvs.writes - writes);
+    assertTrue("test_PrefsStore_writes burst dirty", sut.isDirty());
+    assertTrue("test_PrefsStore_writes behind", sut.writeBehind("morserino", p, t + PrefsStore::WRITE_DELAY));
+    assertFalse("test_PrefsStore_writes behind clean", sut.isDirty());
+    assertFalse("test_PrefsStore_writes behind again", sut.writeBehind("morserino", p, t + 2 * PrefsStore::WRITE_DELAY));
+    printf("  10 speed changes: %lu write(s) (former layout: 10)\n", nvs.writes - writes);
+    assertEquals("test_PrefsStore_writes behind count", 1, nvs.writes - writes);
+
+    MorsePrefs q;
+    sut.load("morserino", q, true);
+    assertEquals("test_PrefsStore_writes wpm", 25, q.wpm);
+    assertEquals("test_PrefsStore_writes keyer", 3, q.keyermode);
+}
+
+void test_PrefsStore()
+{
+    printf("Testing PrefsStore\n");
+    test_PrefsStore_encode();
+    test_PrefsStore_migration();
+    test_PrefsStore_writes();
+}
@@ -0,0 +1,6 @@
+#ifndef PREFSSTORETEST_H_
+#define PREFSSTORETEST_H_
+
+void test_PrefsStore();
+
+#endif /* PREFSSTORETEST_H_ */
@@ -0,0 +1,127 @@
+/*
+ * ProfilerTest.cpp
+ *
+ *  Tests for the section profiler: histogram buckets, percentiles, scopes and the CSV output.
+ */
+
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include <chrono>
+
+#include "TestSupport.h"
+#include "Profiler.h"
+#include "ProfilerTest.h"
+
+static uint32_t ticks;
+
+static uint32_t fakeCounter()
+{
+    return ticks;
+}
+
+void test_Profiler_buckets()
+{
+    uint32_t values[] = { 0, 1, 3, 4, 5, 7, 8, 9, 15, 16, 100, 1000, 123456, 0x7fffffff, 0x80000000, 0xffffffff };
+    boolean ok = true;
+    for (uint32_t v : values)
+    {
+        uint8_t b = Profiler::bucket(v);
+        uint32_t limit = Profiler::bucketLimit(b);
+        uint32_t below = b ? Profiler::bucketLimit(b - 1) : 0;
+        if (b >= Profiler::BUCKETS || v > limit || (b && v <= below) || limit - v > v / 4)
+        {
+            printf("  bucket %u of %u: limits %u..%u\n", b, v, below, limit);
+            ok = false;
+        }
+    }
+    assertTrue("test_Profiler_buckets", ok);
+    assertEquals("test_Profiler_buckets last", Profiler::BUCKETS - 1, Profiler::bucket(0xffffffff));
+}
+
+void test_Profiler_summary()
+{
+    static Profiler::Section sut("summary");          // sections stay registered, so they must live forever
+    std::vector<uint32_t> values;
+
+    for (int i = 0; i < 1000; ++i)
+    {   // mostly short, a few long outliers, like a loop that sometimes updates the display
+        uint32_t v = i % 50 == 0 ? 5000 + i : 100 + i % 37;
+        values.push_back(v);
+        sut.record(v);
+    }
+    std::sort(values.begin(), values.end());
+    uint32_t exactP99 = values[989];
+
+    Profiler::Summary s = sut.getSummary();
+    assertEquals("test_Profiler_summary count", 1000, s.count);
+    assertEquals("test_Profiler_summary min", 100, s.min);
+    assertEquals("test_Profiler_summary max", 5950, s.max);
+    assertTrue("test_Profiler_summary p99", s.p99 >= exactP99 && s.p99 <= exactP99 + exactP99 / 4);
+
+    sut.reset();
+    s = sut.getSummary();
+    assertEquals("test_Profiler_summary reset", 0, s.count);
+    assertEquals("test_Profiler_summary reset p99", 0, s.p99);
+}
+
+void test_Profiler_scope()
+{
+    Profiler::setCounter(fakeCounter, 240);
+    static Profiler::Section sut("checkPaddles");
+
+    for (int i = 0; i < 3; ++i)
+    {
+        Profiler::Scope scope(sut);
+        ticks += 2400 * (i + 1);                    // 10, 20 and 30 µs at 240 MHz
+    }
+    Profiler::Summary s = Profiler::inMicros(sut.getSummary());
+    assertEquals("test_Profiler_scope min", 10, s.min);
+    assertEquals("test_Profiler_scope avg", 20, s.avg);
+    assertEquals("test_Profiler_scope max", 30, s.max);
+
+    char buf[80];
+    Profiler::formatCsv(sut, buf, sizeof(buf));
+    assertEquals("test_Profiler_scope csv", "checkPaddles,3,10,20,30,30", buf);
+
+    boolean found = false;
+    for (Profiler::Section *p = Profiler::getFirst(); p; p = p->getNext())
+    {
+        found |= p == &sut;
+    }
+    assertTrue("test_Profiler_scope registered", found);
+    Profiler::setCounter(0, 1);
+}
+
+static uint32_t steadyCounter()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void test_Profiler_overhead()
+{
+    static Profiler::Section empty("empty");
+    const int N = 200000;
+
+    Profiler::setCounter(steadyCounter, 1000);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < N; ++i)
+    {
+        Profiler::Scope scope(empty);
+    }
+    auto end = std::chrono::steady_clock::now();
+    Profiler::setCounter(0, 1);
+
+    long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / N;
+    printf("  %ld ns per measured section (host, including two reads of the clock)\n", ns);
+    assertEquals("test_Profiler_overhead count", N, empty.getSummary().count);
+}
+
+void test_Profiler()
+{
+    printf("Testing Profiler\n");
+    test_Profiler_buckets();
+    test_Profiler_summary();
+    test_Profiler_scope();
+    test_Profiler_overhead();
+}
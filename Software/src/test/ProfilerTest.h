@@ -0,0 +1,6 @@
+#ifndef PROFILERTEST_H_
+#define PROFILERTEST_H_
+
+void test_Profiler();
+
+#endif /* PROFILERTEST_H_ */
@@ -0,0 +1,217 @@
+/*
+ * QsoGeneratorTest.cpp
+ *
+ *  Tests for the QSO generator: the grammar, the values that last for a QSO, the serial numbers, and errors.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include "TestSupport.h"
+#include "QsoGenerator.h"
+#include "QsoGeneratorTest.h"
+
+static long first(long howBig)
+{
+    return 0;
+}
+
+static long last(long howBig)
+{
+    return howBig - 1;
+}
+
+static uint32_t seed = 1;
+
+static long lcg(long howBig)
+{
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 16) % howBig;
+}
+
+/// words returns the next n words, separated by blanks
+static String words(QsoGenerator &sut, int n)
+{
+    char word[QsoGenerator::MAX_WORD + 1];
+    String result = "";
+
+    for (int i = 0; i < n && sut.next(word); ++i)
+    {
+        result += (i ? " " : "") + String(word);
+    }
+    return result;
+}
+
+static QsoGenerator::Error load(QsoGenerator &sut, const char *text)
+{
+    return sut.load(text, strlen(text));
+}
+
+void test_QsoGenerator_grammar()
+{
+    const char *grammar =
+            "# a comment\n"
+            "qso = cq de {call} {call} k |  {call} de {call}\n"
+            "\n"
+            "call = dl{digit}ab | g{digit}xyz   # calls\n"
+            "digit = 1 | 2\n"
+            "     | 3\n";
+    QsoGenerator sut(first);
+
+    assertEquals("test_QsoGenerator_grammar load", QsoGenerator::OK, load(sut, grammar));
+    assertEquals("test_QsoGenerator_grammar first", "cq de dl1ab dl1ab k cq de dl1ab", words(sut, 8));
+    assertEquals("test_QsoGenerator_grammar QSOs", 2, sut.getQsoCount());
+
+    QsoGenerator other(last);
+    load(other, grammar);
+    assertEquals("test_QsoGenerator_grammar last", "g3xyz de g3xyz g3xyz de g3xyz", words(other, 6));
+}
+
+void test_QsoGenerator_values()
+{
+    const char *grammar =
+            "qso = cq $a $a de $b = $a de $b {same} = %n %c\n"
+            "a = {x}{x}\n"
+            "b = {x} {x}\n"                                 // a value with a blank in it
+            "same = $a\n"
+            "x = 1 | 2 | 3 | 4 | 5 | 6 | 7 | 8 | 9\n";
+    QsoGenerator sut(lcg);
+
+    seed = 1;
+    assertEquals("test_QsoGenerator_values load", QsoGenerator::OK, load(sut, grammar));
+    sut.restart(9);
+    for (int qso = 0; qso < 20; ++qso)
+    {
+        char w[15][QsoGenerator::MAX_WORD + 1];
+        char serial[8];
+        for (int i = 0; i < 15; ++i)
+        {
+            sut.next(w[i]);
+        }
+        snprintf(serial, sizeof(serial), "%03u", sut.getSerial());
+        assertEquals("test_QsoGenerator_values cq", "cq", w[0]);
+        assertEquals("test_QsoGenerator_values a again", w[1], w[2]);
+        assertEquals("test_QsoGenerator_values a later", w[1], w[7]);
+        assertEquals("test_QsoGenerator_values a in a rule", w[1], w[11]);
+        assertEquals("test_QsoGenerator_values b", w[4], w[9]);
+        assertEquals("test_QsoGenerator_values b second word", w[5], w[10]);
+        assertEquals("test_QsoGenerator_values serial", serial, w[13]);
+        assertEquals("test_QsoGenerator_values serial number", 9 + qso, sut.getSerial());
+    }
+    assertEquals("test_QsoGenerator_values QSOs", 20, sut.getQsoCount());
+
+    const char *serials = "qso = %n %c\n";
+    load(sut, serials);
+    sut.restart(90);
+    assertEquals("test_QsoGenerator_values serials", "090 tnt 091 tn1 092 tn2", words(sut, 6));
+    sut.restart(1000);
+    assertEquals("test_QsoGenerator_values 4 digits", "1000 1ttt", words(sut, 2));
+}
+
+void test_QsoGenerator_errors()
+{
+    QsoGenerator sut(first);
+    char word[QsoGenerator::MAX_WORD + 1];
+
+    assertEquals("test_QsoGenerator_errors empty", QsoGenerator::NO_RULES, load(sut, "# nothing\n\n"));
+    assertFalse("test_QsoGenerator_errors no words", sut.next(word));
+    assertEquals("test_QsoGenerator_errors no =", QsoGenerator::SYNTAX, load(sut, "qso = a\nb c\n"));
+    assertEquals("test_QsoGenerator_errors no = line", 2, sut.getErrorLine());
+    assertEquals("test_QsoGenerator_errors unknown", QsoGenerator::UNKNOWN_RULE, load(sut, "qso = a\n\n  {b}\n"));
+    assertEquals("test_QsoGenerator_errors unknown line", 3, sut.getErrorLine());
+    assertEquals("test_QsoGenerator_errors twice", QsoGenerator::SYNTAX, load(sut, "qso = a\nqso = b\n"));
+    assertEquals("test_QsoGenerator_errors brace", QsoGenerator::SYNTAX, load(sut, "qso = {qso\n"));
+    assertEquals("test_QsoGenerator_errors percent", QsoGenerator::SYNTAX, load(sut, "qso = 50%\n"));
+    assertFalse("test_QsoGenerator_errors no rules after an error", sut.next(word));
+
+    String many = "";
+    for (int i = 0; i <= QsoGenerator::MAX_RULES; ++i)
+    {
+        many += "r" + String((unsigned long) i) + " = x\n";
+    }
+    assertEquals("test_QsoGenerator_errors rules", QsoGenerator::TOO_MANY_RULES, load(sut, many.c_str()));
+    String values = "qso =";
+    String valueRules = "";
+    for (int i = 0; i <= QsoGenerator::MAX_VALUES; ++i)
+    {
+        values += " $r" + String((unsigned long) i);
+        valueRules += "r" + String((unsigned long) i) + " = x\n";
+    }
+    values += "\n" + valueRules;
+    assertEquals("test_QsoGenerator_errors values", QsoGenerator::TOO_MANY_VALUES, load(sut, values.c_str()));
+    String longOne = "qso = ";
+    for (int i = 0; i <= QsoGenerator::MAX_CODE / 4; ++i)
+    {
+        longOne += "abc ";
+    }
+    assertEquals("test_QsoGenerator_errors too long", QsoGenerator::TOO_LONG, load(sut, longOne.c_str()));
+
+    assertEquals("test_QsoGenerator_errors only blanks", QsoGenerator::OK, load(sut, "qso = {e} {e}\ne = |\n"));
+    assertFalse("test_QsoGenerator_errors only blanks: no word", sut.next(word));
+    assertEquals("test_QsoGenerator_errors endless", QsoGenerator::OK, load(sut, "qso = {loop}\nloop = a{loop}\n"));
+    assertTrue("test_QsoGenerator_errors endless: cut off", sut.next(word));
+    assertEquals("test_QsoGenerator_errors endless: depth", "aaaaaaaaaaa", word);
+    assertEquals("test_QsoGenerator_errors long word", QsoGenerator::OK, load(sut, "qso = {w}{w}{w}{w}{w}\nw = abcdefghij\n"));
+    sut.next(word);
+    assertEquals("test_QsoGenerator_errors long word cut", QsoGenerator::MAX_WORD, strlen(word));
+}
+
+/// the default grammar: every QSO starts with a CQ (or TEST), and every word is made of characters the M32 can send
+void test_QsoGenerator_default()
+{
+    QsoGenerator sut(lcg);
+    char word[QsoGenerator::MAX_WORD + 1];
+    uint32_t n = 0;
+    uint32_t qsos = 0;
+    boolean ok = true;
+    boolean starts = true;
+
+    seed = 3;
+    assertEquals("test_QsoGenerator_default load", QsoGenerator::OK,
+            sut.load(QsoGenerator::DEFAULT_GRAMMAR, strlen(QsoGenerator::DEFAULT_GRAMMAR)));
+    assertTrue("test_QsoGenerator_default size", sut.getCodeSize() < QsoGenerator::MAX_CODE);
+    while (sut.getQsoCount() <= 1000 && sut.next(word))
+    {
+        ++n;
+        ok = ok && strlen(word) > 0 && strspn(word, "abcdefghijklmnopqrstuvwxyz0123456789/?=<>") == strlen(word);
+        if (sut.getQsoCount() != qsos)
+        {
+            qsos = sut.getQsoCount();
+            starts = starts && (!strcmp(word, "cq") || !strcmp(word, "test"));
+        }
+    }
+    printf("  default grammar: %u bytes of code, %u words in 1000 QSOs\n", sut.getCodeSize(), n - 1);
+    assertTrue("test_QsoGenerator_default characters", ok);
+    assertTrue("test_QsoGenerator_default starts", starts);
+    assertTrue("test_QsoGenerator_default words", n > 20000);
+}
+
+void test_QsoGenerator_benchmark()
+{
+    const int N = 1000000;
+    QsoGenerator sut(lcg);
+    char word[QsoGenerator::MAX_WORD + 1];
+    size_t characters = 0;
+
+    sut.load(QsoGenerator::DEFAULT_GRAMMAR, strlen(QsoGenerator::DEFAULT_GRAMMAR));
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < N; ++i)
+    {
+        sut.next(word);
+        characters += strlen(word);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    long ns = (long) (std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / N);
+    printf("  %ld ns per word, %ld words per second (host)\n", ns, ns ? 1000000000L / ns : 0);
+    assertTrue("test_QsoGenerator_benchmark words", characters > (size_t) N * 2);
+}
+
+void test_QsoGenerator()
+{
+    printf("Testing QsoGenerator\n");
+    test_QsoGenerator_grammar();
+    test_QsoGenerator_values();
+    test_QsoGenerator_errors();
+    test_QsoGenerator_default();
+    test_QsoGenerator_benchmark();
+}
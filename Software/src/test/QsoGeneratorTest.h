@@ -0,0 +1,6 @@
+#ifndef QSOGENERATORTEST_H_
+#define QSOGENERATORTEST_H_
+
+void test_QsoGenerator();
+
+#endif /* QSOGENERATORTEST_H_ */
@@ -0,0 +1,337 @@
+/*
+ * SchedulerTest.cpp
+ *
+ *  Tests for the cooperative scheduler with a simulated clock: the tasks of the main loop take
+ *  as long as they do on the device, and we check how long the keyer has to wait.
+ */
+
+#include <string.h>
+
+#include "TestSupport.h"
+#include "Scheduler.h"
+#include "SchedulerTest.h"
+
+static unsigned long now;
+
+static unsigned long fakeClock()
+{
+    return now;
+}
+
+/// run times of the tasks in µs, roughly as measured on the device
+static const unsigned long KEYER_TIME = 20;         // reading the paddles
+static const unsigned long MODE_TIME = 300;         // one round of generator or decoder
+static const unsigned long UI_TIME = 2000;          // buttons, encoder and a display update
+static const unsigned long BACKGROUND_TIME = 5000;  // writing preferences to flash
+
+static int keyerRuns, modeRuns, uiRuns, backgroundRuns;
+
+static boolean keyerTask()
+{
+    now += KEYER_TIME;
+    ++keyerRuns;
+    return false;
+}
+
+static boolean modeTask()
+{
+    now += MODE_TIME;
+    ++modeRuns;
+    return true;                                    // always in a hurry
+}
+
+static boolean uiTask()
+{
+    now += UI_TIME;
+    ++uiRuns;
+    return false;
+}
+
+static boolean backgroundTask()
+{
+    now += BACKGROUND_TIME;
+    ++backgroundRuns;
+    return false;
+}
+
+static void reset(unsigned long start)
+{
+    now = start;
+    keyerRuns = modeRuns = uiRuns = backgroundRuns = 0;
+}
+
+static void runFor(Scheduler &sut, unsigned long duration)
+{
+    unsigned long end = now + duration;
+    while ((long) (now - end) < 0)
+    {
+        if (!sut.runOnce())
+        {
+            now += 10;                              // idle
+        }
+    }
+}
+
+void test_Scheduler_periodic()
+{
+    reset(0);
+    Scheduler sut(fakeClock);
+
+    sut.add("ui", uiTask, 10000, 1);
+    runFor(sut, 1000000);
+    assertEquals("test_Scheduler_periodic runs", 100, uiRuns);
+
+    Scheduler::Stats s = sut.getStats(0);
+    assertEquals("test_Scheduler_periodic stats runs", 100, s.runs);
+    assertEquals("test_Scheduler_periodic stats time", 100 * UI_TIME, s.totalTime);
+    assertEquals("test_Scheduler_periodic stats max", UI_TIME, s.maxTime);
+    assertTrue("test_Scheduler_periodic stats latency", s.maxLatency <= 10);
+    assertEquals("test_Scheduler_periodic stats overruns", 0, s.overruns);
+}
+
+void test_Scheduler_fullLoad()
+{
+    for (int wrap = 0; wrap < 2; ++wrap)
+    {
+        reset(wrap ? 0xffffffff - 3000000 : 0);     // the µs clock wraps after 71 minutes
+        Scheduler sut(fakeClock);
+
+        uint8_t keyer = sut.add("keyer", keyerTask, 1000, 3);
+        uint8_t mode = sut.add("mode", modeTask, 1000, 2);
+        uint8_t ui = sut.add("ui", uiTask, 20000, 1);
+        uint8_t background = sut.add("background", backgroundTask, 100000, 0);
+        runFor(sut, 10000000);
+
+        /// no preemption: the keyer may have to wait for the longest other task, but not longer
+        Scheduler::Stats k = sut.getStats(keyer);
+        assertTrue("test_Scheduler_fullLoad keyer latency", k.maxLatency <= BACKGROUND_TIME);
+        assertTrue("test_Scheduler_fullLoad keyer runs", keyerRuns >= 9500);
+
+        /// and nobody starves although the mode is always in a hurry
+        assertTrue("test_Scheduler_fullLoad mode runs", modeRuns > 10000);
+        assertTrue("test_Scheduler_fullLoad ui runs", uiRuns >= 495);
+        assertTrue("test_Scheduler_fullLoad background runs", backgroundRuns >= 99);
+        assertTrue("test_Scheduler_fullLoad ui latency", sut.getStats(ui).maxLatency <= BACKGROUND_TIME);
+        assertEquals("test_Scheduler_fullLoad ui overruns", 0, sut.getStats(ui).overruns);
+        assertEquals("test_Scheduler_fullLoad background overruns", 0, sut.getStats(background).overruns);
+
+        if (!wrap)
+        {
+            printf("  10 s full load:\n");
+            for (int i = 0; i < sut.getTaskCount(); ++i)
+            {
+                Scheduler::Stats s = sut.getStats(i);
+                printf("    %-10s %6lu runs, %3lu%% cpu, max latency %5lu µs, %4lu overruns\n", sut.getName(i), s.runs,
+                        s.totalTime / 100000, s.maxLatency, s.overruns);
+            }
+        }
+        assertTrue("test_Scheduler_fullLoad mode latency", sut.getStats(mode).maxLatency <= BACKGROUND_TIME);
+    }
+
+    /// the former loop: paddles, then the mode; buttons, encoder and the rest only if the mode is not in a hurry
+    reset(0);
+    unsigned long lastUi = 0;
+    while (now < 10000000 && now - lastUi < 1000000)
+    {
+        keyerTask();
+        if (!modeTask())
+        {
+            uiTask();
+            lastUi = now;
+        }
+    }
+    printf("  former loop: %i ui runs in %lu ms with a mode that is always in a hurry\n", uiRuns, now / 1000);
+}
+
+void test_Scheduler_overruns()
+{
+    reset(0);
+    Scheduler sut(fakeClock);
+
+    sut.add("ui", uiTask, 1000, 1);                 // takes twice as long as its period
+    runFor(sut, 100000);
+    Scheduler::Stats s = sut.getStats(0);
+    assertTrue("test_Scheduler_overruns runs", s.runs >= 49 && s.runs <= 51);
+    assertTrue("test_Scheduler_overruns overruns", s.overruns >= 48);
+    assertTrue("test_Scheduler_overruns latency", s.maxLatency < 2000);
+
+    sut.resetStats();
+    assertEquals("test_Scheduler_overruns reset", 0, sut.getStats(0).runs);
+}
+
+void test_Scheduler_priority()
+{
+    reset(0);
+    Scheduler sut(fakeClock);
+
+    sut.add("background", backgroundTask, 1000, 0);
+    sut.add("keyer", keyerTask, 1000, 3);
+    assertTrue("test_Scheduler_priority run", sut.runOnce());
+    assertEquals("test_Scheduler_priority keyer first", 1, keyerRuns);
+    assertEquals("test_Scheduler_priority background later", 0, backgroundRuns);
+    assertTrue("test_Scheduler_priority run 2", sut.runOnce());
+    assertEquals("test_Scheduler_priority background", 1, backgroundRuns);
+
+    Scheduler idle(fakeClock);
+    idle.add("keyer", keyerTask, 1000, 3);
+    assertTrue("test_Scheduler_priority idle first", idle.runOnce());
+    assertFalse("test_Scheduler_priority nothing due", idle.runOnce());
+
+    for (int i = 0; i < Scheduler::MAX_TASKS - 2; ++i)
+    {
+        sut.add("more", uiTask, 1000, 1);
+    }
+    assertEquals("test_Scheduler_priority full", Scheduler::NO_TASK, sut.add("too many", uiTask, 1000, 1));
+}
+
+static Scheduler *deferring;
+static uint8_t deferringTask;
+static unsigned long deferBy;
+static unsigned long slept;
+
+static boolean deferringRun()
+{
+    now += KEYER_TIME;
+    ++keyerRuns;
+    if (deferBy)
+    {
+        deferring->defer(deferringTask, now + deferBy);
+    }
+    return false;
+}
+
+static void fakeSleep(unsigned long us)
+{
+    slept += us;
+    now += us;
+}
+
+void test_Scheduler_deferAndWake()
+{
+    reset(0);
+    Scheduler sut(fakeClock);
+    deferring = &sut;
+    deferringTask = sut.add("keyer", deferringRun, 1000, 3);
+
+    deferBy = 50000;
+    runFor(sut, 100000);
+    assertEquals("test_Scheduler_deferAndWake deferred runs", 2, keyerRuns);
+
+    deferBy = 0;
+    sut.wake(deferringTask);
+    assertTrue("test_Scheduler_deferAndWake woken", sut.runOnce());
+    assertEquals("test_Scheduler_deferAndWake woken runs", 3, keyerRuns);
+    runFor(sut, 10000);
+    assertTrue("test_Scheduler_deferAndWake periodic again", keyerRuns >= 12);
+}
+
+void test_Scheduler_sleep()
+{
+    reset(0);
+    slept = 0;
+    Scheduler sut(fakeClock, fakeSleep);
+    sut.resetStats();
+    sut.add("ui", uiTask, 10000, 1);
+
+    assertTrue("test_Scheduler_sleep run", sut.runOnce());
+    assertEquals("test_Scheduler_sleep time to release", 10000 - UI_TIME, sut.timeToNextRelease(now));
+    assertFalse("test_Scheduler_sleep nothing to do", sut.runOnce());
+    assertEquals("test_Scheduler_sleep slept until release", 10000 - UI_TIME, slept);
+    assertEquals("test_Scheduler_sleep at release", 10000, now);
+
+    Scheduler::Load load = sut.getLoad();
+    assertEquals("test_Scheduler_sleep iterations", 2, load.iterations);
+    assertEquals("test_Scheduler_sleep busy", UI_TIME, load.busy);
+    assertEquals("test_Scheduler_sleep idle", 10000 - UI_TIME, load.idle);
+    assertEquals("test_Scheduler_sleep elapsed", 10000, load.elapsed);
+}
+
+/// a practice session: the user keys for 1 s every 10 s, the keyer and the mode have nothing to do in between
+static boolean keying;
+static uint8_t sessionPaddles, sessionMode;
+
+static boolean sessionPaddlesTask()
+{
+    now += KEYER_TIME;
+    if (deferBy && !keying)
+    {
+        deferring->defer(sessionPaddles, now + deferBy);    // woken by the paddle interrupt
+    }
+    return false;
+}
+
+static boolean sessionModeTask()
+{
+    now += 30;
+    if (deferBy && !keying)
+    {
+        deferring->defer(sessionMode, now + deferBy);
+    }
+    return false;
+}
+
+static boolean sessionUiTask()
+{
+    now += 100;                                     // nothing changed, so no display update
+    return false;
+}
+
+static Scheduler::Load practiceSession(boolean eventDriven)
+{
+    reset(0);
+    Scheduler sut(fakeClock, eventDriven ? fakeSleep : 0);
+    deferring = &sut;
+    deferBy = eventDriven ? 100000 : 0;
+    keying = false;
+    sut.resetStats();
+    sessionPaddles = sut.add("paddles", sessionPaddlesTask, 500, 3);
+    sessionMode = sut.add("mode", sessionModeTask, 1000, 2);
+    sut.add("ui", sessionUiTask, 10000, 1);
+    sut.add("background", keyerTask, 100000, 0);
+
+    for (int second = 0; second < 60; ++second)
+    {
+        boolean wasKeying = keying;
+        keying = second % 10 == 0;
+        if (keying && !wasKeying)
+        {
+            sut.wake(sessionPaddles);
+            sut.wake(sessionMode);
+        }
+        unsigned long end = now + 1000000;
+        while ((long) (now - end) < 0)
+        {
+            if (!sut.runOnce() && !eventDriven)
+            {
+                now += 2;                           // one empty round of the loop
+            }
+        }
+    }
+    return sut.getLoad();
+}
+
+void test_Scheduler_practiceSession()
+{
+    Scheduler::Load before = practiceSession(false);
+    Scheduler::Load after = practiceSession(true);
+
+    printf("  60 s practice session, polling:      %7lu loop iterations/s, %3lu%% busy, %3lu%% idle\n",
+            before.iterations / (before.elapsed / 1000000), before.busy / (before.elapsed / 100), before.idle / (before.elapsed / 100));
+    printf("  60 s practice session, event driven: %7lu loop iterations/s, %3lu%% busy, %3lu%% idle\n",
+            after.iterations / (after.elapsed / 1000000), after.busy / (after.elapsed / 100), after.idle / (after.elapsed / 100));
+    assertEquals("test_Scheduler_practiceSession no idle while polling", 0, before.idle);
+    assertTrue("test_Scheduler_practiceSession mostly idle", after.idle > after.elapsed / 100 * 90);
+    assertTrue("test_Scheduler_practiceSession fewer iterations", after.iterations < before.iterations / 50);
+}
+
+void test_Scheduler()
+{
+    printf("Testing Scheduler\n");
+    test_Scheduler_periodic();
+    test_Scheduler_fullLoad();
+    test_Scheduler_overruns();
+    test_Scheduler_priority();
+    test_Scheduler_deferAndWake();
+    test_Scheduler_sleep();
+    test_Scheduler_practiceSession();
+}
@@ -0,0 +1,6 @@
+#ifndef SCHEDULERTEST_H_
+#define SCHEDULERTEST_H_
+
+void test_Scheduler();
+
+#endif /* SCHEDULERTEST_H_ */
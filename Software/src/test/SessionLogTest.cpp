@@ -0,0 +1,206 @@
+/*
+ * SessionLogTest.cpp
+ *
+ *  Tests for the session log: encoding, the RAM buffer, reading it back, and what it costs.
+ */
+
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include "TestSupport.h"
+#include "SessionLog.h"
+#include "SessionLogTest.h"
+
+/// keeps what is written, like the log file on SPIFFS
+struct MemorySink: public SessionLog::Sink
+{
+        std::vector<uint8_t> bytes;
+        unsigned long appends = 0;
+        boolean full = false;
+
+        boolean append(const uint8_t *data, size_t n)
+        {
+            if (full)
+            {
+                return false;
+            }
+            bytes.insert(bytes.end(), data, data + n);
+            ++appends;
+            return true;
+        }
+};
+
+void test_SessionLog_varint()
+{
+    uint8_t buffer[5];
+    uint32_t v;
+
+    assertEquals("test_SessionLog_varint 0", 1, SessionLog::putVarint(buffer, 0));
+    assertEquals("test_SessionLog_varint 127", 1, SessionLog::putVarint(buffer, 127));
+    assertEquals("test_SessionLog_varint 128", 2, SessionLog::putVarint(buffer, 128));
+    assertEquals("test_SessionLog_varint 128 low", 0x80, buffer[0]);
+    assertEquals("test_SessionLog_varint 128 high", 0x01, buffer[1]);
+    assertEquals("test_SessionLog_varint 16383", 2, SessionLog::putVarint(buffer, 16383));
+    assertEquals("test_SessionLog_varint max", 5, SessionLog::putVarint(buffer, 0xffffffff));
+    assertEquals("test_SessionLog_varint read max", 5, SessionLog::getVarint(buffer, 5, v));
+    assertEquals("test_SessionLog_varint max value", 0xffffffff, v);
+    assertEquals("test_SessionLog_varint cut off", 0, SessionLog::getVarint(buffer, 3, v));
+}
+
+void test_SessionLog_roundTrip()
+{
+    MemorySink sink;
+    SessionLog sut(&sink);
+    SessionLog::Record r;
+
+    sut.word("before", false, 10);                              // no session yet: not logged
+    sut.begin(7, 20, 18, 1000);
+    sut.word("paris", false, 1100);
+    sut.element(60, 200, 2000);
+    sut.response("pares", 5000);
+    sut.result(false, 2900, 5001);
+    sut.word("paris", true, 6000);
+    sut.speed(19, 17, 6100);
+    sut.end(70000);
+    sut.begin(2, 15, 15, 80000);
+    sut.decoded("k", 80050);
+    sut.flush(80100);
+
+    SessionLog::Reader reader(&sink.bytes[0], sink.bytes.size());
+    String events;
+    while (reader.next(r))
+    {
+        events += String(SessionLog::getName(r.type)) + "@" + String((unsigned long) r.time);
+        for (int i = 0; i < r.count; ++i)
+        {
+            events += String(i ? "," : ":") + String((unsigned long) r.values[i]);
+        }
+        if (r.text[0])
+        {
+            events += String(" ") + r.text;
+        }
+        events += ";";
+    }
+    assertEquals("test_SessionLog_roundTrip events",
+            "session@0:1,7,20,18;word@100:0 paris;element@1000:60,200;response@4000 pares;result@4001:0,2900;"
+                    "word@5000:1 paris;speed@5100:19,17;end@69000;session@0:1,2,15,15;decoded@50 k;", events);
+    assertEquals("test_SessionLog_roundTrip written", sink.bytes.size(), sut.getWritten());
+    assertEquals("test_SessionLog_roundTrip nothing dropped", 0, sut.getDropped());
+    assertEquals("test_SessionLog_roundTrip one flush", 1, sink.appends);
+}
+
+void test_SessionLog_reader()
+{
+    // an event of a type from the future, and a log that is cut off in the middle of the last event
+    const uint8_t log[] = { SessionLog::SESSION, 0, 4, 1, 3, 20, 20,        //
+            42, 5, 2, 0xaa, 0xbb,                                           // unknown: skipped
+            SessionLog::DECODED, 0x80, 0x01, 1, 'e',                        // 128 ms later
+            SessionLog::WORD, 3, 6, 0, 'p', 'a' };                          // cut off
+    SessionLog::Reader sut(log, sizeof(log));
+    SessionLog::Record r;
+
+    assertTrue("test_SessionLog_reader session", sut.next(r));
+    assertEquals("test_SessionLog_reader values", 4, r.count);
+    assertTrue("test_SessionLog_reader decoded", sut.next(r));
+    assertEquals("test_SessionLog_reader type", SessionLog::DECODED, r.type);
+    assertEquals("test_SessionLog_reader time", 128 + 5, r.time);
+    assertEquals("test_SessionLog_reader text", "e", r.text);
+    assertFalse("test_SessionLog_reader cut off", sut.next(r));
+    assertEquals("test_SessionLog_reader skipped", 1, sut.getSkipped());
+}
+
+void test_SessionLog_buffer()
+{
+    MemorySink sink;
+    SessionLog sut(&sink);
+
+    sut.begin(1, 20, 20, 0);
+    assertFalse("test_SessionLog_buffer not due yet", sut.isDue(100));
+    assertTrue("test_SessionLog_buffer due after a while", sut.isDue(SessionLog::FLUSH_INTERVAL));
+    for (int i = 0; i < 100; ++i)
+    {
+        sut.word("abcdefghij", false, i);
+    }
+    assertTrue("test_SessionLog_buffer dropped when full", sut.getDropped() > 0);
+    assertTrue("test_SessionLog_buffer due when half full", sut.isDue(100));
+    assertTrue("test_SessionLog_buffer flushed", sut.flush(100));
+    assertTrue("test_SessionLog_buffer at most a buffer", sink.bytes.size() <= SessionLog::BUFFER);
+    assertFalse("test_SessionLog_buffer empty", sut.isDue(SessionLog::FLUSH_INTERVAL * 2));
+
+    uint32_t dropped = sut.getDropped();
+    sink.full = true;
+    sut.word("lost", false, 200);
+    assertFalse("test_SessionLog_buffer sink full", sut.flush(300));
+    assertEquals("test_SessionLog_buffer counted", dropped + 1, sut.getDropped());
+}
+
+/// what an hour of practice costs: the echo trainer (a word about every 6 s, answered, sometimes a speed change)
+/// and the decoder (someone keying at 20 WpM all the time); and the time an event takes to log
+void test_SessionLog_benchmark()
+{
+    const char *words[] = { "the", "paris", "qth", "73", "cq", "antenna", "rig", "wx" };
+    MemorySink echo, decoder;
+    SessionLog echoLog(&echo), decoderLog(&decoder);
+    unsigned long now = 0;
+    long events = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    echoLog.begin(3, 20, 20, now);
+    for (int i = 0; now < 3600000UL; ++i)
+    {
+        const char *w = words[i % 8];
+        echoLog.word(w, false, now += 1500);
+        echoLog.response(w, now += 2500);
+        echoLog.result(i % 10 != 0, 2500, now += 1);
+        events += 3;
+        if (i % 20 == 0)
+        {
+            echoLog.speed(20 + i % 3, 20, now);
+            ++events;
+        }
+        now += 2000;
+        if (echoLog.isDue(now))
+        {
+            echoLog.flush(now);
+        }
+    }
+    echoLog.end(now);
+    echoLog.flush(now);
+
+    now = 0;
+    decoderLog.begin(5, 20, 20, now);
+    for (int i = 0; now < 3600000UL; ++i)                       // about 3 elements per character, 20 WpM: 60 ms dits
+    {
+        decoderLog.element(i % 3 ? 60 : 180, 60, now += 300);
+        ++events;
+        if (i % 3 == 2)
+        {
+            decoderLog.decoded("e", now += 120);
+            ++events;
+        }
+        if (decoderLog.isDue(now))
+        {
+            decoderLog.flush(now);
+        }
+    }
+    decoderLog.end(now);
+    decoderLog.flush(now);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    printf("  flash per hour: echo trainer %lu bytes (%lu writes), decoder %lu bytes (%lu writes); %ld ns per event\n",
+            (unsigned long) echo.bytes.size(), echo.appends, (unsigned long) decoder.bytes.size(), decoder.appends,
+            (long) (std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / events));
+    assertEquals("test_SessionLog_benchmark nothing dropped", 0, echoLog.getDropped() + decoderLog.getDropped());
+    assertTrue("test_SessionLog_benchmark echo small", echo.bytes.size() < 16 * 1024);
+    assertTrue("test_SessionLog_benchmark decoder", decoder.bytes.size() < 128 * 1024);
+}
+
+void test_SessionLog()
+{
+    printf("Testing SessionLog\n");
+    test_SessionLog_varint();
+    test_SessionLog_roundTrip();
+    test_SessionLog_reader();
+    test_SessionLog_buffer();
+    test_SessionLog_benchmark();
+}
@@ -0,0 +1,6 @@
+#ifndef SESSIONLOGTEST_H_
+#define SESSIONLOGTEST_H_
+
+void test_SessionLog();
+
+#endif /* SESSIONLOGTEST_H_ */
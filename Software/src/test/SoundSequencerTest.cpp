@@ -0,0 +1,128 @@
+/*
+ * SoundSequencerTest.cpp
+ *
+ *  Tests for the sound sequencer: the timelines of what it tells the sound hardware, one tick per ms.
+ */
+
+#include "TestSupport.h"
+#include "SoundSequencer.h"
+#include "SoundSequencerTest.h"
+
+/// records the calls as "tick:frequency/level" and "tick:-" for silence
+struct TimelineOutput: public SoundSequencer::Output
+{
+        String timeline;
+        unsigned long now;
+        boolean lineOut;
+
+        void tone(uint16_t frequency, uint8_t level, boolean l)
+        {
+            timeline += String(now) + ":" + String(frequency) + "/" + String(level) + " ";
+            lineOut = l;
+        }
+
+        void silence()
+        {
+            timeline += String(now) + ":- ";
+            lineOut = false;
+        }
+};
+
+static void runUntil(SoundSequencer &sut, TimelineOutput &out, unsigned long end)
+{
+    while (out.now < end)
+    {
+        ++out.now;
+        sut.tick();
+    }
+}
+
+void test_SoundSequencer_signalOK()
+{
+    const SoundSequencer::Note ok[] = { { 440, 97, 100 }, { 587, 193, 100 } };
+    TimelineOutput out = { };
+    SoundSequencer sut(&out);
+
+    assertTrue("test_SoundSequencer_signalOK queued", sut.play(ok, 2));
+    runUntil(sut, out, 400);
+
+    assertEquals("test_SoundSequencer_signalOK timeline",
+            "0:440/25 1:440/50 2:440/75 3:440/100 97:440/75 98:440/50 99:440/25 "
+            "100:587/25 101:587/50 102:587/75 103:587/100 293:587/75 294:587/50 295:587/25 296:- ",
+            out.timeline);
+    assertEquals("test_SoundSequencer_signalOK length", 296, SoundSequencer::getLength(ok, 2));
+    assertFalse("test_SoundSequencer_signalOK idle", sut.isBusy());
+    assertFalse("test_SoundSequencer_signalOK silent", sut.isSounding());
+}
+
+void test_SoundSequencer_rests()
+{
+    const SoundSequencer::Note beeps[] = { { 311, 6, 40 }, { 0, 10, 0 }, { 311, 4, 40 } };
+    TimelineOutput out = { };
+    SoundSequencer sut(&out);
+
+    sut.play(beeps, 3);
+    runUntil(sut, out, 40);
+    assertEquals("test_SoundSequencer_rests timeline",
+            "0:311/10 1:311/20 2:311/30 3:311/40 6:311/30 7:311/20 8:311/10 9:- "
+            "19:311/10 20:311/20 21:311/30 22:311/40 23:311/30 24:311/20 25:311/10 26:- ",
+            out.timeline);
+    assertEquals("test_SoundSequencer_rests length", 26, SoundSequencer::getLength(beeps, 3));
+}
+
+void test_SoundSequencer_keying()
+{
+    TimelineOutput out = { };
+    SoundSequencer sut(&out);
+
+    sut.keyDown(700, 60, true);
+    assertTrue("test_SoundSequencer_keying line out", out.lineOut);
+    runUntil(sut, out, 10);
+    assertTrue("test_SoundSequencer_keying sounding", sut.isSounding());
+    assertFalse("test_SoundSequencer_keying no ticks needed while held", sut.isBusy());
+    sut.keyUp();
+    runUntil(sut, out, 12);
+    sut.keyDown(700, 60, true);                         // again, while it decays
+    runUntil(sut, out, 20);
+    sut.keyUp();
+    runUntil(sut, out, 30);
+
+    assertEquals("test_SoundSequencer_keying timeline",
+            "0:700/15 1:700/30 2:700/45 3:700/60 10:700/45 11:700/30 12:700/15 "
+            "12:700/30 13:700/45 14:700/60 20:700/45 21:700/30 22:700/15 23:- ",
+            out.timeline);
+    assertFalse("test_SoundSequencer_keying line out off", out.lineOut);
+}
+
+void test_SoundSequencer_keyingHasPriority()
+{
+    const SoundSequencer::Note err[] = { { 311, 193, 100 } };
+    const SoundSequencer::Note click[] = { { 250, 6, 50 }, { 280, 5, 50 } };
+    TimelineOutput out = { };
+    SoundSequencer sut(&out);
+
+    sut.play(err, 1);
+    sut.play(click, 2);
+    runUntil(sut, out, 5);
+    sut.keyDown(600, 100, false);                       // drops the rest of the ERR signal and the click
+    runUntil(sut, out, 8);
+    sut.keyUp();
+    runUntil(sut, out, 300);
+
+    assertEquals("test_SoundSequencer_keyingHasPriority timeline",
+            "0:311/25 1:311/50 2:311/75 3:311/100 5:600/100 8:600/75 9:600/50 10:600/25 11:- ",
+            out.timeline);
+
+    SoundSequencer::Note many[SoundSequencer::QUEUE + 1] = { };
+    assertFalse("test_SoundSequencer_keyingHasPriority queue full", sut.play(many, SoundSequencer::QUEUE + 1));
+    assertTrue("test_SoundSequencer_keyingHasPriority queue", sut.play(many, SoundSequencer::QUEUE));
+}
+
+void test_SoundSequencer()
+{
+    printf("Testing SoundSequencer\n");
+    test_SoundSequencer_signalOK();
+    test_SoundSequencer_rests();
+    test_SoundSequencer_keying();
+    test_SoundSequencer_keyingHasPriority();
+}
@@ -0,0 +1,6 @@
+#ifndef SOUNDSEQUENCERTEST_H_
+#define SOUNDSEQUENCERTEST_H_
+
+void test_SoundSequencer();
+
+#endif /* SOUNDSEQUENCERTEST_H_ */
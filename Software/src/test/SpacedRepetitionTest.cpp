@@ -0,0 +1,215 @@
+/*
+ * SpacedRepetitionTest.cpp
+ *
+ *  Tests for the spaced repetition scheduler, and a simulated learner to see what it is good for.
+ */
+
+#include <string.h>
+#include "TestSupport.h"
+#include "SpacedRepetition.h"
+#include "SpacedRepetitionTest.h"
+
+void test_SpacedRepetition_grade()
+{
+    SpacedRepetition::Card card = { "k", SpacedRepetition::START_EASINESS, 0, 0, 0, 0 };
+    String intervals;
+
+    for (int i = 0; i < 5; ++i)
+    {
+        SpacedRepetition::grade(card, 5, 100);
+        intervals += String((unsigned long) card.interval) + " ";
+    }
+    assertEquals("test_SpacedRepetition_grade intervals", "3 10 27 75 217 ", intervals);
+    assertEquals("test_SpacedRepetition_grade easiness", 300, card.easiness);
+    assertEquals("test_SpacedRepetition_grade due", 317, card.due);
+
+    SpacedRepetition::grade(card, 1, 400);
+    assertEquals("test_SpacedRepetition_grade lapse interval", 1, card.interval);
+    assertEquals("test_SpacedRepetition_grade lapses", 1, card.lapses);
+    assertEquals("test_SpacedRepetition_grade lapse easiness", 246, card.easiness);
+    for (int i = 0; i < 10; ++i)
+    {
+        SpacedRepetition::grade(card, 0, 400);
+    }
+    assertEquals("test_SpacedRepetition_grade minimum easiness", SpacedRepetition::MIN_EASINESS, card.easiness);
+    assertEquals("test_SpacedRepetition_grade only one lapse", 1, card.lapses);
+    SpacedRepetition::grade(card, 4, 500);
+    assertEquals("test_SpacedRepetition_grade relearned", SpacedRepetition::FIRST_INTERVAL, card.interval);
+}
+
+void test_SpacedRepetition_review()
+{
+    SpacedRepetition sut;
+    const uint16_t times[] = { 300, 900, 300, 300 };
+
+    sut.review("test", "tast", times, 600);
+    assertEquals("test_SpacedRepetition_review clock", 1, sut.getClock());
+    assertEquals("test_SpacedRepetition_review t right", SpacedRepetition::FIRST_INTERVAL, sut.findChar('t')->interval);
+    assertEquals("test_SpacedRepetition_review e wrong", 1, sut.findChar('e')->interval);
+    assertEquals("test_SpacedRepetition_review s", SpacedRepetition::FIRST_INTERVAL, sut.findChar('s')->interval);
+    assertTrue("test_SpacedRepetition_review a not reviewed", sut.findChar('a') == 0);
+    assertEquals("test_SpacedRepetition_review drill word", 1, sut.findWord("test")->interval);
+
+    sut.review("ten", "ten", times, 600);               // e is slow this time: 4
+    assertEquals("test_SpacedRepetition_review e slow", 196, sut.findChar('e')->easiness);
+    assertEquals("test_SpacedRepetition_review e slow but right", SpacedRepetition::FIRST_INTERVAL, sut.findChar('e')->interval);
+    assertEquals("test_SpacedRepetition_review t once per word", SpacedRepetition::SECOND_INTERVAL, sut.findChar('t')->interval);
+    assertTrue("test_SpacedRepetition_review right words stay out", sut.findWord("ten") == 0);
+    assertTrue("test_SpacedRepetition_review single characters are no drill words", sut.findWord("e") == 0);
+
+    assertEquals("test_SpacedRepetition_review drill due", "test", sut.nextWord());
+    for (int i = 0; i < 10 && sut.findWord("test"); ++i)
+    {
+        while (!sut.nextWord())
+        {
+            sut.review("e", "e", 0, 0);
+        }
+        sut.review("test", "test", 0, 0);
+    }
+    assertTrue("test_SpacedRepetition_review retired", sut.findWord("test") == 0);
+}
+
+void test_SpacedRepetition_nextChar()
+{
+    SpacedRepetition sut;
+    char group[4] = { };
+
+    assertEquals("test_SpacedRepetition_nextChar new one", 'k', sut.nextChar("kmr", 0));
+    sut.review("k", "k", 0, 0);
+    assertEquals("test_SpacedRepetition_nextChar next new one", 'm', sut.nextChar("kmr", 0));
+    sut.review("m", "n", 0, 0);
+    assertEquals("test_SpacedRepetition_nextChar the wrong one before a new one", 'm', sut.nextChar("kmr", 0));
+    sut.review("m", "m", 0, 0);
+    assertEquals("test_SpacedRepetition_nextChar k due", 'k', sut.nextChar("kmr", 0));
+    sut.review("k", "k", 0, 0);
+    assertEquals("test_SpacedRepetition_nextChar nothing due, r is new", 'r', sut.nextChar("kmr", 0));
+    sut.review("r", "r", 0, 0);
+    assertEquals("test_SpacedRepetition_nextChar m due", 'm', sut.nextChar("kmr", 0));
+    sut.review("m", "m", 0, 0);
+    assertEquals("test_SpacedRepetition_nextChar nothing due", 0, sut.nextChar("kmr", 0));
+
+    SpacedRepetition fresh;
+    for (int i = 0; i < 3; ++i)
+    {
+        group[i] = fresh.nextChar("kmrsu", group);
+    }
+    assertEquals("test_SpacedRepetition_nextChar group", "kmr", group);
+    assertFalse("test_SpacedRepetition_nextChar not learned", sut.isLearned("kmr"));
+}
+
+void test_SpacedRepetition_blob()
+{
+    SpacedRepetition sut;
+    SpacedRepetition copy;
+    SpacedRepetition::Blob blob;
+
+    sut.review("abc", "abd", 0, 0);
+    sut.toBlob(blob);
+    printf("  spaced repetition blob: %d bytes\n", (int) sizeof(blob));
+    assertTrue("test_SpacedRepetition_blob read", copy.fromBlob(blob, sizeof(blob)));
+    assertEquals("test_SpacedRepetition_blob clock", 1, copy.getClock());
+    assertEquals("test_SpacedRepetition_blob word", "abc", copy.nextWord());
+    blob.words[0].interval ^= 4;
+    assertFalse("test_SpacedRepetition_blob damaged", copy.fromBlob(blob, sizeof(blob)));
+}
+
+/// a learner who forgets: the chance to get a character right is strength / (strength + words since it was last seen);
+/// strength grows by three times the gap whenever it was right (the longer the gap, the more it helps), and halves
+/// when wrong
+struct Learner
+{
+        double strength[64];
+        uint32_t lastSeen[64];
+        uint32_t state;
+
+        double recall(int item, uint32_t now)
+        {
+            if (!strength[item])
+            {
+                return 0.0;
+            }
+            return strength[item] / (strength[item] + (now - lastSeen[item]));
+        }
+
+        boolean answer(int item, uint32_t now)
+        {
+            state = state * 1664525 + 1013904223;
+            boolean right = (state >> 8) % 10000 < recall(item, now) * 10000;
+            if (!strength[item])
+            {
+                strength[item] = 2.0;               // the first time, we hear it and learn it
+            }
+            else if (right)
+            {
+                strength[item] += 3.0 * (now - lastSeen[item]);
+            }
+            else
+            {
+                strength[item] = strength[item] > 4.0 ? strength[item] / 2 : 2.0;
+            }
+            lastSeen[item] = now;
+            return right;
+        }
+};
+
+struct Session
+{
+        int right;
+        int seen;
+        int known;                                  /// items recalled with 80 % 10 words after the session
+};
+
+static Session simulate(const char *pool, int words, boolean scheduled)
+{
+    SpacedRepetition sr;
+    Learner learner = { };
+    Session s = { };
+    uint32_t random = 99;
+    int n = strlen(pool);
+
+    learner.state = 12345;
+    for (int now = 0; now < words; ++now)
+    {
+        char c = scheduled ? sr.nextChar(pool, 0) : 0;
+        if (!c)
+        {
+            random = random * 1664525 + 1013904223;
+            c = pool[(random >> 8) % n];
+        }
+        int item = strchr(pool, c) - pool;
+        boolean right = learner.answer(item, now);
+        s.right += right;
+        char expected[2] = { c, 0 };
+        sr.review(expected, right ? expected : "", 0, 0);
+    }
+    for (int i = 0; i < n; ++i)
+    {
+        s.seen += learner.strength[i] > 0;
+        s.known += learner.recall(i, words + 10) >= 0.8;
+    }
+    return s;
+}
+
+void test_SpacedRepetition_simulation()
+{
+    const char *pool = "kmrsuaptlowi.njef0yv,g5/q9zh38b";
+    const int words = 600;
+
+    Session uniform = simulate(pool, words, false);
+    Session scheduled = simulate(pool, words, true);
+    printf("  %d characters, %d words: uniform %d right, %d seen, %d known; spaced %d right, %d seen, %d known\n",
+            (int) strlen(pool), words, uniform.right, uniform.seen, uniform.known, scheduled.right, scheduled.seen,
+            scheduled.known);
+    assertTrue("test_SpacedRepetition_simulation more right", scheduled.right > uniform.right);
+    assertTrue("test_SpacedRepetition_simulation more known", scheduled.known > uniform.known);
+}
+
+void test_SpacedRepetition()
+{
+    printf("Testing SpacedRepetition\n");
+    test_SpacedRepetition_grade();
+    test_SpacedRepetition_review();
+    test_SpacedRepetition_nextChar();
+    test_SpacedRepetition_blob();
+    test_SpacedRepetition_simulation();
+}
@@ -0,0 +1,6 @@
+#ifndef SPACEDREPETITIONTEST_H_
+#define SPACEDREPETITIONTEST_H_
+
+void test_SpacedRepetition();
+
+#endif /* SPACEDREPETITIONTEST_H_ */
@@ -0,0 +1,195 @@
+/*
+ * SpeedControllerTest.cpp
+ *
+ *  Tests for the speed controller of the echo trainer, and a simulated learner to compare it with the +/- 1 WpM rule.
+ */
+
+#include "TestSupport.h"
+#include "SpeedController.h"
+#include "SpeedControllerTest.h"
+
+void test_SpeedController_timings()
+{
+    SpeedController sut;
+
+    sut.begin(20, 3, 7, 90);
+    const SpeedController::Timings &t = sut.getTimings();
+    assertEquals("test_SpeedController_timings wpm", 20, t.wpm);
+    assertEquals("test_SpeedController_timings eff", 20, t.effWpm);
+    assertEquals("test_SpeedController_timings dit", 60, t.ditLength);
+    assertEquals("test_SpeedController_timings ics", 180, t.interCharacterSpace);
+    assertEquals("test_SpeedController_timings iws", 420, t.interWordSpace);
+    assertEquals("test_SpeedController_timings speed", 20 * SpeedController::SCALE, sut.getSpeed());
+    assertFalse("test_SpeedController_timings unchanged", sut.isChanged());
+
+    for (int i = 0; i < 2 * SpeedController::MIN_WORDS; ++i)   // all wrong: slower, by longer spaces
+    {
+        sut.onWord(false, 0, 0);
+    }
+    assertEquals("test_SpeedController_timings slower wpm", 20, t.wpm);
+    assertEquals("test_SpeedController_timings slower dit", 60, t.ditLength);
+    assertTrue("test_SpeedController_timings slower eff", t.effWpm < 20);
+    assertTrue("test_SpeedController_timings longer ics", t.interCharacterSpace > 180);
+    assertTrue("test_SpeedController_timings ics dits", t.charSpaceDits > 3);
+    assertEquals("test_SpeedController_timings Farnsworth", t.interCharacterSpace * 7 / 30, t.interWordSpace / 10);
+    assertTrue("test_SpeedController_timings changed", sut.isChanged());
+
+    for (int i = 0; i < 400; ++i)                               // all right: faster, by faster characters
+    {
+        sut.onWord(true, 1000, 1000);
+    }
+    assertEquals("test_SpeedController_timings fastest", SpeedController::MAX_WPM, t.wpm);
+    assertEquals("test_SpeedController_timings fastest ics", 3, t.charSpaceDits);
+    assertEquals("test_SpeedController_timings fastest eff", SpeedController::MAX_WPM, t.effWpm);
+
+    for (int i = 0; i < 2000; ++i)
+    {
+        sut.onWord(false, 0, 0);
+    }
+    assertEquals("test_SpeedController_timings slowest iws", SpeedController::MAX_INTER_WORD_SPACE, t.wordSpaceDits);
+    assertTrue("test_SpeedController_timings slowest ics", t.charSpaceDits <= SpeedController::MAX_INTER_CHAR_SPACE);
+}
+
+void test_SpeedController_staircase()
+{
+    SpeedController sut;
+    String steps;
+
+    sut.begin(20, 3, 7, 90);
+    for (int i = 1; i < SpeedController::MIN_WORDS; ++i)
+    {
+        assertFalse("test_SpeedController_staircase too early", sut.onWord(false, 0, 0));
+    }
+    assertTrue("test_SpeedController_staircase enough words", sut.onWord(false, 0, 0));
+    assertEquals("test_SpeedController_staircase first step", 19 * SpeedController::SCALE, sut.getSpeed());
+
+    for (int i = 0; i < 4 * SpeedController::MIN_WORDS; ++i)
+    {
+        uint16_t before = sut.getSpeed();
+        if (sut.onWord(false, 0, 0))
+        {
+            steps += String((long) before - sut.getSpeed()) + " ";
+        }
+    }
+    for (int i = 0; i < 3 * SpeedController::MIN_WORDS; ++i)
+    {
+        uint16_t before = sut.getSpeed();
+        if (sut.onWord(true, 1000, 1000))
+        {
+            steps += String((long) sut.getSpeed() - before) + " ";
+        }
+    }
+    assertEquals("test_SpeedController_staircase steps", "16 32 32 64 32 32 64 ", steps);
+
+    sut.begin(20, 3, 7, 90);
+    for (int i = 0; i < SpeedController::MIN_WORDS; ++i)
+    {
+        sut.onWord(true, i == 0 ? 3000 : 1000, 1000);            // one right, but slow
+    }
+    assertEquals("test_SpeedController_staircase slow counts half", 93, sut.getAccuracy());
+    assertFalse("test_SpeedController_staircase within the dead band", sut.isChanged());
+
+    sut.begin(20, 3, 7, 90);
+    for (int i = 1; i <= 3 * SpeedController::MAX_WORDS; ++i)
+    {
+        sut.onWord(i % 10 != 5, 1000, 1000);                    // one word in ten wrong
+    }
+    assertFalse("test_SpeedController_staircase 90 % stays", sut.isChanged());
+}
+
+/// a learner who gets a word right with 50 % at THRESHOLD WpM (effective), 10 % more for each WpM slower, and who
+/// takes longer to answer the harder it is
+struct Learner
+{
+        static const int THRESHOLD = 30;
+        uint32_t state;
+
+        int percent(uint16_t speed)
+        {
+            int p = 50 + (THRESHOLD * SpeedController::SCALE - (int) speed) * 10 / SpeedController::SCALE;
+            return p < 2 ? 2 : p > 98 ? 98 : p;
+        }
+
+        boolean answer(uint16_t speed, unsigned long &responseMs)
+        {
+            int p = percent(speed);
+            state = state * 1664525 + 1013904223;
+            responseMs = 2000 + 60 * (100 - p);
+            return (int) ((state >> 8) % 100) < p;
+        }
+};
+
+struct SimResult
+{
+        int settled;                                // words until the speed stays within 2 WpM of the 90 % speed
+        int right;                                  // in the second half
+        int jitter;                                 // mean change of speed per word in the second half, in 1/100 WpM
+};
+
+static SimResult simulate(boolean controlled, uint8_t startWpm, int words)
+{
+    const uint16_t goal = (Learner::THRESHOLD - 4) * SpeedController::SCALE;
+    SpeedController controller;
+    Learner learner = { 4711 };
+    SimResult r = { 0, 0, 0 };
+    int wpm = startWpm;
+    long moved = 0;
+
+    controller.begin(startWpm, 3, 7, 90);
+    uint16_t speed = controller.getSpeed();
+    for (int i = 0; i < words; ++i)
+    {
+        unsigned long responseMs;
+        boolean right = learner.answer(speed, responseMs);
+        uint16_t last = speed;
+        if (controlled)
+        {
+            controller.onWord(right, responseMs, 2000);
+            speed = controller.getSpeed();
+        }
+        else
+        {
+            wpm += right ? 1 : -1;
+            wpm = wpm < 5 ? 5 : wpm > 60 ? 60 : wpm;
+            speed = wpm * SpeedController::SCALE;
+        }
+        if (speed + 2 * SpeedController::SCALE < goal || speed > goal + 2 * SpeedController::SCALE)
+        {
+            r.settled = i + 1;
+        }
+        if (i >= words / 2)
+        {
+            r.right += right;
+            moved += speed > last ? speed - last : last - speed;
+        }
+    }
+    r.jitter = moved * 100 / SpeedController::SCALE / (words - words / 2);
+    return r;
+}
+
+void test_SpeedController_simulation()
+{
+    const int words = 400;
+
+    for (uint8_t start = 12; start <= 40; start += 28)
+    {
+        SimResult rule = simulate(false, start, words);
+        SimResult controlled = simulate(true, start, words);
+        printf("  from %d WpM, 90 %% at %d WpM, %d words: +/- 1 rule settled after %d, %d %% right, %d.%02d WpM/word; "
+                "controller %d, %d %% right, %d.%02d WpM/word\n", start, Learner::THRESHOLD - 4, words, rule.settled,
+                rule.right * 100 / (words / 2), rule.jitter / 100, rule.jitter % 100, controlled.settled,
+                controlled.right * 100 / (words / 2), controlled.jitter / 100, controlled.jitter % 100);
+        assertTrue("test_SpeedController_simulation settles", controlled.settled < words / 4);
+        assertTrue("test_SpeedController_simulation faster", controlled.settled < rule.settled);
+        assertTrue("test_SpeedController_simulation near target", controlled.right * 100 / (words / 2) >= 80);
+        assertTrue("test_SpeedController_simulation calmer", controlled.jitter < rule.jitter);
+    }
+}
+
+void test_SpeedController()
+{
+    printf("Testing SpeedController\n");
+    test_SpeedController_timings();
+    test_SpeedController_staircase();
+    test_SpeedController_simulation();
+}
@@ -0,0 +1,6 @@
+#ifndef SPEEDCONTROLLERTEST_H_
+#define SPEEDCONTROLLERTEST_H_
+
+void test_SpeedController();
+
+#endif /* SPEEDCONTROLLERTEST_H_ */
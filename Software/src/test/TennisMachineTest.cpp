@@ -5,14 +5,18 @@
  *      Author: mj
  */
 
+#include <chrono>
+
 #include "TestSupport.h"
 #include "TennisMachine.h"
+#include "TennisPattern.h"
 #include "TennisMachineTest.h"
 
 #define TESTPR(m,v) printf(m, v)
 
 String lastSent;
 boolean lastChallenge;
+uint8_t lastMatched, lastTotal;
 
 void TestClient::print(String m)
 {
@@ -56,6 +60,12 @@ TennisMachine::MessageSet* TestClient::getMsgSet()
     return &machine->getGameConfig()->msgSet;
 }
 
+void TestClient::progress(uint8_t matched, uint8_t total)
+{
+    lastMatched = matched;
+    lastTotal = total;
+}
+
 TennisMachine createSUT()
 {
     TennisMachine sut;
@@ -254,6 +264,170 @@ void test_TennisMachine_4_we_get_invited()
 
 }
 
+void test_TennisMachine_5_top_notch()
+{
+    printf("Testing TennisMachine 5\n");
+    TennisMachine sut = createSUT();
+    TennisMachine::GameConfig gameConfig = *sut.getGameConfig();
+    gameConfig.msgSet.cqCall = "cq cq cq de # # # +";
+    gameConfig.msgSet.dxdepat = "$dx de # k";
+    gameConfig.msgSet.dxdeus = "$dx de $us k";
+    gameConfig.msgSet.usdedx = "$us de $dx k";
+    gameConfig.msgSet.usdepat = "$us de # k";
+    gameConfig.msgSet.sendChallenge = "$dx de $us # # k";
+    gameConfig.msgSet.answerChallenge = "$dx de $us # k";
+    sut.setGameConfig(gameConfig);
+    WordBuffer buf;
+
+    sut.start();
+    buf.addWord("cq cq cq de xx0yyy xx0yyy");
+    sut.onMessageTransmit(buf);
+    assertEquals("1", "StateInitial", sut.getState());
+    assertEquals("1 progress", 6, lastMatched);
+    assertEquals("1 total", 8, lastTotal);
+
+    buf.addWord("xx0yyy");
+    buf.addWord("+");
+    sut.onMessageTransmit(buf);
+    assertEquals("2", "StateInviteSent", sut.getState());
+    assertEquals("2 sent", "cq cq cq de xx0yyy xx0yyy xx0yyy +", lastSent);
+
+    sut.onMessageReceive("xx0yyy de xx1dx");
+    assertEquals("3", "StateInviteSent", sut.getState());
+    sut.onMessageReceive("xx0yyy de xx1dx k");
+    assertEquals("4", "StateInviteAccepted", sut.getState());
+
+    buf.getAndClear();
+    buf.addWord("xx1dx de xx0yyy");
+    sut.onMessageTransmit(buf);
+    assertEquals("5", "StateInviteAccepted", sut.getState());
+    assertEquals("5 progress", 3, lastMatched);
+    buf.addWord("k");
+    sut.onMessageTransmit(buf);
+    assertEquals("6", "StateStartRoundSender", sut.getState());
+
+    buf.addWord("xx1dx de xx0yyy test tset k");
+    sut.onMessageTransmit(buf);
+    assertEquals("7", "StateStartRoundSender", sut.getState());
+    buf.addWord("xx1dx de xx0yyy test test");
+    sut.onMessageTransmit(buf);
+    assertEquals("8", "StateStartRoundSender", sut.getState());
+    assertEquals("8 progress", 5, lastMatched);
+    buf.addWord("k");
+    sut.onMessageTransmit(buf);
+    assertEquals("9", "StateWaitForAnswer", sut.getState());
+    assertEquals("9 challenge", "test", sut.getGameState().challenge);
+}
+
+void test_TennisPattern()
+{
+    printf("Testing TennisPattern\n");
+    TennisPattern::Slots slots = { { "w1aw", "dl4mat", "paris" } };
+
+    TennisPattern p("$dx de $us # # k");
+    assertEquals("pattern 1", true, p.isValid());
+    assertEquals("pattern 2", 6, p.getLength());
+
+    WordBuffer buf;
+    const char *words[] = { "w1aw", "de", "dl4mat", "abc", "abc", "k" };
+    for (int i = 0; i < 6; ++i)
+    {
+        assertEquals("pattern 3", false, p.advance(buf, slots));
+        assertEquals("pattern 4", i, p.getProgress());
+        buf.addWord(words[i]);
+    }
+    assertEquals("pattern 5", true, p.advance(buf, slots));
+    assertEquals("pattern 6", "abc", p.getMatch(buf));
+    assertEquals("pattern 7", "w1aw de dl4mat abc abc k", p.getFullMatch(buf));
+
+    // the buffer has been cleared - start over
+    buf.getAndClear();
+    buf.addWord("w1aw de");
+    assertEquals("pattern 8", false, p.advance(buf, slots));
+    assertEquals("pattern 9", 2, p.getProgress());
+
+    // a typo throws the partial match away, but a new one may start
+    buf.addWord("dl4mat abc abd w1aw");
+    assertEquals("pattern 10", false, p.advance(buf, slots));
+    assertEquals("pattern 11", 1, p.getProgress());
+
+    // overlapping partial matches
+    TennisPattern q("# # #");
+    WordBuffer buf2("a b b b");
+    assertEquals("pattern 12", true, q.matches(buf2, slots));
+    assertEquals("pattern 13", "b", q.getMatch(buf2));
+    WordBuffer star("b b *"), tooShort("b b"), challenge("x paris"), empty;
+    assertEquals("pattern 14", false, q.matches(star, slots));
+    assertEquals("pattern 15", false, q.matches(tooShort, slots));
+
+    assertEquals("pattern 16", true, TennisPattern("$challenge").matches(challenge, slots));
+    assertEquals("pattern 17", false, TennisPattern("").isValid());
+    assertEquals("pattern 18", false, TennisPattern("").matches(empty, slots));
+    assertEquals("pattern 19", false, TennisPattern("a b c d e f g h i j k l m n o p").isValid());
+
+    // more words than the buffer keeps track of
+    WordBuffer buf3;
+    TennisPattern r("cq de #");
+    for (int i = 0; i < 100; ++i)
+    {
+        buf3.addWord("cq");
+        if (i % 10 == 0)
+        {
+            r.advance(buf3, slots);
+        }
+    }
+    buf3.addWord("de dx");
+    assertEquals("pattern 20", true, r.advance(buf3, slots));
+    assertEquals("pattern 21", "dx", r.getMatch(buf3));
+}
+
+/// compare the cost per keyed word: rendering the pattern and matching the whole buffer (as it used to be done)
+/// against advancing the compiled pattern by one word
+void test_TennisPattern_benchmark()
+{
+    const int words = 20000;
+    TennisPattern::Slots slots = { { "w1aw", "dl4mat", "" } };
+    String pattern = "$dx de $us # # k";
+    String dx = "w1aw", us = "dl4mat";
+    const char *keyed[] = { "w1aw", "de", "dl4mat", "test", "tset", "k" };
+
+    WordBuffer buf;
+    int found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < words; ++i)
+    {
+        if (i % 30 == 0)
+        {
+            buf.getAndClear();
+        }
+        buf.addWord(keyed[i % 6]);
+        String rendered = pattern;
+        rendered.replace("$dx", dx);
+        rendered.replace("$us", us);
+        found += buf.matches(rendered);
+    }
+    auto interpreted = std::chrono::steady_clock::now() - start;
+
+    buf.getAndClear();
+    TennisPattern compiled(pattern.c_str());
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < words; ++i)
+    {
+        if (i % 30 == 0)
+        {
+            buf.getAndClear();
+        }
+        buf.addWord(keyed[i % 6]);
+        found += compiled.advance(buf, slots);
+    }
+    auto automaton = std::chrono::steady_clock::now() - start;
+
+    printf("  per keyed word: %ld ns rendering and matching the pattern, %ld ns advancing the compiled pattern\n",
+            (long) (std::chrono::duration_cast<std::chrono::nanoseconds>(interpreted).count() / words),
+            (long) (std::chrono::duration_cast<std::chrono::nanoseconds>(automaton).count() / words));
+    assertEquals("pattern benchmark", 0, found);
+}
+
 void test_TennisMachine_encodeInitialMessage()
 {
     printf("Testing TennisMachine::InitialMessage 1\n");
@@ -280,4 +454,8 @@ void test_TennisMachine()
     test_TennisMachine_2();
     test_TennisMachine_3_with_typos();
     test_TennisMachine_4_we_get_invited();
+    test_TennisMachine_5_top_notch();
+
+    test_TennisPattern();
+    test_TennisPattern_benchmark();
 }
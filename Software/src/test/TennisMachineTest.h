@@ -15,6 +15,7 @@ struct TestClient: public TennisMachine::Client
         void challengeSound(boolean ok);
         void handle(TennisMachine::InitialMessageData *d);
         TennisMachine::MessageSet* getMsgSet();
+        void progress(uint8_t matched, uint8_t total);
 };
 
 #endif /* TENNISMACHINETEST_H_ */
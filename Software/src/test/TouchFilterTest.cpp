@@ -0,0 +1,325 @@
+/*
+ * TouchFilterTest.cpp
+ *
+ *  Tests for the touch paddle filter. The traces are synthetic, but shaped like readings logged from
+ *  a Morserino: an untouched level around 58 with some noise, single-sample spikes (caused by the PWM audio
+ *  and LoRa transmissions), slow drift, and touches down to 18..45 with a few ms of bouncing at the edges.
+ *  The former adaptive threshold of MorseKeyer::readSensors() runs on the same traces for comparison.
+ */
+
+#include <math.h>
+#include <vector>
+
+#include "TestSupport.h"
+#include "TouchFilter.h"
+#include "TouchFilterTest.h"
+
+static uint32_t seed;
+
+static uint32_t nextRandom()
+{
+    seed = seed * 1103515245 + 12345;
+    return (seed >> 8) & 0xffffff;
+}
+
+static double uniform()
+{
+    return nextRandom() / (double) 0x1000000;
+}
+
+static double gaussian()
+{
+    return uniform() + uniform() + uniform() + uniform() + uniform() + uniform() - 3.0;
+}
+
+/// one sample per ms
+struct Trace
+{
+        std::vector<uint16_t> samples;
+        std::vector<bool> touched;
+};
+
+struct TraceShape
+{
+        const char *name;
+        int seconds;
+        double baseline;
+        double drift;                   /// change of the untouched level over the whole trace
+        double noise;
+        double spikeRate;               /// probability of a spike per sample
+        boolean keying;
+        double touchMin, touchMax;      /// level while touched
+};
+
+static Trace makeTrace(const TraceShape &shape)
+{
+    Trace t;
+    int n = shape.seconds * 1000;
+    int next = 500, end = -1;
+    double level = 0;
+
+    for (int i = 0; i < n; ++i)
+    {
+        double base = shape.baseline + shape.drift * i / n;
+        boolean on = i >= next && i < end;
+        if (shape.keying && i >= end)
+        {   // dits, dahs and the spaces between them at 15 to 30 wpm
+            int dit = 40 + nextRandom() % 41;
+            next = i + dit * (1 + nextRandom() % 3);
+            end = next + dit * (nextRandom() % 2 ? 1 : 3);
+            level = shape.touchMin + uniform() * (shape.touchMax - shape.touchMin);
+        }
+
+        double v = base;
+        if (on)
+        {
+            int fromEdge = i - next < end - i ? i - next : end - i;
+            v = fromEdge < 3 ? (uniform() < 0.5 ? level : base) : level;            // bouncing edges
+        }
+        v += gaussian() * shape.noise;
+        if (uniform() < shape.spikeRate)
+        {
+            v -= 15 + uniform() * 30;
+        }
+        if (uniform() < 0.002)
+        {
+            v = 0;                                                                   // invalid reading
+        }
+        t.samples.push_back(v < 0 ? 0 : (uint16_t) v);
+        t.touched.push_back(on);
+    }
+    return t;
+}
+
+/// the former calibration: average of two readings, threshold adapted with every reading, state taken
+/// over when two calls in a row agree (the debouncing in checkPaddles)
+struct FormerModel
+{
+        unsigned int untouched;
+        uint8_t threshold;
+        boolean state, last;
+
+        FormerModel(unsigned int u) :
+                untouched(u + 7), threshold(u + 7 - 9), state(false), last(false)
+        {
+        }
+
+        boolean read(uint16_t a, uint16_t b)
+        {
+            uint8_t v = (a + b) / 2;
+            if (v < threshold + 10)
+            {
+                threshold = (7 * threshold + ((v + untouched) / 2.22)) / 8;
+            }
+            boolean now = v < threshold;
+            if (now == last)
+            {
+                state = now;
+            }
+            last = now;
+            return state;
+        }
+};
+
+struct Result
+{
+        int falseTriggers;
+        int touches;
+        int missed;
+        double latency;
+};
+
+/// evaluate compares the detected state (one value per ms) with the truth: a false trigger is a detected touch
+/// that starts more than 20 ms away from any real one
+static Result evaluate(const Trace &t, const std::vector<bool> &detected)
+{
+    Result r = { 0, 0, 0, 0 };
+    int n = t.samples.size();
+    long latencySum = 0;
+    int latencyCount = 0;
+
+    for (int i = 1; i < n; ++i)
+    {
+        if (detected[i] && !detected[i - 1])
+        {
+            boolean real = false;
+            for (int j = i - 20 > 0 ? i - 20 : 0; j < n && j <= i + 20; ++j)
+            {
+                real |= t.touched[j];
+            }
+            if (!real)
+            {
+                ++r.falseTriggers;
+            }
+        }
+        if (t.touched[i] && !t.touched[i - 1] && i + 20 < n)
+        {
+            ++r.touches;
+            int j = i;
+            while (j < n && (t.touched[j] || j < i + 20) && !detected[j])
+            {
+                ++j;
+            }
+            if (j < n && detected[j])
+            {
+                latencySum += j - i;
+                ++latencyCount;
+            }
+            else
+            {
+                ++r.missed;
+            }
+        }
+    }
+    r.latency = latencyCount ? (double) latencySum / latencyCount : 0;
+    return r;
+}
+
+static Result runFilter(const Trace &t, uint16_t untouched)
+{
+    TouchFilter sut;
+    std::vector<bool> detected;
+    boolean state = false;
+
+    sut.begin(untouched);
+    for (size_t i = 0; i < t.samples.size(); ++i)
+    {
+        state = sut.update(t.samples[i]);
+        if (i % 100 == 0)
+        {
+            sut.calibrate();                                    // by the background task
+        }
+        detected.push_back(state);
+    }
+    return evaluate(t, detected);
+}
+
+static Result runFormer(const Trace &t, uint16_t untouched)
+{
+    FormerModel former(untouched);
+    std::vector<bool> detected;
+    boolean state = false;
+    uint16_t a = 0;
+
+    for (size_t i = 0; i < t.samples.size(); ++i)
+    {
+        if (t.samples[i] == 0)
+        {
+            detected.push_back(state);                          // readings of 0 were repeated
+            continue;
+        }
+        if (i % 2 == 0)
+        {
+            a = t.samples[i];
+        }
+        else
+        {
+            state = former.read(a, t.samples[i]);
+        }
+        detected.push_back(state);
+    }
+    return evaluate(t, detected);
+}
+
+void test_TouchFilter_spikes()
+{
+    TouchFilter sut;
+    sut.begin(58);
+
+    boolean any = false;
+    for (int i = 0; i < 100; ++i)
+    {
+        any |= sut.update(i % 10 == 0 ? 5 : 58);                // a single low reading now and then
+    }
+    assertFalse("test_TouchFilter_spikes", any);
+
+    sut.update(20);
+    assertFalse("test_TouchFilter_spikes one low reading", sut.isTouched());
+    sut.update(20);
+    sut.update(20);
+    assertFalse("test_TouchFilter_spikes median, debouncing", sut.isTouched());
+    sut.update(20);
+    assertTrue("test_TouchFilter_spikes debounced", sut.isTouched());
+
+    sut.update(0);
+    assertTrue("test_TouchFilter_spikes zero ignored", sut.isTouched());
+}
+
+void test_TouchFilter_hysteresis()
+{
+    TouchFilter sut;
+    sut.begin(60);
+    uint16_t threshold = sut.getThreshold();
+    assertEquals("test_TouchFilter_hysteresis threshold", 53, threshold);
+
+    for (int i = 0; i < 5; ++i)
+    {
+        sut.update(threshold - 1);
+    }
+    assertTrue("test_TouchFilter_hysteresis touched", sut.isTouched());
+    for (int i = 0; i < 5; ++i)
+    {
+        sut.update(threshold + 1);                              // above threshold, but below release
+    }
+    assertTrue("test_TouchFilter_hysteresis still touched", sut.isTouched());
+    for (int i = 0; i < 5; ++i)
+    {
+        sut.update(60);
+    }
+    assertFalse("test_TouchFilter_hysteresis released", sut.isTouched());
+}
+
+void test_TouchFilter_calibration()
+{
+    TouchFilter sut;
+    sut.begin(60);
+
+    for (int round = 0; round < 50; ++round)
+    {   // the untouched level drops slowly (humidity), touches go down to 20
+        for (int i = 0; i < 50; ++i)
+        {
+            sut.update(i < 30 ? 60 - round / 5 : 20);
+        }
+        sut.calibrate();
+    }
+    assertEquals("test_TouchFilter_calibration baseline", 51, sut.getBaseline());
+    assertTrue("test_TouchFilter_calibration threshold", sut.getThreshold() >= 39 && sut.getThreshold() <= 41);
+}
+
+void test_TouchFilter_traces()
+{
+    TraceShape shapes[] = {
+            { "quiet", 60, 58, -8, 1.5, 0.005, false, 0, 0 },
+            { "keying", 60, 58, 0, 1.5, 0.005, true, 18, 30 },
+            { "light touch", 60, 58, 4, 1.5, 0.005, true, 38, 45 },
+            { "noisy", 60, 58, -6, 3.0, 0.02, true, 18, 40 } };
+
+    for (const TraceShape &shape : shapes)
+    {
+        seed = 4711;
+        Trace t = makeTrace(shape);
+        uint16_t untouched = (uint16_t) shape.baseline;
+        Result r = runFilter(t, untouched);
+        Result f = runFormer(t, untouched);
+
+        printf("  %-12s %4i touches; filter: %3i false, %3i missed, latency %4.1f ms; former: %3i false, %3i missed, latency %4.1f ms\n",
+                shape.name, r.touches, r.falseTriggers, r.missed, r.latency, f.falseTriggers, f.missed, f.latency);
+
+        char name[80];
+        snprintf(name, sizeof(name), "test_TouchFilter_traces %s false triggers", shape.name);
+        assertEquals(name, 0, r.falseTriggers);
+        snprintf(name, sizeof(name), "test_TouchFilter_traces %s missed", shape.name);
+        assertEquals(name, 0, r.missed);
+        snprintf(name, sizeof(name), "test_TouchFilter_traces %s latency", shape.name);
+        assertTrue(name, r.latency <= 8);
+    }
+}
+
+void test_TouchFilter()
+{
+    printf("Testing TouchFilter\n");
+    test_TouchFilter_spikes();
+    test_TouchFilter_hysteresis();
+    test_TouchFilter_calibration();
+    test_TouchFilter_traces();
+}
@@ -0,0 +1,6 @@
+#ifndef TOUCHFILTERTEST_H_
+#define TOUCHFILTERTEST_H_
+
+void test_TouchFilter();
+
+#endif /* TOUCHFILTERTEST_H_ */
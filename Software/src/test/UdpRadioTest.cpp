@@ -0,0 +1,367 @@
+/*
+ * UdpRadioTest.cpp
+ *
+ *  Tests for the simulated radio, and end-to-end tests of the CW over LoRa protocol and of
+ *  Morse Tennis between two simulated stations. Skipped if the host does not support
+ *  multicast on the loopback interface.
+ */
+
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+#include "TestSupport.h"
+#include "UdpRadio.h"
+#include "LoRaCWPacket.h"
+#include "LoRaCWStreams.h"
+#include "TennisMachine.h"
+#include "UdpRadioTest.h"
+
+struct Inbox
+{
+        std::vector<std::vector<uint8_t>> packets;
+        std::vector<int> rssi;
+        std::vector<unsigned long> arrival;
+
+        void add(const uint8_t *data, uint8_t length, int r)
+        {
+            packets.push_back(std::vector<uint8_t>(data, data + length));
+            rssi.push_back(r);
+            arrival.push_back(UdpRadio::now());
+        }
+        void clear()
+        {
+            packets.clear();
+            rssi.clear();
+            arrival.clear();
+        }
+};
+
+static Inbox inboxA, inboxB;
+static uint16_t testPort;
+
+static void receiveA(const uint8_t *data, uint8_t length, int rssi)
+{
+    inboxA.add(data, length, rssi);
+}
+
+static void receiveB(const uint8_t *data, uint8_t length, int rssi)
+{
+    inboxB.add(data, length, rssi);
+}
+
+static UdpRadio::Config testConfig()
+{
+    UdpRadio::Config c;
+    c.port = testPort;
+    return c;
+}
+
+static boolean setup(UdpRadio &radio, Radio::ReceiveCallback cb)
+{
+    if (!radio.begin(434150000))
+    {
+        return false;
+    }
+    radio.setSyncWord(0x27);
+    radio.onReceive(cb);
+    radio.receive();
+    return true;
+}
+
+/// poll both radios for the given time
+static void run(UdpRadio &a, UdpRadio &b, unsigned long ms)
+{
+    unsigned long end = UdpRadio::now() + ms;
+    do
+    {
+        a.poll();
+        b.poll();
+        usleep(500);
+    } while (UdpRadio::now() < end);
+}
+
+static void send(UdpRadio &radio, const char *text)
+{
+    radio.send((const uint8_t*) text, strlen(text));
+    radio.receive();
+}
+
+void test_UdpRadio_basic()
+{
+    UdpRadio::Config configB = testConfig();
+    configB.rssi = -90;
+    configB.rssiSpread = 5;
+    UdpRadio a(testConfig()), b(configB);
+    setup(a, receiveA);
+    setup(b, receiveB);
+    inboxA.clear();
+    inboxB.clear();
+
+    send(a, "hello");
+    run(a, b, 50);
+    assertEquals("test_UdpRadio_basic received", 1, inboxB.packets.size());
+    assertEquals("test_UdpRadio_basic own", 0, inboxA.packets.size());
+    assertEquals("test_UdpRadio_basic length", 5, inboxB.packets[0].size());
+    assertTrue("test_UdpRadio_basic payload", memcmp(inboxB.packets[0].data(), "hello", 5) == 0);
+    assertTrue("test_UdpRadio_basic rssi", inboxB.rssi[0] >= -95 && inboxB.rssi[0] <= -85);
+
+    // another sync word is another channel
+    b.setSyncWord(0x12);
+    send(a, "other channel");
+    run(a, b, 50);
+    assertEquals("test_UdpRadio_basic sync word", 1, inboxB.packets.size());
+
+    // no reception while idle or sleeping
+    b.setSyncWord(0x27);
+    b.idle();
+    send(a, "idle");
+    b.sleep();
+    send(a, "sleep");
+    run(a, b, 50);
+    assertEquals("test_UdpRadio_basic idle", 1, inboxB.packets.size());
+}
+
+void test_UdpRadio_lossAndDelay()
+{
+    UdpRadio::Config configB = testConfig();
+    configB.lossPercent = 30;
+    configB.delay = 40;
+    configB.jitter = 20;
+    UdpRadio a(testConfig()), b(configB);
+    setup(a, receiveA);
+    setup(b, receiveB);
+    inboxB.clear();
+
+    std::vector<unsigned long> sent;
+    for (int i = 0; i < 100; ++i)
+    {
+        char text[8];
+        sprintf(text, "%d", i);
+        sent.push_back(UdpRadio::now());
+        send(a, text);
+        run(a, b, 1);
+    }
+    run(a, b, 150);
+
+    UdpRadio::Stats stats = b.getStats();
+    printf("  100 packets, 30%% loss configured: %lu received, %lu lost\n", stats.received, stats.lost);
+    assertEquals("test_UdpRadio_lossAndDelay count", 100, stats.received + stats.lost);
+    assertTrue("test_UdpRadio_lossAndDelay loss", stats.lost > 10 && stats.lost < 50);
+
+    int last = -1;
+    for (size_t i = 0; i < inboxB.packets.size(); ++i)
+    {
+        std::string text(inboxB.packets[i].begin(), inboxB.packets[i].end());
+        int n = atoi(text.c_str());
+        assertTrue("test_UdpRadio_lossAndDelay order", n > last);
+        assertTrue("test_UdpRadio_lossAndDelay delay", inboxB.arrival[i] - sent[n] >= 40);
+        last = n;
+    }
+}
+
+/// CW over LoRa end to end: station A keys words, station B sorts them into its streams and decodes them
+void test_UdpRadio_cwOverLoRa()
+{
+    UdpRadio::Config configB = testConfig();
+    configB.delay = 5;
+    configB.jitter = 10;
+    UdpRadio a(testConfig()), b(configB);
+    setup(a, receiveA);
+    setup(b, receiveB);
+    inboxB.clear();
+
+    const char *words[] = { "2121022120", "11101110", "1022101", "2", "1221012012101101110", "12121" };
+    const int rounds = 20;
+    const int count = rounds * sizeof(words) / sizeof(words[0]);
+    LoRaCWStreams streams;
+    LoRaCWPacket::Encoder encoder;
+    std::vector<unsigned long> sent;
+    int correct = 0;
+    unsigned long latency = 0;
+    unsigned long start = UdpRadio::now();
+
+    for (int i = 0; i < count; ++i)
+    {
+        const char *w = words[i % (sizeof(words) / sizeof(words[0]))];
+        encoder.start(LoRaCWPacket::VERSION_2, i, 0x3a, 25);
+        for (const char *p = w; *p; ++p)
+        {
+            encoder.addElement(*p - '0');
+        }
+        encoder.addElement(0);
+        encoder.addElement(3);
+        sent.push_back(UdpRadio::now());
+        send(a, encoder.getBuffer());
+        run(a, b, 2);
+    }
+    run(a, b, 50);
+    unsigned long elapsed = UdpRadio::now() - start;
+
+    for (size_t i = 0; i < inboxB.packets.size(); ++i)
+    {
+        streams.push(inboxB.packets[i].data(), inboxB.packets[i].size(), inboxB.rssi[i], inboxB.arrival[i]);
+    }
+    for (int i = 0; i < count; ++i)
+    {
+        const LoRaCWStreams::Word *w = streams.next(inboxB.arrival.back() + 10000);
+        if (!w)
+        {
+            // the streams hold at most SLOTS words - play out and refill
+            break;
+        }
+        char elements[LoRaCWPacket::MAX_ELEMENTS + 1];
+        LoRaCWPacket::decodeElements(w->data, w->length, elements, sizeof(elements));
+        if (w->header.station == 0x3a && strcmp(elements, words[i % (sizeof(words) / sizeof(words[0]))]) == 0)
+        {
+            ++correct;
+        }
+        latency += w->arrival - sent[i];
+    }
+
+    printf("  CW over LoRa: %d words sent, %lu received, %lu ms, %d of the first %d decoded correctly, average latency %lu ms\n",
+            count, inboxB.packets.size(), elapsed, correct, LoRaCWStreams::SLOTS, correct ? latency / correct : 0);
+    assertEquals("test_UdpRadio_cwOverLoRa received", count, inboxB.packets.size());
+    assertEquals("test_UdpRadio_cwOverLoRa decoded", LoRaCWStreams::SLOTS, correct);
+}
+
+/// Morse Tennis end to end: two machines play a short game over the simulated radio
+
+struct RadioClient: public TennisMachine::Client
+{
+        UdpRadio *radio;
+
+        void send(String s)
+        {
+            radio->send((const uint8_t*) s.c_str(), s.length());
+            radio->receive();
+        }
+        void print(String s) {}
+        void printReceivedMessage(String s) {}
+        void printSentMessage(String s) {}
+        void printScore(TennisMachine::GameState *g) {}
+        void challengeSound(boolean ok) {}
+        void handle(TennisMachine::InitialMessageData *d) {}
+        TennisMachine::MessageSet* getMsgSet()
+        {
+            return &machine->getGameConfig()->msgSet;
+        }
+};
+
+static void setupTennis(TennisMachine &machine, RadioClient &client, UdpRadio &radio)
+{
+    client.radio = &radio;
+    machine.setClient(&client);
+
+    TennisMachine::GameConfig gameConfig;
+    gameConfig.msgSetNo = 0;
+    gameConfig.scoringNo = 0;
+    gameConfig.msgSet.cqCall = "cq de #";
+    gameConfig.msgSet.dxdepat = "$dx de #";
+    gameConfig.msgSet.dxdeus = "$dx de $us";
+    gameConfig.msgSet.usdedx = "$us de $dx";
+    gameConfig.msgSet.usdepat = "$us de #";
+    gameConfig.msgSet.sendChallenge = "# #";
+    gameConfig.msgSet.answerChallenge = "#";
+    gameConfig.receiverPoints = 1;
+    gameConfig.senderPoints = 0;
+    machine.setGameConfig(gameConfig);
+    machine.start();
+}
+
+/// deliver everything received so far to the machines
+static void deliver(UdpRadio &a, UdpRadio &b, TennisMachine &ma, TennisMachine &mb)
+{
+    run(a, b, 30);
+    for (auto &p : inboxA.packets)
+    {
+        ma.onMessageReceive(String(std::string(p.begin(), p.end())));
+    }
+    for (auto &p : inboxB.packets)
+    {
+        mb.onMessageReceive(String(std::string(p.begin(), p.end())));
+    }
+    inboxA.clear();
+    inboxB.clear();
+}
+
+static void transmit(TennisMachine &machine, const char *text)
+{
+    WordBuffer buf;
+    buf.addWord(text);
+    machine.onMessageTransmit(buf);
+}
+
+void test_UdpRadio_tennis()
+{
+    UdpRadio::Config config = testConfig();
+    config.delay = 10;
+    UdpRadio a(config), b(config);
+    setup(a, receiveA);
+    setup(b, receiveB);
+    inboxA.clear();
+    inboxB.clear();
+
+    TennisMachine ma, mb;
+    RadioClient ca, cb;
+    setupTennis(ma, ca, a);
+    setupTennis(mb, cb, b);
+
+    transmit(ma, "cq de aa1aa");
+    deliver(a, b, ma, mb);
+    assertEquals("test_UdpRadio_tennis 1", "StateInviteReceived", mb.getState());
+
+    transmit(mb, "aa1aa de bb2bb");
+    deliver(a, b, ma, mb);
+    assertEquals("test_UdpRadio_tennis 2a", "StateInviteAccepted", ma.getState());
+    assertEquals("test_UdpRadio_tennis 2b", "StateInviteAnswered", mb.getState());
+
+    transmit(ma, "bb2bb de aa1aa");
+    deliver(a, b, ma, mb);
+    assertEquals("test_UdpRadio_tennis 3a", "StateStartRoundSender", ma.getState());
+    assertEquals("test_UdpRadio_tennis 3b", "StateStartRoundReceiver", mb.getState());
+
+    unsigned long start = UdpRadio::now();
+    const int rounds = 5;
+    for (int i = 0; i < rounds; ++i)
+    {
+        transmit(ma, "test test");
+        deliver(a, b, ma, mb);
+        assertEquals("test_UdpRadio_tennis challenge", "StateChallengeReceived", mb.getState());
+        transmit(mb, "test");
+        deliver(a, b, ma, mb);
+        assertEquals("test_UdpRadio_tennis answer", "StateStartRoundReceiver", ma.getState());
+
+        transmit(mb, "abc abc");
+        deliver(a, b, ma, mb);
+        transmit(ma, "abc");
+        deliver(a, b, ma, mb);
+        assertEquals("test_UdpRadio_tennis back", "StateStartRoundSender", ma.getState());
+    }
+    printf("  Morse Tennis: %d rounds in %lu ms\n", rounds, UdpRadio::now() - start);
+    assertEquals("test_UdpRadio_tennis points a", rounds, ma.getGameState().us.points);
+    assertEquals("test_UdpRadio_tennis points b", rounds, mb.getGameState().us.points);
+
+    transmit(mb, "<sk>");
+    deliver(a, b, ma, mb);
+    assertEquals("test_UdpRadio_tennis end a", "StateEnd", ma.getState());
+    assertEquals("test_UdpRadio_tennis end b", "StateEnd", mb.getState());
+}
+
+void test_UdpRadio()
+{
+    printf("Testing UdpRadio\n");
+    testPort = 7732 + getpid() % 1000;
+
+    UdpRadio probe(testConfig());
+    if (!probe.begin(434150000))
+    {
+        printf("  no multicast on loopback - skipped\n");
+        return;
+    }
+
+    test_UdpRadio_basic();
+    test_UdpRadio_lossAndDelay();
+    test_UdpRadio_cwOverLoRa();
+    test_UdpRadio_tennis();
+}
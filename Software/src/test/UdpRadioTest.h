@@ -0,0 +1,6 @@
+#ifndef UDPRADIOTEST_H_
+#define UDPRADIOTEST_H_
+
+void test_UdpRadio();
+
+#endif /* UDPRADIOTEST_H_ */
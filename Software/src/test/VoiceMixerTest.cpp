@@ -0,0 +1,274 @@
+/*
+ * VoiceMixerTest.cpp
+ *
+ *  Tests for the voice mixer: the timing of the elements, the ramps, the levels and clipping, fading and noise, and what
+ *  a voice and each effect cost.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "TestSupport.h"
+#include "VoiceMixer.h"
+#include "VoiceMixerTest.h"
+
+/// at a quarter of the sample rate the samples of a sine are 0, peak, 0, -peak
+static const uint16_t QUARTER_RATE = VoiceMixer::SAMPLE_RATE / 4;
+
+void test_VoiceMixer_timing()
+{
+    VoiceMixer sut;
+    int16_t out[1000];
+
+    assertEquals("test_VoiceMixer_timing dit", 480, VoiceMixer::getDitSamples(20));
+    assertFalse("test_VoiceMixer_timing idle", sut.isBusy());
+
+    // dit, space, space between characters, dit, space: 6 dits
+    sut.send(0, "1 1", 600, 20, 50, 0);
+    assertTrue("test_VoiceMixer_timing sending", sut.isSending(0));
+    for (int i = 0; i < 3; ++i)
+    {
+        sut.render(out, 960);
+    }
+    assertTrue("test_VoiceMixer_timing still sending", sut.isSending(0));
+    sut.render(out, 1);
+    assertFalse("test_VoiceMixer_timing done", sut.isSending(0));
+    assertFalse("test_VoiceMixer_timing silent", sut.isBusy());
+
+    // a dah is 3 dits long, and the mark starts after the delay
+    sut.send(1, "2", QUARTER_RATE, 20, 100, 100);
+    sut.render(out, 800);
+    boolean quiet = true;
+    for (int i = 0; i < 800; ++i)
+    {
+        quiet = quiet && out[i] == 0;
+    }
+    assertTrue("test_VoiceMixer_timing delay", quiet);
+    int last = 0;
+    for (int block = 0; block < 3; ++block)
+    {
+        sut.render(out, 1000);
+        for (int i = 0; i < 1000; ++i)
+        {
+            if (out[i])
+            {
+                last = block * 1000 + i;
+            }
+        }
+    }
+    assertTrue("test_VoiceMixer_timing dah", last >= 3 * 480 && last < 3 * 480 + VoiceMixer::RAMP);
+    assertFalse("test_VoiceMixer_timing unknown voice", sut.send(VoiceMixer::MAX_VOICES, "1", 600, 20, 50, 0));
+}
+
+void test_VoiceMixer_levels()
+{
+    VoiceMixer sut;
+    int16_t out[64];
+
+    sut.setTone(0, QUARTER_RATE, 100);
+    sut.render(out, 4);
+    assertEquals("test_VoiceMixer_levels 0", 0, out[0]);
+    assertEquals("test_VoiceMixer_levels peak", 32767, out[1]);
+    assertEquals("test_VoiceMixer_levels zero", 0, out[2]);
+    assertEquals("test_VoiceMixer_levels negative peak", -32767, out[3]);
+
+    sut.setTone(0, QUARTER_RATE, 50);
+    sut.render(out, 2);
+    assertEquals("test_VoiceMixer_levels half", 16383, out[1]);
+
+    sut.setTone(0, QUARTER_RATE, 0);
+    sut.render(out, 4);
+    assertEquals("test_VoiceMixer_levels off", 0, out[1]);
+
+    VoiceMixer loud;
+    loud.setTone(0, QUARTER_RATE, 100);
+    loud.setTone(1, QUARTER_RATE, 100);
+    loud.render(out, 4);
+    assertEquals("test_VoiceMixer_levels clipped", 32767, out[1]);
+    assertEquals("test_VoiceMixer_levels clipped negative", -32768, out[3]);
+
+    // a mark ramps up in RAMP samples along a raised cosine: slowly at first, half way in the middle
+    sut.send(2, "1", QUARTER_RATE, 20, 100, 0);
+    sut.render(out, 64);
+    assertEquals("test_VoiceMixer_levels ramp", 255, out[1]);
+    assertEquals("test_VoiceMixer_levels ramp 10", 7295, out[9]);
+    assertEquals("test_VoiceMixer_levels ramp half", -16384, out[VoiceMixer::RAMP / 2 - 1]);
+    assertEquals("test_VoiceMixer_levels ramp done", 32767, out[VoiceMixer::RAMP + 1]);
+
+    // keyed from outside: the same ramps, and it decays when it is released
+    VoiceMixer keyed;
+    keyed.key(0, QUARTER_RATE, 100);
+    keyed.render(out, 64);
+    assertEquals("test_VoiceMixer_levels key ramp", 255, out[1]);
+    assertEquals("test_VoiceMixer_levels key on", 32767, out[VoiceMixer::RAMP + 1]);
+    keyed.key(0, QUARTER_RATE, 0);
+    assertTrue("test_VoiceMixer_levels key decays", keyed.isBusy());
+    keyed.render(out, VoiceMixer::RAMP);
+    assertTrue("test_VoiceMixer_levels key decaying", abs(out[1]) < 32767 && abs(out[1]) > 32000);
+    assertFalse("test_VoiceMixer_levels key off", keyed.isBusy());
+
+    assertEquals("test_VoiceMixer_levels duty silence", 512, VoiceMixer::toDuty(0, 10));
+    assertEquals("test_VoiceMixer_levels duty top", 1023, VoiceMixer::toDuty(32767, 10));
+    assertEquals("test_VoiceMixer_levels duty bottom", 0, VoiceMixer::toDuty(-32768, 10));
+}
+
+/// a faded voice goes down by the depth and up again in the period
+void test_VoiceMixer_fading()
+{
+    VoiceMixer sut;
+    int16_t out[VoiceMixer::BLOCK];
+    int low = 32767;
+    int high = 0;
+
+    sut.setTone(0, QUARTER_RATE, 100);
+    sut.setFading(0, 75, 1000);
+    for (int block = 0; block < VoiceMixer::SAMPLE_RATE / VoiceMixer::BLOCK; ++block)       // 1 s
+    {
+        sut.render(out, VoiceMixer::BLOCK);
+        int peak = 0;
+        for (int i = 0; i < VoiceMixer::BLOCK; ++i)
+        {
+            peak = abs(out[i]) > peak ? abs(out[i]) : peak;
+        }
+        low = peak < low ? peak : low;
+        high = peak > high ? peak : high;
+        if (block == VoiceMixer::SAMPLE_RATE / VoiceMixer::BLOCK / 2)
+        {
+            assertTrue("test_VoiceMixer_fading bottom after half the period", peak < 32767 / 4 + 300);
+        }
+    }
+    assertTrue("test_VoiceMixer_fading top", high > 32500);
+    assertTrue("test_VoiceMixer_fading depth", low > 32767 / 4 - 300 && low < 32767 / 4 + 300);
+
+    sut.setFading(0, 75, 0);
+    sut.render(out, 4);
+    assertEquals("test_VoiceMixer_fading off", 32767, out[1]);
+}
+
+/// root of the mean of the squares (there is no libm here)
+static long rootMeanSquare(long long sum, int n)
+{
+    long long x = sum / n;
+    long long r = x;
+
+    while (r > 0 && r * r > x)
+    {
+        r = (r + x / r) / 2;
+    }
+    return (long) r;
+}
+
+/// noise: white noise jumps from sample to sample, pink noise has less of the high frequencies; both as loud
+void test_VoiceMixer_noise()
+{
+    const int N = 8000;
+    static int16_t out[N];
+    long rms[2];
+    long steps[2];
+
+    for (int p = 0; p < 2; ++p)
+    {
+        VoiceMixer sut;
+        long long sum = 0;
+        long long sumSteps = 0;
+        sut.setNoise(50, p);
+        assertTrue("test_VoiceMixer_noise busy", sut.isBusy());
+        sut.render(out, N);
+        for (int i = 1; i < N; ++i)
+        {
+            sum += (long long) out[i] * out[i];
+            sumSteps += (long long) (out[i] - out[i - 1]) * (out[i] - out[i - 1]);
+        }
+        rms[p] = rootMeanSquare(sum, N);
+        steps[p] = rootMeanSquare(sumSteps, N);
+    }
+    printf("  noise at 50 %%: white %ld rms, pink %ld rms\n", rms[0], rms[1]);
+    assertTrue("test_VoiceMixer_noise white level", rms[0] > 8000 && rms[0] < 11000);     // uniform: 16384 / sqrt(3)
+    assertTrue("test_VoiceMixer_noise pink level", rms[1] > rms[0] / 2 && rms[1] < rms[0] * 2);
+    assertTrue("test_VoiceMixer_noise white steps", steps[0] > rms[0]);
+    assertTrue("test_VoiceMixer_noise pink steps", steps[1] < rms[1]);
+
+    VoiceMixer quiet;
+    quiet.setNoise(0, false);
+    assertFalse("test_VoiceMixer_noise off", quiet.isBusy());
+}
+
+/// what a voice costs: all voices send, and the time per sample is divided among them
+void test_VoiceMixer_benchmark()
+{
+    const int N = 8000 * 20;
+    static VoiceMixer sut;
+    int16_t out[256];
+    long sum = 0;
+
+    for (uint8_t v = 0; v < VoiceMixer::MAX_VOICES; ++v)
+    {
+        sut.send(v, "2121 2212 / 1 2121 / 12 / 11111 12 12", 400 + 50 * v, 20 + v, 12, 50 * v);
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < N; i += 256)
+    {
+        sut.render(out, 256);
+        sum += out[i % 256];
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    long ns = (long) (std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / N);
+    printf("  %ld ns per sample, %ld ns per sample per voice (host)\n", ns, ns / VoiceMixer::MAX_VOICES);
+    assertTrue("test_VoiceMixer_benchmark sending", sut.isBusy() || sum != 0);
+}
+
+/// samplesPerSecond renders 10 s of the mixer as it is, three times, and takes the fastest
+static long samplesPerSecond(VoiceMixer &sut)
+{
+    const int N = 8000 * 10;
+    int16_t out[256];
+    long long best = 0;
+
+    for (int run = 0; run < 3; ++run)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < N; i += 256)
+        {
+            sut.render(out, 256);
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        best = run == 0 || ns < best ? ns : best;
+    }
+    return best ? (long) (N * 1000000000LL / best) : 0;
+}
+
+/// what each effect costs: a sounding voice (with its envelope), then with noise, fading and an interfering station
+/// added one by one
+void test_VoiceMixer_effects()
+{
+    static VoiceMixer sut;
+
+    sut.setTone(0, 600, 50);
+    long tone = samplesPerSecond(sut);
+    sut.setNoise(20, false);
+    long white = samplesPerSecond(sut);
+    sut.setNoise(20, true);
+    long pink = samplesPerSecond(sut);
+    sut.setFading(0, 80, 4000);
+    long qsb = samplesPerSecond(sut);
+    sut.setTone(1, 850, 20);
+    sut.setFading(1, 50, 7000);
+    long qrm = samplesPerSecond(sut);
+
+    printf("  samples per second (host): tone %ld, + white noise %ld, pink instead %ld, + QSB %ld, + QRM %ld\n", tone,
+            white, pink, qsb, qrm);
+    assertTrue("test_VoiceMixer_effects real time", qrm > VoiceMixer::SAMPLE_RATE);
+}
+
+void test_VoiceMixer()
+{
+    printf("Testing VoiceMixer\n");
+    test_VoiceMixer_timing();
+    test_VoiceMixer_levels();
+    test_VoiceMixer_fading();
+    test_VoiceMixer_noise();
+    test_VoiceMixer_benchmark();
+    test_VoiceMixer_effects();
+}
@@ -0,0 +1,6 @@
+#ifndef VOICEMIXERTEST_H_
+#define VOICEMIXERTEST_H_
+
+void test_VoiceMixer();
+
+#endif /* VOICEMIXERTEST_H_ */
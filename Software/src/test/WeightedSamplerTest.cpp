@@ -0,0 +1,143 @@
+/*
+ * WeightedSamplerTest.cpp
+ *
+ *  Tests for the weighted sampler: every r picks the right item, and the picks follow the weights.
+ */
+
+#include <chrono>
+#include "TestSupport.h"
+#include "WeightedSampler.h"
+#include "WeightedSamplerTest.h"
+
+/// a small linear congruential generator, so the runs are repeatable
+static uint32_t lcg(uint32_t &state)
+{
+    state = state * 1664525 + 1013904223;
+    return state >> 8;
+}
+
+/// the item that pick(r) should return, by adding up the weights one by one
+static uint16_t linearPick(WeightedSampler &sut, uint32_t r)
+{
+    for (uint16_t i = 0; i < sut.getSize(); ++i)
+    {
+        if (r < sut.get(i))
+        {
+            return i;
+        }
+        r -= sut.get(i);
+    }
+    return sut.getSize() - 1;
+}
+
+void test_WeightedSampler_pick()
+{
+    const uint16_t weights[] = { 3, 0, 1, 4, 0, 2 };
+    WeightedSampler sut;
+
+    sut.build(weights, 6);
+    assertEquals("test_WeightedSampler_pick total", 10, sut.getTotal());
+    String picks;
+    for (uint32_t r = 0; r < sut.getTotal(); ++r)
+    {
+        picks += String((unsigned long) sut.pick(r));
+    }
+    assertEquals("test_WeightedSampler_pick all", "0002333355", picks);
+
+    sut.set(1, 2);
+    sut.set(3, 0);
+    assertEquals("test_WeightedSampler_pick new total", 8, sut.getTotal());
+    picks = "";
+    for (uint32_t r = 0; r < sut.getTotal(); ++r)
+    {
+        picks += String((unsigned long) sut.pick(r));
+    }
+    assertEquals("test_WeightedSampler_pick after set", "00011255", picks);
+    sut.set(6, 9);
+    assertEquals("test_WeightedSampler_pick out of range", 8, sut.getTotal());
+}
+
+void test_WeightedSampler_updates()
+{
+    uint16_t weights[WeightedSampler::CAPACITY];
+    WeightedSampler sut;
+    WeightedSampler built;
+    uint32_t state = 42;
+    int wrong = 0;
+
+    for (int i = 0; i < 200; ++i)
+    {
+        weights[i] = lcg(state) % 300;
+    }
+    sut.build(weights, 200);
+    for (int round = 0; round < 2000; ++round)
+    {
+        uint16_t i = lcg(state) % 200;
+        weights[i] = lcg(state) % 300;
+        sut.set(i, weights[i]);
+        uint32_t r = lcg(state) % sut.getTotal();
+        wrong += sut.pick(r) != linearPick(sut, r);
+    }
+    built.build(weights, 200);
+    assertEquals("test_WeightedSampler_updates picks", 0, wrong);
+    assertEquals("test_WeightedSampler_updates total", built.getTotal(), sut.getTotal());
+}
+
+void test_WeightedSampler_distribution()
+{
+    const uint16_t weights[] = { 16, 216, 16, 16, 116, 16, 64, 16 };
+    const int N = 400000;
+    int counts[8] = { };
+    WeightedSampler sut;
+    uint32_t state = 7;
+
+    sut.build(weights, 8);
+    for (int i = 0; i < N; ++i)
+    {
+        ++counts[sut.pick(lcg(state) % sut.getTotal())];
+    }
+    int worst = 0;
+    for (int i = 0; i < 8; ++i)
+    {
+        int expected = (long) N * weights[i] / sut.getTotal();
+        int deviation = abs(counts[i] - expected) * 1000 / expected;   // per mille
+        worst = deviation > worst ? deviation : worst;
+    }
+    printf("  %d picks from 8 items: largest deviation from the weights %d.%d %%\n", N, worst / 10, worst % 10);
+    assertTrue("test_WeightedSampler_distribution within 2 %", worst < 20);
+}
+
+void test_WeightedSampler_benchmark()
+{
+    const int N = 2000000;
+    uint16_t weights[WeightedSampler::CAPACITY];
+    WeightedSampler sut;
+    uint32_t state = 1;
+    uint32_t sum = 0;
+
+    for (int i = 0; i < WeightedSampler::CAPACITY; ++i)
+    {
+        weights[i] = 16 + i % 200;
+    }
+    sut.build(weights, WeightedSampler::CAPACITY);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < N; ++i)
+    {
+        uint32_t r = lcg(state);
+        sut.set(r % WeightedSampler::CAPACITY, 16 + r % 200);
+        sum += sut.pick(r % sut.getTotal());
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    printf("  %ld ns per update and pick of %d items (host)\n",
+            (long) (std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / N), WeightedSampler::CAPACITY);
+    assertTrue("test_WeightedSampler_benchmark picked", sum > 0);
+}
+
+void test_WeightedSampler()
+{
+    printf("Testing WeightedSampler\n");
+    test_WeightedSampler_pick();
+    test_WeightedSampler_updates();
+    test_WeightedSampler_distribution();
+    test_WeightedSampler_benchmark();
+}
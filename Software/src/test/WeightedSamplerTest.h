@@ -0,0 +1,6 @@
+#ifndef WEIGHTEDSAMPLERTEST_H_
+#define WEIGHTEDSAMPLERTEST_H_
+
+void test_WeightedSampler();
+
+#endif /* WEIGHTEDSAMPLERTEST_H_ */
@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <string>
+#include <chrono>
 
 #include "TestSupport.h"
 
@@ -151,6 +152,87 @@ void test_WordBuffer_fullPatternMatch_1()
     assertEquals("matches 5 3", "dx de me k", sut.getFullPatternMatch());
 }
 
+void test_WordBuffer_matches_spaces()
+{
+    WordBuffer sut;
+    sut.addWord("cq  de");
+    sut.addChar("d");
+    sut.addChar("x");
+    assertEquals("matches spaces 1", true, sut.matches("cq de dx"));
+    assertEquals("matches spaces 2", "cq  de dx", sut.getFullPatternMatch());
+    assertEquals("matches spaces 3", true, sut.matches(" de  # "));
+    assertEquals("matches spaces 4", "dx", sut.getMatch());
+}
+
+void test_WordBuffer_matches_long()
+{
+    WordBuffer sut;
+    for (int i = 0; i < 100; ++i)
+    {
+        sut.addWord(String((unsigned long) i));
+    }
+    assertEquals("matches long 1", true, sut.matches("97 # 99"));
+    assertEquals("matches long 2", "98", sut.getMatch());
+    assertEquals("matches long 3", false, sut.matches("97 # 98"));
+
+    sut.getAndClear();
+    sut.addWord("de");
+    assertEquals("matches long 4", true, sut.matches("de"));
+    assertEquals("matches long 5", false, sut.matches("97 de"));
+}
+
+void test_WordBuffer_matches_pattern()
+{
+    WordBuffer::Pattern pattern("cq de #");
+    assertEquals("matches pattern 1", true, pattern.isValid());
+    assertEquals("matches pattern 2", true, WordBuffer("cq de dx").matches(pattern));
+    assertEquals("matches pattern 3", false, WordBuffer("cq de").matches(pattern));
+
+    WordBuffer::Pattern empty("");
+    assertEquals("matches pattern 4", true, WordBuffer().matches(empty));
+    assertEquals("matches pattern 5", false, WordBuffer("cq").matches(empty));
+
+    std::string tooLong(WordBuffer::Pattern::MAX_LENGTH + 1, 'e');
+    WordBuffer::Pattern invalid(tooLong.c_str());
+    assertEquals("matches pattern 6", false, invalid.isValid());
+    assertEquals("matches pattern 7", false, WordBuffer(tooLong.c_str()).matches(invalid));
+}
+
+void test_WordBuffer_matches_benchmark()
+{
+    WordBuffer sut;
+    for (int i = 0; i < 2000; ++i)
+    {
+        sut.addWord(i % 2 ? "test" : "de");
+    }
+    sut.addWord("cq");
+    sut.addWord("de");
+    sut.addWord("w1aw");
+    WordBuffer::Pattern pattern("cq de #");
+
+    const int rounds = 100000;
+    int found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i)
+    {
+        found += sut.matches(pattern);
+    }
+    auto compiled = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i)
+    {
+        found += sut.matches("cq de #");
+    }
+    auto uncompiled = std::chrono::steady_clock::now() - start;
+
+    printf("  matching a buffer of %u chars: %ld ns per match with compiled pattern, %ld ns when compiling every time\n",
+            sut.get().length(),
+            (long) (std::chrono::duration_cast<std::chrono::nanoseconds>(compiled).count() / rounds),
+            (long) (std::chrono::duration_cast<std::chrono::nanoseconds>(uncompiled).count() / rounds));
+    assertEquals("matches benchmark", 2 * rounds, found);
+}
+
 void test_WordBuffer()
 {
     printf("Testing WordBuffer\n");
@@ -165,5 +247,9 @@ void test_WordBuffer()
     test_WordBuffer_matches_3();
     test_WordBuffer_matches_4();
     test_WordBuffer_fullPatternMatch_1();
+    test_WordBuffer_matches_spaces();
+    test_WordBuffer_matches_long();
+    test_WordBuffer_matches_pattern();
+    test_WordBuffer_matches_benchmark();
 }
 
@@ -0,0 +1,78 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <new>
+
+#include "TestSupport.h"
+
+#include "WordBuffer.h"
+
+/// A test binary of its own: it replaces the global operator new and delete to count heap allocations, which
+/// would change how every other test allocates if it were linked into runtests.
+
+static unsigned long allocations = 0;
+static unsigned long deallocations = 0;
+
+void* operator new(size_t size)
+{
+    ++allocations;
+    void *p = malloc(size ? size : 1);
+    if (!p)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    if (p)
+    {
+        ++deallocations;
+    }
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    operator delete(p);
+}
+
+/// matching neither allocates nor leaks memory
+void test_WordBuffer_matches_allocation()
+{
+    WordBuffer sut;
+    for (int i = 0; i < 50; ++i)
+    {
+        sut.addWord("abcdefghijklmnopqrstuvwxyz");
+    }
+    WordBuffer::Pattern noMatch("abcdefghijklmnopqrstuvwxyz # abcdefghijklmnopqrstuvwxyy");
+    WordBuffer::Pattern match("abcdefghijklmnopqrstuvwxyz # abcdefghijklmnopqrstuvwxyz");
+
+    unsigned long before = allocations;
+    for (int i = 0; i < 1000; ++i)
+    {
+        sut.matches(noMatch);
+    }
+    assertEquals("matches allocation 1", 0, allocations - before);
+
+    sut.matches(match);
+    before = allocations - deallocations;
+    for (int i = 0; i < 1000; ++i)
+    {
+        sut.matches(match);
+        sut.matches("abcdefghijklmnopqrstuvwxyz # abcdefghijklmnopqrstuvwxyz");
+        sut.matches(String("abcdefghijklmnopqrstuvwxyz # abcdefghijklmnopqrstuvwxyy"));
+    }
+    assertEquals("matches allocation 2", 0, (allocations - deallocations) - before);
+}
+
+int main()
+{
+    printf("Allocation tests\n\n");
+
+    printf("Testing WordBuffer\n");
+    test_WordBuffer_matches_allocation();
+
+    printf("Failed tests: %lu\n", failedTests.size());
+    return failedTests.size();
+}
@@ -15,6 +15,27 @@
 
 #include "WordBufferTest.h"
 #include "TennisMachineTest.h"
+#include "LoRaCWStreamsTest.h"
+#include "JitterBufferTest.h"
+#include "UdpRadioTest.h"
+#include "PrefsStoreTest.h"
+#include "BootSequenceTest.h"
+#include "SchedulerTest.h"
+#include "ProfilerTest.h"
+#include "TouchFilterTest.h"
+#include "IambicKeyerTest.h"
+#include "PowerPolicyTest.h"
+#include "SoundSequencerTest.h"
+#include "CharStatsTest.h"
+#include "WeightedSamplerTest.h"
+#include "AdaptiveTextTest.h"
+#include "SpacedRepetitionTest.h"
+#include "SpeedControllerTest.h"
+#include "SessionLogTest.h"
+#include "FistAnalyzerTest.h"
+#include "HeadCopyScorerTest.h"
+#include "QsoGeneratorTest.h"
+#include "VoiceMixerTest.h"
 
 
 int main()
@@ -23,6 +44,27 @@ int main()
 
     test_WordBuffer();
     test_TennisMachine();
+    test_LoRaCWStreams();
+    test_JitterBuffer();
+    test_UdpRadio();
+    test_PrefsStore();
+    test_BootSequence();
+    test_Scheduler();
+    test_Profiler();
+    test_TouchFilter();
+    test_IambicKeyer();
+    test_PowerPolicy();
+    test_SoundSequencer();
+    test_CharStats();
+    test_WeightedSampler();
+    test_AdaptiveText();
+    test_SpacedRepetition();
+    test_SpeedController();
+    test_SessionLog();
+    test_FistAnalyzer();
+    test_HeadCopyScorer();
+    test_QsoGenerator();
+    test_VoiceMixer();
 
     printf("Failed tests: %lu\n", failedTests.size());
     return failedTests.size();
@@ -110,7 +110,14 @@ String String::substring(unsigned int a)
 
 String String::substring(unsigned int a, unsigned int b)
 {
-    return String(delegate.substr(a, b));
+    // like Arduino: from index a up to (but not including) index b
+    if (b < a)
+    {
+        unsigned int t = a;
+        a = b;
+        b = t;
+    }
+    return String(delegate.substr(a, b - a));
 }
 
 int String::lastIndexOf(char c)
@@ -13,6 +13,7 @@
 #include <string>
 
 #define boolean bool
+#define IRAM_ATTR
 
 #define T2 2
 #define T5 5
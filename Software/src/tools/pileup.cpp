@@ -0,0 +1,249 @@
+/*
+ * pileup.cpp
+ *
+ *  Renders a pile-up as the M32 makes it - several callers, each with its own pitch, speed, level and start - into
+ *  a WAV file (8 kHz, 16 bit, mono), to hear what the mixer does; with band conditions if you like.
+ *
+ *  usage: pileup [-n callers] [-s seed] [-N noise] [-p] [-q qsb] [-r qrm] [-b] file.wav
+ *      -n: 1 .. 8 callers (default 3), each sends its call twice
+ *      -N: noise, 0 - 100 % of full scale (default 0); -p: pink noise instead of white
+ *      -q: QSB, the callers fade by 0 - 100 % (default 0), each at its own pace
+ *      -r: QRM, 0 .. 8 - callers other stations that send CQ close by
+ *      with -b: no file, but how many samples per second the mixer makes, per voice and per effect (on this computer)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <chrono>
+#include "VoiceMixer.h"
+
+static const char *CODES[] = {
+    "12", "2111", "2121", "211", "1", "1121", "221", "1111", "11", "1222", "212", "1211", "22",     // a - m
+    "21", "222", "1221", "2212", "121", "111", "2", "112", "1112", "122", "2112", "2122", "2211",   // n - z
+    "22222", "12222", "11222", "11122", "11112", "11111", "21111", "22111", "22211", "22221"        // 0 - 9
+};
+
+/// toCode appends the elements of a text ("dl1abc dl1abc") to code, in the format of VoiceMixer::send()
+static void toCode(const char *text, char *code)
+{
+    for (const char *p = text; *p; ++p)
+    {
+        if (*p == ' ')
+        {
+            strcat(code, "/");
+            continue;
+        }
+        if (p != text && p[-1] != ' ')
+        {
+            strcat(code, " ");
+        }
+        if (*p >= 'a' && *p <= 'z')
+        {
+            strcat(code, CODES[*p - 'a']);
+        }
+        else if (*p >= '0' && *p <= '9')
+        {
+            strcat(code, CODES[26 + *p - '0']);
+        }
+        else if (*p == '/')
+        {
+            strcat(code, "21121");
+        }
+    }
+}
+
+static void randomCall(char *call)
+{
+    const char *prefixes[] = { "dl", "g", "ok", "w", "k", "on", "pa", "i", "ea", "sp", "f", "ha" };
+
+    strcpy(call, prefixes[rand() % 12]);
+    char *p = call + strlen(call);
+    *p++ = '0' + rand() % 10;
+    for (int i = 1 + rand() % 3; i > 0; --i)
+    {
+        *p++ = 'a' + rand() % 26;
+    }
+    *p = 0;
+}
+
+static void put(FILE *f, uint32_t value, int bytes)
+{
+    for (int i = 0; i < bytes; ++i)
+    {
+        fputc((value >> (8 * i)) & 0xff, f);
+    }
+}
+
+static void writeHeader(FILE *f, uint32_t samples)
+{
+    fwrite("RIFF", 1, 4, f);
+    put(f, 36 + 2 * samples, 4);
+    fwrite("WAVEfmt ", 1, 8, f);
+    put(f, 16, 4);
+    put(f, 1, 2);                                   // PCM
+    put(f, 1, 2);                                   // mono
+    put(f, VoiceMixer::SAMPLE_RATE, 4);
+    put(f, 2 * VoiceMixer::SAMPLE_RATE, 4);
+    put(f, 2, 2);
+    put(f, 16, 2);
+    fwrite("data", 1, 4, f);
+    put(f, 2 * samples, 4);
+}
+
+/// samplesPerSecond renders a minute with the mixer as it is
+static double samplesPerSecond(VoiceMixer &mixer)
+{
+    const unsigned long N = 8000UL * 60;
+    int16_t block[256];
+
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned long i = 0; i < N; i += 256)
+    {
+        mixer.render(block, 256);
+    }
+    return N / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void benchmark()
+{
+    static VoiceMixer mixer;
+
+    for (int v = 0; v < VoiceMixer::MAX_VOICES; ++v)
+    {
+        mixer.setTone(v, 400 + 50 * v, 100 / VoiceMixer::MAX_VOICES);
+    }
+    double voices = samplesPerSecond(mixer);
+    printf("%.1f ns per sample per voice, %.4f %% of real time per voice\n",
+            1e9 / voices / VoiceMixer::MAX_VOICES, 100.0 * VoiceMixer::SAMPLE_RATE / voices / VoiceMixer::MAX_VOICES);
+
+    static VoiceMixer effects;
+    effects.setTone(0, 600, 50);
+    double tone = samplesPerSecond(effects);
+    effects.setNoise(20, false);
+    double white = samplesPerSecond(effects);
+    effects.setNoise(20, true);
+    double pink = samplesPerSecond(effects);
+    effects.setFading(0, 80, 4000);
+    double qsb = samplesPerSecond(effects);
+    effects.setTone(1, 850, 20);
+    double qrm = samplesPerSecond(effects);
+    printf("samples per second: one tone %.0f, + white noise %.0f, pink noise instead %.0f, + QSB %.0f, + QRM %.0f\n",
+            tone, white, pink, qsb, qrm);
+}
+
+int main(int argc, char **argv)
+{
+    int callers = 3;
+    int noise = 0;
+    boolean pink = false;
+    int qsb = 0;
+    int qrm = 0;
+    unsigned seed = time(0);
+    boolean bench = false;
+    const char *name = 0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc)
+        {
+            callers = atoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "-s") && i + 1 < argc)
+        {
+            seed = strtoul(argv[++i], 0, 10);
+        }
+        else if (!strcmp(argv[i], "-N") && i + 1 < argc)
+        {
+            noise = atoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "-p"))
+        {
+            pink = true;
+        }
+        else if (!strcmp(argv[i], "-q") && i + 1 < argc)
+        {
+            qsb = atoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "-r") && i + 1 < argc)
+        {
+            qrm = atoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "-b"))
+        {
+            bench = true;
+        }
+        else if (argv[i][0] != '-' && !name)
+        {
+            name = argv[i];
+        }
+        else
+        {
+            name = 0;
+            break;
+        }
+    }
+    if (bench)
+    {
+        benchmark();
+        return 0;
+    }
+    if (!name || callers < 1 || qrm < 0 || callers + qrm > VoiceMixer::MAX_VOICES)
+    {
+        fprintf(stderr, "usage: %s [-n callers] [-s seed] [-N noise] [-p] [-q qsb] [-r qrm] [-b] file.wav\n", argv[0]);
+        return 2;
+    }
+    srand(seed);
+
+    static VoiceMixer mixer;
+    for (int v = 0; v < callers + qrm; ++v)
+    {
+        char call[12];
+        char text[48];
+        char code[VoiceMixer::MAX_CODE + 1] = "";
+        randomCall(call);
+        snprintf(text, sizeof(text), v < callers ? "%s %s" : "cq cq de %s %s k", call, call);
+        toCode(text, code);
+        int pitch = 400 + rand() % 600;
+        int wpm = 16 + rand() % 12;
+        int level = v < callers ? 80 / (callers + qrm) : 40 / (callers + qrm);
+        mixer.send(v, code, pitch, wpm, level, rand() % 1500);
+        if (qsb)
+        {
+            mixer.setFading(v, qsb, 2000 + rand() % 8000);
+        }
+        printf("%-8s %4d Hz %2d wpm%s\n", call, pitch, wpm, v < callers ? "" : " (QRM)");
+    }
+    mixer.setNoise(noise, pink);
+
+    int16_t block[256];
+    FILE *f = fopen(name, "wb");
+    if (!f)
+    {
+        perror(name);
+        return 1;
+    }
+    writeHeader(f, 0);
+    uint32_t samples = 0;
+    boolean sending = true;
+    while (sending)
+    {
+        sending = false;
+        for (int v = 0; v < callers + qrm; ++v)
+        {
+            sending = sending || mixer.isSending(v);
+        }
+        mixer.render(block, 256);
+        for (int i = 0; i < 256; ++i)
+        {
+            put(f, (uint16_t) block[i], 2);
+        }
+        samples += 256;
+    }
+    fseek(f, 0, SEEK_SET);
+    writeHeader(f, samples);
+    fclose(f);
+    printf("%s: %.1f s\n", name, (double) samples / VoiceMixer::SAMPLE_RATE);
+    return 0;
+}
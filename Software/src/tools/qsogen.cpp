@@ -0,0 +1,129 @@
+/*
+ * qsogen.cpp
+ *
+ *  Expands a QSO grammar of the M32 (/qso.txt on SPIFFS) into text, to try a grammar out before uploading it.
+ *
+ *  usage: qsogen [-n qsos] [-s seed] [-b] [file]
+ *      without file: the grammar the M32 uses when none has been uploaded
+ *      without -b: one QSO per line, -n of them (default 10)
+ *      with -b: no text, but how many words per second the generator makes (on this computer)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <chrono>
+#include <vector>
+#include "QsoGenerator.h"
+
+static const char *ERRORS[] = { "ok", "no rules", "too many rules", "too many $values", "too long", "syntax error",
+        "unknown rule" };
+
+static long hostRandom(long howBig)
+{
+    return rand() % howBig;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long qsos = 10;
+    unsigned seed = time(0);
+    boolean benchmark = false;
+    const char *name = 0;
+    std::vector<char> text;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc)
+        {
+            qsos = strtoul(argv[++i], 0, 10);
+        }
+        else if (!strcmp(argv[i], "-s") && i + 1 < argc)
+        {
+            seed = strtoul(argv[++i], 0, 10);
+        }
+        else if (!strcmp(argv[i], "-b"))
+        {
+            benchmark = true;
+        }
+        else if (argv[i][0] != '-' && !name)
+        {
+            name = argv[i];
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [-n qsos] [-s seed] [-b] [file]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (name)
+    {
+        FILE *f = fopen(name, "rb");
+        if (!f)
+        {
+            perror(name);
+            return 1;
+        }
+        char chunk[4096];
+        size_t n;
+        while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+        {
+            text.insert(text.end(), chunk, chunk + n);
+        }
+        fclose(f);
+    }
+    else
+    {
+        text.assign(QsoGenerator::DEFAULT_GRAMMAR, QsoGenerator::DEFAULT_GRAMMAR + strlen(QsoGenerator::DEFAULT_GRAMMAR));
+    }
+
+    static QsoGenerator generator(hostRandom);
+    QsoGenerator::Error e = generator.load(text.data(), text.size());
+    if (e != QsoGenerator::OK)
+    {
+        fprintf(stderr, "%s:%u: %s\n", name ? name : "default grammar", generator.getErrorLine(), ERRORS[e]);
+        return 1;
+    }
+    srand(seed);
+
+    char word[QsoGenerator::MAX_WORD + 1];
+    if (benchmark)
+    {
+        const unsigned long N = 1000000;
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned long i = 0; i < N; ++i)
+        {
+            generator.next(word);
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printf("%.0f words per second, %.1f words per QSO, %u bytes of code\n", N / seconds,
+                (double) N / generator.getQsoCount(), generator.getCodeSize());
+        return 0;
+    }
+
+    uint32_t qso = 0;
+    while (generator.next(word))
+    {
+        if (generator.getQsoCount() != qso)
+        {
+            if (qso)
+            {
+                putchar('\n');
+            }
+            qso = generator.getQsoCount();
+            if (qso > qsos)
+            {
+                return 0;
+            }
+        }
+        else
+        {
+            putchar(' ');
+        }
+        fputs(word, stdout);
+    }
+    putchar('\n');
+    return 0;
+}
@@ -0,0 +1,161 @@
+/*
+ * sessionlog.cpp
+ *
+ *  Reads a session log of the M32 (/session.log on SPIFFS) and prints it as CSV, or sums it up.
+ *
+ *  usage: sessionlog [-s] file
+ *      without -s: one line per event - session,time_ms,event,value1,value2,value3,value4,text
+ *      with -s: one line per session, and the totals
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "SessionLog.h"
+
+struct Summary
+{
+        uint32_t ms = 0;
+        uint32_t menuItem = 0;
+        uint32_t words = 0;
+        uint32_t results = 0;
+        uint32_t right = 0;
+        uint64_t responseMs = 0;
+        uint32_t firstWpm = 0;
+        uint32_t lastWpm = 0;
+        uint32_t elements = 0;
+        uint64_t markMs = 0;
+        uint32_t decoded = 0;
+};
+
+static void printText(const char *text)
+{
+    putchar('"');
+    for (; *text; ++text)
+    {
+        if (*text == '"')
+        {
+            putchar('"');
+        }
+        putchar(*text);
+    }
+    putchar('"');
+}
+
+static void printSummary(int session, const Summary &s)
+{
+    printf("%d,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u\n", session, s.menuItem, s.ms / 1000, s.words, s.results,
+            s.results ? s.right * 100 / s.results : 0, s.results ? (unsigned) (s.responseMs / s.results) : 0, s.firstWpm,
+            s.lastWpm, s.elements, s.elements ? (unsigned) (s.markMs / s.elements) : 0, s.decoded);
+}
+
+int main(int argc, char **argv)
+{
+    boolean summary = argc == 3 && strcmp(argv[1], "-s") == 0;
+    const char *name = argv[argc - 1];
+
+    if (argc != 2 && !summary)
+    {
+        fprintf(stderr, "usage: %s [-s] file\n", argv[0]);
+        return 2;
+    }
+    FILE *f = fopen(name, "rb");
+    if (!f)
+    {
+        perror(name);
+        return 1;
+    }
+    std::vector<uint8_t> bytes;
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+    {
+        bytes.insert(bytes.end(), chunk, chunk + n);
+    }
+    fclose(f);
+
+    SessionLog::Reader reader(bytes.data(), bytes.size());
+    SessionLog::Record r;
+    std::vector<Summary> sessions;
+    Summary total;
+
+    if (summary)
+    {
+        printf("session,menu_item,seconds,words,responses,right_pct,response_ms,first_wpm,last_wpm,elements,mark_ms,"
+                "decoded\n");
+    }
+    else
+    {
+        printf("session,time_ms,event,value1,value2,value3,value4,text\n");
+    }
+    while (reader.next(r))
+    {
+        if (r.type == SessionLog::SESSION || sessions.empty())
+        {
+            sessions.push_back(Summary());
+        }
+        Summary &s = sessions.back();
+        s.ms = r.time;
+        switch (r.type)
+        {
+            case SessionLog::SESSION:
+                s.menuItem = r.values[1];
+                s.firstWpm = s.lastWpm = r.values[2];
+                break;
+            case SessionLog::WORD:
+                ++s.words;
+                break;
+            case SessionLog::RESULT:
+                ++s.results;
+                s.right += r.values[0];
+                s.responseMs += r.values[1];
+                break;
+            case SessionLog::SPEED:
+                s.lastWpm = r.values[0];
+                break;
+            case SessionLog::ELEMENT:
+                ++s.elements;
+                s.markMs += r.values[0];
+                break;
+            case SessionLog::DECODED:
+                ++s.decoded;
+                break;
+        }
+        if (!summary)
+        {
+            printf("%u,%u,%s", (unsigned) sessions.size(), r.time, SessionLog::getName(r.type));
+            for (int i = 0; i < SessionLog::MAX_VALUES; ++i)
+            {
+                i < r.count ? printf(",%u", r.values[i]) : printf(",");
+            }
+            putchar(',');
+            printText(r.text);
+            putchar('\n');
+        }
+    }
+
+    if (summary)
+    {
+        for (size_t i = 0; i < sessions.size(); ++i)
+        {
+            const Summary &s = sessions[i];
+            printSummary(i + 1, s);
+            total.ms += s.ms;
+            total.words += s.words;
+            total.results += s.results;
+            total.right += s.right;
+            total.responseMs += s.responseMs;
+            total.elements += s.elements;
+            total.markMs += s.markMs;
+            total.decoded += s.decoded;
+        }
+        printf("total,,%u,%u,%u,%u,%u,,,%u,%u,%u\n", total.ms / 1000, total.words, total.results,
+                total.results ? total.right * 100 / total.results : 0,
+                total.results ? (unsigned) (total.responseMs / total.results) : 0, total.elements,
+                total.elements ? (unsigned) (total.markMs / total.elements) : 0, total.decoded);
+        fprintf(stderr, "%u sessions, %.1f h of practice, %u bytes, %u bytes per hour, %u unknown events\n",
+                (unsigned) sessions.size(), total.ms / 3600000.0, (unsigned) bytes.size(),
+                total.ms ? (unsigned) (bytes.size() * 3600000.0 / total.ms) : 0, (unsigned) reader.getSkipped());
+    }
+    return 0;
+}